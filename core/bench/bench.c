@@ -0,0 +1,637 @@
+/*
+ * hermesbench - microbenchmarks de HermesDecoder sobre tramas sinteticas
+ *
+ *   make bench                       (todas las pruebas, 20000 tramas)
+ *   ./bench/hermesbench --frames 100000 --filter decode
+ *
+ * Salida CSV por stdout (una fila por prueba y tipo de trama):
+ *   bench,dataset,frames,ns_per_frame,frames_per_s,bytes_per_s
+ * bytes_per_s se refiere a la entrada (hex o registros) salvo en los
+ * writers/printers, donde cuenta los bytes generados.
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "gen.h"
+#include "utils.h"
+#include "hexparse.h"
+#include "config.h"
+#include "decoder.h"
+#include "export.h"
+#include "encoder.h"
+#include "record.h"
+#include "archive.h"
+#include "curve.h"
+#include "curveio.h"
+#include "echo.h"
+#include "tty.h"
+#include "stream.h"
+#include "zstream.h"
+#include "aggregate.h"
+
+#ifdef HERMES_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HERMES_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define BENCH_MIN_SECONDS 0.2
+
+/* --curves: rejilla de 1 cm (cubre todos los tiempos de TH y TVG) */
+#define BENCH_GRID 1024
+static float bench_grid[BENCH_GRID];
+
+typedef struct {
+    gen_kind_t kind;
+    size_t   n;
+    char   **line;          // tramas en hex (terminadas en '\0')
+    size_t  *len;
+    uint8_t (*frame)[HERMES_FRAME_BYTES];
+    hermes_config_t *cfg;   // ya decodificadas (para printers/writers)
+    uint8_t (*echo)[ECHO_SAMPLES];   // volcado de eco sintetico por trama
+    uint8_t (*thr)[ECHO_SAMPLES];    // umbral P1 de la trama en cada muestra
+    uint8_t *uart;          // --tty: tramas seguidas con basura entre ellas
+    size_t   uart_len;
+    uint8_t *gz, *zst;      // las lineas hex comprimidas (si hay zlib/libzstd)
+    size_t   gz_len, zst_len;
+    size_t   hex_bytes;     // total de caracteres hex
+} dataset_t;
+
+/* Destino de los printers: descarta y cuenta bytes */
+static uint64_t sink_bytes;
+static volatile uint64_t sink_val;
+
+static ssize_t sink_write(void *cookie, const char *buf, size_t n){
+    (void)cookie;
+    (void)buf;
+    sink_bytes += n;
+    return (ssize_t)n;
+}
+
+static FILE *sink_open(void){
+    cookie_io_functions_t io = { .write = sink_write };
+    FILE *f = fopencookie(NULL, "w", io);
+    if (f) setvbuf(f, NULL, _IOFBF, 1 << 16);
+    return f;
+}
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ------------------ pruebas (una pasada sobre el dataset) ------------------ */
+typedef struct {
+    const char *name;
+    int out_bytes;          // 1 = bytes_per_s cuenta la salida (sink)
+    void (*run)(const dataset_t *ds, FILE *sink);
+    size_t (*in_bytes)(const dataset_t *ds);
+} bench_t;
+
+static size_t in_hex(const dataset_t *ds){ return ds->hex_bytes; }
+static size_t in_regs(const dataset_t *ds){ return ds->n * HERMES_NUM_REGS; }
+
+static void b_parse_scalar(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    uint8_t buf[HERMES_FRAME_BYTES * 2];
+    for (size_t i = 0; i < ds->n; i++) sink_val += (uint64_t)parse_hex_bytes(ds->line[i], buf, (int)sizeof(buf));
+}
+
+static void b_parse_fast(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    uint8_t buf[HERMES_FRAME_BYTES * 2];
+    for (size_t i = 0; i < ds->n; i++) sink_val += (uint64_t)parse_hex_bytes_n(ds->line[i], ds->len[i], buf, (int)sizeof(buf));
+}
+
+static void b_decode_config(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    hermes_config_t cfg;
+    for (size_t i = 0; i < ds->n; i++){
+        decode_config(ds->frame[i] + HERMES_PREFIX_BYTES, &cfg);
+        sink_val += cfg.th[1].t_us[HERMES_TH_STAGES - 1];
+    }
+}
+
+static void b_decode_reg(const dataset_t *ds, FILE *sink){
+    for (size_t i = 0; i < ds->n; i++){
+        for (int idx = 1; idx <= HERMES_NUM_REGS; idx++) decode_reg(sink, &ds->cfg[i], idx);
+    }
+}
+
+static void b_extract_T12(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    int t[12];
+    for (size_t i = 0; i < ds->n; i++){
+        extract_T12_us(ds->frame[i] + HERMES_PREFIX_BYTES, (int)(i & 1), t);
+        sink_val += (uint64_t)t[11];
+    }
+}
+
+static void b_extract_L1_L8(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    int l[8];
+    for (size_t i = 0; i < ds->n; i++){
+        extract_L1_L8_5bit(ds->frame[i] + HERMES_PREFIX_BYTES, (int)(i & 1), l);
+        sink_val += (uint64_t)l[7];
+    }
+}
+
+static void b_extract_L9_L12(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    int l[4];
+    for (size_t i = 0; i < ds->n; i++){
+        extract_L9_L12_8bit(ds->frame[i] + HERMES_PREFIX_BYTES, (int)(i & 1), l);
+        sink_val += (uint64_t)l[3];
+    }
+}
+
+static void b_th_csv(const dataset_t *ds, FILE *sink){
+    for (size_t i = 0; i < ds->n; i++) fprint_th_profile_csv(sink, &ds->cfg[i], (int)(i & 1));
+}
+
+static void b_tvg_csv(const dataset_t *ds, FILE *sink){
+    for (size_t i = 0; i < ds->n; i++) fprint_tvg_csv(sink, &ds->cfg[i]);
+}
+
+static void b_th_json(const dataset_t *ds, FILE *sink){
+    for (size_t i = 0; i < ds->n; i++) fprint_th_profile_json(sink, &ds->cfg[i], (int)(i & 1));
+}
+
+static void b_tvg_json(const dataset_t *ds, FILE *sink){
+    for (size_t i = 0; i < ds->n; i++) fprint_tvg_json(sink, &ds->cfg[i]);
+}
+
+/* --format ndjson / binary: decodificacion completa legible por maquina */
+static void b_record_ndjson(const dataset_t *ds, FILE *sink){
+    for (size_t i = 0; i < ds->n; i++){
+        export_key_t k = { i + 1, 0, 0x5E02, ds->cfg[i].uart_addr };
+        record_write(sink, RECORD_NDJSON, &k, &ds->cfg[i]);
+    }
+}
+
+static void b_record_binary(const dataset_t *ds, FILE *sink){
+    for (size_t i = 0; i < ds->n; i++){
+        export_key_t k = { i + 1, 0, 0x5E02, ds->cfg[i].uart_addr };
+        record_write(sink, RECORD_BINARY, &k, &ds->cfg[i]);
+    }
+}
+
+/* Inversa: cfg -> REG1..REG55 (make check comprueba la ida y vuelta) */
+static void b_encode_config(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    uint8_t reg[HERMES_NUM_REGS];
+    for (size_t i = 0; i < ds->n; i++){
+        encode_config(&ds->cfg[i], reg);
+        sink_val += reg[HERMES_NUM_REGS - 1];
+    }
+}
+
+/* --encode por registro: base + perfil P1 completo en us y % */
+static void b_encode_frame(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    static const char *KEYS[] = {
+        "P1_T1_US", "P1_T6_US", "P1_T12_US", "P1_L1_PCT", "P1_L8_PCT", "P1_L12", "TVG_G1", "TVG_T0_US"
+    };
+    static const char *VALS[] = { "300", "1000", "4000", "50", "12.5", "200", "33", "1000" };
+    encode_kv_t kv[8];
+    char err[160];
+    uint8_t out[HERMES_FRAME_BYTES];
+
+    for (int k = 0; k < 8; k++) kv[k] = (encode_kv_t){ KEYS[k], strlen(KEYS[k]), VALS[k], strlen(VALS[k]) };
+    for (size_t i = 0; i < ds->n; i++){
+        if (encode_frame(kv, 8, ds->frame[i], out, err, sizeof(err)) == 0) sink_val += out[HERMES_FRAME_BYTES - 1];
+    }
+}
+
+/* --archive: bloques columnares (codificacion de las 105 columnas), sin disco */
+static void b_archive_write(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    archive_writer_t *w = archive_create("/dev/null");
+    if (!w) return;
+    for (size_t i = 0; i < ds->n; i++){
+        hermes_frame_t fr;
+        frame_from_bytes(&fr, ds->frame[i], HERMES_FRAME_BYTES);
+        fr.seq = i + 1;
+        fr.offset = 0;
+        archive_add(w, &fr);
+    }
+    archive_stats_t st;
+    archive_finish(w, &st);
+    sink_val += st.bytes;
+}
+
+/* --curves: P1, P2 y TVG en la rejilla de 1 cm (SIMD vs escalar) */
+static void b_curves_scalar(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    float out[BENCH_GRID];
+    for (size_t i = 0; i < ds->n; i++){
+        for (int k = 0; k < CURVE_NUM_KINDS; k++){
+            curve_table_t t;
+            curve_table(&ds->cfg[i], (curve_kind_t)k, &t);
+            curve_eval_scalar(&t, CURVE_STEP, bench_grid, BENCH_GRID, out);
+            sink_val += (uint64_t)out[BENCH_GRID - 1];
+        }
+    }
+}
+
+static void b_curves_simd(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    float out[BENCH_GRID];
+    for (size_t i = 0; i < ds->n; i++){
+        for (int k = 0; k < CURVE_NUM_KINDS; k++){
+            curve_eval_batch(&ds->cfg[i], 1, (curve_kind_t)k, CURVE_STEP, bench_grid, BENCH_GRID, out);
+            sink_val += (uint64_t)out[BENCH_GRID - 1];
+        }
+    }
+}
+
+static void b_curves_binary(const dataset_t *ds, FILE *sink){
+    curve_out_t co = { bench_grid, BENCH_GRID, (1u << CURVE_NUM_KINDS) - 1, CURVE_LINEAR, 1 };
+    for (size_t i = 0; i < ds->n; i++){
+        export_key_t k = { i + 1, 0, 0x5E02, ds->cfg[i].uart_addr };
+        curve_write_rows(sink, &co, &k, &ds->cfg[i]);
+    }
+}
+
+/* --echo: cruces de cada volcado con el umbral ya calculado de su configuracion */
+static void b_echo_scalar(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    echo_result_t r;
+    for (size_t i = 0; i < ds->n; i++){
+        echo_analyze_scalar(ds->echo[i], ds->thr[i], &r);
+        sink_val += (uint64_t)(r.first + r.margin_sample);
+    }
+}
+
+static void b_echo_simd(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    echo_result_t r;
+    for (size_t i = 0; i < ds->n; i++){
+        echo_analyze(ds->echo[i], ds->thr[i], &r);
+        sink_val += (uint64_t)(r.first + r.margin_sample);
+    }
+}
+
+static size_t in_echo(const dataset_t *ds){ return ds->n * ECHO_SAMPLES; }
+
+/* --tty: todas las apariciones del prefijo en el flujo crudo (peor caso: sin saltar tramas) */
+static size_t uart_count_memmem(const dataset_t *ds){
+    static const uint8_t pre[2] = { 0x5E, 0x02 };
+    size_t count = 0;
+    const uint8_t *p = ds->uart, *end = ds->uart + ds->uart_len;
+    while ((p = memmem(p, (size_t)(end - p), pre, 2)) != NULL){
+        count++;
+        p += 2;
+    }
+    return count;
+}
+
+static size_t uart_count_scan(const dataset_t *ds){
+    size_t count = 0, pos = 0;
+    while (pos < ds->uart_len){
+        size_t k = tty_find_prefix(ds->uart + pos, ds->uart_len - pos, 0x5E02);
+        if (k == ds->uart_len - pos) break;
+        count++;
+        pos += k + 2;
+    }
+    return count;
+}
+
+static void b_tty_memmem(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    sink_val += uart_count_memmem(ds);
+}
+
+static void b_tty_scan(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    sink_val += uart_count_scan(ds);
+}
+
+static size_t in_uart(const dataset_t *ds){ return ds->uart_len; }
+
+/* Ingesta hasta hermes_config_t: linea hex (--input) frente a registro fijo (--input-format bin) */
+static void b_ingest_hex(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    uint8_t buf[HERMES_FRAME_BYTES * 2];
+    hermes_frame_t fr;
+    hermes_config_t cfg;
+    for (size_t i = 0; i < ds->n; i++){
+        int n = parse_hex_bytes_n(ds->line[i], ds->len[i], buf, (int)sizeof(buf));
+        if (frame_from_bytes(&fr, buf, n) != 0) continue;
+        decode_config(fr.reg, &cfg);
+        sink_val += cfg.uart_addr;
+    }
+}
+
+static void b_ingest_bin(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    const uint8_t *map = ds->frame[0];      // las tramas son contiguas, como en el fichero
+    hermes_frame_t fr;
+    hermes_config_t cfg;
+    for (size_t i = 0; i < ds->n; i++){
+        frame_from_bytes(&fr, map + i * HERMES_FRAME_BYTES, HERMES_FRAME_BYTES);
+        decode_config(fr.reg, &cfg);
+        sink_val += cfg.uart_addr;
+    }
+}
+
+static size_t in_bin(const dataset_t *ds){ return ds->n * HERMES_FRAME_BYTES; }
+
+/* --aggregate: histogramas por registro de cada trama (sin decodificar) */
+static void b_aggregate_frame(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    hermes_agg_t *a = aggregate_new();
+    if (!a) return;
+    hermes_frame_t fr;
+    for (size_t i = 0; i < ds->n; i++){
+        frame_from_bytes(&fr, ds->frame[i], HERMES_FRAME_BYTES);
+        aggregate_frame(a, &fr);
+    }
+    sink_val += a->frames;
+    aggregate_free(a);
+}
+
+#if defined(HERMES_HAVE_ZLIB) || defined(HERMES_HAVE_ZSTD)
+/* Ingesta de un log comprimido: hilo de descompresion + stream_run */
+static int ingest_cb(FILE *out, const hermes_frame_t *fr, void *user){
+    (void)out;
+    (void)user;
+    hermes_config_t cfg;
+    decode_config(fr->reg, &cfg);
+    sink_val += cfg.uart_addr;
+    return 0;
+}
+
+static void ingest_compressed(uint8_t *buf, size_t len, zstream_codec_t codec){
+    FILE *in = fmemopen(buf, len, "r");
+    zstream_t *z = in ? zstream_open(in, codec, 1, "bench") : NULL;
+    if (z){
+        stream_stats_t st;
+        stream_run(zstream_file(z), ingest_cb, NULL, &st);
+        zstream_close(z, NULL);
+        sink_val += st.frames;
+    }
+    if (in) fclose(in);
+}
+#endif
+
+#ifdef HERMES_HAVE_ZLIB
+static void b_ingest_gzip(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    ingest_compressed(ds->gz, ds->gz_len, ZSTREAM_GZIP);
+}
+#endif
+
+#ifdef HERMES_HAVE_ZSTD
+static void b_ingest_zstd(const dataset_t *ds, FILE *sink){
+    (void)sink;
+    ingest_compressed(ds->zst, ds->zst_len, ZSTREAM_ZSTD);
+}
+#endif
+
+/* Camino completo de --stream: hex -> registros -> decodificacion -> texto */
+static void b_end_to_end(const dataset_t *ds, FILE *sink){
+    uint8_t buf[HERMES_FRAME_BYTES * 2];
+    hermes_config_t cfg;
+    for (size_t i = 0; i < ds->n; i++){
+        if (parse_hex_bytes_n(ds->line[i], ds->len[i], buf, (int)sizeof(buf)) < HERMES_FRAME_BYTES) continue;
+        decode_config(buf + HERMES_PREFIX_BYTES, &cfg);
+        decode_print_all(sink, &cfg);
+    }
+}
+
+static const bench_t BENCHES[] = {
+    { "parse_hex_bytes",        0, b_parse_scalar,    in_hex  },
+    { "parse_hex_bytes_fast",   0, b_parse_fast,      in_hex  },
+    { "decode_config",          0, b_decode_config,   in_regs },
+    { "decode_reg",             1, b_decode_reg,      NULL    },
+    { "extract_T12_us",         0, b_extract_T12,     in_regs },
+    { "extract_L1_L8_5bit",     0, b_extract_L1_L8,   in_regs },
+    { "extract_L9_L12_8bit",    0, b_extract_L9_L12,  in_regs },
+    { "fprint_th_profile_csv",  1, b_th_csv,          NULL    },
+    { "fprint_tvg_csv",         1, b_tvg_csv,         NULL    },
+    { "fprint_th_profile_json", 1, b_th_json,         NULL    },
+    { "fprint_tvg_json",        1, b_tvg_json,        NULL    },
+    { "record_ndjson",          1, b_record_ndjson,   NULL    },
+    { "record_binary",          1, b_record_binary,   NULL    },
+    { "encode_config",          0, b_encode_config,   in_regs },
+    { "encode_frame",           0, b_encode_frame,    in_regs },
+    { "archive_write",          0, b_archive_write,   in_regs },
+    { "curves_scalar",          0, b_curves_scalar,   in_regs },
+    { "curves_simd",            0, b_curves_simd,     in_regs },
+    { "curves_binary",          1, b_curves_binary,   NULL    },
+    { "echo_analyze_scalar",    0, b_echo_scalar,     in_echo },
+    { "echo_analyze",           0, b_echo_simd,       in_echo },
+    { "tty_scan_memmem",        0, b_tty_memmem,      in_uart },
+    { "tty_find_prefix",        0, b_tty_scan,        in_uart },
+    { "ingest_hex",             0, b_ingest_hex,      in_hex  },
+    { "ingest_bin",             0, b_ingest_bin,      in_bin  },
+    { "aggregate_frame",        0, b_aggregate_frame, in_bin  },
+#ifdef HERMES_HAVE_ZLIB
+    { "ingest_gzip",            0, b_ingest_gzip,     in_hex  },
+#endif
+#ifdef HERMES_HAVE_ZSTD
+    { "ingest_zstd",            0, b_ingest_zstd,     in_hex  },
+#endif
+    { "end_to_end_text",        1, b_end_to_end,      NULL    },
+};
+
+/* ------------------ dataset ------------------ */
+/* Las lineas hex como un log ("linea\n" por trama) */
+static char *dataset_text(const dataset_t *ds, size_t *len){
+    char *t = malloc(ds->hex_bytes + ds->n);
+    if (!t) return NULL;
+    size_t pos = 0;
+    for (size_t i = 0; i < ds->n; i++){
+        memcpy(t + pos, ds->line[i], ds->len[i]);
+        pos += ds->len[i];
+        t[pos++] = '\n';
+    }
+    *len = pos;
+    return t;
+}
+
+static int dataset_compress(dataset_t *ds){
+    size_t len;
+    char *text = dataset_text(ds, &len);
+    if (!text) return -1;
+    int rc = 0;
+
+#ifdef HERMES_HAVE_ZLIB
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    ds->gz = malloc(compressBound((uLong)len) + 64);
+    if (!ds->gz || deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK){   // +16: gzip
+        free(text);
+        return -1;
+    }
+    zs.next_in = (Bytef *)text;
+    zs.avail_in = (uInt)len;
+    zs.next_out = ds->gz;
+    zs.avail_out = (uInt)(compressBound((uLong)len) + 64);
+    deflate(&zs, Z_FINISH);
+    ds->gz_len = zs.total_out;
+    deflateEnd(&zs);
+#endif
+
+#ifdef HERMES_HAVE_ZSTD
+    ds->zst = malloc(ZSTD_compressBound(len));
+    if (!ds->zst){
+        free(text);
+        return -1;
+    }
+    ds->zst_len = ZSTD_compress(ds->zst, ZSTD_compressBound(len), text, len, 3);
+    if (ZSTD_isError(ds->zst_len)) rc = -1;
+#endif
+
+    free(text);
+    return rc;
+}
+
+static int dataset_build(dataset_t *ds, gen_kind_t kind, size_t n, uint64_t seed){
+    memset(ds, 0, sizeof(*ds));
+    ds->kind = kind;
+    ds->n = n;
+    ds->line = calloc(n, sizeof(*ds->line));
+    ds->len = calloc(n, sizeof(*ds->len));
+    ds->frame = calloc(n, sizeof(*ds->frame));
+    ds->cfg = calloc(n, sizeof(*ds->cfg));
+    ds->echo = calloc(n, sizeof(*ds->echo));
+    ds->thr = calloc(n, sizeof(*ds->thr));
+    ds->uart = malloc(n * (HERMES_FRAME_BYTES + 3));
+    if (!ds->line || !ds->len || !ds->frame || !ds->cfg || !ds->echo || !ds->thr || !ds->uart) return -1;
+
+    gen_t g;
+    char tmp[3 * HERMES_FRAME_BYTES + 1];
+    gen_init(&g, kind, seed);
+
+    for (size_t i = 0; i < n; i++){
+        ds->len[i] = gen_line(&g, tmp, sizeof(tmp));
+        ds->line[i] = strdup(tmp);
+        if (!ds->line[i]) return -1;
+        ds->hex_bytes += ds->len[i];
+
+        if (parse_hex_bytes(tmp, ds->frame[i], HERMES_FRAME_BYTES) != HERMES_FRAME_BYTES) return -1;
+        decode_config(ds->frame[i] + HERMES_PREFIX_BYTES, &ds->cfg[i]);
+
+        /* eco: muestras derivadas de la trama y el umbral de su configuracion */
+        for (int j = 0; j < ECHO_SAMPLES; j++){
+            ds->echo[i][j] = (uint8_t)(ds->frame[i][HERMES_PREFIX_BYTES + j % HERMES_NUM_REGS] ^ (j * 37));
+        }
+        echo_threshold(&ds->cfg[i], 0, (curve_interp_t)(i & 1), ds->thr[i]);
+
+        /* uart: la trama y 0..2 bytes de basura que a veces empiezan como el prefijo */
+        memcpy(ds->uart + ds->uart_len, ds->frame[i], HERMES_FRAME_BYTES);
+        ds->uart_len += HERMES_FRAME_BYTES;
+        for (size_t j = 0; j < i % 3; j++) ds->uart[ds->uart_len++] = (j == 0) ? 0x5E : (uint8_t)i;
+    }
+    return dataset_compress(ds);
+}
+
+static void dataset_free(dataset_t *ds){
+    for (size_t i = 0; ds->line && i < ds->n; i++) free(ds->line[i]);
+    free(ds->line);
+    free(ds->len);
+    free(ds->frame);
+    free(ds->cfg);
+    free(ds->echo);
+    free(ds->thr);
+    free(ds->uart);
+    free(ds->gz);
+    free(ds->zst);
+}
+
+static void run_bench(const bench_t *b, const dataset_t *ds, FILE *sink){
+    b->run(ds, sink);   // calentamiento
+    fflush(sink);
+
+    uint64_t passes = 0;
+    sink_bytes = 0;
+    double t0 = now_s(), t;
+    do {
+        b->run(ds, sink);
+        passes++;
+        t = now_s() - t0;
+    } while (t < BENCH_MIN_SECONDS);
+    fflush(sink);
+
+    double frames = (double)passes * (double)ds->n;
+    double bytes = b->out_bytes ? (double)sink_bytes : (double)passes * (double)b->in_bytes(ds);
+
+    printf("%s,%s,%.0f,%.1f,%.0f,%.0f\n", b->name, gen_kind_name(ds->kind),
+           frames, t * 1e9 / frames, frames / t, bytes / t);
+    fflush(stdout);
+}
+
+static void bench_usage(const char *prog){
+    fprintf(stderr,
+        "Uso: %s [--frames N] [--seed S] [--filter texto] [--kind random|worst|fleet]\n",
+        prog);
+}
+
+int main(int argc, char **argv){
+    size_t nframes = 20000;
+    unsigned long long seed = 1;
+    const char *filter = NULL;
+    int only_kind = -1;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc){
+            nframes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--kind") == 0 && i + 1 < argc){
+            only_kind = gen_kind_parse(argv[++i]);
+            if (only_kind < 0){
+                bench_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            bench_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nframes == 0) nframes = 1;
+    for (int i = 0; i < BENCH_GRID; i++) bench_grid[i] = (float)i;
+
+    FILE *sink = sink_open();
+    if (!sink){
+        fprintf(stderr, "No se pudo crear el sink de salida.\n");
+        return 1;
+    }
+
+    fprintf(stderr, "hermesbench: %zu tramas por dataset, semilla %llu, hexparse=%s, curve=%s, echo=%s, tty=%s\n",
+            nframes, seed, hexparse_impl(), curve_impl(), echo_impl(), tty_scan_impl());
+    printf("bench,dataset,frames,ns_per_frame,frames_per_s,bytes_per_s\n");
+
+    for (int k = 0; k < GEN_NUM_KINDS; k++){
+        if (only_kind >= 0 && k != only_kind) continue;
+
+        dataset_t ds;
+        if (dataset_build(&ds, (gen_kind_t)k, nframes, seed) != 0){
+            fprintf(stderr, "Sin memoria generando el dataset %s.\n", gen_kind_name((gen_kind_t)k));
+            dataset_free(&ds);
+            fclose(sink);
+            return 1;
+        }
+
+        for (size_t b = 0; b < sizeof(BENCHES) / sizeof(BENCHES[0]); b++){
+            if (filter && !strstr(BENCHES[b].name, filter)) continue;
+            run_bench(&BENCHES[b], &ds, sink);
+        }
+        dataset_free(&ds);
+    }
+
+    curve_rows_free_all();
+    fclose(sink);
+    return 0;
+}
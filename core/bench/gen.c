@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "gen.h"
+
+static const char *const KIND_NAMES[GEN_NUM_KINDS] = { "random", "worst", "fleet" };
+
+static uint64_t next_u64(gen_t *g){
+    uint64_t x = g->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    g->state = x;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+static void random_regs(gen_t *g, uint8_t *frame){
+    frame[0] = 0x5E;
+    frame[1] = 0x02;
+    for (int i = HERMES_PREFIX_BYTES; i < HERMES_FRAME_BYTES; i++){
+        frame[i] = (uint8_t)(next_u64(g) >> 56);
+    }
+}
+
+void gen_init(gen_t *g, gen_kind_t kind, uint64_t seed){
+    memset(g, 0, sizeof(*g));
+    g->kind = kind;
+    g->state = seed ? seed : 0x9E3779B97F4A7C15ull;
+
+    if (kind == GEN_FLEET){
+        for (int d = 0; d < GEN_FLEET_DEVICES; d++){
+            uint8_t *f = g->fleet[d];
+            random_regs(g, f);
+            f[HERMES_PREFIX_BYTES + 11] = (uint8_t)((d << 4) | (f[HERMES_PREFIX_BYTES + 11] & 0x0F)); // PULSE_P2.UART_ADDR
+            f[HERMES_PREFIX_BYTES + 12] &= (uint8_t)~0x40;                                           // CURR_LIM_P1 RESERVED = 0
+            f[HERMES_PREFIX_BYTES + 6] &= (uint8_t)~0x02;                                            // TVGAIN6 RESERVED = 0
+        }
+    }
+}
+
+void gen_frame(gen_t *g, uint8_t out[HERMES_FRAME_BYTES]){
+    switch (g->kind){
+        case GEN_WORST:
+            random_regs(g, out);
+            for (int i = 0; i < 6; i++) out[HERMES_PREFIX_BYTES + 23 + i] = 0xFF;   // P1 T1..T12 = max
+            for (int i = 0; i < 6; i++) out[HERMES_PREFIX_BYTES + 39 + i] = 0xFF;   // P2 T1..T12 = max
+            out[HERMES_PREFIX_BYTES + 6] |= 0x02;                                   // TVGAIN6 RESERVED
+            out[HERMES_PREFIX_BYTES + 12] |= 0x40;                                  // CURR_LIM_P1 RESERVED
+            break;
+
+        case GEN_FLEET: {
+            uint64_t r = next_u64(g);
+            uint8_t *base = g->fleet[r % GEN_FLEET_DEVICES];
+            if ((r >> 32) % 50 == 0){
+                /* Ajuste: un registro de umbrales (P1/P2_THR_0..14) cambia */
+                int reg = 23 + (int)((r >> 40) % 31);
+                base[HERMES_PREFIX_BYTES + reg] ^= (uint8_t)(1u << ((r >> 48) & 7));
+            }
+            memcpy(out, base, HERMES_FRAME_BYTES);
+            break;
+        }
+
+        default:
+            random_regs(g, out);
+            break;
+    }
+}
+
+size_t gen_line(gen_t *g, char *out, size_t cap){
+    static const char HEX_UP[] = "0123456789ABCDEF";
+    static const char HEX_LO[] = "0123456789abcdef";
+    uint8_t f[HERMES_FRAME_BYTES];
+    gen_frame(g, f);
+
+    int spaced = (g->kind == GEN_WORST);
+    const char *hex = spaced ? HEX_LO : HEX_UP;
+    size_t need = (size_t)HERMES_FRAME_BYTES * (spaced ? 3 : 2);
+    if (cap < need) return 0;
+
+    size_t n = 0;
+    for (int i = 0; i < HERMES_FRAME_BYTES; i++){
+        if (spaced && i) out[n++] = ' ';
+        out[n++] = hex[f[i] >> 4];
+        out[n++] = hex[f[i] & 0x0F];
+    }
+    out[n] = '\0';
+    return n;
+}
+
+const char *gen_kind_name(gen_kind_t kind){
+    return (kind >= 0 && kind < GEN_NUM_KINDS) ? KIND_NAMES[kind] : "?";
+}
+
+int gen_kind_parse(const char *name){
+    for (int i = 0; i < GEN_NUM_KINDS; i++){
+        if (strcmp(name, KIND_NAMES[i]) == 0) return i;
+    }
+    return -1;
+}
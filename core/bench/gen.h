@@ -0,0 +1,49 @@
+#ifndef HERMES_BENCH_GEN_H
+#define HERMES_BENCH_GEN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "frame.h"
+
+/*
+ * Generador determinista de tramas sinteticas (2 + 55 bytes) para
+ * benchmarks y pruebas de carga. Misma semilla -> mismas tramas.
+ *
+ *   GEN_RANDOM : los 55 registros aleatorios
+ *   GEN_WORST  : peor caso para parser/decoder: hex en minusculas separado
+ *                por espacios, bits RESERVED activos y tiempos maximos
+ *   GEN_FLEET  : flota de 16 dispositivos (UART_ADDR 0..15) con una
+ *                configuracion base cada uno; ~2% de tramas con un ajuste
+ *                pequeño (caso tipico de --cache / --diff)
+ */
+
+typedef enum {
+    GEN_RANDOM = 0,
+    GEN_WORST,
+    GEN_FLEET,
+    GEN_NUM_KINDS
+} gen_kind_t;
+
+#define GEN_FLEET_DEVICES 16
+
+typedef struct {
+    gen_kind_t kind;
+    uint64_t state;                                   // xorshift64*
+    uint8_t  fleet[GEN_FLEET_DEVICES][HERMES_FRAME_BYTES];
+} gen_t;
+
+void gen_init(gen_t *g, gen_kind_t kind, uint64_t seed);
+
+/* Siguiente trama binaria */
+void gen_frame(gen_t *g, uint8_t out[HERMES_FRAME_BYTES]);
+
+/* Siguiente trama como linea hex (sin '\n'); devuelve la longitud */
+size_t gen_line(gen_t *g, char *out, size_t cap);
+
+/* "random" / "worst" / "fleet" <-> gen_kind_t (-1 si no existe) */
+const char *gen_kind_name(gen_kind_t kind);
+int gen_kind_parse(const char *name);
+
+#endif // HERMES_BENCH_GEN_H
@@ -0,0 +1,74 @@
+/*
+ * genframes - genera tramas sinteticas deterministas, una por linea
+ *
+ *   ./bench/genframes --kind fleet --count 100000 --seed 1 > frames.log
+ *   ./bench/genframes --kind worst | ./hermesdecoder --stream
+ *   ./bench/genframes --format bin --count 1000000 > frames.bin
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gen.h"
+
+static void gen_usage(const char *prog){
+    fprintf(stderr,
+        "Uso: %s [--kind random|worst|fleet] [--count N] [--seed S] [--format hex|bin|binlen]\n"
+        "  Escribe N tramas (por defecto 1000) en hex, una por línea, o como\n"
+        "  registros binarios para --input-format bin/binlen.\n",
+        prog);
+}
+
+int main(int argc, char **argv){
+    int kind = GEN_RANDOM;
+    unsigned long long count = 1000, seed = 1;
+    const char *format = "hex";
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--kind") == 0 && i + 1 < argc){
+            kind = gen_kind_parse(argv[++i]);
+            if (kind < 0){
+                fprintf(stderr, "Tipo desconocido: %s\n\n", argv[i]);
+                gen_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc){
+            count = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc){
+            format = argv[++i];
+            if (strcmp(format, "hex") != 0 && strcmp(format, "bin") != 0 && strcmp(format, "binlen") != 0){
+                fprintf(stderr, "Formato desconocido: %s\n\n", format);
+                gen_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            gen_usage(argv[0]);
+            return (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) ? 0 : 1;
+        }
+    }
+
+    gen_t g;
+    char line[3 * HERMES_FRAME_BYTES + 1];
+    gen_init(&g, (gen_kind_t)kind, seed);
+
+    if (strcmp(format, "hex") != 0){
+        /* binlen: cabecera u16 big-endian con la longitud, como --serve */
+        uint8_t rec[2 + HERMES_FRAME_BYTES] = { 0, HERMES_FRAME_BYTES };
+        int hdr = (format[3] == 'l') ? 2 : 0;
+        for (unsigned long long n = 0; n < count; n++){
+            gen_frame(&g, rec + 2);
+            size_t len = (size_t)hdr + HERMES_FRAME_BYTES;
+            if (fwrite(rec + 2 - hdr, 1, len, stdout) != len) return 1;
+        }
+        return 0;
+    }
+
+    for (unsigned long long n = 0; n < count; n++){
+        size_t len = gen_line(&g, line, sizeof(line));
+        line[len] = '\n';
+        if (fwrite(line, 1, len + 1, stdout) != len + 1) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * hermesload - generador de carga local para hermesdecoder --serve
+ *
+ *   ./hermesdecoder --serve /tmp/hermes.sock --threads 4 &
+ *   ./bench/hermesload --socket /tmp/hermes.sock --clients 8 --pipeline 16
+ *
+ * Cada cliente es un hilo con su propia conexion que mantiene hasta
+ * --pipeline peticiones en vuelo (las nuevas se envian en un solo write
+ * por cada lote de respuestas). La latencia se mide por peticion, desde
+ * el envio hasta que llega su respuesta completa.
+ *
+ * Modos: text (linea hex -> JSON), bin (bytes crudos -> resultado binario),
+ * json (bytes crudos -> JSON). Salida CSV por stdout:
+ *   mode,clients,pipeline,requests,errors,seconds,req_per_s,p50_us,p90_us,p99_us,p999_us,max_us
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "gen.h"
+#include "serve.h"
+
+#define LOAD_POOL      1024             // peticiones distintas por cliente
+#define LOAD_REQ_MAX   (3 * HERMES_FRAME_BYTES + 8)
+#define LOAD_RX_BYTES  (1u << 20)
+
+typedef enum { MODE_TEXT, MODE_BIN, MODE_JSON } load_mode_t;
+
+static const char *MODE_NAMES[] = { "text", "bin", "json" };
+
+typedef struct {
+    const char *path;
+    load_mode_t mode;
+    gen_kind_t kind;
+    uint64_t seed;
+    size_t requests;      // por cliente
+    size_t pipeline;
+} load_cfg_t;
+
+typedef struct {
+    const load_cfg_t *cfg;
+    int id;
+    uint64_t *lat_ns;     // una por peticion
+    size_t done, errors;
+    int failed;
+} client_t;
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Codifica una peticion en el formato de serve.h. Devuelve la longitud. */
+static size_t encode_req(gen_t *g, load_mode_t mode, uint8_t *out){
+    if (mode == MODE_TEXT){
+        size_t n = gen_line(g, (char *)out, LOAD_REQ_MAX - 1);
+        out[n++] = '\n';
+        return n;
+    }
+    out[0] = 0x00;
+    out[1] = (mode == MODE_JSON) ? SERVE_REQ_JSON : 0;
+    out[2] = 0;
+    out[3] = HERMES_FRAME_BYTES;
+    gen_frame(g, out + 4);
+    return 4 + HERMES_FRAME_BYTES;
+}
+
+static int write_all(int fd, const uint8_t *p, size_t n){
+    while (n){
+        ssize_t r = write(fd, p, n);
+        if (r < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+/*
+ * Consume las respuestas completas de rx. Devuelve cuantas; cuenta en *err
+ * las de error y deja en *used los bytes consumidos.
+ */
+static size_t parse_responses(const uint8_t *rx, size_t len, size_t *used, size_t *err){
+    size_t pos = 0, n = 0;
+    while (pos < len){
+        if (rx[pos] == 0x00){
+            if (len - pos < 4) break;
+            size_t blen = ((size_t)rx[pos + 2] << 8) | rx[pos + 3];
+            if (len - pos < 4 + blen) break;
+            *err += rx[pos + 1] != 0;
+            pos += 4 + blen;
+        } else {
+            const uint8_t *nl = memchr(rx + pos, '\n', len - pos);
+            if (!nl) break;
+            size_t llen = (size_t)(nl - (rx + pos));
+            *err += memmem(rx + pos, llen, "\"error\"", 7) != NULL;
+            pos += llen + 1;
+        }
+        n++;
+    }
+    *used = pos;
+    return n;
+}
+
+static void *client_main(void *arg){
+    client_t *c = arg;
+    const load_cfg_t *cfg = c->cfg;
+
+    uint8_t *pool = malloc((size_t)LOAD_POOL * LOAD_REQ_MAX);
+    size_t  *plen = malloc(LOAD_POOL * sizeof(*plen));
+    uint8_t *tx = malloc(cfg->pipeline * LOAD_REQ_MAX);
+    uint8_t *rx = malloc(LOAD_RX_BYTES);
+    uint64_t *sent = malloc(cfg->pipeline * sizeof(*sent));   // anillo de instantes de envio
+    int fd = -1;
+
+    if (!pool || !plen || !tx || !rx || !sent) goto fail;
+
+    gen_t g;
+    gen_init(&g, cfg->kind, cfg->seed + (uint64_t)c->id);
+    for (size_t i = 0; i < LOAD_POOL; i++) plen[i] = encode_req(&g, cfg->mode, pool + i * LOAD_REQ_MAX);
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", cfg->path);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) goto fail;
+
+    size_t next = 0, rx_len = 0;
+    while (c->done < cfg->requests){
+        /* Rellena la ventana */
+        size_t txn = 0;
+        uint64_t t = now_ns();
+        while (next < cfg->requests && next - c->done < cfg->pipeline){
+            size_t k = next % LOAD_POOL;
+            memcpy(tx + txn, pool + k * LOAD_REQ_MAX, plen[k]);
+            txn += plen[k];
+            sent[next % cfg->pipeline] = t;
+            next++;
+        }
+        if (txn && write_all(fd, tx, txn) != 0) goto fail;
+
+        ssize_t r = read(fd, rx + rx_len, LOAD_RX_BYTES - rx_len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) goto fail;
+        rx_len += (size_t)r;
+
+        size_t used;
+        size_t got = parse_responses(rx, rx_len, &used, &c->errors);
+        t = now_ns();
+        for (size_t i = 0; i < got; i++, c->done++){
+            c->lat_ns[c->done] = t - sent[c->done % cfg->pipeline];
+        }
+        memmove(rx, rx + used, rx_len - used);
+        rx_len -= used;
+    }
+    goto out;
+
+fail:
+    c->failed = 1;
+out:
+    if (fd >= 0) close(fd);
+    free(pool);
+    free(plen);
+    free(tx);
+    free(rx);
+    free(sent);
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b){
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double pct_us(const uint64_t *v, size_t n, double p){
+    if (!n) return 0.0;
+    size_t i = (size_t)(p * (double)(n - 1) + 0.5);
+    return (double)v[i] / 1000.0;
+}
+
+static void load_usage(const char *prog){
+    fprintf(stderr,
+        "Uso: %s --socket <ruta> [--clients N] [--requests N] [--pipeline N]\n"
+        "          [--mode text|bin|json] [--kind random|worst|fleet] [--seed S]\n"
+        "  --requests es por cliente (defecto 20000); --pipeline = peticiones en vuelo.\n",
+        prog);
+}
+
+int main(int argc, char **argv){
+    load_cfg_t cfg = { .mode = MODE_TEXT, .kind = GEN_RANDOM, .seed = 1, .requests = 20000, .pipeline = 1 };
+    int nclients = 1;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc){
+            cfg.path = argv[++i];
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc){
+            nclients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--requests") == 0 && i + 1 < argc){
+            cfg.requests = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc){
+            cfg.pipeline = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            cfg.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--kind") == 0 && i + 1 < argc){
+            int k = gen_kind_parse(argv[++i]);
+            if (k < 0){
+                load_usage(argv[0]);
+                return 1;
+            }
+            cfg.kind = (gen_kind_t)k;
+        } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc){
+            const char *m = argv[++i];
+            if (strcmp(m, "text") == 0) cfg.mode = MODE_TEXT;
+            else if (strcmp(m, "bin") == 0) cfg.mode = MODE_BIN;
+            else if (strcmp(m, "json") == 0) cfg.mode = MODE_JSON;
+            else {
+                load_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            load_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!cfg.path || nclients < 1 || cfg.requests == 0 || cfg.pipeline == 0){
+        load_usage(argv[0]);
+        return 1;
+    }
+
+    size_t total = (size_t)nclients * cfg.requests;
+    uint64_t *lat = malloc(total * sizeof(*lat));
+    client_t *cl = calloc((size_t)nclients, sizeof(*cl));
+    pthread_t *tid = calloc((size_t)nclients, sizeof(*tid));
+    if (!lat || !cl || !tid){
+        fprintf(stderr, "Sin memoria.\n");
+        return 1;
+    }
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < nclients; i++){
+        cl[i] = (client_t){ .cfg = &cfg, .id = i, .lat_ns = lat + (size_t)i * cfg.requests };
+        if (pthread_create(&tid[i], NULL, client_main, &cl[i]) != 0){
+            fprintf(stderr, "No se pudo crear el cliente %d.\n", i);
+            return 1;
+        }
+    }
+
+    size_t done = 0, errors = 0;
+    int failed = 0;
+    for (int i = 0; i < nclients; i++){
+        pthread_join(tid[i], NULL);
+        failed |= cl[i].failed;
+        errors += cl[i].errors;
+        /* compacta las latencias validas al principio */
+        memmove(lat + done, cl[i].lat_ns, cl[i].done * sizeof(*lat));
+        done += cl[i].done;
+    }
+    double secs = (double)(now_ns() - t0) * 1e-9;
+
+    if (failed) fprintf(stderr, "Algún cliente perdió la conexión con %s.\n", cfg.path);
+
+    qsort(lat, done, sizeof(*lat), cmp_u64);
+    printf("mode,clients,pipeline,requests,errors,seconds,req_per_s,p50_us,p90_us,p99_us,p999_us,max_us\n");
+    printf("%s,%d,%zu,%zu,%zu,%.3f,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+           MODE_NAMES[cfg.mode], nclients, cfg.pipeline, done, errors, secs,
+           (double)done / secs,
+           pct_us(lat, done, 0.50), pct_us(lat, done, 0.90), pct_us(lat, done, 0.99),
+           pct_us(lat, done, 0.999), done ? (double)lat[done - 1] / 1000.0 : 0.0);
+
+    free(lat);
+    free(cl);
+    free(tid);
+    return failed ? 1 : 0;
+}
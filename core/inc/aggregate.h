@@ -0,0 +1,70 @@
+#ifndef HERMES_AGGREGATE_H
+#define HERMES_AGGREGATE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "frame.h"
+#include "record.h"
+#include "regmap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * --aggregate: distribucion de la flota en una pasada, sin salida por trama.
+ *
+ * Todos los campos de regmap.def caben en un registro (width <= 8), asi que
+ * basta un histograma de 256 contadores por registro: el de cada campo se
+ * obtiene al final sumando los valores de byte que comparten sus bits. Por
+ * trama son 55 incrementos, sin extraer campos ni llamar a decode_config().
+ * Ademas: tramas con algun bit RESERVED y, por preset y etapa TH, un
+ * histograma del nivel (L1..L8 de 5 bits, L9..L12 de 8) y min/max/suma del
+ * tiempo acumulado.
+ *
+ * Cada hilo acumula en el suyo (aggregate_thread) y al terminar se suman.
+ */
+
+typedef struct hermes_agg {
+    uint64_t frames;
+    uint64_t reserved;                       // tramas con algun RESERVED != 0
+    uint64_t skipped;                        // volcados de eco (no son registros)
+    uint64_t reg[REGMAP_NUM_REGS][256];      // histograma de cada byte REG1..REG55
+    uint64_t level[2][HERMES_TH_STAGES][256];
+    uint32_t t_min[2][HERMES_TH_STAGES];
+    uint32_t t_max[2][HERMES_TH_STAGES];
+    uint64_t t_sum[2][HERMES_TH_STAGES];
+
+    struct hermes_agg *registry_next;
+} hermes_agg_t;
+
+hermes_agg_t *aggregate_new(void);
+void aggregate_free(hermes_agg_t *a);
+
+/* Acumula una trama (fr->nbytes >= ECHO_FRAME_BYTES cuenta como volcado) */
+void aggregate_frame(hermes_agg_t *a, const hermes_frame_t *fr);
+
+/* dst += src */
+void aggregate_merge(hermes_agg_t *dst, const hermes_agg_t *src);
+
+/* Acumulador del hilo actual (creado en la primera llamada) */
+hermes_agg_t *aggregate_thread(void);
+
+/* Suma de los acumuladores de todos los hilos en dst / liberacion al final */
+void aggregate_thread_merge(hermes_agg_t *dst);
+void aggregate_thread_free_all(void);
+
+/*
+ * Informe: RECORD_TEXT (tabla compacta: por campo, valores distintos,
+ * min/max/media y los mas frecuentes; RESERVED por registro; umbrales TH)
+ * o RECORD_NDJSON (un objeto JSON con los histogramas completos).
+ */
+int aggregate_report(FILE *out, const hermes_agg_t *a, record_format_t fmt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_AGGREGATE_H
@@ -0,0 +1,142 @@
+#ifndef HERMES_ARCHIVE_H
+#define HERMES_ARCHIVE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Archivo columnar de tramas decodificadas (--archive <fichero>).
+ *
+ * Las tramas se agrupan por numero (seq) en bloques de hasta
+ * ARCHIVE_GROUP_ROWS filas, igual con uno o varios hilos (ordenadas por
+ * dispositivo y frame_id dentro del bloque, para que la configuracion de
+ * cada equipo quede en rachas) y cada bloque se guarda columna a columna:
+ *
+ *   frame_id, offset, timestamp_us, prefix           metadatos
+ *   <REG>.<CAMPO>                                    cada campo de regmap.def
+ *   <REG>                                            registros sin campos
+ *                                                    (Px_THR_6..10, byte entero)
+ *
+ * Con eso se reconstruyen los 55 registros bit a bit. "device" es un alias
+ * de PULSE_P2.UART_ADDR. Cada trozo de columna usa la codificacion mas
+ * pequena de: bit-packing sobre el minimo (FOR), deltas empaquetadas, RLE o
+ * diccionario + indices empaquetados.
+ *
+ * Layout (little-endian):
+ *   cabecera: "HRMSARC1", u32 version, u32 ncols,
+ *             ncols x { u8 len, nombre, u8 reg_idx (0 = meta), u8 lsb, u8 width }
+ *   datos:    trozos de columna, bloque a bloque
+ *   indice:   u32 ngroups, ngroups x { u32 nrows,
+ *             ncols x { u64 off, u32 size, u8 enc, u64 min, u64 max } }
+ *   cola:     u64 offset del indice, "HRMSARC1"
+ *
+ * El lector hace mmap del fichero y solo toca los trozos de las columnas que
+ * se piden; min/max por trozo permite saltar bloques enteros.
+ */
+
+#define ARCHIVE_MAGIC       "HRMSARC1"   // primeros y ultimos 8 bytes del fichero
+#define ARCHIVE_GROUP_ROWS  65536u
+#define ARCHIVE_NAME_MAX    40
+
+/* Columnas de metadatos (siempre las primeras, en este orden) */
+enum {
+    ARCHIVE_COL_FRAME_ID = 0,
+    ARCHIVE_COL_OFFSET,
+    ARCHIVE_COL_TIMESTAMP,
+    ARCHIVE_COL_PREFIX,
+    ARCHIVE_NUM_META
+};
+
+/* Codificaciones de un trozo de columna */
+enum {
+    ARCHIVE_ENC_FOR = 0,    // u8 bits, varint base, (v - base) empaquetado
+    ARCHIVE_ENC_DELTA,      // varint primero, zigzag min delta, u8 bits, deltas
+    ARCHIVE_ENC_RLE,        // (varint valor, varint repeticiones)...
+    ARCHIVE_ENC_DICT,       // varint n, n varints, u8 bits, indices empaquetados
+    ARCHIVE_NUM_ENC
+};
+
+typedef struct {
+    char    name[ARCHIVE_NAME_MAX];
+    uint8_t reg_idx;        // 1..55, 0 en metadatos
+    uint8_t lsb;
+    uint8_t width;          // bits del valor
+} archive_col_t;
+
+typedef struct {
+    uint64_t off;           // offset del trozo en el fichero
+    uint32_t size;
+    uint8_t  enc;           // ARCHIVE_ENC_*
+    uint64_t min, max;
+} archive_chunk_t;
+
+/* ------------------ escritura ------------------ */
+typedef struct archive_writer archive_writer_t;
+
+typedef struct {
+    uint64_t rows;
+    uint64_t groups;
+    uint64_t bytes;          // tamano final del fichero
+    uint64_t col_bytes[ARCHIVE_NUM_ENC];   // bytes de datos por codificacion
+} archive_stats_t;
+
+/* Crea path con la cabecera del esquema actual. NULL si no se puede. */
+archive_writer_t *archive_create(const char *path);
+
+/*
+ * Anade una trama (thread-safe, en cualquier orden): va al bloque
+ * (seq - 1) / ARCHIVE_GROUP_ROWS, asi que seq debe ser 1..N sin repetir. Un
+ * bloque completo se codifica fuera del cerrojo. 0 o -1 (seq repetido, sin
+ * memoria o fallo al escribir un bloque).
+ */
+int archive_add(archive_writer_t *w, const hermes_frame_t *fr);
+
+/* Vuelca el ultimo bloque, escribe el indice y cierra. 0 o -1. */
+int archive_finish(archive_writer_t *w, archive_stats_t *st);
+
+/* ------------------ lectura (mmap) ------------------ */
+typedef struct archive archive_t;
+
+/* NULL si no existe o no es un archivo valido (motivo en stderr) */
+archive_t *archive_open(const char *path);
+void       archive_close(archive_t *a);
+
+uint64_t archive_rows(const archive_t *a);
+int      archive_num_groups(const archive_t *a);
+uint32_t archive_group_rows(const archive_t *a, int g);
+int      archive_num_cols(const archive_t *a);
+const archive_col_t *archive_col(const archive_t *a, int c);
+
+/* Columna por nombre: "DEADTIME.PULSE_DT", "PULSE_DT" si es unico, "device"... -1 si no */
+int archive_find_col(const archive_t *a, const char *name);
+
+void archive_chunk(const archive_t *a, int g, int c, archive_chunk_t *ch);
+
+/* Decodifica la columna c del bloque g en out[archive_group_rows(g)]. 0 o -1 (corrupto). */
+int archive_read_col(const archive_t *a, int g, int c, uint64_t *out);
+
+/*
+ * Reconstruye las tramas de 57 bytes del bloque g en frames (fila a fila);
+ * frame_id/offset/ts pueden ser NULL. 0 o -1.
+ */
+int archive_read_frames(const archive_t *a, int g, uint8_t (*frames)[HERMES_FRAME_BYTES],
+                        uint64_t *frame_id, uint64_t *offset, uint64_t *ts);
+
+/* Todas las tramas en hex, una por linea, por frame_id dentro de cada bloque (--archive-cat). 0 o -1. */
+int archive_write_hex(FILE *out, const archive_t *a);
+
+/* Esquema y tamanos por columna (--archive-info) */
+void archive_print_info(FILE *out, const archive_t *a);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_ARCHIVE_H
@@ -0,0 +1,46 @@
+#ifndef HERMES_BATCH_H
+#define HERMES_BATCH_H
+
+#include <stdio.h>
+
+#include "config.h"
+#include "frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Export por lotes (--batch-export): en lugar de 6 ficheros por trama, todas
+ * las tramas se anexan a un unico fichero por tipo de perfil:
+ *
+ *   <prefix>_p1_profile.csv    <prefix>_p1_profile.ndjson
+ *   <prefix>_p2_profile.csv    <prefix>_p2_profile.ndjson
+ *   <prefix>_tvg_profile.csv   <prefix>_tvg_profile.ndjson
+ *
+ * Cada fila (CSV) o linea (NDJSON) lleva frame_id, offset, device y prefix.
+ * Los ficheros usan buffers grandes. Con ordered (--threads) las tramas se
+ * escriben en orden de seq aunque lleguen de varios workers: la de turno va
+ * directa a los ficheros y las que se adelantan esperan en memoria, como los
+ * chunks de parallel_run(). Sin ordered se escriben segun llegan.
+ */
+
+typedef struct batch_export batch_export_t;
+
+/*
+ * Abre los ficheros pedidos (csv / json). ordered: varios hilos y seq 1..N
+ * sin repetir. NULL si alguno no se puede crear.
+ */
+batch_export_t *batch_export_open(const char *prefix, int csv, int json, int ordered);
+
+/* Anexa los perfiles de una trama. 0 o -1 si fallo alguna escritura. */
+int batch_export_frame(batch_export_t *bx, const hermes_frame_t *fr, const hermes_config_t *cfg);
+
+/* Vuelca y cierra; lista en report los ficheros (OK/ERR). 0 o -1. */
+int batch_export_close(batch_export_t *bx, FILE *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_BATCH_H
@@ -0,0 +1,60 @@
+#ifndef HERMES_BINSTREAM_H
+#define HERMES_BINSTREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Entrada binaria (--input-format): capturas del firmware sin pasar a hex.
+ *
+ *   INPUT_BIN     registros fijos de HERMES_FRAME_BYTES (prefijo + REG1..55)
+ *   INPUT_BINLEN  registros [len u16 big-endian][len bytes], como el cuerpo
+ *                 de las peticiones binarias de --serve; admite longitudes
+ *                 variables (p.ej. volcados de eco de --echo)
+ *
+ * El fichero se mapea completo y cada trama es una vista (hermes_frame_t.reg)
+ * dentro del mmap: no hay parseo ni copia. offset es el del registro
+ * (cabecera incluida) y las "lineas" de stream_stats_t son registros.
+ */
+
+typedef enum {
+    INPUT_HEX = 0,
+    INPUT_BIN,
+    INPUT_BINLEN,
+} input_format_t;
+
+#define BINLEN_HDR_BYTES  2
+#define BIN_INCOMPLETE    (-4)   // bin_record(): el fichero termina dentro del registro
+
+/* "hex" / "bin" / "binlen" -> input_format_t, -1 si no existe */
+int input_format_parse(const char *s);
+
+/*
+ * Registro en pos: *payload = primer byte de la trama, *len = bytes de la
+ * trama y *next = inicio del siguiente. LINE_OK, LINE_SHORT (len < 57) o
+ * BIN_INCOMPLETE.
+ */
+int bin_record(const uint8_t *map, size_t size, size_t pos, input_format_t fmt,
+               size_t *payload, size_t *len, size_t *next);
+
+/*
+ * Recorre path (mmap) y llama a cb por trama. Con nthreads > 1 reparte
+ * bloques de registros entre hilos y vuelca su salida en el orden original
+ * (misma salida que con un hilo). Errores por stderr y en st->errors.
+ * path debe ser un fichero regular (un FIFO es error, no una entrada vacía).
+ * 0 o -1 (fichero/memoria/hilos).
+ */
+int bin_run(const char *path, input_format_t fmt, int nthreads, frame_cb cb, void *user,
+            stream_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_BINSTREAM_H
@@ -0,0 +1,73 @@
+#ifndef HERMES_CONFIG_H
+#define HERMES_CONFIG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HERMES_TH_STAGES     12
+#define HERMES_TVG_STAGES    6
+#define HERMES_TVG_GAINS     5
+#define HERMES_TVG_GAIN_MAX  63
+
+/* Perfil de umbrales de un preset (P1 o P2), ya acumulado */
+typedef struct {
+    int32_t  delta_us[HERMES_TH_STAGES];  // T1..T12 (TIME_US[nibble])
+    int32_t  t_us[HERMES_TH_STAGES];      // tiempo acumulado
+    double   dist_cm[HERMES_TH_STAGES];   // tof_us_to_cm(t_us)
+    double   pct[HERMES_TH_STAGES];       // value_to_pct(stage, level)
+    uint8_t  t_code[HERMES_TH_STAGES];    // nibble de tiempo crudo
+    uint8_t  level[HERMES_TH_STAGES];     // L1..L8 (5b), L9..L12 (8b)
+    uint8_t  thr_off;                     // Px_THR_15 (reservado/offset)
+} hermes_th_t;
+
+/* Perfil TVG (T0..T5, G1..G5; el último tramo mantiene G5) */
+typedef struct {
+    int32_t  delta_us[HERMES_TVG_STAGES];
+    int32_t  t_us[HERMES_TVG_STAGES];
+    double   dist_cm[HERMES_TVG_STAGES];
+    double   gain_pct[HERMES_TVG_STAGES];
+    uint8_t  gain_raw[HERMES_TVG_STAGES]; // ganancia aplicada en cada tramo
+    uint8_t  t_code[HERMES_TVG_STAGES];
+    uint8_t  g[HERMES_TVG_GAINS];         // G1..G5 (6b, G2/G3 partidos)
+    uint8_t  reserved;                    // TVGAIN6 b1
+    uint8_t  freq_shift;                  // TVGAIN6 b0
+} hermes_tvg_t;
+
+/*
+ * Trama decodificada una sola vez. Todos los printers/exporters leen de aqui,
+ * de modo que la extraccion de bits se hace una vez por trama.
+ */
+typedef struct {
+    uint8_t reg[55];          // REG1..REG55 tal cual
+
+    /* INIT_GAIN .. TEMP_TRIM (REG8..REG21) */
+    uint8_t bpf_bw, gain_init;
+    uint8_t freq;
+    uint8_t thr_cmp_deglitch, pulse_dt;
+    uint8_t io_if_sel, uart_diag, io_dis, p1_pulse;
+    uint8_t uart_addr, p2_pulse;
+    uint8_t dis_cl, curr_lim_reserved, curr_lim1;
+    uint8_t lpf_co, curr_lim2;
+    uint8_t p1_rec, p2_rec;
+    uint8_t fdiag_len, fdiag_start;
+    uint8_t fdiag_err_th, sat_th, p1_nls_en;
+    uint8_t p2_nls_en, vpwr_ov_th, lmp_tmr, fvolt_err_th;
+    uint8_t afe_gain_rng, lpm_en, decpl_temp_sel, decpl_t;
+    uint8_t noise_lvl, scale_k, scale_n;
+    uint8_t temp_gain, temp_off;
+
+    /* P1_GAIN_CTRL / P2_GAIN_CTRL (REG22..REG23), [0]=P1 [1]=P2 */
+    uint8_t dig_gain_lr_st[2], dig_gain_lr[2], dig_gain_sr[2];
+
+    hermes_tvg_t tvg;         // REG1..REG7
+    hermes_th_t  th[2];       // [0]=P1 (REG24..39), [1]=P2 (REG40..55)
+} hermes_config_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_CONFIG_H
@@ -0,0 +1,83 @@
+#ifndef HERMES_CURVE_H
+#define HERMES_CURVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Curvas TH P1/P2 y TVG evaluadas en una rejilla de distancias (--curves).
+ *
+ * Los exports solo dan los 12 puntos TH y los 6 tramos TVG; aqui se obtiene
+ * el valor (% de escala, como value_pct/gain_pct) en cada punto de una
+ * rejilla arbitraria en cm, para muchas configuraciones a la vez:
+ *
+ *   CURVE_STEP    TH: L1 hasta el punto 1, Lk desde el punto k (se mantiene
+ *                 L12 al final). TVG: el escalon de plot_tvg()/render.
+ *   CURVE_LINEAR  TH: rectas entre puntos como en las graficas (L1 antes
+ *                 del primero, L12 despues del ultimo). TVG sigue en escalon.
+ *
+ * Los puntos de ruptura son dist_cm de cada etapa (tof_us_to_cm). La
+ * evaluacion recorre los puntos con compare + blend sobre 8 (AVX2) o 4
+ * (SSE2) distancias a la vez, elegido en tiempo de ejecucion; el resultado
+ * es identico bit a bit al escalar.
+ */
+
+typedef enum {
+    CURVE_P1  = 0,
+    CURVE_P2  = 1,
+    CURVE_TVG = 2,
+    CURVE_NUM_KINDS
+} curve_kind_t;
+
+typedef enum {
+    CURVE_STEP = 0,
+    CURVE_LINEAR,
+} curve_interp_t;
+
+/* Puntos de ruptura de una curva (x en cm, no decreciente) */
+#define CURVE_MAX_POINTS HERMES_TH_STAGES
+
+typedef struct {
+    int   n;
+    float x[CURVE_MAX_POINTS];
+    float v[CURVE_MAX_POINTS];
+} curve_table_t;
+
+void curve_table(const hermes_config_t *cfg, curve_kind_t kind, curve_table_t *t);
+
+/* out[i] = curva en grid[i] (cm), i < n */
+void curve_eval(const curve_table_t *t, curve_interp_t interp, const float *grid, size_t n, float *out);
+
+/* Lote: out[f * ngrid + i] para cada cfgs[f] (matriz densa por filas) */
+void curve_eval_batch(const hermes_config_t *cfgs, size_t ncfg, curve_kind_t kind, curve_interp_t interp,
+                      const float *grid, size_t ngrid, float *out);
+
+/* Referencia escalar (comprobaciones del bench) */
+void curve_eval_scalar(const curve_table_t *t, curve_interp_t interp, const float *grid, size_t n, float *out);
+
+/* "avx2", "sse2" o "scalar": implementacion elegida en esta CPU */
+const char *curve_impl(void);
+
+/* "p1" | "p2" | "tvg" -> CURVE_*, o -1 */
+int curve_kind_parse(const char *s);
+const char *curve_kind_name(curve_kind_t kind);
+
+/* "step" | "linear" -> CURVE_*, o -1 */
+int curve_interp_parse(const char *s);
+
+/* TVG es un escalon tambien en CURVE_LINEAR (como se dibuja) */
+static inline curve_interp_t curve_kind_interp(curve_kind_t kind, curve_interp_t interp){
+    return kind == CURVE_TVG ? CURVE_STEP : interp;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_CURVE_H
@@ -0,0 +1,69 @@
+#ifndef HERMES_CURVEIO_H
+#define HERMES_CURVEIO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+#include "export.h"
+#include "curve.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Parte de --curves que solo usa la CLI: rejilla desde texto o fichero y
+ * escritura de la matriz CSV/binaria. Reserva memoria y hace stdio, asi que
+ * no entra en libhermes (que solo enlaza los kernels de curve.c).
+ */
+
+/* Rejilla maxima (puntos) */
+#define CURVE_GRID_MAX  (1u << 20)
+
+/*
+ * Rejilla "desde:paso:hasta[cm|us]" (ambos extremos incluidos) o fichero con
+ * una distancia por linea/espacio (cada una con sufijo cm o us opcional).
+ * Los tiempos se pasan a cm con tof_us_to_cm. *grid es de malloc.
+ * 0 o -1 con el motivo en err.
+ */
+int curve_grid_parse(const char *spec, float **grid, size_t *n, char *err, size_t errcap);
+
+/*
+ * Matriz de salida:
+ *
+ * CSV: cabecera "frame_id,offset,device,curve,<x0>,<x1>,..." (x en cm) y una
+ * fila por trama y curva con los valores en % (2 decimales).
+ *
+ * Binario (little-endian, para np.fromfile):
+ *   cabecera: "HRMSCRV1", u32 version, u32 ngrid, u32 curvas (bits 1<<CURVE_*),
+ *             u32 interp, f32 grid[ngrid]
+ *   filas:    u64 frame_id, u64 offset, u32 curve, u32 device, f32 v[ngrid]
+ */
+#define CURVE_BIN_MAGIC    "HRMSCRV1"
+#define CURVE_BIN_VERSION  1
+
+typedef struct {
+    const float   *grid;
+    size_t         ngrid;
+    unsigned       kinds;     // bits 1u << CURVE_*
+    curve_interp_t interp;
+    int            binary;
+} curve_out_t;
+
+int curve_write_header(FILE *f, const curve_out_t *co);
+
+/*
+ * Filas de una trama (una por curva de co->kinds). 0 o -1. Thread-safe:
+ * cada hilo reutiliza sus buffers de fila, que se liberan todos juntos con
+ * curve_rows_free_all() cuando los hilos han terminado.
+ */
+int curve_write_rows(FILE *f, const curve_out_t *co, const export_key_t *k, const hermes_config_t *cfg);
+void curve_rows_free_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_CURVEIO_H
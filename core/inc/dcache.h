@@ -0,0 +1,78 @@
+#ifndef HERMES_DCACHE_H
+#define HERMES_DCACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cache de decodificacion indexada por hash del bloque reg[55].
+ *
+ * Guarda el hermes_config_t ya decodificado y, bajo demanda, los textos
+ * derivados (decodificacion RAW y ficheros CSV/JSON). Con un acierto no se
+ * vuelve a llamar a decode_config() ni a los writers de export.c.
+ *
+ * Acotada en bytes con expulsion LRU. No es thread-safe: cada hilo usa la
+ * suya (dcache_thread).
+ */
+
+typedef enum {
+    DC_TEXT = 0,     // decode_print_all()
+    DC_P1_CSV,
+    DC_P2_CSV,
+    DC_TVG_CSV,
+    DC_P1_JSON,
+    DC_P2_JSON,
+    DC_TVG_JSON,
+    DC_NUM_FRAGS
+} dcache_frag_t;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t frag_hits;      // fragmentos servidos ya renderizados
+    uint64_t frag_renders;   // fragmentos renderizados
+    size_t   bytes;          // memoria en uso
+    size_t   entries;
+} dcache_stats_t;
+
+typedef struct dcache dcache_t;
+typedef struct dcache_entry dcache_entry_t;
+
+dcache_t *dcache_new(size_t max_bytes);
+void      dcache_free(dcache_t *c);
+
+/*
+ * Config decodificada de reg (de la cache o recien decodificada). *e sirve
+ * para pedir fragmentos y es valido hasta la siguiente llamada a
+ * dcache_lookup() sobre la misma cache. NULL solo si no hay memoria.
+ */
+const hermes_config_t *dcache_lookup(dcache_t *c, const uint8_t reg[55], dcache_entry_t **e);
+
+/* Fragmento de texto de la entrada (se renderiza la primera vez). NULL si no hay memoria. */
+const char *dcache_fragment(dcache_t *c, dcache_entry_t *e, dcache_frag_t kind, size_t *len);
+
+void dcache_get_stats(const dcache_t *c, dcache_stats_t *st);
+
+/* Cache del hilo actual (creada en la primera llamada con max_bytes) */
+dcache_t *dcache_thread(size_t max_bytes);
+
+/* Suma de estadisticas de todas las caches de hilo / liberacion al final */
+void dcache_thread_stats(dcache_stats_t *st);
+void dcache_thread_free_all(void);
+
+/* Hash de 64 bits del bloque de registros */
+uint64_t dcache_hash(const uint8_t reg[55]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_DCACHE_H
@@ -1,6 +1,31 @@
-#ifndef HERMES_DECODER_H
-#define HERMES_DECODER_H
-
-void decode_reg(const uint8_t reg[55], int idx /*1..55*/, uint8_t b);
-
+#ifndef HERMES_DECODER_H
+#define HERMES_DECODER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "config.h"
+
+/* Una sola pasada: extrae todos los campos y perfiles TH/TVG de REG1..REG55 */
+void decode_config(const uint8_t reg[55], hermes_config_t *cfg);
+
+/* Mascaras de registros cambiados: bit (idx - 1) = REGidx */
+#define DECODE_REGS_ALL    ((1ull << 55) - 1)
+#define DECODE_REGS_TVG    ((1ull << 7) - 1)                 // REG1..REG7
+#define DECODE_REGS_TH_P1  (((1ull << 16) - 1) << 23)        // REG24..REG39
+#define DECODE_REGS_TH_P2  (((1ull << 16) - 1) << 39)        // REG40..REG55
+
+/*
+ * Decodificacion incremental: cfg ya contiene la trama anterior y reg la
+ * nueva; solo se re-extraen los registros de changed y se recalculan los
+ * perfiles TH/TVG a los que afectan.
+ */
+void decode_config_update(const uint8_t reg[55], uint64_t changed, hermes_config_t *cfg);
+
+/* Imprime en out el registro idx (1..55) ya decodificado en cfg */
+void decode_reg(FILE *out, const hermes_config_t *cfg, int idx /*1..55*/);
+
+/* Decodificacion RAW completa: "[NN]" + decode_reg() para REG1..REG55 */
+void decode_print_all(FILE *out, const hermes_config_t *cfg);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef HERMES_DIFF_H
+#define HERMES_DIFF_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Modo --diff: guarda la ultima trama decodificada de cada dispositivo y,
+ * para cada trama nueva, solo re-decodifica e imprime los registros/campos
+ * que han cambiado y las etapas TH/TVG afectadas.
+ *
+ * El estado depende del orden de las tramas: no es thread-safe.
+ */
+
+typedef enum {
+    DIFF_KEY_UART = 0,   // PULSE_P2.UART_ADDR
+    DIFF_KEY_PREFIX,     // prefijo/modo de la trama
+} diff_key_t;
+
+typedef struct diff_state diff_state_t;
+
+diff_state_t *diff_new(diff_key_t key);
+void diff_free(diff_state_t *ds);
+
+/* Registros distintos entre a y b: bit (idx - 1) = REGidx */
+uint64_t diff_regs(const uint8_t a[55], const uint8_t b[55]);
+
+/*
+ * Decodifica fr contra la trama anterior de su dispositivo e imprime en out
+ * los cambios (o la decodificacion completa si es la primera). Devuelve la
+ * configuracion completa ya actualizada (valida hasta la siguiente llamada)
+ * o NULL si no hay memoria.
+ */
+const hermes_config_t *diff_frame(diff_state_t *ds, FILE *out, const hermes_frame_t *fr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_DIFF_H
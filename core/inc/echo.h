@@ -0,0 +1,87 @@
+#ifndef HERMES_ECHO_H
+#define HERMES_ECHO_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "frame.h"
+#include "curve.h"
+#include "record.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Volcados de eco del PGA460 (--echo): en la misma entrada que las tramas de
+ * configuracion, una linea con el prefijo y las 128 muestras de 8 bits:
+ *
+ *   [0..1]    prefijo; el nibble bajo de [1] es el dispositivo (UART_ADDR)
+ *   [2..129]  muestras (ECHO_DATA_DUMP)
+ *
+ * Una linea de ECHO_FRAME_BYTES o mas es un volcado; las demas son tramas de
+ * configuracion y actualizan la ultima configuracion de su dispositivo
+ * (PULSE_P2.UART_ADDR). Cada volcado se compara con la curva TH del preset
+ * elegido de esa configuracion:
+ *
+ *   - umbral en la escala de 8 bits de las muestras: L1..L8 << 3, L9..L12
+ *   - muestra i en t = i * 4096 * (Px_REC + 1) / 128 us, distancia con
+ *     tof_us_to_cm; la curva (escalon o lineal) es la de --curves
+ *   - cruce: muestra > umbral. Primer y ultimo cruce, numero de cruces, y
+ *     el margen: max(muestra - umbral) (negativo si no hay cruce) con su
+ *     muestra. La distancia del objeto es la del primer cruce.
+ *
+ * El umbral por muestra se calcula una vez por configuracion; cada volcado
+ * solo hace las comparaciones, con SSE2/AVX2 elegido en tiempo de ejecucion.
+ * El estado depende del orden de las lineas: no es thread-safe.
+ */
+
+#define ECHO_SAMPLES      128
+#define ECHO_FRAME_BYTES  (HERMES_PREFIX_BYTES + ECHO_SAMPLES)
+#define ECHO_DEVICES      16
+
+typedef struct {
+    int crossings;         // muestras por encima del umbral
+    int first, last;       // primera/ultima muestra que cruza, -1 si ninguna
+    int margin;            // max(muestra - umbral)
+    int margin_sample;     // primera muestra con ese margen
+} echo_result_t;
+
+/* Umbral de 8 bits en cada muestra y paso entre muestras (us) */
+int echo_threshold(const hermes_config_t *cfg, int is_p2, curve_interp_t interp, uint8_t thr[ECHO_SAMPLES]);
+
+void echo_analyze(const uint8_t samples[ECHO_SAMPLES], const uint8_t thr[ECHO_SAMPLES], echo_result_t *r);
+
+/* Referencia escalar (comprobaciones del bench) */
+void echo_analyze_scalar(const uint8_t samples[ECHO_SAMPLES], const uint8_t thr[ECHO_SAMPLES], echo_result_t *r);
+
+/* "avx2", "sse2" o "scalar" */
+const char *echo_impl(void);
+
+/* ------------------ modo --echo ------------------ */
+typedef struct echo_state echo_state_t;
+
+typedef struct {
+    uint64_t dumps;        // volcados analizados
+    uint64_t configs;      // tramas de configuracion
+    uint64_t unpaired;     // volcados sin configuracion de su dispositivo
+    uint64_t detected;     // volcados con algun cruce
+} echo_stats_t;
+
+echo_state_t *echo_new(int is_p2, curve_interp_t interp, record_format_t fmt);
+void echo_free(echo_state_t *es);
+
+/*
+ * Una linea ya parseada: configuracion (se guarda, sin salida) o volcado
+ * (una linea de resultado en out, texto o NDJSON). 0 o -1.
+ */
+int echo_frame(echo_state_t *es, FILE *out, const hermes_frame_t *fr);
+
+void echo_get_stats(const echo_state_t *es, echo_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_ECHO_H
@@ -0,0 +1,79 @@
+#ifndef HERMES_ENCODER_H
+#define HERMES_ENCODER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+#include "frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Encoder: la inversa de decoder.c. Construye tramas de 57 bytes a partir de
+ * perfiles TH/TVG y campos con nombre (barridos de calibracion, pruebas).
+ *
+ * Claves de un registro de entrada (columna CSV o miembro JSON):
+ *   prefix                  prefijo de la trama (defecto: el de la base)
+ *   base, reg               trama (57 bytes) o REG1..REG55 en hex de partida
+ *   <REG>                   byte completo, p.ej. DEADTIME=0x23
+ *   <REG>.<CAMPO>, <CAMPO>  campo del esquema (regmap.def), valor crudo
+ *   P1_T<k>_US              T1..T12 de P1 (delta, us), cuantizado a TIME_US
+ *   P1_T<k>_AT_US           tiempo acumulado de la etapa k (us)
+ *   P1_L<k>, P1_L<k>_PCT    nivel crudo (L1..L8 5b, L9..L12 8b) o en %
+ *   P2_...                  igual para P2
+ *   TVG_T<k>_US, _AT_US     k = 0..5
+ *   TVG_G<k>, TVG_G<k>_PCT  k = 1..5, ganancia completa de 6 bits
+ *
+ * En NDJSON tambien valen los objetos de --serve (format_frame_json): "reg",
+ * "prefix", "p1"/"p2" [{delta_us, t_us, value_raw, value_pct}] y
+ * "tvg": {"flags": {...}, "points": [{delta_us, t_us, gain_raw, gain_pct}]}.
+ *
+ * Orden de aplicacion: base, registros, campos, tiempos (delta y despues
+ * acumulados), niveles y ganancias. Cada trama se vuelve a decodificar y se
+ * compara con lo pedido (encode_check) antes de emitirla.
+ */
+
+/* Par clave/valor de un registro de entrada (no terminados en '\0') */
+typedef struct {
+    const char *key;
+    size_t      klen;
+    const char *val;
+    size_t      vlen;
+} encode_kv_t;
+
+typedef struct {
+    uint64_t records;   // filas/lineas con datos
+    uint64_t frames;    // tramas emitidas
+    uint64_t errors;    // registros rechazados
+} encode_stats_t;
+
+/* REG1..REG55 a partir de los campos crudos de cfg (inversa de decode_config) */
+void encode_config(const hermes_config_t *cfg, uint8_t reg[55]);
+
+/* Decodifica reg y compara sus campos crudos con want. 0 o -1. */
+int encode_check(const hermes_config_t *want, const uint8_t reg[55]);
+
+/*
+ * Aplica kv sobre base (57 bytes) y deja la trama en out. 0 o -1 con el
+ * motivo en err.
+ */
+int encode_frame(const encode_kv_t *kv, int n, const uint8_t base[HERMES_FRAME_BYTES],
+                 uint8_t out[HERMES_FRAME_BYTES], char *err, size_t errcap);
+
+/*
+ * Lotes: CSV (cabecera con las claves + una fila por trama) o NDJSON (un
+ * objeto por linea), detectado por el primer caracter. Escribe una linea hex
+ * por trama en out ("5E 02 ..."); los registros erroneos se cuentan, se
+ * informan en stderr y se saltan. 0 o -1 (memoria/lectura).
+ */
+int encode_run(FILE *in, FILE *out, const uint8_t base[HERMES_FRAME_BYTES], encode_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_ENCODER_H
@@ -1,23 +1,69 @@
-#ifndef HERMES_EXPORT_H
-#define HERMES_EXPORT_H
-
-#include <stdio.h>
-
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-/* CSV*/
-int write_th_profile_csv(const char *path, const uint8_t reg[55], int is_p2);
-int write_tvg_csv(const char *path, const uint8_t reg[55]);
-
-/*JSON*/
-int write_th_profile_json(const char *path, const uint8_t reg[55], int is_p2);
-int write_tvg_json(const char *path, const uint8_t reg[55]);
-
-#ifdef __cplusplus
-}
-#endif
-
+#ifndef HERMES_EXPORT_H
+#define HERMES_EXPORT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Tamaño maximo de un perfil serializado (CSV o JSON) */
+#define EXPORT_MAX_BYTES 4096
+
+/*
+ * Serializacion en memoria del llamador, sin heap (semantica de snprintf):
+ * buf queda terminado en '\0' (si cap > 0) y se devuelve la longitud
+ * completa sin el; si es >= cap, buf esta truncado.
+ */
+size_t format_th_profile_csv(char *buf, size_t cap, const hermes_config_t *cfg, int is_p2);
+size_t format_tvg_csv(char *buf, size_t cap, const hermes_config_t *cfg);
+size_t format_th_profile_json(char *buf, size_t cap, const hermes_config_t *cfg, int is_p2);
+size_t format_tvg_json(char *buf, size_t cap, const hermes_config_t *cfg);
+
+/* Volcado a un FILE ya abierto (0 o -1 si hubo error de escritura) */
+int fprint_th_profile_csv(FILE *f, const hermes_config_t *cfg, int is_p2);
+int fprint_tvg_csv(FILE *f, const hermes_config_t *cfg);
+int fprint_th_profile_json(FILE *f, const hermes_config_t *cfg, int is_p2);
+int fprint_tvg_json(FILE *f, const hermes_config_t *cfg);
+
+/* Clave de cada fila en el export por lotes (--batch-export) */
+typedef struct {
+    uint64_t frame_id;   // numero de trama (1..N)
+    uint64_t offset;     // offset en bytes de la linea origen
+    uint16_t prefix;     // prefijo/modo de la trama
+    uint8_t  device;     // PULSE_P2.UART_ADDR
+} export_key_t;
+
+/* Lotes: CSV con una fila por etapa y trama, NDJSON con una linea por trama */
+int fprint_th_rows_csv_header(FILE *f);
+int fprint_th_rows_csv(FILE *f, const export_key_t *k, const hermes_config_t *cfg, int is_p2);
+int fprint_tvg_rows_csv_header(FILE *f);
+int fprint_tvg_rows_csv(FILE *f, const export_key_t *k, const hermes_config_t *cfg);
+int fprint_th_ndjson(FILE *f, const export_key_t *k, const hermes_config_t *cfg, int is_p2);
+int fprint_tvg_ndjson(FILE *f, const export_key_t *k, const hermes_config_t *cfg);
+
+/*
+ * Trama completa (registros, P1, P2 y TVG) en una sola linea JSON terminada
+ * en '\n', en memoria del llamador como format_*. Cabe en EXPORT_FRAME_MAX_BYTES.
+ */
+#define EXPORT_FRAME_MAX_BYTES 8192
+size_t format_frame_json(char *buf, size_t cap, const export_key_t *k, const hermes_config_t *cfg);
+
+/* CSV*/
+int write_th_profile_csv(const char *path, const hermes_config_t *cfg, int is_p2);
+int write_tvg_csv(const char *path, const hermes_config_t *cfg);
+
+/*JSON*/
+int write_th_profile_json(const char *path, const hermes_config_t *cfg, int is_p2);
+int write_tvg_json(const char *path, const hermes_config_t *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // HERMES_EXPORT_H
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef HERMES_FRAME_H
+#define HERMES_FRAME_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Layout de la trama: [0..1] prefijo/modo, [2..56] REG1..REG55 */
+#define HERMES_PREFIX_BYTES 2
+#define HERMES_NUM_REGS     55
+#define HERMES_FRAME_BYTES  (HERMES_PREFIX_BYTES + HERMES_NUM_REGS)
+
+typedef struct {
+    uint64_t seq;        // numero de trama (1..N) dentro de la entrada
+    uint64_t offset;     // offset en bytes de la linea origen
+    uint16_t prefix;     // buf[0..1] (p.ej. 0x5E02)
+    int      nbytes;     // bytes parseados de la linea
+    const uint8_t *reg;  // vista de REG1..REG55 (no propietaria)
+} hermes_frame_t;
+
+/* Rellena fr a partir de los bytes parseados. Devuelve 0 o -1 si n < 57. */
+int frame_from_bytes(hermes_frame_t *fr, const uint8_t *buf, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_FRAME_H
@@ -0,0 +1,144 @@
+#ifndef HERMES_H
+#define HERMES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * libhermes - API estable de HermesDecoder para embeber en otros programas.
+ *
+ *   make lib  ->  libhermes.a / libhermes.so  (cabeceras: hermes.h, config.h)
+ *
+ * Garantias:
+ *   - Sin memoria dinamica: todo se escribe en estructuras/buffers del llamador.
+ *   - Sin estado global mutable: todas las funciones son reentrantes y se
+ *     pueden llamar desde varios hilos a la vez.
+ *   - Nunca escribe en stdout/stderr; los errores se devuelven como HERMES_ERR_*.
+ *
+ * hermes_config_t (config.h) forma parte de la ABI: un cambio de su layout
+ * incrementa HERMES_API_VERSION.
+ */
+
+#if defined(__GNUC__)
+#define HERMES_API __attribute__((visibility("default")))
+#else
+#define HERMES_API
+#endif
+
+#define HERMES_API_VERSION  1
+
+/* Codigos de retorno (0 = OK, negativos = error) */
+enum {
+    HERMES_OK            =  0,
+    HERMES_ERR_HEX       = -1,  // caracter no hex, nibbles impares o linea demasiado larga
+    HERMES_ERR_SHORT     = -2,  // menos de 57 bytes (prefijo + REG1..REG55)
+    HERMES_ERR_ARG       = -3,  // puntero nulo o parametro fuera de rango
+    HERMES_ERR_NOSPACE   = -4,  // el buffer del llamador es demasiado pequeño
+    HERMES_ERR_NOTFOUND  = -5,  // registro o campo desconocido
+};
+
+/* Perfiles y formatos de hermes_serialize() */
+typedef enum {
+    HERMES_PROFILE_P1  = 0,
+    HERMES_PROFILE_P2  = 1,
+    HERMES_PROFILE_TVG = 2,
+} hermes_profile_t;
+
+/* Interpolacion de hermes_curve_grid() */
+typedef enum {
+    HERMES_CURVE_STEP   = 0,
+    HERMES_CURVE_LINEAR = 1,
+} hermes_interp_t;
+
+typedef enum {
+    HERMES_FMT_CSV  = 0,
+    HERMES_FMT_JSON = 1,
+} hermes_format_t;
+
+/* Trama decodificada */
+typedef struct {
+    uint16_t prefix;        // bytes [0..1] (p.ej. 0x5E02)
+    int      nbytes;        // bytes de la trama (>= 57; el resto se ignora)
+    int      reserved_bad;  // registros con bits RESERVED != 0
+    hermes_config_t cfg;
+} hermes_decoded_t;
+
+/* Punto de una curva: tiempo acumulado, distancia y valor (% de escala) */
+typedef struct {
+    int32_t t_us;
+    double  dist_cm;
+    double  value_pct;
+} hermes_point_t;
+
+/* Puntos de cada curva: 12 etapas TH; TVG = origen + 6 tramos (escalon) */
+#define HERMES_TH_POINTS   HERMES_TH_STAGES
+#define HERMES_TVG_POINTS  (HERMES_TVG_STAGES + 1)
+
+/* Tamaño que garantiza que cualquier hermes_serialize() cabe */
+#define HERMES_SERIALIZE_MAX  4096
+
+/* HERMES_API_VERSION con el que se compilo la biblioteca */
+HERMES_API int hermes_version(void);
+
+/* Texto estatico para un codigo HERMES_* */
+HERMES_API const char *hermes_strerror(int rc);
+
+/*
+ * Decodifica una trama en hex ("5E 02 ..." o "5E02...", mismos separadores
+ * que la CLI). len es la longitud de hex (no necesita '\0').
+ */
+HERMES_API int hermes_decode_hex(const char *hex, size_t len, hermes_decoded_t *out);
+
+/* Igual a partir de los bytes crudos de la trama (n >= 57) */
+HERMES_API int hermes_decode_bytes(const uint8_t *frame, size_t n, hermes_decoded_t *out);
+
+/* Solo REG1..REG55 (sin prefijo) */
+HERMES_API int hermes_decode_regs(const uint8_t reg[55], hermes_config_t *cfg);
+
+/*
+ * Valor crudo de un campo por nombre: "REG.FIELD" (p.ej. "DEADTIME.PULSE_DT")
+ * o solo "FIELD" si es unico.
+ */
+HERMES_API int hermes_field_get(const hermes_config_t *cfg, const char *spec, unsigned *value);
+
+/* Byte del registro por nombre ("DEADTIME") */
+HERMES_API int hermes_reg_get(const hermes_config_t *cfg, const char *name, uint8_t *value);
+
+/*
+ * Curvas en el buffer del llamador. Devuelven el numero de puntos escritos
+ * (HERMES_TH_POINTS / HERMES_TVG_POINTS) o un HERMES_ERR_*.
+ * preset: 0 = P1, 1 = P2.
+ */
+HERMES_API int hermes_th_curve(const hermes_config_t *cfg, int preset, hermes_point_t *pts, size_t cap);
+HERMES_API int hermes_tvg_curve(const hermes_config_t *cfg, hermes_point_t *pts, size_t cap);
+
+/*
+ * Curva de cada cfgs[f] evaluada en grid_cm[0..ngrid): out[f * ngrid + i]
+ * en % de escala (matriz densa por filas; cap en floats >= ncfg * ngrid).
+ * STEP: nivel de la ultima etapa alcanzada (el primero antes del punto 1);
+ * LINEAR: rectas entre puntos como las graficas (TVG siempre en escalon).
+ * Usa AVX2/SSE2 si la CPU lo soporta. HERMES_OK o HERMES_ERR_*.
+ */
+HERMES_API int hermes_curve_grid(const hermes_config_t *cfgs, size_t ncfg, hermes_profile_t profile,
+                                 hermes_interp_t interp, const float *grid_cm, size_t ngrid,
+                                 float *out, size_t cap);
+
+/*
+ * Serializa un perfil en CSV o JSON (mismo contenido que --export-csv /
+ * --export-json). Escribe un texto terminado en '\0' y devuelve su longitud,
+ * o HERMES_ERR_NOSPACE si no cabe en cap (buf queda truncado).
+ */
+HERMES_API int hermes_serialize(const hermes_config_t *cfg, hermes_profile_t profile,
+                                hermes_format_t fmt, char *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_H
@@ -0,0 +1,30 @@
+#ifndef HERMES_HEXPARSE_H
+#define HERMES_HEXPARSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Version vectorizada de parse_hex_bytes(): mismo contrato y mismo resultado
+ * (numero de bytes o -1). Clasifica y convierte 64 caracteres por iteracion
+ * con SSE2 (o AVX2 si la CPU lo soporta, elegido en tiempo de ejecucion).
+ * Las entradas raras (p.ej. "A A", caracteres invalidos) se delegan en la
+ * version escalar para conservar exactamente su semantica.
+ */
+int parse_hex_bytes_fast(const char *s, uint8_t *out, int max_out);
+
+/* Igual, con la longitud ya conocida (s[len] no tiene por que ser '\0') */
+int parse_hex_bytes_n(const char *s, size_t len, uint8_t *out, int max_out);
+
+/* "avx2", "sse2" o "scalar": implementacion elegida en esta CPU */
+const char *hexparse_impl(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_HEXPARSE_H
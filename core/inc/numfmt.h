@@ -0,0 +1,43 @@
+#ifndef HERMES_NUMFMT_H
+#define HERMES_NUMFMT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Formateo rapido de los numeros de los exports CSV/JSON.
+ *
+ * dist_cm, value_pct y gain_pct salen de dominios pequenos (niveles de 5 y
+ * 8 bits, ganancias de 6 bits y sumas acumuladas de TIME_US), asi que se
+ * preformatean una vez con el mismo "%.4f"/"%.2f" de siempre y se copian de
+ * una tabla. La salida es identica byte a byte a la de snprintf: si el valor
+ * no coincide con el de la tabla (cfg construido a mano) se usa snprintf.
+ *
+ * out debe tener al menos NUMFMT_MAX bytes. Devuelven la longitud (sin '\0',
+ * que no se escribe).
+ */
+
+#define NUMFMT_MAX 32
+
+/* Entero decimal ("%llu" / "%lld") */
+size_t numfmt_u64(char *out, uint64_t v);
+size_t numfmt_i64(char *out, int64_t v);
+
+/* "%.4f" de dist_cm = tof_us_to_cm(t_us) */
+size_t numfmt_dist_cm(char *out, int32_t t_us, double dist_cm);
+
+/* "%.2f" de pct = value_to_pct(stage, raw) (L1..L8 de 5 bits, L9..L12 de 8) */
+size_t numfmt_th_pct(char *out, int stage /*1..12*/, int raw, double pct);
+
+/* "%.2f" de la ganancia TVG en % (raw / HERMES_TVG_GAIN_MAX) */
+size_t numfmt_gain_pct(char *out, int raw, double pct);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_NUMFMT_H
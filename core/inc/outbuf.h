@@ -0,0 +1,80 @@
+#ifndef HERMES_OUTBUF_H
+#define HERMES_OUTBUF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "numfmt.h"
+
+/*
+ * Ayudas internas de los serializadores (export.c, record.c, serve.c,
+ * curveio.c); no forman parte de la API de libhermes.
+ *
+ * outbuf_t: texto en memoria del llamador con semantica de snprintf. len
+ * cuenta aunque no quepa, lo que no cabe se corta (buf es siempre un
+ * prefijo del texto) y ob_done() pone el '\0'.
+ */
+typedef struct {
+    char  *p;
+    size_t cap;
+    size_t len;     // longitud total, aunque no quepa
+} outbuf_t;
+
+static inline void ob_mem(outbuf_t *b, const char *s, size_t n){
+    if (b->len < b->cap){
+        size_t room = b->cap - b->len;
+        memcpy(b->p + b->len, s, n < room ? n : room);
+    }
+    b->len += n;
+}
+
+#define ob_lit(b, s) ob_mem((b), (s), sizeof(s) - 1)
+
+static inline void ob_str(outbuf_t *b, const char *s){
+    ob_mem(b, s, strlen(s));
+}
+
+/* '\0' tras el texto (o en cap - 1 si se trunco) y longitud completa */
+static inline size_t ob_done(outbuf_t *b){
+    if (b->cap) b->p[b->len < b->cap ? b->len : b->cap - 1] = '\0';
+    return b->len;
+}
+
+/* Numero de numfmt.c (expr escribe en out): en el propio buffer si cabe NUMFMT_MAX, si no via tmp */
+#define OB_NUM(b, expr) do {                                                  \
+        char _tmp[NUMFMT_MAX];                                                \
+        int _direct = (b)->len + NUMFMT_MAX <= (b)->cap;                      \
+        char *out = _direct ? (b)->p + (b)->len : _tmp;                       \
+        size_t _n = (expr);                                                   \
+        if (_direct) (b)->len += _n; else ob_mem((b), _tmp, _n);              \
+    } while (0)
+
+/* ------------------ binario little-endian (devuelven p + tamaño) ------------------ */
+static inline uint8_t *put_u16le(uint8_t *p, uint16_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *put_u32le(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static inline uint8_t *put_u64le(uint8_t *p, uint64_t v){
+    put_u32le(p, (uint32_t)v);
+    return put_u32le(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint8_t *put_f32le(uint8_t *p, double v){
+    float f = (float)v;
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return put_u32le(p, u);
+}
+
+#endif // HERMES_OUTBUF_H
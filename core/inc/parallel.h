@@ -0,0 +1,81 @@
+#ifndef HERMES_PARALLEL_H
+#define HERMES_PARALLEL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PARALLEL_CHUNK_BYTES (4u << 20)   // tamaño objetivo de cada chunk
+
+/*
+ * Decodifica un fichero de tramas con nthreads hilos:
+ *   - mmap del fichero completo
+ *   - troceado en chunks alineados a '\n'
+ *   - cada hilo escribe en buffers propios (salida y errores)
+ *   - el hilo principal los vuelca a stdout/stderr en el orden original
+ *
+ * La salida es identica a stream_run() sobre el mismo fichero: mismos
+ * numeros de trama, offsets y mensajes de error. Como mucho 2*nthreads
+ * chunks estan en memoria a la vez. path debe ser un fichero regular (los
+ * FIFO van por pipeline_run()). Devuelve 0 o -1 (fichero/memoria/hilos).
+ */
+int parallel_run(const char *path, int nthreads, frame_cb cb, void *user, stream_stats_t *st);
+
+/* ------------------ pool de chunks ------------------ */
+/* Trozo [start, end) del mmap que procesa un hilo */
+typedef struct {
+    size_t   start, end;
+
+    /* fase A: los cuenta scan, o split si el troceado ya los sabe (counted = 1) */
+    uint64_t nlines, nframes, nblank;
+    int      counted;
+
+    /* base global: lineas/tramas de los chunks anteriores (valida si based) */
+    uint64_t base_line, base_frame;
+    int      based;
+
+    /* fase B */
+    char    *out;  size_t out_len;
+    char    *err;  size_t err_len;
+    uint64_t errors;
+    int      done;
+} parallel_chunk_t;
+
+/*
+ * Lo que cambia de un formato a otro. scratch es estado por hilo de
+ * scratch_bytes (a cero) que pasa de scan a render; scratch_free libera lo
+ * que cuelgue de el. scan puede ser NULL si split marca todos los chunks
+ * como counted.
+ */
+typedef struct {
+    /* Rellena start/end (y opcionalmente la fase A) de como mucho max_chunks. Cuantos. */
+    size_t (*split)(const char *map, size_t size, parallel_chunk_t *chunks, size_t max_chunks, void *arg);
+    /* Fase A: nlines/nframes/nblank del chunk. 0 o -1. */
+    int    (*scan)(const char *map, size_t size, parallel_chunk_t *c, void *scratch, void *arg);
+    /* Fase B: salida y errores con la numeracion global; errores en c->errors. 0 o -1. */
+    int    (*render)(const char *map, size_t size, parallel_chunk_t *c, FILE *out, FILE *err,
+                     void *scratch, void *arg);
+    size_t scratch_bytes;
+    void   (*scratch_free)(void *scratch);
+} parallel_ops_t;
+
+/*
+ * Reparte map entre nthreads hilos con ops y vuelca la salida de cada chunk
+ * a stdout/stderr en orden; como mucho 2*nthreads chunks en memoria. Lo usan
+ * parallel_run() (lineas hex) y bin_run() (registros binarios). Suma los
+ * contadores de los chunks a st. 0 o -1 (memoria/hilos/fallo de ops).
+ */
+int parallel_pool_run(const char *map, size_t size, int nthreads,
+                      const parallel_ops_t *ops, void *arg, stream_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_PARALLEL_H
@@ -0,0 +1,57 @@
+#ifndef HERMES_PIPELINE_H
+#define HERMES_PIPELINE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIPELINE_BATCH_LINES  512         // lineas por lote
+#define PIPELINE_BATCH_BYTES  (512u << 10) // o bytes por lote, lo que antes llegue
+
+/* Contadores de una cola del pipeline */
+typedef struct {
+    uint64_t items;          // elementos que han pasado por la cola
+    uint64_t depth_sum;      // suma de la profundidad vista en cada push
+    uint64_t depth_max;
+    uint64_t push_stalls;    // productor encontro la cola llena / sin hueco
+    uint64_t pop_stalls;     // consumidor la encontro vacia / sin el siguiente
+    uint64_t push_stall_ns;
+    uint64_t pop_stall_ns;
+} pipe_queue_stats_t;
+
+typedef struct {
+    pipe_queue_stats_t free_q;   // writer  -> reader  (lotes libres: backpressure)
+    pipe_queue_stats_t work_q;   // reader  -> workers (lotes con lineas)
+    pipe_queue_stats_t done_q;   // workers -> writer  (lotes decodificados, en orden)
+    uint64_t order_stalls;       // workers esperando la numeracion del lote anterior
+    uint64_t order_stall_ns;
+    uint64_t batches;
+    int      workers;
+    int      pool;               // lotes en circulacion (limite de memoria)
+} pipeline_stats_t;
+
+/*
+ * Pipeline para entrada sin fin (stdin):
+ *   reader (1 hilo) -> work_q -> N workers (parseo + decode + render)
+ *                   -> done (en orden) -> writer (hilo llamante) -> stdout
+ *
+ * Los lotes salen de un pool fijo de 4*N; cuando el writer se atasca el
+ * reader deja de leer (backpressure) y la memoria queda acotada. La salida
+ * es identica a stream_run(). Devuelve 0 o -1.
+ */
+int pipeline_run(FILE *in, int nworkers, frame_cb cb, void *user,
+                 stream_stats_t *st, pipeline_stats_t *ps);
+
+/* Informe de colas/esperas para localizar el cuello de botella */
+void pipeline_print_stats(FILE *out, const pipeline_stats_t *ps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_PIPELINE_H
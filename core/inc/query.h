@@ -0,0 +1,86 @@
+#ifndef HERMES_QUERY_H
+#define HERMES_QUERY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Consultas sobre logs de tramas y archivos columnares:
+ *
+ *   hermesdecoder query <fichero> ["<expresion>"] [--index f] [--reindex] [--count | --ids]
+ *
+ * Expresion: comparaciones "campo op valor" unidas con and/or/not (o &&,
+ * ||, !) y parentesis. op es ==, !=, <, <=, >, >=; valor decimal o 0x.. y
+ * un campo solo equivale a "campo != 0". Campos:
+ *
+ *   <REG>.<CAMPO>, <CAMPO> (si es unico), <REG> (byte entero)   regmap.def
+ *   device (PULSE_P2.UART_ADDR), prefix, frame_id, offset
+ *   reserved   registros con bits RESERVED != 0 (regmap_check_reserved)
+ *   hash       hash de la configuracion (prefijo + REG1..REG55, FNV-1a 64)
+ *   timestamp_us                                        solo en archivos
+ *
+ *   query flota.log "DEADTIME.PULSE_DT > 8"
+ *   query flota.log "TVGAIN6.RESERVED or CURR_LIM_P1.RESERVED"
+ *   query flota.hrc "device == 3 and P1_THR_10 == 0x8C" --ids
+ *
+ * Log hex: la primera consulta construye un indice persistente
+ * (<fichero>.hidx) con cada configuracion distinta una sola vez y la lista
+ * de (frame_id, offset) que la usan. La expresion se evalua por
+ * configuracion y solo se vuelve a mirar trama a trama si depende de
+ * frame_id/offset; ninguna trama se decodifica. Si el log crece, solo se
+ * indexan las lineas nuevas (se anade un segmento al indice); si se
+ * trunca o rota, se reconstruye.
+ *
+ * Archivo (--archive): no hace falta indice; el min/max de cada trozo de
+ * columna descarta bloques enteros y solo se leen las columnas de la
+ * expresion.
+ *
+ * Salida: las tramas que cumplen, en hex y una por linea (lista para
+ * --stream); --ids imprime "frame_id offset" y --count solo el total.
+ */
+
+typedef enum {
+    QUERY_OUT_HEX = 0,
+    QUERY_OUT_IDS,
+    QUERY_OUT_COUNT,
+} query_out_t;
+
+typedef struct {
+    const char *expr;        // NULL = solo crear/actualizar el indice
+    const char *index_path;  // NULL = <fichero>.hidx
+    int reindex;             // reconstruir el indice desde cero
+    query_out_t out;
+} query_opts_t;
+
+typedef struct {
+    uint64_t frames;         // tramas en el fichero
+    uint64_t matches;
+    uint64_t new_lines;      // lineas indexadas en esta llamada (logs)
+    uint64_t configs;        // configuraciones distintas (logs)
+    uint64_t configs_maybe;  // configuraciones evaluadas trama a trama
+    uint64_t groups;         // bloques del archivo
+    uint64_t groups_read;    // bloques no descartados por min/max
+} query_stats_t;
+
+/* Compilacion de la expresion (tambien para validar antes de abrir nada) */
+typedef struct query query_t;
+
+/* NULL con el motivo en err */
+query_t *query_compile(const char *expr, char *err, size_t errcap);
+void     query_free(query_t *q);
+
+/*
+ * Ejecuta la consulta sobre path (log hex o archivo, segun la cabecera) y
+ * escribe el resultado en out. 0 o -1 (motivo en stderr).
+ */
+int query_run(const char *path, const query_opts_t *o, FILE *out, query_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_QUERY_H
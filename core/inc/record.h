@@ -0,0 +1,71 @@
+#ifndef HERMES_RECORD_H
+#define HERMES_RECORD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+#include "export.h"
+#include "regmap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Salida legible por maquina de la decodificacion completa (--format):
+ * los 55 registros con sus campos, los avisos RESERVED y los perfiles
+ * derivados, sin pasar por el texto de decode_reg().
+ *
+ * NDJSON: un objeto por trama y linea, sin espacios:
+ *   {"frame_id":N,"offset":O,"device":D,"prefix":"0x5E02","reserved_bad":R,
+ *    "warnings":["CURR_LIM_P1.RESERVED",...],
+ *    "regs":{"TVGAIN0":{"idx":1,"raw":18,"fields":{"TVG_T0":1,"TVG_T1":2}},...},
+ *    "p1":{"points":[{stage,delta_us,t_us,dist_cm,value_pct,value_raw}x12]},
+ *    "p2":{...},
+ *    "tvg":{"g":[G1..G5],"points":[{stage,delta_us,t_us,dist_cm,gain_pct,gain_raw}x6]}}
+ * Los campos van crudos (los tiempos como nibble); los registros empaquetados
+ * (Px_THR_6..10) no tienen campos: sus niveles estan en los puntos.
+ *
+ * Binario: registro de RECORD_BIN_BYTES, little-endian y sin relleno:
+ *   u64 frame_id, u64 offset, u16 prefix, u8 device, u8 reserved_bad,
+ *   u8 reg[55],
+ *   u8 field[REGMAP_NUM_FIELDS]      valores crudos en el orden de regmap.def
+ *   u8 tvg_g[5], u8 level[2][12]     G1..G5, L1..L12 de P1 y P2
+ *   puntos {i32 delta_us, i32 t_us, f32 dist_cm, f32 pct}: P1[12], P2[12], TVG[6]
+ */
+
+typedef enum {
+    RECORD_TEXT = 0,    // decode_print_all() (por defecto)
+    RECORD_NDJSON,
+    RECORD_BINARY,
+} record_format_t;
+
+#define RECORD_BIN_POINTS  (2 * HERMES_TH_STAGES + HERMES_TVG_STAGES)
+#define RECORD_BIN_BYTES   (8 + 8 + 2 + 1 + 1 + 55 + REGMAP_NUM_FIELDS + \
+                            HERMES_TVG_GAINS + 2 * HERMES_TH_STAGES + RECORD_BIN_POINTS * 16)
+
+/* Cota de una linea NDJSON (incluido '\n') */
+#define RECORD_NDJSON_MAX_BYTES 16384
+
+/* "text" | "ndjson" | "binary" -> RECORD_*, o -1 */
+int record_format_parse(const char *s);
+
+/*
+ * Semantica de snprintf: buf termina en '\0' y se devuelve la longitud
+ * completa; si es >= cap, buf esta truncado.
+ */
+size_t record_format_ndjson(char *buf, size_t cap, const export_key_t *k, const hermes_config_t *cfg);
+
+/* Escribe RECORD_BIN_BYTES en buf (cap >= RECORD_BIN_BYTES) o nada. Devuelve RECORD_BIN_BYTES. */
+size_t record_format_binary(uint8_t *buf, size_t cap, const export_key_t *k, const hermes_config_t *cfg);
+
+/* Un registro NDJSON o binario en f con un solo fwrite (0 o -1) */
+int record_write(FILE *f, record_format_t fmt, const export_key_t *k, const hermes_config_t *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_RECORD_H
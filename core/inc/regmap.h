@@ -0,0 +1,119 @@
+#ifndef HERMES_REGMAP_H
+#define HERMES_REGMAP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Esquema de registros del PGA460 (REG1..REG55) como tabla estatica.
+ * La tabla se genera en compilacion a partir de inc/regmap.def y dirige
+ * la decodificacion, la validacion de bits RESERVED y la impresion.
+ */
+
+#define REGMAP_NUM_REGS    55
+#define REGMAP_MAX_FIELDS  4
+#define REGMAP_NUM_FIELDS  91       // campos de regmap.def (comprobado en regmap.c)
+#define REGMAP_NO_CFG      0xFFFF   // campo sin destino en hermes_config_t
+
+/* Transformacion del valor al imprimir */
+enum {
+    REG_XF_RAW = 0,     // "%u"
+    REG_XF_TIME_US,     // TIME_US[nibble], "%dus"
+};
+
+/* Flags de campo */
+#define REG_FF_RESERVED  0x01   // debe ser 0; imprime WARNING si no
+#define REG_FF_HIDDEN    0x02   // se decodifica pero no se imprime
+
+/* Accion adicional tras imprimir el registro */
+enum {
+    REG_POST_NONE = 0,
+    REG_POST_TH_L1_L8,  // imprime L1..L8 decodificados del preset
+};
+
+typedef struct {
+    const char *name;
+    uint8_t  lsb;
+    uint8_t  width;
+    uint8_t  xform;
+    uint8_t  flags;
+    uint16_t cfg_off;   // offsetof(hermes_config_t, ...) o REGMAP_NO_CFG
+} reg_field_t;
+
+typedef struct {
+    const char *name;
+    const char *note;   // texto fijo tras "| " (puede ser "")
+    uint8_t  idx;       // 1..55
+    uint8_t  rsv_mask;  // bits RESERVED del registro
+    uint8_t  post;      // REG_POST_*
+    uint8_t  preset;    // 0 = P1, 1 = P2 (solo registros THR)
+    uint8_t  nfields;
+    reg_field_t fields[REGMAP_MAX_FIELDS];
+} reg_desc_t;
+
+/* Descriptor del registro idx (1..55) o NULL */
+const reg_desc_t *regmap_desc(int idx);
+
+/* Busca un registro por nombre ("DEADTIME") o -1 */
+int regmap_find_reg(const char *name);
+
+/*
+ * Busca "REG.FIELD" (p.ej. "DEADTIME.PULSE_DT") o solo "FIELD" si es unico.
+ * Devuelve 0 y rellena *reg_idx / *field o -1 si no existe.
+ */
+int regmap_find_field(const char *spec, int *reg_idx, int *field);
+
+/* Valor crudo del campo f del registro idx */
+static inline unsigned regmap_field_value(const uint8_t reg[55], const reg_desc_t *d, int f){
+    const reg_field_t *fd = &d->fields[f];
+    return ((unsigned)reg[d->idx - 1] >> fd->lsb) & ((1u << fd->width) - 1u);
+}
+
+/* Escribe v en el campo f del registro idx. -1 si v no cabe en el campo. */
+static inline int regmap_field_set(uint8_t reg[55], const reg_desc_t *d, int f, unsigned v){
+    const reg_field_t *fd = &d->fields[f];
+    unsigned mask = (1u << fd->width) - 1u;
+    if (v > mask) return -1;
+    reg[d->idx - 1] = (uint8_t)((reg[d->idx - 1] & ~(mask << fd->lsb)) | (v << fd->lsb));
+    return 0;
+}
+
+/* Cuenta los registros con bits RESERVED != 0 (0 = trama limpia) */
+int regmap_check_reserved(const uint8_t reg[55]);
+
+/*
+ * Decodifica solo los registros indicados (idx 1..55) en cfg; idx == NULL
+ * decodifica los n primeros registros (n = 55 -> todos). Los perfiles
+ * TH/TVG derivados (tiempos acumulados, %...) no se tocan; para la trama
+ * completa usar decode_config().
+ */
+void regmap_decode(const uint8_t reg[55], const int *idx, int n, hermes_config_t *cfg);
+
+/*
+ * Inversa de regmap_decode() para todos los registros: escribe en reg los
+ * campos con destino en cfg. Los bits sin destino (G1..G4 partidos, L1..L8
+ * empaquetados) los completa encode_config().
+ */
+void regmap_encode(const hermes_config_t *cfg, uint8_t reg[55]);
+
+/* Imprime el registro idx en el formato de la decodificacion RAW */
+void regmap_print(FILE *out, const hermes_config_t *cfg, int idx);
+
+/*
+ * Como regmap_print() pero para --diff: "0xAA -> 0xBB" y solo los campos
+ * cuyo valor cambia respecto a old_reg (sin el bloque L1..L8).
+ */
+void regmap_print_diff(FILE *out, const uint8_t old_reg[55], const hermes_config_t *cfg, int idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_REGMAP_H
@@ -0,0 +1,40 @@
+#ifndef HERMES_RENDER_H
+#define HERMES_RENDER_H
+
+#include <stdio.h>
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Renderizado nativo de los perfiles (sin gnuplot ni ficheros temporales).
+ * Dibuja las mismas curvas que plot.c directamente desde hermes_config_t:
+ *   TH : sensibilidad (%) vs distancia (cm), P1 y P2 con linespoints
+ *   TVG: ganancia (%) vs distancia (cm) en escalones
+ *
+ * SVG se escribe como texto; PNG se rasteriza en memoria (paleta de 8 bits)
+ * y se codifica sin dependencias externas. Reentrante: se puede llamar
+ * desde los workers de --threads.
+ */
+
+typedef enum {
+    RENDER_SVG = 0x01,
+    RENDER_PNG = 0x02,
+} render_fmt_t;
+
+/* Escribe la grafica en f en el formato indicado (uno solo). 0 o -1. */
+int render_th(FILE *f, const hermes_config_t *cfg, render_fmt_t fmt);
+int render_tvg(FILE *f, const hermes_config_t *cfg, render_fmt_t fmt);
+
+/* Igual que render_* pero abriendo/cerrando path */
+int write_th_plot(const char *path, const hermes_config_t *cfg, render_fmt_t fmt);
+int write_tvg_plot(const char *path, const hermes_config_t *cfg, render_fmt_t fmt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_RENDER_H
@@ -0,0 +1,69 @@
+#ifndef HERMES_RING_H
+#define HERMES_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cola acotada sin locks de punteros (esquema de Vyukov): vale para
+ * SPSC, SPMC, MPSC y MPMC. La capacidad se redondea a potencia de 2.
+ * push/pop no bloquean: devuelven -1 si la cola esta llena/vacia y el
+ * llamante decide como esperar (ver ring_wait).
+ */
+
+typedef struct {
+    _Atomic size_t seq;
+    void *data;
+} ring_cell_t;
+
+typedef struct {
+    ring_cell_t *cells;
+    size_t mask;
+    _Alignas(64) _Atomic size_t head;  // siguiente posicion de push
+    _Alignas(64) _Atomic size_t tail;  // siguiente posicion de pop
+} ring_t;
+
+int    ring_init(ring_t *r, size_t capacity);
+void   ring_free(ring_t *r);
+int    ring_push(ring_t *r, void *item);    // 0 o -1 (llena)
+int    ring_pop(ring_t *r, void **item);    // 0 o -1 (vacia)
+size_t ring_depth(ring_t *r);              // aproximada si hay concurrencia
+
+/*
+ * Espera progresiva sobre una condicion: pausa de CPU, luego yield y, si
+ * sigue sin cumplirse, dormir hasta el siguiente ring_notify. Quien espera:
+ *
+ *     unsigned spins = 0;
+ *     for (;;){
+ *         unsigned gen = ring_event_gen(&ev);   // antes de mirar
+ *         if (condicion) break;
+ *         ring_wait(&ev, gen, &spins);
+ *     }
+ *
+ * Quien la cumple (push, flag, ...) llama despues a ring_notify; si no hay
+ * nadie dormido solo cuesta un incremento atomico.
+ */
+typedef struct {
+    _Atomic unsigned gen;        // cambia en cada notify
+    _Atomic unsigned sleepers;   // hilos dormidos (o a punto) en cv
+    pthread_mutex_t  mu;
+    pthread_cond_t   cv;
+} ring_event_t;
+
+void     ring_event_init(ring_event_t *ev);
+void     ring_event_destroy(ring_event_t *ev);
+unsigned ring_event_gen(ring_event_t *ev);
+void     ring_wait(ring_event_t *ev, unsigned gen, unsigned *spins);
+void     ring_notify(ring_event_t *ev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_RING_H
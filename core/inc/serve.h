@@ -0,0 +1,57 @@
+#ifndef HERMES_SERVE_H
+#define HERMES_SERVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Servidor de decodificacion persistente (--serve <socket>): socket Unix
+ * SOCK_STREAM con un bucle epoll por hilo (--threads N) y muchas conexiones
+ * a la vez. Evita el arranque de un proceso por trama en scripts y
+ * herramientas que solo saben hablar por pipe/socket.
+ *
+ * Protocolo. En una conexion se pueden encadenar peticiones sin esperar
+ * respuesta (pipelining) y mezclar los dos formatos; las respuestas salen en
+ * el orden de las peticiones y se agrupan en un solo send() por lectura.
+ *
+ *   Texto:   una trama en hex por linea ("5E 02 ...\n"; las vacias se ignoran)
+ *            -> una linea JSON (format_frame_json) o
+ *               {"frame_id": N, "offset": O, "error": "..."}
+ *
+ *   Binario: [0x00][flags][len_hi][len_lo] + len bytes de carga
+ *              SERVE_REQ_HEX : la carga es hex (si no, bytes crudos de la trama)
+ *              SERVE_REQ_JSON: responder con JSON (si no, resultado binario)
+ *            -> [0x00][status][len_hi][len_lo] + len bytes
+ *              status 0: JSON o resultado binario; si no, -HERMES_ERR_* y el
+ *              mensaje de hermes_strerror()
+ *
+ * El primer byte distingue el formato: una linea de texto nunca empieza por 0x00.
+ *
+ * Resultado binario (little-endian, sin relleno, SERVE_BIN_RESULT_BYTES):
+ *   u16 prefix, u8 reserved_bad, u8 reg[55],
+ *   31 puntos {i32 t_us, f32 dist_cm, f32 value_pct}: P1[12], P2[12], TVG[7]
+ *   (los puntos de hermes_th_curve() / hermes_tvg_curve())
+ */
+
+#define SERVE_REQ_HEX   0x01
+#define SERVE_REQ_JSON  0x02
+
+#define SERVE_BIN_POINTS        (2 * 12 + 7)
+#define SERVE_BIN_RESULT_BYTES  (2 + 1 + 55 + SERVE_BIN_POINTS * 12)
+
+/* Linea de texto mas larga aceptada; si se supera se cierra la conexion */
+#define SERVE_MAX_LINE  (64u << 10)
+
+/*
+ * Escucha en path hasta SIGINT/SIGTERM con nthreads bucles epoll. Un socket
+ * previo en path se sustituye; cualquier otro fichero es un error. Al salir
+ * borra el socket y resume conexiones/peticiones en stderr. 0 o -1.
+ */
+int serve_run(const char *path, int nthreads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_SERVE_H
@@ -0,0 +1,89 @@
+#ifndef HERMES_STATS_H
+#define HERMES_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Instrumentacion de --stats: tiempo por etapa con CLOCK_MONOTONIC y
+ * contadores, en acumuladores por hilo (sin locks en el camino caliente)
+ * que se suman al final. Cada etapa guarda un histograma log-lineal de
+ * latencias (8 sub-cubos por potencia de 2, error < 12.5%) para p50/p99.
+ *
+ * Desactivado (por defecto) cada punto de medida es una lectura de
+ * stats_enabled. Con stats_start(1) se abren ademas contadores hardware
+ * (ciclos, instrucciones, fallos de cache) con perf_event_open para todo
+ * el proceso, si el kernel lo permite; si no, el informe lo indica.
+ *
+ *   uint64_t t = stats_begin();
+ *   ...
+ *   stats_end(STAGE_PARSE, t);
+ */
+
+typedef enum {
+    STAGE_READ = 0,      // lectura de la entrada (lineas, lotes, tty)
+    STAGE_DECOMPRESS,    // .gz/.zst -> texto (hilos de zstream)
+    STAGE_PARSE,         // hex -> bytes (parse_hex_bytes)
+    STAGE_DECODE,        // decode_config: registros, perfiles TH/TVG (o cache)
+    STAGE_OUTPUT,        // salida de la trama: decode_reg, record, diff, curvas, eco, archivo
+    STAGE_EXPORT_CSV,    // ficheros CSV por trama
+    STAGE_EXPORT_JSON,   // ficheros JSON por trama
+    STAGE_EXPORT_BATCH,  // --batch-export
+    STAGE_RENDER,        // --render (SVG/PNG)
+    STAGE_PLOT,          // --plot/--plot-tvg (gnuplot)
+    STAGE_NUM
+} stats_stage_t;
+
+typedef enum {
+    STAT_BYTES = 0,      // bytes de entrada
+    STAT_RESERVED,       // tramas con algun bit RESERVED activo
+    STAT_NUM
+} stats_counter_t;
+
+typedef enum {
+    STATS_TEXT = 0,
+    STATS_JSON,
+} stats_format_t;
+
+extern int stats_enabled;
+
+uint64_t stats_now_ns(void);
+void stats_record(stats_stage_t s, uint64_t ns);
+void stats_add(stats_counter_t c, uint64_t n);
+
+static inline uint64_t stats_begin(void){
+    return stats_enabled ? stats_now_ns() : 0;
+}
+
+static inline void stats_end(stats_stage_t s, uint64_t t0){
+    if (t0) stats_record(s, stats_now_ns() - t0);
+}
+
+static inline void stats_count(stats_counter_t c, uint64_t n){
+    if (stats_enabled) stats_add(c, n);
+}
+
+/* Activa la medida (antes de lanzar hilos); hw = intentar perf_event_open */
+void stats_start(int hw);
+
+/*
+ * Informe al terminar (hilos ya unidos): tiempo total, tramas, bytes,
+ * errores, avisos RESERVED, contadores hardware y, por etapa, llamadas,
+ * tiempo acumulado, media, p50, p99 y maximo. Texto o una linea JSON.
+ */
+void stats_report(FILE *out, stats_format_t fmt, const stream_stats_t *st);
+
+/* Libera los acumuladores de todos los hilos */
+void stats_free(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_STATS_H
@@ -0,0 +1,98 @@
+#ifndef HERMES_STREAM_H
+#define HERMES_STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lector de lineas sin limite de longitud (getline) con seguimiento de offset */
+typedef struct {
+    FILE    *fp;
+    char    *line;
+    size_t   cap;
+    uint64_t offset;      // offset de la linea actual
+    uint64_t next_offset; // offset de la siguiente linea
+    uint64_t lineno;      // 1..N
+} line_reader_t;
+
+void    line_reader_init(line_reader_t *lr, FILE *fp);
+ssize_t line_reader_next(line_reader_t *lr); // longitud de la linea o -1 en EOF
+void    line_reader_free(line_reader_t *lr);
+
+typedef struct {
+    uint64_t lines;     // lineas leidas
+    uint64_t frames;    // tramas decodificadas
+    uint64_t errors;    // lineas con error (hex invalido, trama corta, cb != 0)
+    uint64_t blank;     // lineas vacias ignoradas
+} stream_stats_t;
+
+/* Resultado de stream_parse_line() */
+enum {
+    LINE_OK      =  0,
+    LINE_BLANK   =  1,
+    LINE_BAD_HEX = -1,
+    LINE_SHORT   = -2,   // fr->nbytes = bytes parseados
+    LINE_NOMEM   = -3,
+};
+
+/*
+ * Parsea una linea (no necesariamente terminada en '\0') en *buf, que crece
+ * segun haga falta. Con LINE_OK, fr apunta a *buf (seq/offset los pone el
+ * llamante).
+ */
+int stream_parse_line(const char *line, size_t len, uint8_t **buf, size_t *cap, hermes_frame_t *fr);
+
+/* Mensaje de error de linea, mismo formato en todos los modos */
+void stream_report_error(FILE *err, int status, uint64_t lineno, uint64_t offset, int nbytes);
+
+/* Linea ya parseada a la espera de numeracion global (modos multihilo) */
+typedef struct {
+    uint64_t offset;         // offset de la linea en la entrada
+    uint32_t line;           // linea relativa al bloque (0..)
+    int32_t  status;         // LINE_* (nunca LINE_BLANK)
+    int32_t  nbytes;
+    uint8_t  bytes[HERMES_FRAME_BYTES];
+} frame_rec_t;
+
+/* Vector creciente de frame_rec_t, reutilizable entre bloques */
+typedef struct {
+    frame_rec_t *v;
+    size_t n, cap;
+} frame_recs_t;
+
+int  frame_recs_push(frame_recs_t *r, const frame_rec_t *rec);
+void frame_recs_free(frame_recs_t *r);
+
+/*
+ * Callback por trama: escribe su salida en out. Un valor != 0 cuenta como
+ * error pero no detiene el bucle.
+ */
+typedef int (*frame_cb)(FILE *out, const hermes_frame_t *fr, void *user);
+
+/*
+ * Recorre todas las lineas de fp, parsea cada una como trama y llama a cb
+ * con out = stdout. Las lineas erroneas se reportan por stderr y se cuentan
+ * en st->errors. Devuelve 0 o -1 si no se pudo reservar memoria.
+ */
+int stream_run(FILE *fp, frame_cb cb, void *user, stream_stats_t *st);
+
+/*
+ * Renderiza un bloque de registros con numeracion global: linea = base_line
+ * + rec.line + 1, trama = base_frame + 1.. Los errores van a err y se suman
+ * en *errors (incluye callbacks != 0).
+ */
+void stream_render_recs(FILE *out, FILE *err, const frame_recs_t *recs,
+                        uint64_t base_line, uint64_t base_frame,
+                        frame_cb cb, void *user, uint64_t *errors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_STREAM_H
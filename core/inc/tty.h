@@ -0,0 +1,68 @@
+#ifndef HERMES_TTY_H
+#define HERMES_TTY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Captura en vivo del UART (--tty <dispositivo> --baud N): bytes crudos sin
+ * lineas. Las tramas se delimitan buscando el prefijo (por defecto 5E 02) y
+ * tomando HERMES_FRAME_BYTES desde el:
+ *
+ *   - bytes antes de un prefijo: basura, se descartan (resincronizacion)
+ *   - silencio de mas de ~20 bytes con una trama a medias: truncada, se
+ *     descarta entera
+ *   - si tras una trama ya emitida no viene otro prefijo pero habia uno
+ *     dentro de ella, se perdieron bytes: se vuelve a ese prefijo para no
+ *     perder la trama siguiente (la anterior ya emitida se marca como
+ *     corrupta con "Trama N (offset O): corrupta" en stderr y cuenta en
+ *     st->errors)
+ *
+ * Cada trama se entrega a cb en cuanto llega su ultimo byte (salida con
+ * fflush si la entrada es un terminal). Tambien acepta un fichero o FIFO
+ * con la captura cruda; entonces termina en EOF. Con un terminal termina
+ * con SIGINT/SIGTERM o al cerrarse el otro extremo (pty).
+ */
+
+#define TTY_DEFAULT_BAUD    115200
+#define TTY_DEFAULT_PREFIX  0x5E02
+
+typedef struct {
+    uint64_t bytes;        // bytes leidos
+    uint64_t skipped;      // bytes descartados buscando un prefijo
+    uint64_t resyncs;      // veces que se descarto basura entre tramas
+    uint64_t truncated;    // tramas incompletas al llegar un silencio o EOF
+    uint64_t corrupt;      // tramas emitidas con un prefijo dentro (bytes perdidos)
+} tty_stats_t;
+
+/* B<baud> de termios o -1 si la velocidad no es estandar */
+int tty_baud_ok(int baud);
+
+/*
+ * Primer i con p[i] == prefix >> 8 y p[i + 1] == prefix & 0xFF (i + 1 < n),
+ * o n si no hay. SSE2/AVX2 elegido en tiempo de ejecucion.
+ */
+size_t tty_find_prefix(const uint8_t *p, size_t n, uint16_t prefix);
+
+/* "avx2", "sse2" o "scalar" */
+const char *tty_scan_impl(void);
+
+/*
+ * Lee path hasta EOF o senal y llama a cb(stdout, ...) por trama. seq es el
+ * numero de trama y offset el byte del prefijo en la captura. 0 o -1 (no se
+ * pudo abrir/configurar; motivo en stderr).
+ */
+int tty_run(const char *path, int baud, uint16_t prefix, frame_cb cb, void *user,
+            stream_stats_t *st, tty_stats_t *ts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_TTY_H
@@ -1,6 +1,6 @@
-#ifndef HERMES_USAGE_H
-#define HERMES_USAGE_H
-
-void usage(const char *prog);
-
+#ifndef HERMES_USAGE_H
+#define HERMES_USAGE_H
+
+void usage(const char *prog);
+
 #endif
\ No newline at end of file
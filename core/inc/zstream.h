@@ -0,0 +1,76 @@
+#ifndef HERMES_ZSTREAM_H
+#define HERMES_ZSTREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Entrada comprimida (.gz / .zst) para los modos stream: los logs rotados se
+ * leen directamente, sin descomprimir a disco ni pasar por zcat.
+ *
+ * Un hilo descomprime en un anillo de bloques reutilizables (ZSTREAM_SLOTS
+ * de ZSTREAM_SLOT_BYTES) mientras el hilo llamante parsea y decodifica; el
+ * resultado se ofrece como un FILE* de solo lectura, asi que stream_run() y
+ * pipeline_run() lo consumen sin cambios. Un .zst con varias tramas zstd
+ * (pzstd, ficheros .zst concatenados) que sea un fichero regular se mapea,
+ * se reparte por tramas entre nthreads hilos y se entrega en orden.
+ *
+ * El formato se detecta por la firma completa (1F 8B gzip, 28 B5 2F FD
+ * zstd), asi que un texto o binario que solo empiece por 0x1F o 0x28 se
+ * lee tal cual; el resto de la cabecera lo valida el descompresor. Los miembros gzip y tramas zstd concatenados se leen
+ * seguidos, como con zcat.
+ */
+
+#define ZSTREAM_SLOTS       4
+#define ZSTREAM_SLOT_BYTES  (256u << 10)   // salida por bloque (modo secuencial)
+#define ZSTREAM_READ_BYTES  (128u << 10)   // lecturas de la entrada comprimida
+
+typedef enum {
+    ZSTREAM_NONE = 0,
+    ZSTREAM_GZIP,
+    ZSTREAM_ZSTD,
+} zstream_codec_t;
+
+typedef struct {
+    zstream_codec_t codec;
+    uint64_t in_bytes;      // comprimidos leidos
+    uint64_t out_bytes;     // descomprimidos entregados
+    uint64_t frames;        // tramas zstd repartidas (0 en modo secuencial)
+    int      workers;       // hilos de descompresion
+} zstream_stats_t;
+
+typedef struct zstream zstream_t;
+
+/* Mira la firma al principio de in sin consumir ningun byte */
+zstream_codec_t zstream_detect(FILE *in);
+
+const char *zstream_codec_name(zstream_codec_t c);
+
+/* 1 si el binario se compilo con soporte para el formato */
+int zstream_available(zstream_codec_t c);
+
+/*
+ * Empieza a descomprimir in (que no se cierra). name solo se usa en los
+ * mensajes de error. NULL si falta memoria, hilos o soporte del formato
+ * (con mensaje por stderr).
+ */
+zstream_t *zstream_open(FILE *in, zstream_codec_t codec, int nthreads, const char *name);
+
+/* Datos descomprimidos; EOF al terminar, error de lectura si el fichero esta corrupto */
+FILE *zstream_file(zstream_t *z);
+
+/*
+ * Cierra el FILE*, detiene y une los hilos y rellena st (si no es NULL).
+ * 0, o -1 si la entrada estaba corrupta o truncada (mensaje por stderr).
+ */
+int zstream_close(zstream_t *z, zstream_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HERMES_ZSTREAM_H
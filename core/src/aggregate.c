@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "aggregate.h"
+#include "echo.h"
+#include "utils.h"
+
+#define TOP_VALUES 5   // valores mostrados por campo en el informe de texto
+
+hermes_agg_t *aggregate_new(void){
+    hermes_agg_t *a = calloc(1, sizeof(*a));
+    if (!a) return NULL;
+    for (int p = 0; p < 2; p++){
+        for (int s = 0; s < HERMES_TH_STAGES; s++) a->t_min[p][s] = UINT32_MAX;
+    }
+    return a;
+}
+
+void aggregate_free(hermes_agg_t *a){
+    free(a);
+}
+
+void aggregate_frame(hermes_agg_t *a, const hermes_frame_t *fr){
+    // Los volcados de --echo no son tramas de registros
+    if (fr->nbytes >= ECHO_FRAME_BYTES){
+        a->skipped++;
+        return;
+    }
+
+    const uint8_t *reg = fr->reg;
+    a->frames++;
+    for (int i = 0; i < REGMAP_NUM_REGS; i++) a->reg[i][reg[i]]++;
+    if (regmap_check_reserved(reg)) a->reserved++;
+
+    for (int p = 0; p < 2; p++){
+        int dt[HERMES_TH_STAGES], L[HERMES_TH_STAGES];
+        extract_T12_us(reg, p, dt);
+        extract_L1_L8_5bit(reg, p, L);
+        extract_L9_L12_8bit(reg, p, L + 8);
+
+        uint32_t t = 0;
+        for (int s = 0; s < HERMES_TH_STAGES; s++){
+            t += (uint32_t)dt[s];
+            a->level[p][s][L[s] & 0xFF]++;
+            if (t < a->t_min[p][s]) a->t_min[p][s] = t;
+            if (t > a->t_max[p][s]) a->t_max[p][s] = t;
+            a->t_sum[p][s] += t;
+        }
+    }
+}
+
+void aggregate_merge(hermes_agg_t *dst, const hermes_agg_t *src){
+    dst->frames   += src->frames;
+    dst->reserved += src->reserved;
+    dst->skipped  += src->skipped;
+    for (int i = 0; i < REGMAP_NUM_REGS; i++){
+        for (int v = 0; v < 256; v++) dst->reg[i][v] += src->reg[i][v];
+    }
+    for (int p = 0; p < 2; p++){
+        for (int s = 0; s < HERMES_TH_STAGES; s++){
+            for (int v = 0; v < 256; v++) dst->level[p][s][v] += src->level[p][s][v];
+            if (src->t_min[p][s] < dst->t_min[p][s]) dst->t_min[p][s] = src->t_min[p][s];
+            if (src->t_max[p][s] > dst->t_max[p][s]) dst->t_max[p][s] = src->t_max[p][s];
+            dst->t_sum[p][s] += src->t_sum[p][s];
+        }
+    }
+}
+
+/* ------------------ acumuladores por hilo ------------------ */
+static __thread hermes_agg_t *tls_agg;
+static hermes_agg_t *registry;
+static pthread_mutex_t registry_mu = PTHREAD_MUTEX_INITIALIZER;
+
+hermes_agg_t *aggregate_thread(void){
+    if (tls_agg) return tls_agg;
+
+    hermes_agg_t *a = aggregate_new();
+    if (!a) return NULL;
+    pthread_mutex_lock(&registry_mu);
+    a->registry_next = registry;
+    registry = a;
+    pthread_mutex_unlock(&registry_mu);
+
+    tls_agg = a;
+    return a;
+}
+
+void aggregate_thread_merge(hermes_agg_t *dst){
+    pthread_mutex_lock(&registry_mu);
+    for (hermes_agg_t *a = registry; a; a = a->registry_next) aggregate_merge(dst, a);
+    pthread_mutex_unlock(&registry_mu);
+}
+
+void aggregate_thread_free_all(void){
+    pthread_mutex_lock(&registry_mu);
+    hermes_agg_t *a = registry;
+    registry = NULL;
+    pthread_mutex_unlock(&registry_mu);
+
+    while (a){
+        hermes_agg_t *next = a->registry_next;
+        aggregate_free(a);
+        a = next;
+    }
+    tls_agg = NULL;
+}
+
+/* ------------------ informe ------------------ */
+/* Resumen de un histograma de 256 valores */
+typedef struct {
+    int      distinct, min, max;
+    double   mean;
+    uint64_t total;
+} hist_sum_t;
+
+static void hist_summary(const uint64_t h[256], hist_sum_t *r){
+    memset(r, 0, sizeof(*r));
+    r->min = -1;
+    double sum = 0.0;
+    for (int v = 0; v < 256; v++){
+        if (!h[v]) continue;
+        if (r->min < 0) r->min = v;
+        r->max = v;
+        r->distinct++;
+        r->total += h[v];
+        sum += (double)v * (double)h[v];
+    }
+    if (r->min < 0) r->min = 0;
+    r->mean = r->total ? sum / (double)r->total : 0.0;
+}
+
+/* Histograma del campo f a partir del de su registro */
+static void field_hist(const hermes_agg_t *a, const reg_desc_t *d, int f, uint64_t out[256]){
+    const reg_field_t *fd = &d->fields[f];
+    unsigned mask = (1u << fd->width) - 1u;
+    memset(out, 0, 256 * sizeof(uint64_t));
+    for (unsigned v = 0; v < 256; v++) out[(v >> fd->lsb) & mask] += a->reg[d->idx - 1][v];
+}
+
+static uint64_t reserved_frames(const hermes_agg_t *a, const reg_desc_t *d){
+    uint64_t n = 0;
+    for (unsigned v = 0; v < 256; v++){
+        if (v & d->rsv_mask) n += a->reg[d->idx - 1][v];
+    }
+    return n;
+}
+
+static double pct(uint64_t n, uint64_t total){
+    return total ? 100.0 * (double)n / (double)total : 0.0;
+}
+
+static void report_text(FILE *out, const hermes_agg_t *a){
+    fprintf(out, "Aggregate: %llu tramas, %llu con RESERVED (%.2f%%)",
+            (unsigned long long)a->frames, (unsigned long long)a->reserved, pct(a->reserved, a->frames));
+    if (a->skipped) fprintf(out, ", %llu volcados de eco ignorados", (unsigned long long)a->skipped);
+    fprintf(out, "\n\n");
+    if (!a->frames) return;
+
+    fprintf(out, "%-30s %9s %5s %5s %8s  %s\n", "campo", "distintos", "min", "max", "media",
+            "valores más frecuentes (% de tramas)");
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        for (int f = 0; d && f < d->nfields; f++){
+            uint64_t h[256];
+            hist_sum_t hs;
+            field_hist(a, d, f, h);
+            hist_summary(h, &hs);
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s.%s", d->name, d->fields[f].name);
+            fprintf(out, "%-30s %9d %5d %5d %8.2f ", name, hs.distinct, hs.min, hs.max, hs.mean);
+
+            // los TOP_VALUES mas frecuentes (empate -> valor menor)
+            uint64_t seen[256];
+            memcpy(seen, h, sizeof(seen));
+            int shown = 0;
+            for (; shown < TOP_VALUES && shown < hs.distinct; shown++){
+                int best = 0;
+                for (int v = 1; v < 256; v++){
+                    if (seen[v] > seen[best]) best = v;
+                }
+                fprintf(out, " %d:%.1f%%", best, pct(seen[best], a->frames));
+                seen[best] = 0;
+            }
+            if (hs.distinct > shown) fprintf(out, " (+%d)", hs.distinct - shown);
+            fprintf(out, "\n");
+        }
+    }
+
+    fprintf(out, "\nRESERVED (tramas con el bit activo):\n");
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        if (!d || !d->rsv_mask) continue;
+        uint64_t n = reserved_frames(a, d);
+        fprintf(out, "  %-24s %12llu (%.2f%%)\n", d->name, (unsigned long long)n, pct(n, a->frames));
+    }
+
+    fprintf(out, "\n%-9s %5s %5s %8s  %10s %10s %10s\n", "umbral TH", "L min", "L max", "L media",
+            "t min us", "t max us", "t media us");
+    for (int p = 0; p < 2; p++){
+        for (int s = 0; s < HERMES_TH_STAGES; s++){
+            hist_sum_t hs;
+            hist_summary(a->level[p][s], &hs);
+            char name[16];
+            snprintf(name, sizeof(name), "P%d L%d", p + 1, s + 1);
+            fprintf(out, "%-9s %5d %5d %8.2f  %10u %10u %10.1f\n", name, hs.min, hs.max, hs.mean,
+                    a->t_min[p][s], a->t_max[p][s], (double)a->t_sum[p][s] / (double)a->frames);
+        }
+    }
+}
+
+static void report_json(FILE *out, const hermes_agg_t *a){
+    fprintf(out, "{\"frames\":%llu,\"reserved_frames\":%llu,\"skipped\":%llu,\"fields\":{",
+            (unsigned long long)a->frames, (unsigned long long)a->reserved, (unsigned long long)a->skipped);
+
+    int first = 1;
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        for (int f = 0; d && f < d->nfields; f++){
+            uint64_t h[256];
+            hist_sum_t hs;
+            field_hist(a, d, f, h);
+            hist_summary(h, &hs);
+            fprintf(out, "%s\"%s.%s\":{\"distinct\":%d,\"min\":%d,\"max\":%d,\"mean\":%.4f,\"hist\":{",
+                    first ? "" : ",", d->name, d->fields[f].name, hs.distinct, hs.min, hs.max, hs.mean);
+            int hfirst = 1;
+            for (int v = 0; v < 256; v++){
+                if (!h[v]) continue;
+                fprintf(out, "%s\"%d\":%llu", hfirst ? "" : ",", v, (unsigned long long)h[v]);
+                hfirst = 0;
+            }
+            fprintf(out, "}}");
+            first = 0;
+        }
+    }
+
+    fprintf(out, "},\"reserved\":{");
+    first = 1;
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        if (!d || !d->rsv_mask) continue;
+        fprintf(out, "%s\"%s\":%llu", first ? "" : ",", d->name, (unsigned long long)reserved_frames(a, d));
+        first = 0;
+    }
+
+    fprintf(out, "},\"th\":{");
+    for (int p = 0; p < 2; p++){
+        fprintf(out, "%s\"p%d\":[", p ? "," : "", p + 1);
+        for (int s = 0; s < HERMES_TH_STAGES; s++){
+            hist_sum_t hs;
+            hist_summary(a->level[p][s], &hs);
+            int any = a->frames != 0;
+            fprintf(out, "%s{\"stage\":%d,\"level_min\":%d,\"level_max\":%d,\"level_mean\":%.4f,"
+                         "\"t_min_us\":%u,\"t_max_us\":%u,\"t_mean_us\":%.2f}",
+                    s ? "," : "", s + 1, hs.min, hs.max, hs.mean,
+                    any ? a->t_min[p][s] : 0, a->t_max[p][s],
+                    any ? (double)a->t_sum[p][s] / (double)a->frames : 0.0);
+        }
+        fprintf(out, "]");
+    }
+    fprintf(out, "}}\n");
+}
+
+int aggregate_report(FILE *out, const hermes_agg_t *a, record_format_t fmt){
+    if (fmt == RECORD_NDJSON) report_json(out, a);
+    else report_text(out, a);
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,918 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "archive.h"
+#include "regmap.h"
+
+#define ARC_MAGIC       ARCHIVE_MAGIC
+#define ARC_MAGIC_LEN   8
+#define ARC_VERSION     1
+#define ARC_MAX_COLS    (ARCHIVE_NUM_META + REGMAP_NUM_FIELDS + REGMAP_NUM_REGS)
+#define ARC_CHUNK_BYTES (8 + 4 + 1 + 8 + 8)   // entrada del indice por columna
+#define ARC_DICT_MAX    256
+
+static const char *const ENC_NAME[ARCHIVE_NUM_ENC] = { "for", "delta", "rle", "dict" };
+
+/* ------------------ buffer de bytes y bits ------------------ */
+typedef struct {
+    uint8_t *p;
+    size_t len, cap;
+    int err;
+} bbuf_t;
+
+static void bb_put(bbuf_t *b, const void *s, size_t n){
+    if (b->len + n > b->cap){
+        size_t cap = b->cap ? b->cap : 4096;
+        while (cap < b->len + n) cap *= 2;
+        uint8_t *np = realloc(b->p, cap);
+        if (!np){
+            b->err = 1;
+            return;
+        }
+        b->p = np;
+        b->cap = cap;
+    }
+    memcpy(b->p + b->len, s, n);
+    b->len += n;
+}
+
+static void bb_u8(bbuf_t *b, uint8_t v){ bb_put(b, &v, 1); }
+
+static void bb_u32(bbuf_t *b, uint32_t v){
+    uint8_t s[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    bb_put(b, s, 4);
+}
+
+static void bb_u64(bbuf_t *b, uint64_t v){
+    bb_u32(b, (uint32_t)v);
+    bb_u32(b, (uint32_t)(v >> 32));
+}
+
+static void bb_varint(bbuf_t *b, uint64_t v){
+    uint8_t s[10];
+    int n = 0;
+    while (v >= 0x80){
+        s[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    s[n++] = (uint8_t)v;
+    bb_put(b, s, (size_t)n);
+}
+
+static uint32_t rd_u32(const uint8_t *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t rd_u64(const uint8_t *p){
+    return (uint64_t)rd_u32(p) | ((uint64_t)rd_u32(p + 4) << 32);
+}
+
+/* Bits LSB primero, sobre espacio ya reservado con bb_reserve() */
+typedef struct {
+    bbuf_t  *b;
+    uint8_t *out;
+    uint64_t acc;
+    int      nacc;           // < 32 entre llamadas
+} bitw_t;
+
+static int bb_reserve(bbuf_t *b, size_t n){
+    if (b->len + n <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < b->len + n) cap *= 2;
+    uint8_t *np = realloc(b->p, cap);
+    if (!np){
+        b->err = 1;
+        return -1;
+    }
+    b->p = np;
+    b->cap = cap;
+    return 0;
+}
+
+/* Empaqueta n valores de bits bits: reserva justo ceil(n * bits / 8) bytes */
+static int bw_start(bitw_t *w, bbuf_t *b, uint32_t n, int bits){
+    if (bb_reserve(b, ((size_t)n * (size_t)bits + 7) / 8 + 4) != 0) return -1;
+    *w = (bitw_t){ b, b->p + b->len, 0, 0 };
+    return 0;
+}
+
+static inline void bw_put(bitw_t *w, uint64_t v, int bits){
+    if (bits > 32){
+        bw_put(w, v & 0xFFFFFFFFu, 32);
+        v >>= 32;
+        bits -= 32;
+    }
+    w->acc |= v << w->nacc;
+    w->nacc += bits;
+    if (w->nacc >= 32){
+        uint32_t x = (uint32_t)w->acc;
+        w->out[0] = (uint8_t)x;
+        w->out[1] = (uint8_t)(x >> 8);
+        w->out[2] = (uint8_t)(x >> 16);
+        w->out[3] = (uint8_t)(x >> 24);
+        w->out += 4;
+        w->acc >>= 32;
+        w->nacc -= 32;
+    }
+}
+
+static void bw_end(bitw_t *w){
+    for (; w->nacc > 0; w->nacc -= 8){
+        *w->out++ = (uint8_t)w->acc;
+        w->acc >>= 8;
+    }
+    w->b->len = (size_t)(w->out - w->b->p);
+}
+
+typedef struct {
+    const uint8_t *p, *end;
+    uint64_t acc;
+    int      nacc;
+} bitr_t;
+
+static int br_get(bitr_t *r, int bits, uint64_t *v){
+    uint64_t out = 0;
+    for (int got = 0; got < bits; ){
+        int take = (bits - got) > 32 ? 32 : bits - got;
+        while (r->nacc < take){
+            if (r->p >= r->end) return -1;
+            r->acc |= (uint64_t)*r->p++ << r->nacc;
+            r->nacc += 8;
+        }
+        out |= (r->acc & ((1ull << take) - 1)) << got;
+        r->acc >>= take;
+        r->nacc -= take;
+        got += take;
+    }
+    *v = out;
+    return 0;
+}
+
+static int rd_varint(const uint8_t **p, const uint8_t *end, uint64_t *v){
+    uint64_t out = 0;
+    for (int shift = 0; shift < 64; shift += 7){
+        if (*p >= end) return -1;
+        uint8_t c = *(*p)++;
+        out |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)){
+            *v = out;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int bits_for(uint64_t x){
+    return x ? 64 - __builtin_clzll(x) : 0;
+}
+
+static uint64_t zigzag(int64_t v){ return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t  unzigzag(uint64_t v){ return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+/* ------------------ codificaciones ------------------
+ * Primero se mide lo que ocuparia cada codificacion (una pasada por la
+ * columna) y solo se codifica la ganadora.
+ */
+static int varint_len(uint64_t v){
+    return v ? 1 + (bits_for(v) - 1) / 7 : 1;
+}
+
+static size_t packed_len(uint32_t n, int bits){
+    return ((size_t)n * (size_t)bits + 7) / 8;
+}
+
+static int cmp_u64(const void *a, const void *b){
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    uint64_t min, max;
+    int64_t  dmin, dmax;
+    size_t   size[ARCHIVE_NUM_ENC];   // SIZE_MAX = no aplicable
+    int      nd;                      // valores distintos (<= ARC_DICT_MAX)
+    uint64_t dict[ARC_DICT_MAX];      // ordenados
+    int16_t  slot[256];               // valor -> indice (width <= 8)
+} col_plan_t;
+
+static void col_plan(col_plan_t *p, const uint64_t *v, uint32_t n, int width){
+    p->min = p->max = v[0];
+    p->dmin = p->dmax = 0;
+    size_t rle = 0;
+    uint32_t run_start = 0;
+
+    for (uint32_t i = 1; i < n; i++){
+        if (v[i] < p->min) p->min = v[i];
+        if (v[i] > p->max) p->max = v[i];
+        int64_t d = (int64_t)(v[i] - v[i - 1]);
+        if (i == 1 || d < p->dmin) p->dmin = d;
+        if (i == 1 || d > p->dmax) p->dmax = d;
+        if (v[i] != v[i - 1]){
+            rle += (size_t)(varint_len(v[i - 1]) + varint_len(i - run_start));
+            run_start = i;
+        }
+    }
+    rle += (size_t)(varint_len(v[n - 1]) + varint_len(n - run_start));
+
+    p->size[ARCHIVE_ENC_FOR] = 1 + (size_t)varint_len(p->min) + packed_len(n, bits_for(p->max - p->min));
+    p->size[ARCHIVE_ENC_DELTA] = (size_t)varint_len(v[0]) + (size_t)varint_len(zigzag(p->dmin)) + 1 +
+                                 packed_len(n - 1, bits_for((uint64_t)p->dmax - (uint64_t)p->dmin));
+    p->size[ARCHIVE_ENC_RLE] = rle;
+    p->size[ARCHIVE_ENC_DICT] = SIZE_MAX;
+
+    /* Diccionario: tabla directa para campos de registro, orden para metadatos */
+    p->nd = 0;
+    if (width <= 8){
+        memset(p->slot, -1, sizeof(p->slot));
+        for (uint32_t i = 0; i < n; i++) p->slot[v[i]] = 0;
+        for (int x = 0; x < 256; x++){
+            if (p->slot[x] < 0) continue;
+            p->slot[x] = (int16_t)p->nd;
+            p->dict[p->nd++] = (uint64_t)x;
+        }
+    } else {
+        /* Metadatos: conjunto hash pequeno; frame_id/offset se descartan a los 257 valores */
+        uint64_t set[2 * ARC_DICT_MAX];
+        uint8_t used[2 * ARC_DICT_MAX] = {0};
+        for (uint32_t i = 0; i < n; i++){
+            unsigned h = (unsigned)((v[i] * 0x9E3779B97F4A7C15ull) >> 55);   // 9 bits
+            while (used[h] && set[h] != v[i]) h = (h + 1) & (2 * ARC_DICT_MAX - 1);
+            if (used[h]) continue;
+            if (p->nd == ARC_DICT_MAX){
+                p->nd = 0;
+                return;
+            }
+            used[h] = 1;
+            set[h] = v[i];
+            p->dict[p->nd++] = v[i];
+        }
+        qsort(p->dict, (size_t)p->nd, sizeof(p->dict[0]), cmp_u64);
+    }
+
+    size_t sz = (size_t)varint_len((uint64_t)p->nd) + 1 + packed_len(n, bits_for((uint64_t)(p->nd - 1)));
+    for (int k = 0; k < p->nd; k++) sz += (size_t)varint_len(p->dict[k]);
+    p->size[ARCHIVE_ENC_DICT] = sz;
+}
+
+static void col_encode(bbuf_t *b, const col_plan_t *p, int enc, const uint64_t *v, uint32_t n, int width){
+    bitw_t w;
+    int bits;
+
+    switch (enc){
+    case ARCHIVE_ENC_FOR:
+        bits = bits_for(p->max - p->min);
+        bb_u8(b, (uint8_t)bits);
+        bb_varint(b, p->min);
+        if (bw_start(&w, b, n, bits) != 0) return;
+        for (uint32_t i = 0; i < n; i++) bw_put(&w, v[i] - p->min, bits);
+        bw_end(&w);
+        return;
+
+    case ARCHIVE_ENC_DELTA:
+        bits = bits_for((uint64_t)p->dmax - (uint64_t)p->dmin);
+        bb_varint(b, v[0]);
+        bb_varint(b, zigzag(p->dmin));
+        bb_u8(b, (uint8_t)bits);
+        if (bw_start(&w, b, n - 1, bits) != 0) return;
+        for (uint32_t i = 1; i < n; i++) bw_put(&w, (uint64_t)((int64_t)(v[i] - v[i - 1]) - p->dmin), bits);
+        bw_end(&w);
+        return;
+
+    case ARCHIVE_ENC_RLE:
+        for (uint32_t i = 0; i < n; ){
+            uint32_t j = i + 1;
+            while (j < n && v[j] == v[i]) j++;
+            bb_varint(b, v[i]);
+            bb_varint(b, j - i);
+            i = j;
+        }
+        return;
+
+    case ARCHIVE_ENC_DICT:
+        bits = bits_for((uint64_t)(p->nd - 1));
+        bb_varint(b, (uint64_t)p->nd);
+        for (int k = 0; k < p->nd; k++) bb_varint(b, p->dict[k]);
+        bb_u8(b, (uint8_t)bits);
+        if (bw_start(&w, b, n, bits) != 0) return;
+        for (uint32_t i = 0; i < n; i++){
+            if (width <= 8){
+                bw_put(&w, (uint64_t)p->slot[v[i]], bits);
+            } else {
+                const uint64_t *hit = bsearch(&v[i], p->dict, (size_t)p->nd, sizeof(p->dict[0]), cmp_u64);
+                bw_put(&w, (uint64_t)(hit - p->dict), bits);
+            }
+        }
+        bw_end(&w);
+        return;
+    }
+}
+
+static int dec_chunk(const uint8_t *p, const uint8_t *end, int enc, uint32_t n, uint64_t *out){
+    uint64_t x, base, bits;
+    bitr_t r;
+
+    switch (enc){
+    case ARCHIVE_ENC_FOR:
+        if (p >= end) return -1;
+        bits = *p++;
+        if (bits > 64 || rd_varint(&p, end, &base) != 0) return -1;
+        r = (bitr_t){ p, end, 0, 0 };
+        for (uint32_t i = 0; i < n; i++){
+            if (br_get(&r, (int)bits, &x) != 0) return -1;
+            out[i] = base + x;
+        }
+        return 0;
+
+    case ARCHIVE_ENC_DELTA: {
+        uint64_t first, zmin;
+        if (rd_varint(&p, end, &first) != 0 || rd_varint(&p, end, &zmin) != 0 || p >= end) return -1;
+        bits = *p++;
+        if (bits > 64) return -1;
+        int64_t dmin = unzigzag(zmin);
+        r = (bitr_t){ p, end, 0, 0 };
+        if (n) out[0] = first;
+        for (uint32_t i = 1; i < n; i++){
+            if (br_get(&r, (int)bits, &x) != 0) return -1;
+            out[i] = out[i - 1] + (uint64_t)((int64_t)x + dmin);
+        }
+        return 0;
+    }
+
+    case ARCHIVE_ENC_RLE:
+        for (uint32_t i = 0; i < n; ){
+            uint64_t run;
+            if (rd_varint(&p, end, &x) != 0 || rd_varint(&p, end, &run) != 0) return -1;
+            if (run == 0 || run > n - i) return -1;
+            for (uint64_t k = 0; k < run; k++) out[i++] = x;
+        }
+        return 0;
+
+    case ARCHIVE_ENC_DICT: {
+        uint64_t nd, dict[ARC_DICT_MAX];
+        if (rd_varint(&p, end, &nd) != 0 || nd == 0 || nd > ARC_DICT_MAX) return -1;
+        for (uint64_t k = 0; k < nd; k++){
+            if (rd_varint(&p, end, &dict[k]) != 0) return -1;
+        }
+        if (p >= end) return -1;
+        bits = *p++;
+        r = (bitr_t){ p, end, 0, 0 };
+        for (uint32_t i = 0; i < n; i++){
+            if (br_get(&r, (int)bits, &x) != 0 || x >= nd) return -1;
+            out[i] = dict[x];
+        }
+        return 0;
+    }
+    }
+    return -1;
+}
+
+/* ------------------ esquema ------------------ */
+static int build_schema(archive_col_t *cols){
+    static const archive_col_t META[ARCHIVE_NUM_META] = {
+        { "frame_id", 0, 0, 64 }, { "offset", 0, 0, 64 }, { "timestamp_us", 0, 0, 64 }, { "prefix", 0, 0, 16 },
+    };
+    int n = 0;
+    for (; n < ARCHIVE_NUM_META; n++) cols[n] = META[n];
+
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        if (d->nfields == 0){
+            cols[n] = (archive_col_t){ "", (uint8_t)idx, 0, 8 };
+            snprintf(cols[n].name, sizeof(cols[n].name), "%s", d->name);
+            n++;
+            continue;
+        }
+        for (int f = 0; f < d->nfields; f++){
+            cols[n] = (archive_col_t){ "", (uint8_t)idx, d->fields[f].lsb, d->fields[f].width };
+            snprintf(cols[n].name, sizeof(cols[n].name), "%s.%s", d->name, d->fields[f].name);
+            n++;
+        }
+    }
+    return n;
+}
+
+/* ------------------ escritura ------------------ */
+typedef struct {
+    uint64_t frame_id, offset, ts;
+    uint16_t prefix;
+    uint8_t  reg[HERMES_NUM_REGS];
+} arc_row_t;
+
+/*
+ * Bloque en construccion: la trama seq va a rows[(seq - 1) % ARCHIVE_GROUP_ROWS]
+ * del bloque (seq - 1) / ARCHIVE_GROUP_ROWS, llegue en el orden que llegue.
+ * frame_id == 0 marca una fila vacia.
+ */
+typedef struct {
+    arc_row_t *rows;
+    uint32_t   n;
+} arc_group_t;
+
+struct archive_writer {
+    FILE *f;
+    char *fbuf;
+    pthread_mutex_t mu;
+    int err;
+    uint64_t pos;
+
+    archive_col_t cols[ARC_MAX_COLS];
+    int ncols;
+
+    /* bajo mu */
+    arc_group_t **pend;      // pend[i]: bloque head + i (NULL si aun no tiene filas)
+    size_t   npend, pend_cap;
+    uint64_t head;           // primer bloque sin volcar
+    int      flushing;       // hay un hilo volcando: solo el toca lo de abajo
+    int      failed;
+
+    /* del hilo que vuelca */
+    uint64_t *vals;
+    col_plan_t plan;
+    bbuf_t enc;              // trozo de columna en curso
+
+    bbuf_t dir;              // entradas del indice ya serializadas
+    uint64_t groups, total_rows;
+    uint64_t col_bytes[ARCHIVE_NUM_ENC];
+};
+
+static void aw_write(archive_writer_t *w, const void *p, size_t n){
+    if (fwrite(p, 1, n, w->f) != n) w->err = 1;
+    w->pos += n;
+}
+
+/* PULSE_P2.UART_ADDR: REG12 bits 7..4 */
+#define ARC_DEVICE(r) ((r)->reg[11] >> 4)
+
+static int cmp_row(const void *a, const void *b){
+    const arc_row_t *x = a, *y = b;
+    if (ARC_DEVICE(x) != ARC_DEVICE(y)) return ARC_DEVICE(x) - ARC_DEVICE(y);
+    return (x->frame_id > y->frame_id) - (x->frame_id < y->frame_id);
+}
+
+static void col_values(const archive_col_t *c, int ci, const arc_row_t *rows, uint32_t n, uint64_t *v){
+    switch (ci){
+    case ARCHIVE_COL_FRAME_ID:  for (uint32_t i = 0; i < n; i++) v[i] = rows[i].frame_id; return;
+    case ARCHIVE_COL_OFFSET:    for (uint32_t i = 0; i < n; i++) v[i] = rows[i].offset; return;
+    case ARCHIVE_COL_TIMESTAMP: for (uint32_t i = 0; i < n; i++) v[i] = rows[i].ts; return;
+    case ARCHIVE_COL_PREFIX:    for (uint32_t i = 0; i < n; i++) v[i] = rows[i].prefix; return;
+    }
+    unsigned mask = (1u << c->width) - 1u;
+    for (uint32_t i = 0; i < n; i++) v[i] = (rows[i].reg[c->reg_idx - 1] >> c->lsb) & mask;
+}
+
+/* Codifica y escribe un bloque. Sin mu: solo lo llama el hilo que vuelca. */
+static int flush_group(archive_writer_t *w, arc_group_t *grp){
+    arc_row_t *rows = grp->rows;
+    uint32_t n = grp->n;
+    if (n == 0) return 0;
+
+    if (n < ARCHIVE_GROUP_ROWS){   // ultimo bloque: se juntan las filas
+        uint32_t k = 0;
+        for (uint32_t i = 0; k < n && i < ARCHIVE_GROUP_ROWS; i++){
+            if (rows[i].frame_id) rows[k++] = rows[i];
+        }
+    }
+    qsort(rows, n, sizeof(*rows), cmp_row);
+    bb_u32(&w->dir, n);
+
+    for (int c = 0; c < w->ncols; c++){
+        uint64_t *v = w->vals;
+        col_values(&w->cols[c], c, rows, n, v);
+
+        col_plan(&w->plan, v, n, w->cols[c].width);
+        int best = ARCHIVE_ENC_FOR;
+        for (int e = 1; e < ARCHIVE_NUM_ENC; e++){
+            if (w->plan.size[e] < w->plan.size[best]) best = e;
+        }
+        bbuf_t *out = &w->enc;
+        out->len = 0;
+        col_encode(out, &w->plan, best, v, n, w->cols[c].width);
+        w->err |= out->err;
+
+        bb_u64(&w->dir, w->pos);
+        bb_u32(&w->dir, (uint32_t)out->len);
+        bb_u8(&w->dir, (uint8_t)best);
+        bb_u64(&w->dir, w->plan.min);
+        bb_u64(&w->dir, w->plan.max);
+        aw_write(w, out->p, out->len);
+        w->col_bytes[best] += out->len;
+    }
+
+    w->groups++;
+    w->total_rows += n;
+    w->err |= w->dir.err;
+    return w->err ? -1 : 0;
+}
+
+static void group_free(arc_group_t *grp){
+    if (!grp) return;
+    free(grp->rows);
+    free(grp);
+}
+
+/* Bloque g (>= head), creandolo si hace falta. Con mu tomado; NULL sin memoria. */
+static arc_group_t *pend_group(archive_writer_t *w, uint64_t g){
+    size_t i = (size_t)(g - w->head);
+    if (i >= w->pend_cap){
+        size_t cap = w->pend_cap ? w->pend_cap : 8;
+        while (cap <= i) cap *= 2;
+        arc_group_t **np = realloc(w->pend, cap * sizeof(*np));
+        if (!np) return NULL;
+        memset(np + w->pend_cap, 0, (cap - w->pend_cap) * sizeof(*np));
+        w->pend = np;
+        w->pend_cap = cap;
+    }
+    if (i >= w->npend) w->npend = i + 1;
+    if (!w->pend[i]){
+        arc_group_t *grp = calloc(1, sizeof(*grp));
+        if (grp) grp->rows = calloc(ARCHIVE_GROUP_ROWS, sizeof(*grp->rows));
+        if (!grp || !grp->rows){
+            group_free(grp);
+            return NULL;
+        }
+        w->pend[i] = grp;
+    }
+    return w->pend[i];
+}
+
+/*
+ * Vuelca en orden los bloques completos de cabeza (todos si final). Con mu
+ * tomado: el bloque se saca de pend bajo mu y se codifica sin el, y solo un
+ * hilo vuelca a la vez, asi que los demas siguen anadiendo filas.
+ */
+static void drain(archive_writer_t *w, int final){
+    if (w->flushing) return;
+    w->flushing = 1;
+    while (w->npend > 0){
+        arc_group_t *grp = w->pend[0];
+        if (!final && (!grp || grp->n < ARCHIVE_GROUP_ROWS)) break;
+        memmove(w->pend, w->pend + 1, (w->npend - 1) * sizeof(*w->pend));
+        w->pend[--w->npend] = NULL;
+        w->head++;
+        if (!grp) continue;
+
+        pthread_mutex_unlock(&w->mu);
+        int rc = flush_group(w, grp);
+        group_free(grp);
+        pthread_mutex_lock(&w->mu);
+        if (rc != 0) w->failed = 1;
+    }
+    w->flushing = 0;
+}
+
+static void writer_free(archive_writer_t *w){
+    for (size_t i = 0; i < w->npend; i++) group_free(w->pend[i]);
+    free(w->pend);
+    free(w->vals);
+    free(w->enc.p);
+    free(w->dir.p);
+    free(w->fbuf);
+    pthread_mutex_destroy(&w->mu);
+    free(w);
+}
+
+archive_writer_t *archive_create(const char *path){
+    archive_writer_t *w = calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    pthread_mutex_init(&w->mu, NULL);
+
+    w->vals = malloc(ARCHIVE_GROUP_ROWS * sizeof(*w->vals));
+    w->fbuf = malloc(1u << 20);
+    if (!w->vals || !w->fbuf){
+        writer_free(w);
+        return NULL;
+    }
+
+    w->f = fopen(path, "wb");
+    if (!w->f){
+        fprintf(stderr, "No se pudo crear %s.\n", path);
+        writer_free(w);
+        return NULL;
+    }
+    setvbuf(w->f, w->fbuf, _IOFBF, 1u << 20);
+
+    w->ncols = build_schema(w->cols);
+
+    bbuf_t h = {0};
+    bb_put(&h, ARC_MAGIC, ARC_MAGIC_LEN);
+    bb_u32(&h, ARC_VERSION);
+    bb_u32(&h, (uint32_t)w->ncols);
+    for (int c = 0; c < w->ncols; c++){
+        size_t len = strlen(w->cols[c].name);
+        bb_u8(&h, (uint8_t)len);
+        bb_put(&h, w->cols[c].name, len);
+        bb_u8(&h, w->cols[c].reg_idx);
+        bb_u8(&h, w->cols[c].lsb);
+        bb_u8(&h, w->cols[c].width);
+    }
+    w->err |= h.err;
+    aw_write(w, h.p, h.len);
+    free(h.p);
+    return w;
+}
+
+int archive_add(archive_writer_t *w, const hermes_frame_t *fr){
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    arc_row_t row;
+    row.frame_id = fr->seq;
+    row.offset = fr->offset;
+    row.ts = (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+    row.prefix = fr->prefix;
+    memcpy(row.reg, fr->reg, HERMES_NUM_REGS);
+
+    uint64_t g = (fr->seq - 1) / ARCHIVE_GROUP_ROWS;
+    int rc = -1;
+
+    pthread_mutex_lock(&w->mu);
+    arc_group_t *grp = (fr->seq >= 1 && g >= w->head) ? pend_group(w, g) : NULL;
+    if (grp){
+        arc_row_t *r = &grp->rows[(fr->seq - 1) % ARCHIVE_GROUP_ROWS];
+        if (r->frame_id == 0){   // seq repetido: se rechaza
+            *r = row;
+            grp->n++;
+            rc = 0;
+        }
+    }
+    if (grp && grp->n == ARCHIVE_GROUP_ROWS) drain(w, 0);
+    if (w->failed) rc = -1;
+    pthread_mutex_unlock(&w->mu);
+    return rc;
+}
+
+int archive_finish(archive_writer_t *w, archive_stats_t *st){
+    pthread_mutex_lock(&w->mu);
+    drain(w, 1);
+    pthread_mutex_unlock(&w->mu);
+
+    uint8_t tail[8 + ARC_MAGIC_LEN];
+    uint64_t dir_off = w->pos;
+    bbuf_t b = { tail, 0, sizeof(tail), 0 };   // sin realloc: cabe justo
+    bb_u64(&b, dir_off);
+    bb_put(&b, ARC_MAGIC, ARC_MAGIC_LEN);
+
+    uint8_t ng[4] = { (uint8_t)w->groups, (uint8_t)(w->groups >> 8), (uint8_t)(w->groups >> 16), (uint8_t)(w->groups >> 24) };
+    aw_write(w, ng, sizeof(ng));
+    aw_write(w, w->dir.p, w->dir.len);
+    aw_write(w, tail, sizeof(tail));
+
+    int rc = w->err ? -1 : 0;
+    if (fclose(w->f) != 0) rc = -1;
+
+    if (st){
+        memset(st, 0, sizeof(*st));
+        st->rows = w->total_rows;
+        st->groups = w->groups;
+        st->bytes = w->pos;
+        memcpy(st->col_bytes, w->col_bytes, sizeof(st->col_bytes));
+    }
+    writer_free(w);
+    return rc;
+}
+
+/* ------------------ lectura ------------------ */
+struct archive {
+    const uint8_t *map;
+    size_t len;
+    archive_col_t cols[ARC_MAX_COLS];
+    int ncols;
+    int ngroups;
+    const uint8_t *dir;      // primera entrada de bloque
+    size_t group_bytes;      // 4 + ncols * ARC_CHUNK_BYTES
+    uint64_t rows;
+};
+
+static archive_t *bad_archive(archive_t *a, const char *path, const char *why){
+    fprintf(stderr, "%s: %s.\n", path, why);
+    archive_close(a);
+    return NULL;
+}
+
+archive_t *archive_open(const char *path){
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        fprintf(stderr, "No se pudo abrir %s.\n", path);
+        return NULL;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || sb.st_size < (off_t)(2 * ARC_MAGIC_LEN + 8 + 8)){
+        close(fd);
+        fprintf(stderr, "%s: no es un archivo de tramas.\n", path);
+        return NULL;
+    }
+
+    archive_t *a = calloc(1, sizeof(*a));
+    if (!a){
+        close(fd);
+        return NULL;
+    }
+    a->len = (size_t)sb.st_size;
+    void *m = mmap(NULL, a->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED){
+        free(a);
+        fprintf(stderr, "No se pudo mapear %s.\n", path);
+        return NULL;
+    }
+    a->map = m;
+
+    const uint8_t *p = a->map, *end = a->map + a->len;
+    if (memcmp(p, ARC_MAGIC, ARC_MAGIC_LEN) != 0 || memcmp(end - ARC_MAGIC_LEN, ARC_MAGIC, ARC_MAGIC_LEN) != 0){
+        return bad_archive(a, path, "no es un archivo de tramas");
+    }
+    if (rd_u32(p + 8) != ARC_VERSION) return bad_archive(a, path, "version no soportada");
+
+    uint32_t ncols = rd_u32(p + 12);
+    if (ncols < ARCHIVE_NUM_META || ncols > ARC_MAX_COLS) return bad_archive(a, path, "esquema no valido");
+    p += 16;
+    for (uint32_t c = 0; c < ncols; c++){
+        if (p >= end || p + 1 + *p + 3 > end || *p >= ARCHIVE_NAME_MAX) return bad_archive(a, path, "esquema truncado");
+        size_t nl = *p++;
+        memcpy(a->cols[c].name, p, nl);
+        a->cols[c].name[nl] = '\0';
+        p += nl;
+        a->cols[c].reg_idx = p[0];
+        a->cols[c].lsb = p[1];
+        a->cols[c].width = p[2];
+        p += 3;
+        if (a->cols[c].reg_idx > REGMAP_NUM_REGS || a->cols[c].width == 0 || a->cols[c].width > 64 ||
+            (a->cols[c].reg_idx && a->cols[c].lsb + a->cols[c].width > 8)){
+            return bad_archive(a, path, "esquema no valido");
+        }
+    }
+    a->ncols = (int)ncols;
+
+    uint64_t dir_off = rd_u64(end - ARC_MAGIC_LEN - 8);
+    if (dir_off + 4 > a->len - ARC_MAGIC_LEN - 8) return bad_archive(a, path, "indice no valido");
+    a->ngroups = (int)rd_u32(a->map + dir_off);
+    a->dir = a->map + dir_off + 4;
+    a->group_bytes = 4 + (size_t)ncols * ARC_CHUNK_BYTES;
+    if ((uint64_t)a->ngroups * a->group_bytes != a->len - ARC_MAGIC_LEN - 8 - dir_off - 4){
+        return bad_archive(a, path, "indice truncado");
+    }
+    for (int g = 0; g < a->ngroups; g++) a->rows += archive_group_rows(a, g);
+    return a;
+}
+
+void archive_close(archive_t *a){
+    if (!a) return;
+    if (a->map) munmap((void *)a->map, a->len);
+    free(a);
+}
+
+uint64_t archive_rows(const archive_t *a){ return a->rows; }
+int      archive_num_groups(const archive_t *a){ return a->ngroups; }
+int      archive_num_cols(const archive_t *a){ return a->ncols; }
+
+uint32_t archive_group_rows(const archive_t *a, int g){
+    return rd_u32(a->dir + (size_t)g * a->group_bytes);
+}
+
+const archive_col_t *archive_col(const archive_t *a, int c){
+    return (c >= 0 && c < a->ncols) ? &a->cols[c] : NULL;
+}
+
+int archive_find_col(const archive_t *a, const char *name){
+    if (strcmp(name, "device") == 0) name = "PULSE_P2.UART_ADDR";
+
+    int found = -1;
+    for (int c = 0; c < a->ncols; c++){
+        const char *cn = a->cols[c].name;
+        if (strcmp(cn, name) == 0) return c;
+        const char *dot = strchr(cn, '.');
+        if (dot && strcmp(dot + 1, name) == 0){
+            if (found >= 0) return -1;   // ambiguo sin "REG."
+            found = c;
+        }
+    }
+    return found;
+}
+
+void archive_chunk(const archive_t *a, int g, int c, archive_chunk_t *ch){
+    const uint8_t *e = a->dir + (size_t)g * a->group_bytes + 4 + (size_t)c * ARC_CHUNK_BYTES;
+    ch->off = rd_u64(e);
+    ch->size = rd_u32(e + 8);
+    ch->enc = e[12];
+    ch->min = rd_u64(e + 13);
+    ch->max = rd_u64(e + 21);
+}
+
+int archive_read_col(const archive_t *a, int g, int c, uint64_t *out){
+    if (g < 0 || g >= a->ngroups || c < 0 || c >= a->ncols) return -1;
+
+    archive_chunk_t ch;
+    archive_chunk(a, g, c, &ch);
+    if (ch.off > a->len || ch.size > a->len - ch.off) return -1;
+    return dec_chunk(a->map + ch.off, a->map + ch.off + ch.size, ch.enc, archive_group_rows(a, g), out);
+}
+
+int archive_read_frames(const archive_t *a, int g, uint8_t (*frames)[HERMES_FRAME_BYTES],
+                        uint64_t *frame_id, uint64_t *offset, uint64_t *ts){
+    uint32_t n = archive_group_rows(a, g);
+    uint64_t *v = malloc((n ? n : 1) * sizeof(*v));
+    if (!v) return -1;
+    memset(frames, 0, (size_t)n * HERMES_FRAME_BYTES);
+
+    int rc = 0;
+    for (int c = 0; c < a->ncols && rc == 0; c++){
+        const archive_col_t *col = &a->cols[c];
+        uint64_t *dst = (c == ARCHIVE_COL_FRAME_ID) ? frame_id : (c == ARCHIVE_COL_OFFSET) ? offset :
+                        (c == ARCHIVE_COL_TIMESTAMP) ? ts : NULL;
+        if (c < ARCHIVE_NUM_META && c != ARCHIVE_COL_PREFIX && !dst) continue;
+
+        rc = archive_read_col(a, g, c, dst ? dst : v);
+        if (rc != 0 || dst) continue;
+
+        if (c == ARCHIVE_COL_PREFIX){
+            for (uint32_t i = 0; i < n; i++){
+                frames[i][0] = (uint8_t)(v[i] >> 8);
+                frames[i][1] = (uint8_t)v[i];
+            }
+        } else {
+            uint8_t *base = &frames[0][HERMES_PREFIX_BYTES + col->reg_idx - 1];
+            for (uint32_t i = 0; i < n; i++) base[(size_t)i * HERMES_FRAME_BYTES] |= (uint8_t)(v[i] << col->lsb);
+        }
+    }
+    free(v);
+    return rc;
+}
+
+static const uint64_t *hex_ids;   // clave de qsort en archive_write_hex (un solo hilo)
+
+static int cmp_by_id(const void *a, const void *b){
+    uint64_t x = hex_ids[*(const uint32_t *)a], y = hex_ids[*(const uint32_t *)b];
+    return (x > y) - (x < y);
+}
+
+int archive_write_hex(FILE *out, const archive_t *a){
+    static const char HEX[] = "0123456789ABCDEF";
+    uint8_t (*frames)[HERMES_FRAME_BYTES] = malloc(ARCHIVE_GROUP_ROWS * sizeof(*frames));
+    uint64_t *ids = malloc(ARCHIVE_GROUP_ROWS * sizeof(*ids));
+    uint32_t *order = malloc(ARCHIVE_GROUP_ROWS * sizeof(*order));
+    int rc = (frames && ids && order) ? 0 : -1;
+
+    for (int g = 0; g < a->ngroups && rc == 0; g++){
+        uint32_t n = archive_group_rows(a, g);
+        if (n > ARCHIVE_GROUP_ROWS || archive_read_frames(a, g, frames, ids, NULL, NULL) != 0){
+            fprintf(stderr, "Bloque %d corrupto.\n", g);
+            rc = -1;
+            break;
+        }
+        /* En disco van por dispositivo: se devuelven en el orden de la entrada */
+        for (uint32_t i = 0; i < n; i++) order[i] = i;
+        hex_ids = ids;
+        qsort(order, n, sizeof(*order), cmp_by_id);
+
+        for (uint32_t i = 0; i < n; i++){
+            const uint8_t *f = frames[order[i]];
+            char s[3 * HERMES_FRAME_BYTES];
+            for (int b = 0; b < HERMES_FRAME_BYTES; b++){
+                s[3 * b]     = HEX[f[b] >> 4];
+                s[3 * b + 1] = HEX[f[b] & 0x0F];
+                s[3 * b + 2] = ' ';
+            }
+            s[3 * HERMES_FRAME_BYTES - 1] = '\n';
+            if (fwrite(s, 1, sizeof(s), out) != sizeof(s)){
+                rc = -1;
+                break;
+            }
+        }
+    }
+    free(frames);
+    free(ids);
+    free(order);
+    return rc;
+}
+
+void archive_print_info(FILE *out, const archive_t *a){
+    fprintf(out, "Archivo: %llu tramas, %d bloques, %d columnas, %zu bytes (%.1f bytes/trama)\n\n",
+            (unsigned long long)a->rows, a->ngroups, a->ncols, a->len,
+            a->rows ? (double)a->len / (double)a->rows : 0.0);
+    fprintf(out, "  %-32s %5s %12s  %s\n", "columna", "bits", "bytes", "codificaciones");
+
+    for (int c = 0; c < a->ncols; c++){
+        uint64_t bytes = 0, uses[ARCHIVE_NUM_ENC] = {0};
+        for (int g = 0; g < a->ngroups; g++){
+            archive_chunk_t ch;
+            archive_chunk(a, g, c, &ch);
+            bytes += ch.size;
+            if (ch.enc < ARCHIVE_NUM_ENC) uses[ch.enc]++;
+        }
+        fprintf(out, "  %-32s %5u %12llu ", a->cols[c].name, a->cols[c].width, (unsigned long long)bytes);
+        for (int e = 0; e < ARCHIVE_NUM_ENC; e++){
+            if (uses[e]) fprintf(out, " %s=%llu", ENC_NAME[e], (unsigned long long)uses[e]);
+        }
+        fputc('\n', out);
+    }
+}
@@ -0,0 +1,266 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "export.h"
+#include "batch.h"
+
+#define BATCH_BUF_BYTES  (1u << 20)
+
+enum { BX_P1_CSV = 0, BX_P2_CSV, BX_TVG_CSV, BX_P1_JSON, BX_P2_JSON, BX_TVG_JSON, BX_NUM };
+
+typedef struct {
+    FILE *f;
+    char *buf;                // buffer de stdio (BATCH_BUF_BYTES)
+    pthread_mutex_t mu;
+    int err;
+    char path[256];
+} bx_file_t;
+
+/* Filas de una trama que llego antes de su turno (seq == 0: hueco libre) */
+typedef struct {
+    uint64_t seq;
+    char    *p;               // las filas de cada fichero, seguidas
+    size_t   len[BX_NUM];
+} bx_pend_t;
+
+struct batch_export {
+    bx_file_t file[BX_NUM];
+    uint64_t frames;
+    pthread_mutex_t mu;       // frames y, si ordered, todo lo de abajo
+
+    /* ordered: las tramas se escriben en orden de seq aunque lleguen de varios hilos */
+    int ordered;
+    int flushing;             // hay un hilo escribiendo: solo el toca los ficheros
+    uint64_t next;            // siguiente seq a escribir
+    bx_pend_t *pend;          // anillo: la trama seq va en pend[seq & (pend_cap - 1)]
+    size_t pend_cap, npend;
+};
+
+static const char *const BX_KIND[BX_NUM] = { "p1", "p2", "tvg", "p1", "p2", "tvg" };
+
+static int bx_write(FILE *f, const export_key_t *k, const hermes_config_t *cfg, int kind){
+    switch (kind){
+        case BX_P1_CSV:   return fprint_th_rows_csv(f, k, cfg, 0);
+        case BX_P2_CSV:   return fprint_th_rows_csv(f, k, cfg, 1);
+        case BX_TVG_CSV:  return fprint_tvg_rows_csv(f, k, cfg);
+        case BX_P1_JSON:  return fprint_th_ndjson(f, k, cfg, 0);
+        case BX_P2_JSON:  return fprint_th_ndjson(f, k, cfg, 1);
+        case BX_TVG_JSON: return fprint_tvg_ndjson(f, k, cfg);
+        default:          return -1;
+    }
+}
+
+static int bx_close_file(bx_file_t *x){
+    if (!x->f) return 0;
+
+    int rc = x->err ? -1 : 0;
+    if (fclose(x->f) != 0) rc = -1;
+    x->f = NULL;
+    free(x->buf);
+    pthread_mutex_destroy(&x->mu);
+    return rc;
+}
+
+batch_export_t *batch_export_open(const char *prefix, int csv, int json, int ordered){
+    batch_export_t *bx = calloc(1, sizeof(*bx));
+    if (!bx) return NULL;
+    pthread_mutex_init(&bx->mu, NULL);
+    bx->ordered = ordered;
+    bx->next = 1;
+
+    const char *p = (prefix && prefix[0]) ? prefix : NULL;
+
+    for (int i = 0; i < BX_NUM; i++){
+        int is_json = (i >= BX_P1_JSON);
+        if (is_json ? !json : !csv) continue;
+
+        bx_file_t *x = &bx->file[i];
+        snprintf(x->path, sizeof(x->path), "%s%s%s_profile.%s",
+                 p ? p : "", p ? "_" : "", BX_KIND[i], is_json ? "ndjson" : "csv");
+
+        x->f = fopen(x->path, "w");
+        if (!x->f){
+            fprintf(stderr, "No se pudo crear %s.\n", x->path);
+            batch_export_close(bx, NULL);
+            return NULL;
+        }
+        x->buf = malloc(BATCH_BUF_BYTES);
+        if (x->buf) setvbuf(x->f, x->buf, _IOFBF, BATCH_BUF_BYTES);
+        pthread_mutex_init(&x->mu, NULL);
+
+        if (i == BX_TVG_CSV) x->err |= fprint_tvg_rows_csv_header(x->f) != 0;
+        else if (!is_json)   x->err |= fprint_th_rows_csv_header(x->f) != 0;
+    }
+    return bx;
+}
+
+/* Guarda e en el anillo, creciendo si seq queda fuera. Con mu tomado. 0 o -1. */
+static int pend_put(batch_export_t *bx, const bx_pend_t *e){
+    if (e->seq < bx->next) return -1;   // seq repetido
+    if (e->seq - bx->next >= bx->pend_cap){
+        size_t cap = bx->pend_cap ? bx->pend_cap : 1024;
+        while (e->seq - bx->next >= cap) cap *= 2;
+        bx_pend_t *np = calloc(cap, sizeof(*np));
+        if (!np) return -1;
+        for (size_t i = 0; i < bx->pend_cap; i++){
+            if (bx->pend[i].seq) np[bx->pend[i].seq & (cap - 1)] = bx->pend[i];
+        }
+        free(bx->pend);
+        bx->pend = np;
+        bx->pend_cap = cap;
+    }
+    bx_pend_t *slot = &bx->pend[e->seq & (bx->pend_cap - 1)];
+    if (slot->seq) return -1;
+    *slot = *e;
+    bx->npend++;
+    return 0;
+}
+
+/*
+ * Escribe en orden las tramas pendientes a partir de next (todas, saltando
+ * huecos, si final). Con mu tomado y flushing puesto: la escritura se hace
+ * sin mu, asi que los demas hilos siguen renderizando y encolando.
+ */
+static void pend_drain(batch_export_t *bx, int final){
+    while (bx->npend > 0){
+        bx_pend_t *slot = &bx->pend[bx->next & (bx->pend_cap - 1)];
+        if (slot->seq != bx->next){
+            if (!final) break;
+            bx->next++;
+            continue;
+        }
+        bx_pend_t e = *slot;
+        slot->seq = 0;
+        bx->npend--;
+        bx->next++;
+
+        pthread_mutex_unlock(&bx->mu);
+        size_t off = 0;
+        for (int i = 0; i < BX_NUM; i++){
+            bx_file_t *x = &bx->file[i];
+            if (e.len[i] && !x->err && fwrite(e.p + off, 1, e.len[i], x->f) != e.len[i]) x->err = 1;
+            off += e.len[i];
+        }
+        free(e.p);
+        pthread_mutex_lock(&bx->mu);
+    }
+}
+
+/* Con ordered: la trama de turno va directa a los ficheros, el resto a memoria */
+static int frame_ordered(batch_export_t *bx, const export_key_t *k, const hermes_config_t *cfg){
+    int rc = 0;
+
+    pthread_mutex_lock(&bx->mu);
+    bx->frames++;
+    int mine = !bx->flushing && k->frame_id == bx->next;
+    if (mine){
+        bx->flushing = 1;
+        bx->next++;
+    }
+    pthread_mutex_unlock(&bx->mu);
+
+    if (mine){
+        for (int i = 0; i < BX_NUM; i++){
+            bx_file_t *x = &bx->file[i];
+            if (x->f && !x->err && bx_write(x->f, k, cfg, i) != 0) x->err = 1;
+        }
+    } else {
+        bx_pend_t e = { k->frame_id, NULL, {0} };
+        size_t size = 0;
+        FILE *m = open_memstream(&e.p, &size);
+        if (!m) return -1;
+        long prev = 0;
+        for (int i = 0; i < BX_NUM; i++){
+            if (!bx->file[i].f) continue;
+            if (bx_write(m, k, cfg, i) != 0) rc = -1;
+            long pos = ftell(m);
+            e.len[i] = (size_t)(pos - prev);
+            prev = pos;
+        }
+        if (fclose(m) != 0) rc = -1;
+
+        if (rc != 0){   // se encola vacia: las siguientes no deben esperarla
+            free(e.p);
+            e.p = NULL;
+            memset(e.len, 0, sizeof(e.len));
+        }
+
+        pthread_mutex_lock(&bx->mu);
+        if (pend_put(bx, &e) != 0){
+            free(e.p);
+            rc = -1;
+        }
+        mine = !bx->flushing;   // quien escribia pudo acabar antes de encolar esta
+        if (mine) bx->flushing = 1;
+        pthread_mutex_unlock(&bx->mu);
+        if (!mine) return rc;
+    }
+
+    pthread_mutex_lock(&bx->mu);
+    pend_drain(bx, 0);
+    for (int i = 0; i < BX_NUM; i++){
+        if (bx->file[i].f && bx->file[i].err) rc = -1;
+    }
+    bx->flushing = 0;
+    pthread_mutex_unlock(&bx->mu);
+    return rc;
+}
+
+int batch_export_frame(batch_export_t *bx, const hermes_frame_t *fr, const hermes_config_t *cfg){
+    export_key_t k = { fr->seq, fr->offset, fr->prefix, cfg->uart_addr };
+    if (bx->ordered) return frame_ordered(bx, &k, cfg);
+
+    int rc = 0;
+    for (int i = 0; i < BX_NUM; i++){
+        bx_file_t *x = &bx->file[i];
+        if (!x->f) continue;
+
+        pthread_mutex_lock(&x->mu);
+        if (!x->err && bx_write(x->f, &k, cfg, i) != 0) x->err = 1;
+        rc |= x->err ? -1 : 0;
+        pthread_mutex_unlock(&x->mu);
+    }
+
+    pthread_mutex_lock(&bx->mu);
+    bx->frames++;
+    pthread_mutex_unlock(&bx->mu);
+    return rc;
+}
+
+int batch_export_close(batch_export_t *bx, FILE *report){
+    if (!bx) return 0;
+
+    pthread_mutex_lock(&bx->mu);
+    pend_drain(bx, 1);
+    pthread_mutex_unlock(&bx->mu);
+    free(bx->pend);
+
+    int rc = 0;
+    int any_csv = bx->file[BX_P1_CSV].f != NULL;
+    int any_json = bx->file[BX_P1_JSON].f != NULL;
+
+    for (int i = 0; i < BX_NUM; i++){
+        bx_file_t *x = &bx->file[i];
+        if (!x->f) continue;
+
+        if (report && i == BX_P1_CSV && any_csv){
+            fprintf(report, "CSV exportados (%llu tramas):\n", (unsigned long long)bx->frames);
+        }
+        if (report && i == BX_P1_JSON && any_json){
+            fprintf(report, "NDJSON exportados (%llu tramas):\n", (unsigned long long)bx->frames);
+        }
+
+        int ok = bx_close_file(x);
+        if (report) fprintf(report, "  %s %s\n", (ok == 0) ? "OK " : "ERR", x->path);
+        rc |= ok;
+    }
+
+    pthread_mutex_destroy(&bx->mu);
+    free(bx);
+    return rc;
+}
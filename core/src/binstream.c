@@ -0,0 +1,198 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "frame.h"
+#include "stream.h"
+#include "parallel.h"
+#include "binstream.h"
+#include "stats.h"
+
+int input_format_parse(const char *s){
+    if (strcmp(s, "hex") == 0) return INPUT_HEX;
+    if (strcmp(s, "bin") == 0) return INPUT_BIN;
+    if (strcmp(s, "binlen") == 0) return INPUT_BINLEN;
+    return -1;
+}
+
+int bin_record(const uint8_t *map, size_t size, size_t pos, input_format_t fmt,
+               size_t *payload, size_t *len, size_t *next){
+    if (fmt == INPUT_BINLEN){
+        if (size - pos < BINLEN_HDR_BYTES){
+            *payload = pos;
+            *len = size - pos;
+            return BIN_INCOMPLETE;
+        }
+        *payload = pos + BINLEN_HDR_BYTES;
+        *len = ((size_t)map[pos] << 8) | map[pos + 1];
+    } else {
+        *payload = pos;
+        *len = HERMES_FRAME_BYTES;
+    }
+    *next = *payload + *len;
+    if (*next > size){
+        *len = size - *payload;
+        return BIN_INCOMPLETE;
+    }
+    return (*len < HERMES_FRAME_BYTES) ? LINE_SHORT : LINE_OK;
+}
+
+/* Registros [start, end) con numeracion global a partir de base_rec/base_frame */
+static void render_range(const uint8_t *map, size_t size, input_format_t fmt, size_t start, size_t end,
+                         uint64_t base_rec, uint64_t base_frame, FILE *out, FILE *err,
+                         frame_cb cb, void *user, stream_stats_t *st){
+    uint64_t rec = base_rec, seq = base_frame;
+    size_t pos = start;
+
+    while (pos < end){
+        size_t payload, len, next;
+        int status = bin_record(map, size, pos, fmt, &payload, &len, &next);
+        rec++;
+        st->lines++;
+        if (status == BIN_INCOMPLETE){
+            fprintf(err, "Registro %llu (offset %llu): incompleto, el fichero termina tras %zu bytes.\n",
+                    (unsigned long long)rec, (unsigned long long)pos, size - pos);
+            st->errors++;
+            break;
+        }
+        if (status != LINE_OK){
+            fprintf(err, "Registro %llu (offset %llu): trama demasiado corta (%zu bytes).\n",
+                    (unsigned long long)rec, (unsigned long long)pos, len);
+            st->errors++;
+            pos = next;
+            continue;
+        }
+
+        hermes_frame_t fr;
+        frame_from_bytes(&fr, map + payload, (int)len);
+        fr.seq    = ++seq;
+        fr.offset = pos;
+        stats_count(STAT_BYTES, next - pos);
+        if (cb(out, &fr, user) != 0) st->errors++;
+        st->frames++;
+        pos = next;
+    }
+}
+
+/* ------------------ multihilo (pool de parallel.c) ------------------ */
+typedef struct {
+    input_format_t fmt;
+    frame_cb cb;
+    void    *user;
+} bin_arg_t;
+
+/*
+ * Bloques de ~PARALLEL_CHUNK_BYTES que terminan en un limite de registro.
+ * Con INPUT_BIN es aritmetica; con INPUT_BINLEN recorre solo las cabeceras.
+ * Los registros y tramas salen de aqui, asi que el pool no necesita fase A.
+ * Un registro incompleto al final cuenta como registro (render_range lo
+ * informa como error).
+ */
+static size_t split_records(const char *map, size_t size, parallel_chunk_t *chunks, size_t max_chunks, void *arg){
+    const uint8_t *m = (const uint8_t *)map;
+    input_format_t fmt = ((const bin_arg_t *)arg)->fmt;
+    size_t n = 0, pos = 0;
+
+    while (pos < size && n < max_chunks){
+        parallel_chunk_t *c = &chunks[n++];
+        c->start = pos;
+        c->counted = 1;
+
+        if (fmt == INPUT_BIN){
+            size_t k = PARALLEL_CHUNK_BYTES / HERMES_FRAME_BYTES;
+            size_t left = (size - pos) / HERMES_FRAME_BYTES;
+            if (k >= left){
+                c->end = size;
+                c->nlines = left + ((size - pos) % HERMES_FRAME_BYTES != 0);
+                k = left;
+            } else {
+                c->end = pos + k * HERMES_FRAME_BYTES;
+                c->nlines = k;
+            }
+            c->nframes = k;
+            pos = c->end;
+            continue;
+        }
+
+        size_t limit = pos + PARALLEL_CHUNK_BYTES;
+        while (pos < size && pos < limit){
+            size_t payload, len, next;
+            int status = bin_record(m, size, pos, fmt, &payload, &len, &next);
+            c->nlines++;
+            if (status == BIN_INCOMPLETE){
+                pos = size;
+                break;
+            }
+            if (status == LINE_OK) c->nframes++;
+            pos = next;
+        }
+        c->end = pos;
+    }
+    return n;
+}
+
+static int render_chunk(const char *map, size_t size, parallel_chunk_t *c, FILE *out, FILE *err,
+                        void *scratch, void *arg){
+    (void)scratch;
+    const bin_arg_t *a = (const bin_arg_t *)arg;
+    stream_stats_t st;
+    memset(&st, 0, sizeof(st));
+    render_range((const uint8_t *)map, size, a->fmt, c->start, c->end, c->base_line, c->base_frame,
+                 out, err, a->cb, a->user, &st);
+    c->errors = st.errors;
+    return 0;
+}
+
+static const parallel_ops_t BIN_OPS = { split_records, NULL, render_chunk, 0, NULL };
+
+int bin_run(const char *path, input_format_t fmt, int nthreads, frame_cb cb, void *user,
+            stream_stats_t *st){
+    memset(st, 0, sizeof(*st));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        fprintf(stderr, "No se pudo abrir %s.\n", path);
+        return -1;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0){
+        close(fd);
+        return -1;
+    }
+    if (!S_ISREG(sb.st_mode)){
+        fprintf(stderr, "--input-format bin/binlen requiere un fichero regular: %s no lo es.\n", path);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)sb.st_size;
+    if (size == 0){
+        close(fd);
+        return 0;
+    }
+
+    const uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        fprintf(stderr, "No se pudo mapear %s.\n", path);
+        return -1;
+    }
+    madvise((void *)map, size, MADV_SEQUENTIAL);
+
+    int rc = 0;
+    if (nthreads > 1){
+        bin_arg_t a = { fmt, cb, user };
+        rc = parallel_pool_run((const char *)map, size, nthreads, &BIN_OPS, &a, st);
+    } else {
+        render_range(map, size, fmt, 0, size, 0, 0, stdout, stderr, cb, user, st);
+    }
+
+    munmap((void *)map, size);
+    return rc;
+}
@@ -0,0 +1,206 @@
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "curve.h"
+
+/*
+ * Evaluacion "ultimo punto alcanzado": para cada distancia g se toma el
+ * ultimo i con g >= x[i] (x no decreciente). Escalar y SIMD recorren los
+ * puntos en el mismo orden y hacen las mismas operaciones en float (sin
+ * FMA), asi que dan exactamente el mismo resultado:
+ *
+ *   escalon  v[i]          (v[0] antes del primer punto)
+ *   lineal   v[i] + (g - x[i]) / (x[i+1] - x[i]) * (v[i+1] - v[i])
+ *            (v[0] antes del primero, v[n-1] desde el ultimo)
+ */
+
+typedef void (*curve_eval_fn)(const curve_table_t *t, curve_interp_t interp,
+                              const float *grid, size_t n, float *out);
+
+void curve_table(const hermes_config_t *cfg, curve_kind_t kind, curve_table_t *t){
+    if (kind == CURVE_TVG){
+        t->n = HERMES_TVG_STAGES;
+        for (int i = 0; i < HERMES_TVG_STAGES; i++){
+            t->x[i] = (float)cfg->tvg.dist_cm[i];
+            t->v[i] = (float)cfg->tvg.gain_pct[i];
+        }
+        return;
+    }
+
+    const hermes_th_t *th = &cfg->th[kind == CURVE_P2];
+    t->n = HERMES_TH_STAGES;
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        t->x[i] = (float)th->dist_cm[i];
+        t->v[i] = (float)th->pct[i];
+    }
+}
+
+/* ------------------ scalar ------------------ */
+static inline float eval_one(const curve_table_t *t, curve_interp_t interp, float g){
+    int k = -1;
+    for (int i = 0; i < t->n; i++){
+        if (g >= t->x[i]) k = i;
+    }
+    if (k < 0) return t->v[0];
+    if (interp == CURVE_STEP || k == t->n - 1) return t->v[k];
+
+    float x0 = t->x[k], x1 = t->x[k + 1];
+    float v0 = t->v[k], v1 = t->v[k + 1];
+    return v0 + (g - x0) / (x1 - x0) * (v1 - v0);
+}
+
+void curve_eval_scalar(const curve_table_t *t, curve_interp_t interp, const float *grid, size_t n, float *out){
+    for (size_t i = 0; i < n; i++) out[i] = eval_one(t, interp, grid[i]);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* ------------------ SSE2 ------------------ */
+static inline __m128 sse2_blend(__m128 a, __m128 b, __m128 m){
+    return _mm_or_ps(_mm_and_ps(m, b), _mm_andnot_ps(m, a));
+}
+
+static void eval_sse2(const curve_table_t *t, curve_interp_t interp, const float *grid, size_t n, float *out){
+    const int np = t->n;
+    size_t i = 0;
+
+    if (interp == CURVE_STEP){
+        for (; i + 4 <= n; i += 4){
+            __m128 g = _mm_loadu_ps(grid + i);
+            __m128 v = _mm_set1_ps(t->v[0]);
+            for (int k = 1; k < np; k++){
+                __m128 m = _mm_cmpge_ps(g, _mm_set1_ps(t->x[k]));
+                v = sse2_blend(v, _mm_set1_ps(t->v[k]), m);
+            }
+            _mm_storeu_ps(out + i, v);
+        }
+    } else {
+        for (; i + 4 <= n; i += 4){
+            __m128 g  = _mm_loadu_ps(grid + i);
+            __m128 x0 = _mm_setzero_ps(), x1 = _mm_setzero_ps();
+            __m128 v0 = _mm_set1_ps(t->v[0]), v1 = _mm_setzero_ps();
+            __m128 in = _mm_setzero_ps();                    // entre dos puntos
+            for (int k = 0; k < np; k++){
+                __m128 m = _mm_cmpge_ps(g, _mm_set1_ps(t->x[k]));
+                int last = (k == np - 1);
+                x0 = sse2_blend(x0, _mm_set1_ps(t->x[k]), m);
+                v0 = sse2_blend(v0, _mm_set1_ps(t->v[k]), m);
+                x1 = sse2_blend(x1, _mm_set1_ps(t->x[last ? k : k + 1]), m);
+                v1 = sse2_blend(v1, _mm_set1_ps(t->v[last ? k : k + 1]), m);
+                in = sse2_blend(in, last ? _mm_setzero_ps() : _mm_castsi128_ps(_mm_set1_epi32(-1)), m);
+            }
+            __m128 r = _mm_add_ps(v0, _mm_mul_ps(_mm_div_ps(_mm_sub_ps(g, x0), _mm_sub_ps(x1, x0)),
+                                                 _mm_sub_ps(v1, v0)));
+            _mm_storeu_ps(out + i, sse2_blend(v0, r, in));
+        }
+    }
+    for (; i < n; i++) out[i] = eval_one(t, interp, grid[i]);
+}
+
+/* ------------------ AVX2 ------------------ */
+__attribute__((target("avx2")))
+static void eval_avx2(const curve_table_t *t, curve_interp_t interp, const float *grid, size_t n, float *out){
+    const int np = t->n;
+    size_t i = 0;
+
+    if (interp == CURVE_STEP){
+        for (; i + 8 <= n; i += 8){
+            __m256 g = _mm256_loadu_ps(grid + i);
+            __m256 v = _mm256_set1_ps(t->v[0]);
+            for (int k = 1; k < np; k++){
+                __m256 m = _mm256_cmp_ps(g, _mm256_set1_ps(t->x[k]), _CMP_GE_OQ);
+                v = _mm256_blendv_ps(v, _mm256_set1_ps(t->v[k]), m);
+            }
+            _mm256_storeu_ps(out + i, v);
+        }
+    } else {
+        for (; i + 8 <= n; i += 8){
+            __m256 g  = _mm256_loadu_ps(grid + i);
+            __m256 x0 = _mm256_setzero_ps(), x1 = _mm256_setzero_ps();
+            __m256 v0 = _mm256_set1_ps(t->v[0]), v1 = _mm256_setzero_ps();
+            __m256 in = _mm256_setzero_ps();
+            for (int k = 0; k < np; k++){
+                __m256 m = _mm256_cmp_ps(g, _mm256_set1_ps(t->x[k]), _CMP_GE_OQ);
+                int last = (k == np - 1);
+                x0 = _mm256_blendv_ps(x0, _mm256_set1_ps(t->x[k]), m);
+                v0 = _mm256_blendv_ps(v0, _mm256_set1_ps(t->v[k]), m);
+                x1 = _mm256_blendv_ps(x1, _mm256_set1_ps(t->x[last ? k : k + 1]), m);
+                v1 = _mm256_blendv_ps(v1, _mm256_set1_ps(t->v[last ? k : k + 1]), m);
+                in = _mm256_blendv_ps(in, last ? _mm256_setzero_ps()
+                                               : _mm256_castsi256_ps(_mm256_set1_epi32(-1)), m);
+            }
+            __m256 r = _mm256_add_ps(v0, _mm256_mul_ps(_mm256_div_ps(_mm256_sub_ps(g, x0), _mm256_sub_ps(x1, x0)),
+                                                       _mm256_sub_ps(v1, v0)));
+            _mm256_storeu_ps(out + i, _mm256_blendv_ps(v0, r, in));
+        }
+    }
+    for (; i < n; i++) out[i] = eval_one(t, interp, grid[i]);
+}
+#endif
+
+/* ------------------ dispatch ------------------ */
+static curve_eval_fn cv_eval;
+static const char   *cv_name;
+
+static pthread_once_t cv_once = PTHREAD_ONCE_INIT;
+
+static void cv_select(void){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")){
+        cv_eval = eval_avx2;
+        cv_name = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")){
+        cv_eval = eval_sse2;
+        cv_name = "sse2";
+        return;
+    }
+#endif
+    cv_eval = curve_eval_scalar;
+    cv_name = "scalar";
+}
+
+const char *curve_impl(void){
+    pthread_once(&cv_once, cv_select);
+    return cv_name;
+}
+
+void curve_eval(const curve_table_t *t, curve_interp_t interp, const float *grid, size_t n, float *out){
+    pthread_once(&cv_once, cv_select);
+    cv_eval(t, interp, grid, n, out);
+}
+
+void curve_eval_batch(const hermes_config_t *cfgs, size_t ncfg, curve_kind_t kind, curve_interp_t interp,
+                      const float *grid, size_t ngrid, float *out){
+    pthread_once(&cv_once, cv_select);
+    interp = curve_kind_interp(kind, interp);
+    for (size_t f = 0; f < ncfg; f++){
+        curve_table_t t;
+        curve_table(&cfgs[f], kind, &t);
+        cv_eval(&t, interp, grid, ngrid, out + f * ngrid);
+    }
+}
+
+static const char *const KIND_NAMES[CURVE_NUM_KINDS] = { "p1", "p2", "tvg" };
+
+int curve_kind_parse(const char *s){
+    for (int k = 0; k < CURVE_NUM_KINDS; k++){
+        if (strcmp(s, KIND_NAMES[k]) == 0) return k;
+    }
+    return -1;
+}
+
+const char *curve_kind_name(curve_kind_t kind){
+    return (kind >= 0 && kind < CURVE_NUM_KINDS) ? KIND_NAMES[kind] : "?";
+}
+
+int curve_interp_parse(const char *s){
+    if (strcmp(s, "step") == 0)   return CURVE_STEP;
+    if (strcmp(s, "linear") == 0) return CURVE_LINEAR;
+    return -1;
+}
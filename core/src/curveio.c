@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "numfmt.h"
+#include "outbuf.h"
+#include "curveio.h"
+
+/* ------------------ rejilla ------------------ */
+
+/* Sufijo de unidad al final de [s, *end): 1 = us, 0 = cm/ninguno */
+static int unit_suffix(const char *s, size_t *len){
+    if (*len >= 2 && strncmp(s + *len - 2, "us", 2) == 0){ *len -= 2; return 1; }
+    if (*len >= 2 && strncmp(s + *len - 2, "cm", 2) == 0){ *len -= 2; }
+    return 0;
+}
+
+static int push_point(float **grid, size_t *n, size_t *cap, double cm){
+    if (*n >= CURVE_GRID_MAX) return -1;
+    if (*n == *cap){
+        size_t nc = *cap ? *cap * 2 : 1024;
+        float *p = (float *)realloc(*grid, nc * sizeof(float));
+        if (!p) return -1;
+        *grid = p;
+        *cap = nc;
+    }
+    (*grid)[(*n)++] = (float)cm;
+    return 0;
+}
+
+static int parse_range(const char *spec, float **grid, size_t *n, char *err, size_t errcap){
+    size_t len = strlen(spec);
+    int us = unit_suffix(spec, &len);
+
+    char buf[128];
+    if (len >= sizeof(buf)){
+        snprintf(err, errcap, "rejilla demasiado larga");
+        return -1;
+    }
+    memcpy(buf, spec, len);
+    buf[len] = '\0';
+
+    double v[3];
+    char *p = buf;
+    for (int i = 0; i < 3; i++){
+        char *end;
+        v[i] = strtod(p, &end);
+        if (end == p || !isfinite(v[i]) || *end != (i < 2 ? ':' : '\0')){
+            snprintf(err, errcap, "rejilla invalida \"%s\" (desde:paso:hasta[cm|us])", spec);
+            return -1;
+        }
+        p = end + 1;
+    }
+    double from = v[0], step = v[1], to = v[2];
+    if (!(step > 0.0) || to < from){
+        snprintf(err, errcap, "rejilla \"%s\": paso > 0 y hasta >= desde", spec);
+        return -1;
+    }
+    double cnt = (to - from) / step + 1e-9 + 1.0;   // se trunca al convertir
+    if (cnt > (double)CURVE_GRID_MAX){
+        snprintf(err, errcap, "rejilla \"%s\": mas de %u puntos", spec, CURVE_GRID_MAX);
+        return -1;
+    }
+
+    size_t cap = 0;
+    *grid = NULL;
+    *n = 0;
+    for (size_t i = 0; i < (size_t)cnt; i++){
+        double x = from + (double)i * step;
+        if (push_point(grid, n, &cap, us ? tof_us_to_cm_f(x) : x) != 0){
+            snprintf(err, errcap, "sin memoria para la rejilla");
+            free(*grid);
+            *grid = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int parse_file(const char *path, float **grid, size_t *n, char *err, size_t errcap){
+    FILE *f = fopen(path, "r");
+    if (!f){
+        snprintf(err, errcap, "no se pudo abrir la rejilla %s", path);
+        return -1;
+    }
+
+    size_t cap = 0;
+    *grid = NULL;
+    *n = 0;
+    char tok[64];
+    size_t tl = 0;
+    int c, line = 1, rc = 0, comment = 0;
+    do {
+        c = fgetc(f);
+        int sep = (c == EOF || c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == ';');
+        if (!sep && !comment && c == '#') comment = 1;
+        if (!sep && !comment){
+            if (tl + 1 >= sizeof(tok)){
+                snprintf(err, errcap, "%s:%d: valor demasiado largo", path, line);
+                rc = -1;
+                break;
+            }
+            tok[tl++] = (char)c;
+            continue;
+        }
+        if (tl){
+            int us = unit_suffix(tok, &tl);
+            tok[tl] = '\0';
+            char *end;
+            double x = strtod(tok, &end);
+            if (tl == 0 || *end != '\0' || !isfinite(x)){
+                snprintf(err, errcap, "%s:%d: distancia invalida", path, line);
+                rc = -1;
+                break;
+            }
+            if (push_point(grid, n, &cap, us ? tof_us_to_cm_f(x) : x) != 0){
+                snprintf(err, errcap, "%s: mas de %u puntos o sin memoria", path, CURVE_GRID_MAX);
+                rc = -1;
+                break;
+            }
+            tl = 0;
+        }
+        if (c == '\n'){
+            line++;
+            comment = 0;
+        }
+    } while (c != EOF);
+    fclose(f);
+
+    if (rc == 0 && *n == 0){
+        snprintf(err, errcap, "%s: rejilla vacia", path);
+        rc = -1;
+    }
+    if (rc != 0){
+        free(*grid);
+        *grid = NULL;
+        *n = 0;
+    }
+    return rc;
+}
+
+int curve_grid_parse(const char *spec, float **grid, size_t *n, char *err, size_t errcap){
+    /* Un fichero existente tiene prioridad; si no, "desde:paso:hasta" */
+    if (strchr(spec, ':')){
+        FILE *f = fopen(spec, "r");
+        if (!f) return parse_range(spec, grid, n, err, errcap);
+        fclose(f);
+    }
+    return parse_file(spec, grid, n, err, errcap);
+}
+
+/* ------------------ salida ------------------ */
+static void put_f32s(uint8_t *p, const float *v, size_t n){
+    for (size_t i = 0; i < n; i++){
+        uint32_t u;
+        memcpy(&u, &v[i], sizeof(u));
+        put_u32le(p + 4 * i, u);
+    }
+}
+
+int curve_write_header(FILE *f, const curve_out_t *co){
+    if (co->binary){
+        uint8_t h[24];
+        memcpy(h, CURVE_BIN_MAGIC, 8);
+        put_u32le(h + 8, CURVE_BIN_VERSION);
+        put_u32le(h + 12, (uint32_t)co->ngrid);
+        put_u32le(h + 16, co->kinds);
+        put_u32le(h + 20, (uint32_t)co->interp);
+        uint8_t *g = (uint8_t *)malloc(co->ngrid * 4);
+        if (!g) return -1;
+        put_f32s(g, co->grid, co->ngrid);
+        int rc = (fwrite(h, 1, sizeof(h), f) == sizeof(h) &&
+                  fwrite(g, 1, co->ngrid * 4, f) == co->ngrid * 4) ? 0 : -1;
+        free(g);
+        return rc;
+    }
+
+    if (fputs("frame_id,offset,device,curve", f) == EOF) return -1;
+    for (size_t i = 0; i < co->ngrid; i++){
+        if (fprintf(f, ",%.4f", (double)co->grid[i]) < 0) return -1;
+    }
+    return fputc('\n', f) == EOF ? -1 : 0;
+}
+
+/* "%.2f" de un porcentaje sin pasar por printf (los valores estan en 0..100) */
+static size_t fmt_pct2(char *o, float v){
+    double d = (double)v * 100.0 + 0.5;
+    if (!(d >= 0.0 && d < 1e15)) return (size_t)snprintf(o, NUMFMT_MAX, "%.2f", (double)v);
+    uint64_t c = (uint64_t)d;
+    size_t n = numfmt_u64(o, c / 100);
+    o[n++] = '.';
+    o[n++] = (char)('0' + (c / 10) % 10);
+    o[n++] = (char)('0' + c % 10);
+    return n;
+}
+
+/* ------------------ buffers de fila por hilo ------------------ */
+typedef struct rowbuf {
+    float  *vals;
+    size_t  vals_cap;
+    char   *line;
+    size_t  line_cap;
+    struct rowbuf *registry_next;     // lista de buffers de hilo
+} rowbuf_t;
+
+static __thread rowbuf_t *tls_rows;
+static rowbuf_t *registry;
+static pthread_mutex_t registry_mu = PTHREAD_MUTEX_INITIALIZER;
+
+/* Buffers del hilo con sitio para nvals valores y una fila de nline bytes */
+static rowbuf_t *rows_reserve(size_t nvals, size_t nline){
+    rowbuf_t *r = tls_rows;
+    if (!r){
+        r = (rowbuf_t *)calloc(1, sizeof(*r));
+        if (!r) return NULL;
+        pthread_mutex_lock(&registry_mu);
+        r->registry_next = registry;
+        registry = r;
+        pthread_mutex_unlock(&registry_mu);
+        tls_rows = r;
+    }
+    if (nvals > r->vals_cap){
+        float *p = (float *)realloc(r->vals, nvals * sizeof(float));
+        if (!p) return NULL;
+        r->vals = p;
+        r->vals_cap = nvals;
+    }
+    if (nline > r->line_cap){
+        char *p = (char *)realloc(r->line, nline);
+        if (!p) return NULL;
+        r->line = p;
+        r->line_cap = nline;
+    }
+    return r;
+}
+
+void curve_rows_free_all(void){
+    pthread_mutex_lock(&registry_mu);
+    rowbuf_t *r = registry;
+    registry = NULL;
+    pthread_mutex_unlock(&registry_mu);
+
+    while (r){
+        rowbuf_t *next = r->registry_next;
+        free(r->vals);
+        free(r->line);
+        free(r);
+        r = next;
+    }
+    tls_rows = NULL;
+}
+
+int curve_write_rows(FILE *f, const curve_out_t *co, const export_key_t *k, const hermes_config_t *cfg){
+    size_t ng = co->ngrid;
+    size_t line_cap = co->binary ? 24 + 4 * ng : 4 * NUMFMT_MAX + 8 + ng * (NUMFMT_MAX + 1);
+    rowbuf_t *r = rows_reserve(ng, line_cap);
+    if (!r) return -1;
+
+    for (int kind = 0; kind < CURVE_NUM_KINDS; kind++){
+        if (!(co->kinds & (1u << kind))) continue;
+
+        curve_table_t t;
+        curve_table(cfg, (curve_kind_t)kind, &t);
+        curve_eval(&t, curve_kind_interp((curve_kind_t)kind, co->interp), co->grid, ng, r->vals);
+
+        char *o = r->line;
+        size_t n;
+        if (co->binary){
+            uint8_t *b = (uint8_t *)o;
+            put_u64le(b, k->frame_id);
+            put_u64le(b + 8, k->offset);
+            put_u32le(b + 16, (uint32_t)kind);
+            put_u32le(b + 20, k->device);
+            put_f32s(b + 24, r->vals, ng);
+            n = 24 + 4 * ng;
+        } else {
+            n = numfmt_u64(o, k->frame_id);
+            o[n++] = ',';
+            n += numfmt_u64(o + n, k->offset);
+            o[n++] = ',';
+            n += numfmt_u64(o + n, k->device);
+            o[n++] = ',';
+            const char *name = curve_kind_name((curve_kind_t)kind);
+            size_t nl = strlen(name);
+            memcpy(o + n, name, nl);
+            n += nl;
+            for (size_t i = 0; i < ng; i++){
+                o[n++] = ',';
+                n += fmt_pct2(o + n, r->vals[i]);
+            }
+            o[n++] = '\n';
+        }
+        if (fwrite(o, 1, n, f) != n) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,271 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "decoder.h"
+#include "export.h"
+#include "dcache.h"
+
+struct dcache_entry {
+    uint64_t hash;
+    dcache_entry_t *next;             // cadena del bucket
+    dcache_entry_t *lru_prev, *lru_next;
+    size_t   bytes;                   // tamaño contabilizado
+    char    *frag[DC_NUM_FRAGS];
+    size_t   frag_len[DC_NUM_FRAGS];
+    hermes_config_t cfg;              // cfg.reg hace de clave completa
+};
+
+struct dcache {
+    dcache_entry_t **buckets;
+    size_t   nbuckets;                // potencia de 2
+    dcache_entry_t *lru_head;         // mas reciente
+    dcache_entry_t *lru_tail;         // candidato a expulsion
+    size_t   max_bytes;
+    dcache_stats_t st;
+    dcache_t *registry_next;          // lista de caches de hilo
+};
+
+/* ------------------ hash ------------------ */
+static inline uint64_t mix64(uint64_t h){
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t dcache_hash(const uint8_t reg[55]){
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    uint64_t w;
+    for (int i = 0; i < 48; i += 8){
+        memcpy(&w, reg + i, 8);
+        h = (h ^ w) * 0x100000001b3ull;
+        h ^= h >> 29;
+    }
+    w = 0;
+    memcpy(&w, reg + 48, 7);
+    h = (h ^ w) * 0x100000001b3ull;
+    return mix64(h);
+}
+
+/* ------------------ LRU ------------------ */
+static void lru_unlink(dcache_t *c, dcache_entry_t *e){
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next; else c->lru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev; else c->lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void lru_push_front(dcache_t *c, dcache_entry_t *e){
+    e->lru_prev = NULL;
+    e->lru_next = c->lru_head;
+    if (c->lru_head) c->lru_head->lru_prev = e;
+    c->lru_head = e;
+    if (!c->lru_tail) c->lru_tail = e;
+}
+
+static void entry_destroy(dcache_entry_t *e){
+    for (int k = 0; k < DC_NUM_FRAGS; k++) free(e->frag[k]);
+    free(e);
+}
+
+static void bucket_remove(dcache_t *c, dcache_entry_t *e){
+    dcache_entry_t **pp = &c->buckets[e->hash & (c->nbuckets - 1)];
+    while (*pp && *pp != e) pp = &(*pp)->next;
+    if (*pp) *pp = e->next;
+}
+
+/* Expulsa por la cola hasta caber en max_bytes (nunca expulsa keep) */
+static void evict(dcache_t *c, const dcache_entry_t *keep){
+    while (c->st.bytes > c->max_bytes && c->lru_tail && c->lru_tail != keep){
+        dcache_entry_t *e = c->lru_tail;
+        lru_unlink(c, e);
+        bucket_remove(c, e);
+        c->st.bytes -= e->bytes;
+        c->st.entries--;
+        c->st.evictions++;
+        entry_destroy(e);
+    }
+}
+
+static void rehash(dcache_t *c){
+    size_t nb = c->nbuckets * 2;
+    dcache_entry_t **b = calloc(nb, sizeof(*b));
+    if (!b) return; // se sigue con cadenas mas largas
+
+    for (size_t i = 0; i < c->nbuckets; i++){
+        dcache_entry_t *e = c->buckets[i];
+        while (e){
+            dcache_entry_t *next = e->next;
+            size_t k = e->hash & (nb - 1);
+            e->next = b[k];
+            b[k] = e;
+            e = next;
+        }
+    }
+    free(c->buckets);
+    c->buckets = b;
+    c->nbuckets = nb;
+}
+
+/* ------------------ API ------------------ */
+dcache_t *dcache_new(size_t max_bytes){
+    dcache_t *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    c->nbuckets = 1024;
+    c->buckets = calloc(c->nbuckets, sizeof(*c->buckets));
+    if (!c->buckets){
+        free(c);
+        return NULL;
+    }
+    c->max_bytes = max_bytes;
+    return c;
+}
+
+void dcache_free(dcache_t *c){
+    if (!c) return;
+    dcache_entry_t *e = c->lru_head;
+    while (e){
+        dcache_entry_t *next = e->lru_next;
+        entry_destroy(e);
+        e = next;
+    }
+    free(c->buckets);
+    free(c);
+}
+
+const hermes_config_t *dcache_lookup(dcache_t *c, const uint8_t reg[55], dcache_entry_t **out){
+    uint64_t h = dcache_hash(reg);
+
+    for (dcache_entry_t *e = c->buckets[h & (c->nbuckets - 1)]; e; e = e->next){
+        if (e->hash == h && memcmp(e->cfg.reg, reg, 55) == 0){
+            c->st.hits++;
+            if (c->lru_head != e){
+                lru_unlink(c, e);
+                lru_push_front(c, e);
+            }
+            *out = e;
+            return &e->cfg;
+        }
+    }
+
+    c->st.misses++;
+    dcache_entry_t *e = calloc(1, sizeof(*e));
+    if (!e) return NULL;
+    decode_config(reg, &e->cfg);
+    e->hash  = h;
+    e->bytes = sizeof(*e);
+
+    size_t k = h & (c->nbuckets - 1);
+    e->next = c->buckets[k];
+    c->buckets[k] = e;
+    lru_push_front(c, e);
+    c->st.bytes += e->bytes;
+    c->st.entries++;
+
+    evict(c, e);
+    if (c->st.entries > c->nbuckets) rehash(c);
+
+    *out = e;
+    return &e->cfg;
+}
+
+static int render_frag(FILE *f, const hermes_config_t *cfg, dcache_frag_t kind){
+    switch (kind){
+        case DC_TEXT:     decode_print_all(f, cfg); return 0;
+        case DC_P1_CSV:   return fprint_th_profile_csv(f, cfg, 0);
+        case DC_P2_CSV:   return fprint_th_profile_csv(f, cfg, 1);
+        case DC_TVG_CSV:  return fprint_tvg_csv(f, cfg);
+        case DC_P1_JSON:  return fprint_th_profile_json(f, cfg, 0);
+        case DC_P2_JSON:  return fprint_th_profile_json(f, cfg, 1);
+        case DC_TVG_JSON: return fprint_tvg_json(f, cfg);
+        default:          return -1;
+    }
+}
+
+const char *dcache_fragment(dcache_t *c, dcache_entry_t *e, dcache_frag_t kind, size_t *len){
+    if (kind >= DC_NUM_FRAGS) return NULL;
+
+    if (e->frag[kind]){
+        c->st.frag_hits++;
+        *len = e->frag_len[kind];
+        return e->frag[kind];
+    }
+
+    char *buf = NULL;
+    size_t n = 0;
+    FILE *f = open_memstream(&buf, &n);
+    if (!f) return NULL;
+    int rc = render_frag(f, &e->cfg, kind);
+    if (fclose(f) != 0 || rc != 0){
+        free(buf);
+        return NULL;
+    }
+
+    c->st.frag_renders++;
+    e->frag[kind] = buf;
+    e->frag_len[kind] = n;
+    e->bytes += n + 1;
+    c->st.bytes += n + 1;
+    evict(c, e);
+
+    *len = n;
+    return buf;
+}
+
+void dcache_get_stats(const dcache_t *c, dcache_stats_t *st){
+    *st = c->st;
+}
+
+/* ------------------ caches por hilo ------------------ */
+static __thread dcache_t *tls_cache;
+static dcache_t *registry;
+static pthread_mutex_t registry_mu = PTHREAD_MUTEX_INITIALIZER;
+
+dcache_t *dcache_thread(size_t max_bytes){
+    if (tls_cache) return tls_cache;
+
+    dcache_t *c = dcache_new(max_bytes);
+    if (!c) return NULL;
+    pthread_mutex_lock(&registry_mu);
+    c->registry_next = registry;
+    registry = c;
+    pthread_mutex_unlock(&registry_mu);
+
+    tls_cache = c;
+    return c;
+}
+
+void dcache_thread_stats(dcache_stats_t *st){
+    memset(st, 0, sizeof(*st));
+    pthread_mutex_lock(&registry_mu);
+    for (dcache_t *c = registry; c; c = c->registry_next){
+        st->hits         += c->st.hits;
+        st->misses       += c->st.misses;
+        st->evictions    += c->st.evictions;
+        st->frag_hits    += c->st.frag_hits;
+        st->frag_renders += c->st.frag_renders;
+        st->bytes        += c->st.bytes;
+        st->entries      += c->st.entries;
+    }
+    pthread_mutex_unlock(&registry_mu);
+}
+
+void dcache_thread_free_all(void){
+    pthread_mutex_lock(&registry_mu);
+    dcache_t *c = registry;
+    registry = NULL;
+    pthread_mutex_unlock(&registry_mu);
+
+    while (c){
+        dcache_t *next = c->registry_next;
+        dcache_free(c);
+        c = next;
+    }
+    tls_cache = NULL;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "regmap.h"
+#include "decoder.h"
+#include "diff.h"
+
+typedef struct {
+    uint32_t key;
+    uint64_t seq;             // ultima trama vista de este dispositivo
+    hermes_config_t cfg;
+} diff_slot_t;
+
+struct diff_state {
+    diff_key_t key;
+    int uart_reg, uart_field; // PULSE_P2.UART_ADDR en el esquema
+    diff_slot_t *slots;       // pocos dispositivos: busqueda lineal
+    size_t nslots, cap;
+};
+
+diff_state_t *diff_new(diff_key_t key){
+    diff_state_t *ds = calloc(1, sizeof(*ds));
+    if (!ds) return NULL;
+
+    ds->key = key;
+    if (regmap_find_field("PULSE_P2.UART_ADDR", &ds->uart_reg, &ds->uart_field) != 0){
+        free(ds);
+        return NULL;
+    }
+    return ds;
+}
+
+void diff_free(diff_state_t *ds){
+    if (!ds) return;
+    free(ds->slots);
+    free(ds);
+}
+
+/* Palabra de 8 bytes con a[0] en el byte bajo (ctz >> 3 = indice del registro) */
+static inline uint64_t load_le64(const uint8_t *p){
+    uint64_t w;
+    memcpy(&w, p, 8);
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+/* XOR de 8 en 8 bytes (el ultimo bloque solapa: 47..54) */
+uint64_t diff_regs(const uint8_t a[55], const uint8_t b[55]){
+    uint64_t mask = 0;
+
+    for (int off = 0; off < 55; off += 8){
+        int base = (off < 47) ? off : 47;
+        uint64_t x = load_le64(a + base) ^ load_le64(b + base);
+        while (x){
+            int byte = __builtin_ctzll(x) >> 3;
+            mask |= 1ull << (base + byte);
+            x &= ~(0xFFull << (byte * 8));
+        }
+    }
+    return mask;
+}
+
+static uint32_t frame_key(const diff_state_t *ds, const hermes_frame_t *fr){
+    if (ds->key == DIFF_KEY_PREFIX) return fr->prefix;
+    return regmap_field_value(fr->reg, regmap_desc(ds->uart_reg), ds->uart_field);
+}
+
+static void print_key(FILE *out, const diff_state_t *ds, uint32_t key){
+    if (ds->key == DIFF_KEY_PREFIX) fprintf(out, "Dispositivo prefix=0x%04X: ", key);
+    else                            fprintf(out, "Dispositivo UART_ADDR=%u: ", key);
+}
+
+static diff_slot_t *find_slot(diff_state_t *ds, uint32_t key, int *is_new){
+    for (size_t i = 0; i < ds->nslots; i++){
+        if (ds->slots[i].key == key){
+            *is_new = 0;
+            return &ds->slots[i];
+        }
+    }
+
+    if (ds->nslots == ds->cap){
+        size_t ncap = ds->cap ? ds->cap * 2 : 8;
+        diff_slot_t *p = realloc(ds->slots, ncap * sizeof(*p));
+        if (!p) return NULL;
+        ds->slots = p;
+        ds->cap = ncap;
+    }
+    *is_new = 1;
+    diff_slot_t *s = &ds->slots[ds->nslots++];
+    s->key = key;
+    return s;
+}
+
+/* Etapas cuyo tiempo acumulado o nivel/ganancia cambian */
+static void print_th_stages(FILE *out, const hermes_th_t *a, const hermes_th_t *b, const char *name){
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        if (a->t_us[i] == b->t_us[i] && a->level[i] == b->level[i]) continue;
+        fprintf(out, "  %s etapa %2d: t=%dus -> %dus  L=%u -> %u (%.2f%% -> %.2f%%)\n",
+                name, i + 1, a->t_us[i], b->t_us[i], a->level[i], b->level[i], a->pct[i], b->pct[i]);
+    }
+}
+
+static void print_tvg_stages(FILE *out, const hermes_tvg_t *a, const hermes_tvg_t *b){
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        if (a->t_us[i] == b->t_us[i] && a->gain_raw[i] == b->gain_raw[i]) continue;
+        fprintf(out, "  TVG tramo %d: t=%dus -> %dus  G=%u -> %u (%.2f%% -> %.2f%%)\n",
+                i, a->t_us[i], b->t_us[i], a->gain_raw[i], b->gain_raw[i],
+                a->gain_pct[i], b->gain_pct[i]);
+    }
+}
+
+const hermes_config_t *diff_frame(diff_state_t *ds, FILE *out, const hermes_frame_t *fr){
+    uint32_t key = frame_key(ds, fr);
+    int is_new;
+    diff_slot_t *s = find_slot(ds, key, &is_new);
+    if (!s) return NULL;
+
+    print_key(out, ds, key);
+
+    if (is_new){
+        fprintf(out, "primera trama, decodificación completa\n");
+        decode_config(fr->reg, &s->cfg);
+        decode_print_all(out, &s->cfg);
+        s->seq = fr->seq;
+        return &s->cfg;
+    }
+
+    uint64_t changed = diff_regs(s->cfg.reg, fr->reg);
+    if (!changed){
+        fprintf(out, "sin cambios respecto a la trama #%llu\n", (unsigned long long)s->seq);
+        s->seq = fr->seq;
+        return &s->cfg;
+    }
+
+    fprintf(out, "%d registro(s) cambiado(s) respecto a la trama #%llu\n",
+            __builtin_popcountll(changed), (unsigned long long)s->seq);
+
+    hermes_config_t prev = s->cfg;
+    decode_config_update(fr->reg, changed, &s->cfg);
+    s->seq = fr->seq;
+
+    for (uint64_t m = changed; m; m &= m - 1){
+        int idx = __builtin_ctzll(m) + 1;
+        fprintf(out, "[%02d]", idx);
+        regmap_print_diff(out, prev.reg, &s->cfg, idx);
+    }
+
+    if (changed & DECODE_REGS_TVG)   print_tvg_stages(out, &prev.tvg, &s->cfg.tvg);
+    if (changed & DECODE_REGS_TH_P1) print_th_stages(out, &prev.th[0], &s->cfg.th[0], "P1");
+    if (changed & DECODE_REGS_TH_P2) print_th_stages(out, &prev.th[1], &s->cfg.th[1], "P2");
+    return &s->cfg;
+}
@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "numfmt.h"
+#include "decoder.h"
+#include "echo.h"
+
+typedef void (*echo_analyze_fn)(const uint8_t *s, const uint8_t *t, echo_result_t *r);
+
+int echo_threshold(const hermes_config_t *cfg, int is_p2, curve_interp_t interp, uint8_t thr[ECHO_SAMPLES]){
+    const hermes_th_t *th = &cfg->th[is_p2 ? 1 : 0];
+    int rec = is_p2 ? cfg->p2_rec : cfg->p1_rec;
+    int dt_us = 4096 * (rec + 1) / ECHO_SAMPLES;
+
+    /* Niveles en la escala de las muestras: 5 bits -> << 3, 8 bits tal cual */
+    int lv[HERMES_TH_STAGES];
+    for (int i = 0; i < HERMES_TH_STAGES; i++) lv[i] = (i < 8) ? th->level[i] << 3 : th->level[i];
+
+    /*
+     * Misma curva que --curves, pero en us y con enteros: los tiempos de
+     * muestra y de etapa son exactos, y muestra > umbral equivale a
+     * muestra > floor(umbral).
+     */
+    for (int i = 0; i < ECHO_SAMPLES; i++){
+        int32_t u = i * dt_us;
+        int k = -1;
+        for (int j = 0; j < HERMES_TH_STAGES; j++){
+            if (u >= th->t_us[j]) k = j;
+        }
+        int v;
+        if (k < 0){
+            v = lv[0];
+        } else if (interp == CURVE_STEP || k == HERMES_TH_STAGES - 1){
+            v = lv[k];
+        } else {
+            int32_t num = (u - th->t_us[k]) * (lv[k + 1] - lv[k]);
+            int32_t den = th->t_us[k + 1] - th->t_us[k];      // > 0: u < t_us[k + 1]
+            int32_t q = num / den;
+            if (num % den && num < 0) q--;                      // floor
+            v = lv[k] + q;
+        }
+        thr[i] = (uint8_t)v;
+    }
+    return dt_us;
+}
+
+/* ------------------ scalar ------------------ */
+void echo_analyze_scalar(const uint8_t samples[ECHO_SAMPLES], const uint8_t thr[ECHO_SAMPLES], echo_result_t *r){
+    r->crossings = 0;
+    r->first = r->last = -1;
+    r->margin = -256;
+    r->margin_sample = 0;
+    for (int i = 0; i < ECHO_SAMPLES; i++){
+        int d = (int)samples[i] - (int)thr[i];
+        if (d > 0){
+            if (r->first < 0) r->first = i;
+            r->last = i;
+            r->crossings++;
+        }
+        if (d > r->margin){
+            r->margin = d;
+            r->margin_sample = i;
+        }
+    }
+}
+
+static void echo_scalar_fn(const uint8_t *s, const uint8_t *t, echo_result_t *r){
+    echo_analyze_scalar(s, t, r);
+}
+
+/* Cruces a partir de la mascara de 128 bits */
+static inline void echo_from_mask(uint64_t lo, uint64_t hi, echo_result_t *r){
+    r->crossings = __builtin_popcountll(lo) + __builtin_popcountll(hi);
+    r->first = lo ? __builtin_ctzll(lo) : hi ? 64 + __builtin_ctzll(hi) : -1;
+    r->last  = hi ? 127 - __builtin_clzll(hi) : lo ? 63 - __builtin_clzll(lo) : -1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* ------------------ SSE2 ------------------ */
+static inline int sse2_hmax_u8(__m128i v){
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+    return _mm_cvtsi128_si32(v) & 0xFF;
+}
+
+static inline int sse2_hmin_u8(__m128i v){
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 8));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 4));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 2));
+    v = _mm_min_epu8(v, _mm_srli_si128(v, 1));
+    return _mm_cvtsi128_si32(v) & 0xFF;
+}
+
+/*
+ * up = sat(s - t) (> 0 si cruza), dn = sat(t - s). El margen es max(up) si
+ * hay cruces y -min(dn) si no; una segunda pasada busca su primera muestra.
+ */
+static void echo_sse2(const uint8_t *s, const uint8_t *t, echo_result_t *r){
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmax = zero, vmin = _mm_set1_epi8((char)0xFF);
+    uint64_t m[2] = { 0, 0 };
+
+    for (int k = 0; k < ECHO_SAMPLES / 16; k++){
+        __m128i vs = _mm_loadu_si128((const __m128i *)(s + 16 * k));
+        __m128i vt = _mm_loadu_si128((const __m128i *)(t + 16 * k));
+        __m128i up = _mm_subs_epu8(vs, vt);
+        __m128i dn = _mm_subs_epu8(vt, vs);
+        uint64_t gt = (uint64_t)(~_mm_movemask_epi8(_mm_cmpeq_epi8(up, zero)) & 0xFFFF);
+        m[k >> 2] |= gt << (16 * (k & 3));
+        vmax = _mm_max_epu8(vmax, up);
+        vmin = _mm_min_epu8(vmin, dn);
+    }
+    echo_from_mask(m[0], m[1], r);
+
+    int cross = r->crossings > 0;
+    int best  = cross ? sse2_hmax_u8(vmax) : sse2_hmin_u8(vmin);
+    __m128i vb = _mm_set1_epi8((char)best);
+    r->margin = cross ? best : -best;
+    r->margin_sample = 0;
+    for (int k = 0; k < ECHO_SAMPLES / 16; k++){
+        __m128i vs = _mm_loadu_si128((const __m128i *)(s + 16 * k));
+        __m128i vt = _mm_loadu_si128((const __m128i *)(t + 16 * k));
+        __m128i d  = cross ? _mm_subs_epu8(vs, vt) : _mm_subs_epu8(vt, vs);
+        int eq = _mm_movemask_epi8(_mm_cmpeq_epi8(d, vb));
+        if (eq){
+            r->margin_sample = 16 * k + __builtin_ctz((unsigned)eq);
+            break;
+        }
+    }
+}
+
+/* ------------------ AVX2 ------------------ */
+__attribute__((target("avx2")))
+static void echo_avx2(const uint8_t *s, const uint8_t *t, echo_result_t *r){
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i vmax = zero, vmin = _mm256_set1_epi8((char)0xFF);
+    uint64_t m[2] = { 0, 0 };
+
+    for (int k = 0; k < ECHO_SAMPLES / 32; k++){
+        __m256i vs = _mm256_loadu_si256((const __m256i *)(s + 32 * k));
+        __m256i vt = _mm256_loadu_si256((const __m256i *)(t + 32 * k));
+        __m256i up = _mm256_subs_epu8(vs, vt);
+        __m256i dn = _mm256_subs_epu8(vt, vs);
+        uint64_t gt = (uint32_t)~_mm256_movemask_epi8(_mm256_cmpeq_epi8(up, zero));
+        m[k >> 1] |= gt << (32 * (k & 1));
+        vmax = _mm256_max_epu8(vmax, up);
+        vmin = _mm256_min_epu8(vmin, dn);
+    }
+    echo_from_mask(m[0], m[1], r);
+
+    int cross = r->crossings > 0;
+    int best  = cross ? sse2_hmax_u8(_mm_max_epu8(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1)))
+                      : sse2_hmin_u8(_mm_min_epu8(_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1)));
+    __m256i vb = _mm256_set1_epi8((char)best);
+    r->margin = cross ? best : -best;
+    r->margin_sample = 0;
+    for (int k = 0; k < ECHO_SAMPLES / 32; k++){
+        __m256i vs = _mm256_loadu_si256((const __m256i *)(s + 32 * k));
+        __m256i vt = _mm256_loadu_si256((const __m256i *)(t + 32 * k));
+        __m256i d  = cross ? _mm256_subs_epu8(vs, vt) : _mm256_subs_epu8(vt, vs);
+        unsigned eq = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(d, vb));
+        if (eq){
+            r->margin_sample = 32 * k + __builtin_ctz(eq);
+            break;
+        }
+    }
+}
+#endif
+
+/* ------------------ dispatch ------------------ */
+static echo_analyze_fn ea_fn;
+static const char     *ea_name;
+
+static pthread_once_t ea_once = PTHREAD_ONCE_INIT;
+
+static void ea_select(void){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")){
+        ea_fn   = echo_avx2;
+        ea_name = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")){
+        ea_fn   = echo_sse2;
+        ea_name = "sse2";
+        return;
+    }
+#endif
+    ea_fn   = echo_scalar_fn;
+    ea_name = "scalar";
+}
+
+const char *echo_impl(void){
+    pthread_once(&ea_once, ea_select);
+    return ea_name;
+}
+
+void echo_analyze(const uint8_t samples[ECHO_SAMPLES], const uint8_t thr[ECHO_SAMPLES], echo_result_t *r){
+    pthread_once(&ea_once, ea_select);
+    ea_fn(samples, thr, r);
+}
+
+/* ------------------ modo --echo ------------------ */
+typedef struct {
+    int      have;
+    uint64_t seq;                  // trama de configuracion en uso
+    int      dt_us;
+    uint8_t  thr[ECHO_SAMPLES];
+} echo_dev_t;
+
+struct echo_state {
+    int is_p2;
+    curve_interp_t interp;
+    record_format_t fmt;
+    echo_stats_t st;
+    echo_dev_t dev[ECHO_DEVICES];  // UART_ADDR es de 4 bits
+};
+
+echo_state_t *echo_new(int is_p2, curve_interp_t interp, record_format_t fmt){
+    echo_state_t *es = calloc(1, sizeof(*es));
+    if (!es) return NULL;
+    es->is_p2 = is_p2;
+    es->interp = interp;
+    es->fmt = fmt;
+    pthread_once(&ea_once, ea_select);   // elige el kernel antes de la primera linea
+    return es;
+}
+
+void echo_free(echo_state_t *es){
+    free(es);
+}
+
+void echo_get_stats(const echo_state_t *es, echo_stats_t *st){
+    *st = es->st;
+}
+
+static inline char *put_lit(char *o, const char *s){
+    size_t n = strlen(s);
+    memcpy(o, s, n);
+    return o + n;
+}
+
+static inline char *put_u64(char *o, uint64_t v){
+    return o + numfmt_u64(o, v);
+}
+
+static inline char *put_i64(char *o, int64_t v){
+    return o + numfmt_i64(o, v);
+}
+
+/* muestra, t_us y distancia de una muestra */
+static char *put_sample_text(char *o, int i, int dt_us){
+    int t_us = i * dt_us;
+    o = put_i64(o, i);
+    o = put_lit(o, " (");
+    o = put_i64(o, t_us);
+    o = put_lit(o, " us, ");
+    o += numfmt_dist_cm(o, t_us, tof_us_to_cm(t_us));
+    return put_lit(o, " cm)");
+}
+
+static char *put_sample_json(char *o, int i, int dt_us){
+    if (i < 0) return put_lit(o, "null");
+    int t_us = i * dt_us;
+    o = put_lit(o, "{\"sample\":");
+    o = put_i64(o, i);
+    o = put_lit(o, ",\"t_us\":");
+    o = put_i64(o, t_us);
+    o = put_lit(o, ",\"dist_cm\":");
+    o += numfmt_dist_cm(o, t_us, tof_us_to_cm(t_us));
+    return put_lit(o, "}");
+}
+
+int echo_frame(echo_state_t *es, FILE *out, const hermes_frame_t *fr){
+    if (fr->nbytes < ECHO_FRAME_BYTES){
+        hermes_config_t cfg;
+        decode_config(fr->reg, &cfg);
+        echo_dev_t *d = &es->dev[cfg.uart_addr & (ECHO_DEVICES - 1)];
+        d->dt_us = echo_threshold(&cfg, es->is_p2, es->interp, d->thr);
+        d->seq = fr->seq;
+        d->have = 1;
+        es->st.configs++;
+        return 0;
+    }
+
+    int device = fr->prefix & (ECHO_DEVICES - 1);
+    const echo_dev_t *d = &es->dev[device];
+    if (!d->have){
+        es->st.unpaired++;
+        return 0;
+    }
+
+    echo_result_t r;
+    echo_analyze(fr->reg, d->thr, &r);
+    es->st.dumps++;
+    if (r.crossings) es->st.detected++;
+
+    char line[512];
+    char *o = line;
+    const char *preset = es->is_p2 ? "P2" : "P1";
+    if (es->fmt == RECORD_NDJSON){
+        o = put_lit(o, "{\"frame_id\":");
+        o = put_u64(o, fr->seq);
+        o = put_lit(o, ",\"offset\":");
+        o = put_u64(o, fr->offset);
+        o = put_lit(o, ",\"device\":");
+        o = put_i64(o, device);
+        o = put_lit(o, es->is_p2 ? ",\"preset\":\"p2\"" : ",\"preset\":\"p1\"");
+        o = put_lit(o, ",\"config_frame_id\":");
+        o = put_u64(o, d->seq);
+        o = put_lit(o, ",\"crossings\":");
+        o = put_i64(o, r.crossings);
+        o = put_lit(o, ",\"first\":");
+        o = put_sample_json(o, r.first, d->dt_us);
+        o = put_lit(o, ",\"last\":");
+        o = put_sample_json(o, r.last, d->dt_us);
+        o = put_lit(o, ",\"margin\":");
+        o = put_i64(o, r.margin);
+        o = put_lit(o, ",\"margin_sample\":");
+        o = put_i64(o, r.margin_sample);
+        o = put_lit(o, "}\n");
+    } else {
+        o = put_lit(o, "Eco ");
+        o = put_u64(o, fr->seq);
+        o = put_lit(o, " @");
+        o = put_u64(o, fr->offset);
+        o = put_lit(o, " dispositivo ");
+        o = put_i64(o, device);
+        o = put_lit(o, ", ");
+        o = put_lit(o, preset);
+        o = put_lit(o, " de la trama ");
+        o = put_u64(o, d->seq);
+        o = put_lit(o, ": ");
+        if (r.crossings){
+            o = put_i64(o, r.crossings);
+            o = put_lit(o, r.crossings == 1 ? " cruce, objeto en muestra " : " cruces, objeto en muestra ");
+            o = put_sample_text(o, r.first, d->dt_us);
+            o = put_lit(o, ", último ");
+            o = put_sample_text(o, r.last, d->dt_us);
+            o = put_lit(o, ", margen +");
+        } else {
+            o = put_lit(o, "sin cruces, margen ");
+        }
+        o = put_i64(o, r.margin);
+        o = put_lit(o, " en muestra ");
+        o = put_i64(o, r.margin_sample);
+        *o++ = '\n';
+    }
+
+    size_t n = (size_t)(o - line);
+    return fwrite(line, 1, n, out) == n ? 0 : -1;
+}
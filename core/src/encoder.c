@@ -0,0 +1,613 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "encoder.h"
+#include "decoder.h"
+#include "regmap.h"
+#include "utils.h"
+#include "hexparse.h"
+#include "stream.h"
+
+#define ENC_MAX_KV      1024
+#define ENC_ARENA_BYTES (32u << 10)   // claves generadas al aplanar JSON
+#define ENC_KEY_MAX     64
+
+/* ------------------ cfg -> reg ------------------ */
+/* Inversa de decode_tvg(): G1..G4 partidos entre TVGAIN3..5 (G5 va por el esquema) */
+static void encode_tvg_gains(const uint8_t g[HERMES_TVG_GAINS], uint8_t reg[55]){
+    reg[3] = (uint8_t)(((g[0] & 0x3F) << 2) | ((g[1] >> 4) & 0x03)); // G1 | G2[5:4]
+    reg[4] = (uint8_t)(((g[1] & 0x0F) << 4) | ((g[2] >> 2) & 0x0F)); // G2[3:0] | G3[5:2]
+    reg[5] = (uint8_t)(((g[2] & 0x03) << 6) | (g[3] & 0x3F));        // G3[1:0] | G4
+}
+
+void encode_config(const hermes_config_t *cfg, uint8_t reg[55]){
+    memset(reg, 0, 55);
+    regmap_encode(cfg, reg);   // campos simples, T1..T12, L9..L12, G5...
+    encode_tvg_gains(cfg->tvg.g, reg);
+
+    for (int p = 0; p < 2; p++){
+        int L[8];
+        for (int i = 0; i < 8; i++) L[i] = cfg->th[p].level[i];
+        pack_L1_L8_5bit(reg, p, L);
+    }
+}
+
+int encode_check(const hermes_config_t *want, const uint8_t reg[55]){
+    hermes_config_t got;
+    decode_config(reg, &got);
+
+    const uint8_t *a = (const uint8_t *)want, *b = (const uint8_t *)&got;
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        for (int f = 0; f < d->nfields; f++){
+            uint16_t off = d->fields[f].cfg_off;
+            if (off != REGMAP_NO_CFG && a[off] != b[off]) return -1;
+        }
+    }
+    if (memcmp(want->tvg.g, got.tvg.g, sizeof(got.tvg.g)) != 0) return -1;
+    for (int p = 0; p < 2; p++){
+        if (memcmp(want->th[p].level, got.th[p].level, sizeof(got.th[p].level)) != 0) return -1;
+    }
+    return 0;
+}
+
+/* ------------------ claves ------------------ */
+enum {
+    K_IGNORE = 0,
+    K_BASE,
+    K_PREFIX,
+    K_REG,
+    K_FIELD,
+    K_TIME,       // delta (us)
+    K_TIME_AT,    // acumulado (us)
+    K_LEVEL,      // nivel TH o ganancia TVG
+    K_NUM_KINDS
+};
+
+#define PROF_TVG 2   // prof: 0 = P1, 1 = P2, 2 = TVG
+
+typedef struct {
+    int kind;
+    int prof, stage;      // stage 0-based (TVG: T0..T5 / G1..G5)
+    int pct;
+    int reg_idx, field;
+    const encode_kv_t *kv;
+} enc_item_t;
+
+__attribute__((format(printf, 3, 4)))
+static int fail(char *err, size_t cap, const char *fmt, ...){
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(err, cap, fmt, ap);
+    va_end(ap);
+    return -1;
+}
+
+/* "T3_US" -> 3, con el sufijo esperado; -1 si no encaja */
+static int parse_stage(const char *s, char letter, const char *suffix){
+    if (*s++ != letter) return -1;
+    char *end;
+    long k = strtol(s, &end, 10);
+    if (end == s || strcmp(end, suffix) != 0) return -1;
+    return (int)k;
+}
+
+/* Claves canonicas P1_/P2_/TVG_ */
+static int classify_profile(const char *k, enc_item_t *it){
+    int prof;
+    if (strncmp(k, "P1_", 3) == 0) prof = 0;
+    else if (strncmp(k, "P2_", 3) == 0) prof = 1;
+    else if (strncmp(k, "TVG_", 4) == 0) prof = PROF_TVG;
+    else return -1;
+
+    const char *s = k + (prof == PROF_TVG ? 4 : 3);
+    int n, lo = (prof == PROF_TVG) ? 0 : 1;
+    int tmax = (prof == PROF_TVG) ? HERMES_TVG_STAGES - 1 : HERMES_TH_STAGES;
+    int lmax = (prof == PROF_TVG) ? HERMES_TVG_GAINS : HERMES_TH_STAGES;
+    char lv = (prof == PROF_TVG) ? 'G' : 'L';
+
+    it->prof = prof;
+    if ((n = parse_stage(s, 'T', "_US")) >= lo && n <= tmax){
+        it->kind = K_TIME;
+        it->stage = n - lo;
+    } else if ((n = parse_stage(s, 'T', "_AT_US")) >= lo && n <= tmax){
+        it->kind = K_TIME_AT;
+        it->stage = n - lo;
+    } else if ((n = parse_stage(s, lv, "")) >= 1 && n <= lmax){
+        it->kind = K_LEVEL;
+        it->stage = n - 1;
+    } else if ((n = parse_stage(s, lv, "_PCT")) >= 1 && n <= lmax){
+        it->kind = K_LEVEL;
+        it->stage = n - 1;
+        it->pct = 1;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/* Rutas de los objetos de --serve: p1[3].value_raw, tvg.points[0].gain_pct... */
+static int classify_path(const char *k, enc_item_t *it){
+    const char *m;
+    int i, prof;
+
+    if ((k[0] == 'p') && (k[1] == '1' || k[1] == '2') && k[2] == '['){
+        prof = k[1] - '1';
+        m = k + 3;
+    } else if (strncmp(k, "tvg.points[", 11) == 0){
+        prof = PROF_TVG;
+        m = k + 11;
+    } else if (strcmp(k, "tvg.flags.reserved") == 0 || strcmp(k, "tvg.flags.freq_shift") == 0){
+        it->kind = K_FIELD;
+        return regmap_find_field(k[10] == 'r' ? "TVGAIN6.RESERVED" : "TVGAIN6.FREQ_SHIFT",
+                                 &it->reg_idx, &it->field);
+    } else {
+        return -1;
+    }
+
+    char *end;
+    i = (int)strtol(m, &end, 10);
+    if (end == m || strncmp(end, "].", 2) != 0) return -1;
+    m = end + 2;
+
+    int nst = (prof == PROF_TVG) ? HERMES_TVG_STAGES : HERMES_TH_STAGES;
+    if (i < 0 || i >= nst) return -1;
+
+    it->prof = prof;
+    it->stage = i;
+    if (strcmp(m, "delta_us") == 0){
+        it->kind = K_TIME;
+    } else if (strcmp(m, "t_us") == 0){
+        it->kind = K_TIME_AT;
+    } else if (strcmp(m, prof == PROF_TVG ? "gain_raw" : "value_raw") == 0){
+        it->kind = K_LEVEL;
+    } else if (strcmp(m, prof == PROF_TVG ? "gain_pct" : "value_pct") == 0){
+        it->kind = K_LEVEL;
+        it->pct = 1;
+    } else if (strcmp(m, "stage") == 0 || strcmp(m, "dist_cm") == 0 || strcmp(m, "gain_raw_max") == 0){
+        it->kind = K_IGNORE;
+    } else {
+        return -1;
+    }
+    /* el ultimo tramo TVG repite G5 */
+    if (prof == PROF_TVG && it->kind == K_LEVEL && it->stage >= HERMES_TVG_GAINS) it->stage = HERMES_TVG_GAINS - 1;
+    return 0;
+}
+
+static const char *IGNORED_KEYS[] = {
+    "frame_id", "offset", "device", "reserved_bad", "units.x", "units.time", "units.y", NULL
+};
+
+static int classify(const encode_kv_t *kv, enc_item_t *it, char *err, size_t errcap){
+    char k[ENC_KEY_MAX];
+    if (kv->klen == 0 || kv->klen >= sizeof(k)) return fail(err, errcap, "clave no valida");
+    memcpy(k, kv->key, kv->klen);
+    k[kv->klen] = '\0';
+
+    memset(it, 0, sizeof(*it));
+    it->kv = kv;
+
+    if (kv->vlen == 0){
+        it->kind = K_IGNORE;   // celda vacia
+        return 0;
+    }
+    for (int i = 0; IGNORED_KEYS[i]; i++){
+        if (strcmp(k, IGNORED_KEYS[i]) == 0) return 0;
+    }
+    if (strcmp(k, "base") == 0 || strcmp(k, "reg") == 0){
+        it->kind = K_BASE;
+        return 0;
+    }
+    if (strcmp(k, "prefix") == 0){
+        it->kind = K_PREFIX;
+        return 0;
+    }
+    if (classify_profile(k, it) == 0 || classify_path(k, it) == 0) return 0;
+
+    memset(it, 0, sizeof(*it));
+    it->kv = kv;
+    if ((it->reg_idx = regmap_find_reg(k)) > 0){
+        it->kind = K_REG;
+        return 0;
+    }
+    if (regmap_find_field(k, &it->reg_idx, &it->field) == 0){
+        it->kind = K_FIELD;
+        return 0;
+    }
+    return fail(err, errcap, "clave desconocida o ambigua: %s", k);
+}
+
+/* ------------------ valores ------------------ */
+static int val_long(const encode_kv_t *kv, int base, long lo, long hi, long *v, char *err, size_t errcap){
+    char s[ENC_KEY_MAX], *end;
+    if (kv->vlen >= sizeof(s)) return fail(err, errcap, "valor demasiado largo en %.*s", (int)kv->klen, kv->key);
+    memcpy(s, kv->val, kv->vlen);
+    s[kv->vlen] = '\0';
+
+    *v = strtol(s, &end, base);
+    while (*end == ' ') end++;
+    if (end == s || *end || *v < lo || *v > hi){
+        return fail(err, errcap, "%.*s=%s fuera de rango (%ld..%ld)", (int)kv->klen, kv->key, s, lo, hi);
+    }
+    return 0;
+}
+
+static int val_double(const encode_kv_t *kv, double lo, double hi, double *v, char *err, size_t errcap){
+    char s[ENC_KEY_MAX], *end;
+    if (kv->vlen >= sizeof(s)) return fail(err, errcap, "valor demasiado largo en %.*s", (int)kv->klen, kv->key);
+    memcpy(s, kv->val, kv->vlen);
+    s[kv->vlen] = '\0';
+
+    *v = strtod(s, &end);
+    while (*end == ' ') end++;
+    if (end == s || *end || !(*v >= lo && *v <= hi)){
+        return fail(err, errcap, "%.*s=%s fuera de rango (%g..%g)", (int)kv->klen, kv->key, s, lo, hi);
+    }
+    return 0;
+}
+
+/* Nibble de tiempo de la etapa de it */
+static uint8_t *time_code(hermes_config_t *cfg, const enc_item_t *it){
+    return (it->prof == PROF_TVG) ? &cfg->tvg.t_code[it->stage] : &cfg->th[it->prof].t_code[it->stage];
+}
+
+static int apply_time_at(hermes_config_t *cfg, const enc_item_t *items, int n, char *err, size_t errcap){
+    /* acumulados por perfil y etapa (el ultimo gana), aplicados en orden de etapa */
+    double at[3][HERMES_TH_STAGES];
+    const enc_item_t *src[3][HERMES_TH_STAGES] = {{0}};
+
+    for (int i = 0; i < n; i++){
+        if (items[i].kind != K_TIME_AT) continue;
+        if (val_double(items[i].kv, 0.0, 1e9, &at[items[i].prof][items[i].stage], err, errcap) != 0) return -1;
+        src[items[i].prof][items[i].stage] = &items[i];
+    }
+
+    for (int p = 0; p < 3; p++){
+        int nst = (p == PROF_TVG) ? HERMES_TVG_STAGES : HERMES_TH_STAGES;
+        int cum = 0;
+        for (int s = 0; s < nst; s++){
+            uint8_t *code = time_code(cfg, &(enc_item_t){ .prof = p, .stage = s });
+            if (src[p][s]){
+                double delta = at[p][s] - cum;
+                if (delta <= 0.0){
+                    return fail(err, errcap, "%.*s: el tiempo acumulado debe crecer",
+                                (int)src[p][s]->kv->klen, src[p][s]->kv->key);
+                }
+                *code = us_to_nibble(delta > 1e6 ? 1000000 : (int)(delta + 0.5));
+            }
+            cum += nibble_to_us(*code);
+        }
+    }
+    return 0;
+}
+
+static int apply_level(hermes_config_t *cfg, const enc_item_t *it, char *err, size_t errcap){
+    if (it->prof == PROF_TVG){
+        uint8_t *g = &cfg->tvg.g[it->stage];
+        if (it->pct){
+            double pct;
+            if (val_double(it->kv, 0.0, 100.0, &pct, err, errcap) != 0) return -1;
+            *g = (uint8_t)(pct / 100.0 * HERMES_TVG_GAIN_MAX + 0.5);
+        } else {
+            long v;
+            if (val_long(it->kv, 0, 0, HERMES_TVG_GAIN_MAX, &v, err, errcap) != 0) return -1;
+            *g = (uint8_t)v;
+        }
+        return 0;
+    }
+
+    uint8_t *level = &cfg->th[it->prof].level[it->stage];
+    if (it->pct){
+        double pct;
+        if (val_double(it->kv, 0.0, 100.0, &pct, err, errcap) != 0) return -1;
+        *level = (uint8_t)pct_to_value(it->stage + 1, pct);
+    } else {
+        long v;
+        if (val_long(it->kv, 0, 0, it->stage < 8 ? 31 : 255, &v, err, errcap) != 0) return -1;
+        *level = (uint8_t)v;
+    }
+    return 0;
+}
+
+/* ------------------ trama ------------------ */
+int encode_frame(const encode_kv_t *kv, int n, const uint8_t base[HERMES_FRAME_BYTES],
+                 uint8_t out[HERMES_FRAME_BYTES], char *err, size_t errcap){
+    enc_item_t items[ENC_MAX_KV];
+    if (n > ENC_MAX_KV) return fail(err, errcap, "demasiadas claves (%d)", n);
+
+    for (int i = 0; i < n; i++){
+        if (classify(&kv[i], &items[i], err, errcap) != 0) return -1;
+    }
+
+    memcpy(out, base, HERMES_FRAME_BYTES);
+    uint8_t *reg = out + HERMES_PREFIX_BYTES;
+    hermes_config_t cfg;
+    long v;
+
+    for (int kind = K_BASE; kind < K_NUM_KINDS; kind++){
+        if (kind == K_TIME){
+            decode_config(reg, &cfg);   // a partir de aqui se trabaja sobre cfg
+        }
+        if (kind == K_TIME_AT){
+            if (apply_time_at(&cfg, items, n, err, errcap) != 0) return -1;
+            continue;
+        }
+
+        for (int i = 0; i < n; i++){
+            const enc_item_t *it = &items[i];
+            if (it->kind != kind) continue;
+
+            switch (kind){
+            case K_BASE: {
+                uint8_t buf[HERMES_FRAME_BYTES + 1];
+                int nb = parse_hex_bytes_n(it->kv->val, it->kv->vlen, buf, (int)sizeof(buf));
+                if (nb == HERMES_FRAME_BYTES) memcpy(out, buf, HERMES_FRAME_BYTES);
+                else if (nb == HERMES_NUM_REGS) memcpy(reg, buf, HERMES_NUM_REGS);
+                else return fail(err, errcap, "%.*s: se esperan 55 o 57 bytes en hex", (int)it->kv->klen, it->kv->key);
+                break;
+            }
+            case K_PREFIX:
+                if (val_long(it->kv, 16, 0, 0xFFFF, &v, err, errcap) != 0) return -1;
+                out[0] = (uint8_t)(v >> 8);
+                out[1] = (uint8_t)v;
+                break;
+            case K_REG:
+                if (val_long(it->kv, 0, 0, 0xFF, &v, err, errcap) != 0) return -1;
+                reg[it->reg_idx - 1] = (uint8_t)v;
+                break;
+            case K_FIELD: {
+                const reg_desc_t *d = regmap_desc(it->reg_idx);
+                long hi = (1l << d->fields[it->field].width) - 1;
+                if (val_long(it->kv, 0, 0, hi, &v, err, errcap) != 0) return -1;
+                regmap_field_set(reg, d, it->field, (unsigned)v);
+                break;
+            }
+            case K_TIME: {
+                double us;
+                if (val_double(it->kv, 0.0, 1e6, &us, err, errcap) != 0) return -1;
+                *time_code(&cfg, it) = us_to_nibble((int)(us + 0.5));
+                break;
+            }
+            case K_LEVEL:
+                if (apply_level(&cfg, it, err, errcap) != 0) return -1;
+                break;
+            }
+        }
+    }
+
+    encode_config(&cfg, reg);
+    if (encode_check(&cfg, reg) != 0) return fail(err, errcap, "inconsistencia encoder/decoder");
+    return 0;
+}
+
+/* ------------------ lotes: CSV / NDJSON -> kv ------------------ */
+typedef struct {
+    const char *p, *end;
+    char   *arena;
+    size_t  alen;
+    encode_kv_t *kv;
+    int     n;
+    char    path[ENC_KEY_MAX];
+    size_t  plen;
+    int     depth;
+} jflat_t;
+
+static void jf_ws(jflat_t *j){
+    while (j->p < j->end && (*j->p == ' ' || *j->p == '\t' || *j->p == '\r' || *j->p == '\n')) j->p++;
+}
+
+/* Cadena JSON: devuelve el contenido sin comillas (los escapes se dejan tal cual) */
+static int jf_string(jflat_t *j, const char **s, size_t *len){
+    if (j->p >= j->end || *j->p != '"') return -1;
+    const char *start = ++j->p;
+    while (j->p < j->end && *j->p != '"'){
+        if (*j->p == '\\') j->p++;
+        j->p++;
+    }
+    if (j->p >= j->end) return -1;
+    *s = start;
+    *len = (size_t)(j->p - start);
+    j->p++;
+    return 0;
+}
+
+static int jf_emit(jflat_t *j, const char *val, size_t vlen){
+    if (j->n >= ENC_MAX_KV || j->alen + j->plen > ENC_ARENA_BYTES) return -1;
+    char *k = j->arena + j->alen;
+    memcpy(k, j->path, j->plen);
+    j->alen += j->plen;
+    j->kv[j->n++] = (encode_kv_t){ k, j->plen, val, vlen };
+    return 0;
+}
+
+static int jf_push(jflat_t *j, const char *fmt, const char *s, size_t len, int idx){
+    int r = (fmt[0] == '[') ? snprintf(j->path + j->plen, sizeof(j->path) - j->plen, "[%d]", idx)
+                            : snprintf(j->path + j->plen, sizeof(j->path) - j->plen,
+                                       j->plen ? ".%.*s" : "%.*s", (int)len, s);
+    if (r < 0 || (size_t)r >= sizeof(j->path) - j->plen) return -1;
+    j->plen += (size_t)r;
+    return 0;
+}
+
+static int jf_value(jflat_t *j){
+    if (++j->depth > 16) return -1;
+    jf_ws(j);
+    if (j->p >= j->end) return -1;
+
+    size_t saved = j->plen;
+    int rc = 0;
+
+    if (*j->p == '{' || *j->p == '['){
+        int obj = (*j->p == '{');
+        char close = obj ? '}' : ']';
+        j->p++;
+        jf_ws(j);
+        if (j->p < j->end && *j->p == close){
+            j->p++;
+        } else {
+            for (int idx = 0; ; idx++){
+                jf_ws(j);
+                if (obj){
+                    const char *k;
+                    size_t klen;
+                    if (jf_string(j, &k, &klen) != 0) return -1;
+                    jf_ws(j);
+                    if (j->p >= j->end || *j->p++ != ':') return -1;
+                    if (jf_push(j, ".", k, klen, 0) != 0) return -1;
+                } else if (jf_push(j, "[", NULL, 0, idx) != 0){
+                    return -1;
+                }
+                if (jf_value(j) != 0) return -1;
+                j->plen = saved;
+                jf_ws(j);
+                if (j->p >= j->end) return -1;
+                if (*j->p == ',') { j->p++; continue; }
+                if (*j->p++ != close) return -1;
+                break;
+            }
+        }
+    } else if (*j->p == '"'){
+        const char *s;
+        size_t len;
+        if (jf_string(j, &s, &len) != 0) return -1;
+        rc = jf_emit(j, s, len);
+    } else {
+        const char *s = j->p;
+        while (j->p < j->end && !strchr(",}] \t\r\n", *j->p)) j->p++;
+        size_t len = (size_t)(j->p - s);
+        if (len == 0) return -1;
+        if (!(len == 4 && memcmp(s, "null", 4) == 0)) rc = jf_emit(j, s, len);
+    }
+
+    j->depth--;
+    return rc;
+}
+
+static int split_csv(char *line, size_t len, const char **cell, size_t *clen, int max){
+    int n = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= len; i++){
+        if (i < len && line[i] != ',') continue;
+        if (n >= max) return -1;
+        size_t a = start, b = i;
+        while (a < b && (line[a] == ' ' || line[a] == '\t' || line[a] == '"')) a++;
+        while (b > a && (line[b - 1] == ' ' || line[b - 1] == '\t' || line[b - 1] == '"')) b--;
+        cell[n] = line + a;
+        clen[n] = b - a;
+        n++;
+        start = i + 1;
+    }
+    return n;
+}
+
+static void write_frame_hex(FILE *out, const uint8_t f[HERMES_FRAME_BYTES]){
+    static const char HEX[] = "0123456789ABCDEF";
+    char s[3 * HERMES_FRAME_BYTES];
+    for (int i = 0; i < HERMES_FRAME_BYTES; i++){
+        s[3 * i]     = HEX[f[i] >> 4];
+        s[3 * i + 1] = HEX[f[i] & 0x0F];
+        s[3 * i + 2] = ' ';
+    }
+    s[3 * HERMES_FRAME_BYTES - 1] = '\n';
+    fwrite(s, 1, sizeof(s), out);
+}
+
+int encode_run(FILE *in, FILE *out, const uint8_t base[HERMES_FRAME_BYTES], encode_stats_t *st){
+    line_reader_t lr;
+    line_reader_init(&lr, in);
+    memset(st, 0, sizeof(*st));
+
+    encode_kv_t *kv = malloc(ENC_MAX_KV * sizeof(*kv));
+    const char **cell = malloc(ENC_MAX_KV * sizeof(*cell));
+    size_t *clen = malloc(ENC_MAX_KV * sizeof(*clen));
+    char *arena = malloc(ENC_ARENA_BYTES);
+    char *header = NULL;
+    const char **cols = NULL;
+    size_t *colen = NULL;
+    int ncols = 0, format = 0; // 0 = por detectar, 1 = CSV, 2 = NDJSON
+    int rc = 0;
+
+    if (!kv || !cell || !clen || !arena){
+        rc = -1;
+        goto out;
+    }
+
+    ssize_t len;
+    while ((len = line_reader_next(&lr)) >= 0){
+        char *line = lr.line;
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+
+        size_t skip = 0;
+        while ((ssize_t)skip < len && (line[skip] == ' ' || line[skip] == '\t')) skip++;
+        if ((ssize_t)skip == len) continue;
+
+        if (!format){
+            format = (line[skip] == '{') ? 2 : 1;
+            if (format == 1){
+                /* cabecera CSV: claves */
+                header = strdup(line);
+                cols = malloc(ENC_MAX_KV * sizeof(*cols));
+                colen = malloc(ENC_MAX_KV * sizeof(*colen));
+                if (!header || !cols || !colen){
+                    rc = -1;
+                    goto out;
+                }
+                ncols = split_csv(header, (size_t)len, cols, colen, ENC_MAX_KV);
+                if (ncols < 0){
+                    fprintf(stderr, "Encode: cabecera CSV con demasiadas columnas.\n");
+                    rc = -1;
+                    goto out;
+                }
+                continue;
+            }
+        }
+
+        char err[160];
+        int n = 0;
+        st->records++;
+
+        if (format == 1){
+            int nc = split_csv(line, (size_t)len, cell, clen, ncols);
+            if (nc < 0){
+                snprintf(err, sizeof(err), "más columnas que la cabecera (%d)", ncols);
+                n = -1;
+            } else {
+                for (int c = 0; c < nc; c++) kv[n++] = (encode_kv_t){ cols[c], colen[c], cell[c], clen[c] };
+            }
+        } else {
+            jflat_t j = { .p = line + skip, .end = line + len, .arena = arena, .kv = kv };
+            if (jf_value(&j) != 0){
+                snprintf(err, sizeof(err), "JSON no válido");
+                n = -1;
+            } else {
+                n = j.n;
+            }
+        }
+
+        uint8_t frame[HERMES_FRAME_BYTES];
+        if (n >= 0 && encode_frame(kv, n, base, frame, err, sizeof(err)) == 0){
+            write_frame_hex(out, frame);
+            st->frames++;
+        } else {
+            fprintf(stderr, "Encode: línea %llu: %s\n", (unsigned long long)lr.lineno, err);
+            st->errors++;
+        }
+    }
+    if (ferror(in) || ferror(out)) rc = -1;
+
+out:
+    line_reader_free(&lr);
+    free(kv);
+    free(cell);
+    free(clen);
+    free(arena);
+    free(header);
+    free(cols);
+    free(colen);
+    return rc;
+}
@@ -1,221 +1,394 @@
-#include <stdio.h>
-#include <stdint.h>
-
-#include "export.h"
-#include "utils.h"
-
-int write_th_profile_csv(const char *path, const uint8_t reg[55], int is_p2){
-    int delta_us[12];
-    int L5[8], L8[4];
-    int value_raw[12];
-
-    extract_T12_us(reg, is_p2, delta_us);
-    extract_L1_L8_5bit(reg, is_p2, L5);
-    extract_L9_L12_8bit(reg, is_p2, L8);
-
-    for (int i = 0; i < 8; i++) value_raw[i] = L5[i];
-    for (int i = 0; i < 4; i++) value_raw[8 + i] = L8[i];
-
-    FILE *f = fopen(path, "w");
-    if (!f) return -1;
-
-    fprintf(f, "stage,delta_us,t_us,dist_cm,value_pct,value_raw\n");
-
-    int acc_us = 0;
-    for (int i = 0; i < 12; i++){
-        int stage = i + 1;
-        acc_us += delta_us[i];
-
-        double dist_cm = tof_us_to_cm(acc_us);
-        double pct = value_to_pct(stage, value_raw[i]);
-
-        fprintf(f, "%d,%d,%d,%.4f,%.2f,%d\n",
-                stage,
-                delta_us[i],
-                acc_us,
-                dist_cm,
-                pct,
-                value_raw[i]);
-    }
-
-    fclose(f);
-    return 0;
-}
-
-int write_tvg_csv(const char *path, const uint8_t reg[55]){
-    int t_us[6];
-    int g_raw[5];
-    int g_max[5];
-
-    /* Extraer tiempos TVG (T0..T5) */
-    uint8_t b0 = reg[0]; // TVGAIN0
-    uint8_t b1 = reg[1]; // TVGAIN1
-    uint8_t b2 = reg[2]; // TVGAIN2
-
-    t_us[0] = nibble_to_us(HI_NIBBLE(b0));
-    t_us[1] = nibble_to_us(LO_NIBBLE(b0));
-    t_us[2] = nibble_to_us(HI_NIBBLE(b1));
-    t_us[3] = nibble_to_us(LO_NIBBLE(b1));
-    t_us[4] = nibble_to_us(HI_NIBBLE(b2));
-    t_us[5] = nibble_to_us(LO_NIBBLE(b2));
-
-    /* Extraer ganancias TVG (G1..G5) - SEGÚN EXCEL (G2 y G3 PARTIDOS) */
-    uint8_t tvg3 = reg[3]; // TVGAIN3
-    uint8_t tvg4 = reg[4]; // TVGAIN4
-    uint8_t tvg5 = reg[5]; // TVGAIN5
-    uint8_t tvg6 = reg[6]; // TVGAIN6
-
-    // Partes de G2 y G3 (ver Excel)
-    int g2_hi2 = (int)GET_BITS(tvg3, 0, 2); // TVGAIN3 b1..b0 -> G2[5:4]
-    int g2_lo4 = (int)GET_BITS(tvg4, 4, 4); // TVGAIN4 b7..b4 -> G2[3:0]
-
-    int g3_hi4 = (int)GET_BITS(tvg4, 0, 4); // TVGAIN4 b3..b0 -> G3[5:2]
-    int g3_lo2 = (int)GET_BITS(tvg5, 6, 2); // TVGAIN5 b7..b6 -> G3[1:0]
-
-    // Ganancias finales (todas 6 bits)
-    g_raw[0] = (int)GET_BITS(tvg3, 2, 6);        g_max[0] = 63; // G1 = TVGAIN3 b7..b2
-    g_raw[1] = (g2_hi2 << 4) | g2_lo4;           g_max[1] = 63; // G2 (6b) = (hi2<<4) | lo4
-    g_raw[2] = (g3_hi4 << 2) | g3_lo2;           g_max[2] = 63; // G3 (6b) = (hi4<<2) | lo2
-    g_raw[3] = (int)GET_BITS(tvg5, 0, 6);        g_max[3] = 63; // G4 = TVGAIN5 b5..b0
-    g_raw[4] = (int)GET_BITS(tvg6, 2, 6);        g_max[4] = 63; // G5 = TVGAIN6 b7..b2
-
-    // Flags TVGAIN6
-    int reserved   = (int)GET_BITS(tvg6, 1, 1);
-    int freq_shift = (int)GET_BITS(tvg6, 0, 1);
-    if (reserved != 0){
-        printf("WARNING: TVGAIN6 RESERVED bit != 0 (%d)\n", reserved);
-    }
-    (void)freq_shift; // por ahora no se usa
-
-    FILE *f = fopen(path, "w");
-    if (!f) return -1;
-
-    fprintf(f, "stage,delta_us,t_us,dist_cm_tvg,gain_pct,gain_raw,gain_raw_max\n");
-
-    int acc_us = 0;
-    for (int i = 0; i < 6; i++){
-        acc_us += t_us[i];
-
-        int gain_idx = (i < 5) ? i : 4; // último tramo mantiene G5
-        double gain_pct = (g_raw[gain_idx] / (double)g_max[gain_idx]) * 100.0;
-        double dist_cm_tvg = tof_us_to_cm(acc_us);
-
-        fprintf(
-            f,
-            "%d,%d,%d,%.4f,%.2f,%d,%d\n",
-            i + 1,
-            t_us[i],
-            acc_us,
-            dist_cm_tvg,
-            gain_pct,
-            g_raw[gain_idx],
-            g_max[gain_idx]
-        );
-    }
-
-    fclose(f);
-    return 0;
-}
-
-int write_th_profile_json(const char *path, const uint8_t reg[55], int is_p2){
-    int delta_us[12];
-    int L5[8], L8[4];
-    int raw[12];
-
-    extract_T12_us(reg, is_p2, delta_us);
-    extract_L1_L8_5bit(reg, is_p2, L5);
-    extract_L9_L12_8bit(reg, is_p2, L8);
-
-    for (int i = 0; i < 8; i++) raw[i] = L5[i];
-    for (int i = 0; i < 4; i++) raw[8+i] = L8[i];
-
-    FILE *f = fopen(path, "w");
-    if (!f) return -1;
-
-    fprintf(f, "{\n");
-    fprintf(f, "  \"profile\": \"%s\",\n", is_p2 ? "P2" : "P1");
-    fprintf(f, "  \"units\": {\"x\": \"cm\", \"time\": \"us\", \"y\": \"percent\"},\n");
-    fprintf(f, "  \"points\": [\n");
-
-    int acc = 0;
-    for (int i = 0; i < 12; i++){
-        int stage = i + 1;
-        acc += delta_us[i];
-        double dist_cm = tof_us_to_cm(acc);
-        double pct = value_to_pct(stage, raw[i]);
-
-        fprintf(f,
-            "    {\"stage\": %d, \"delta_us\": %d, \"t_us\": %d, \"dist_cm\": %.4f, \"value_pct\": %.2f, \"value_raw\": %d}%s\n",
-            stage, delta_us[i], acc, dist_cm, pct, raw[i],
-            (i == 11) ? "" : ","
-        );
-    }
-
-    fprintf(f, "  ]\n");
-    fprintf(f, "}\n");
-
-    fclose(f);
-    return 0;
-}
-
-int write_tvg_json(const char *path, const uint8_t reg[55]){
-    int t_us[6];
-    int g_raw[5];
-    int g_max[5];
-
-    // tiempos (T0..T5)
-    uint8_t b0 = reg[0], b1 = reg[1], b2 = reg[2];
-    t_us[0] = nibble_to_us(HI_NIBBLE(b0));
-    t_us[1] = nibble_to_us(LO_NIBBLE(b0));
-    t_us[2] = nibble_to_us(HI_NIBBLE(b1));
-    t_us[3] = nibble_to_us(LO_NIBBLE(b1));
-    t_us[4] = nibble_to_us(HI_NIBBLE(b2));
-    t_us[5] = nibble_to_us(LO_NIBBLE(b2));
-
-    // ganancias según Excel (G2/G3 partidos)
-    uint8_t tvg3 = reg[3], tvg4 = reg[4], tvg5 = reg[5], tvg6 = reg[6];
-
-    int g2_hi2 = (int)GET_BITS(tvg3, 0, 2);   // TVGAIN3 b1..b0
-    int g2_lo4 = (int)GET_BITS(tvg4, 4, 4);   // TVGAIN4 b7..b4
-    int g3_hi4 = (int)GET_BITS(tvg4, 0, 4);   // TVGAIN4 b3..b0
-    int g3_lo2 = (int)GET_BITS(tvg5, 6, 2);   // TVGAIN5 b7..b6
-
-    g_raw[0] = (int)GET_BITS(tvg3, 2, 6);         g_max[0] = 63; // G1
-    g_raw[1] = (g2_hi2 << 4) | g2_lo4;            g_max[1] = 63; // G2
-    g_raw[2] = (g3_hi4 << 2) | g3_lo2;            g_max[2] = 63; // G3
-    g_raw[3] = (int)GET_BITS(tvg5, 0, 6);         g_max[3] = 63; // G4
-    g_raw[4] = (int)GET_BITS(tvg6, 2, 6);         g_max[4] = 63; // G5
-
-    int reserved  = (int)GET_BITS(tvg6, 1, 1);
-    int freq_shift = (int)GET_BITS(tvg6, 0, 1);
-
-    FILE *f = fopen(path, "w");
-    if (!f) return -1;
-
-    fprintf(f, "{\n");
-    fprintf(f, "  \"profile\": \"TVG\",\n");
-    fprintf(f, "  \"units\": {\"x\": \"cm\", \"time\": \"us\", \"y\": \"percent\"},\n");
-    fprintf(f, "  \"flags\": {\"reserved\": %d, \"freq_shift\": %d},\n", reserved, freq_shift);
-    fprintf(f, "  \"points\": [\n");
-
-    int acc_us = 0;
-    for (int i = 0; i < 6; i++){
-        acc_us += t_us[i];
-
-        int gain_idx = (i < 5) ? i : 4; // cola mantiene G5
-        double gain_pct = (g_raw[gain_idx] / (double)g_max[gain_idx]) * 100.0;
-        double dist_cm = tof_us_to_cm(acc_us);
-
-        fprintf(f,
-            "    {\"stage\": %d, \"delta_us\": %d, \"t_us\": %d, \"dist_cm\": %.4f, \"gain_pct\": %.2f, \"gain_raw\": %d, \"gain_raw_max\": %d}%s\n",
-            i + 1, t_us[i], acc_us, dist_cm, gain_pct, g_raw[gain_idx], g_max[gain_idx],
-            (i == 5) ? "" : ","
-        );
-    }
-
-    fprintf(f, "  ]\n");
-    fprintf(f, "}\n");
-
-    fclose(f);
-    return 0;
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "export.h"
+#include "frame.h"
+#include "regmap.h"
+#include "utils.h"
+#include "numfmt.h"
+#include "outbuf.h"
+
+/* ------------------ Perfil completo (un fichero por trama) ------------------
+ * Los formatos se generan en memoria del llamador (format_*, sin heap) y
+ * fprint_* / write_* son envoltorios sobre FILE / ruta. Los numeros salen de
+ * numfmt.c (tablas preformateadas), sin printf por campo.
+ */
+static void ob_int(outbuf_t *b, int64_t v){ OB_NUM(b, numfmt_i64(out, v)); }
+
+static void ob_u64(outbuf_t *b, uint64_t v){ OB_NUM(b, numfmt_u64(out, v)); }
+
+static void ob_dist(outbuf_t *b, int32_t t_us, double dist_cm){ OB_NUM(b, numfmt_dist_cm(out, t_us, dist_cm)); }
+
+static void ob_th_pct(outbuf_t *b, int stage, int raw, double pct){ OB_NUM(b, numfmt_th_pct(out, stage, raw, pct)); }
+
+static void ob_gain_pct(outbuf_t *b, int raw, double pct){ OB_NUM(b, numfmt_gain_pct(out, raw, pct)); }
+
+/* "0x%04X" */
+static void ob_prefix(outbuf_t *b, uint16_t prefix){
+    static const char HEX[] = "0123456789ABCDEF";
+    char s[6] = { '0', 'x', HEX[prefix >> 12], HEX[(prefix >> 8) & 0x0F], HEX[(prefix >> 4) & 0x0F], HEX[prefix & 0x0F] };
+    ob_mem(b, s, sizeof(s));
+}
+
+static int emit(FILE *f, const char *buf, size_t n, size_t cap){
+    if (n >= cap) return -1;
+    if (fwrite(buf, 1, n, f) != n) return -1;
+    return ferror(f) ? -1 : 0;
+}
+
+static int write_path(const char *path, int (*fn)(FILE *, const hermes_config_t *, int),
+                      const hermes_config_t *cfg, int is_p2){
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    int rc = fn(f, cfg, is_p2);
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+/* ------------------ puntos ------------------ */
+/* "%d,%d,%d,%.4f,%.2f,%d\n" */
+static void ob_th_row_csv(outbuf_t *b, const hermes_th_t *th, int i){
+    ob_int(b, i + 1);
+    ob_lit(b, ",");
+    ob_int(b, th->delta_us[i]);
+    ob_lit(b, ",");
+    ob_int(b, th->t_us[i]);
+    ob_lit(b, ",");
+    ob_dist(b, th->t_us[i], th->dist_cm[i]);
+    ob_lit(b, ",");
+    ob_th_pct(b, i + 1, th->level[i], th->pct[i]);
+    ob_lit(b, ",");
+    ob_int(b, th->level[i]);
+    ob_lit(b, "\n");
+}
+
+/* "%d,%d,%d,%.4f,%.2f,%d,%d\n" */
+static void ob_tvg_row_csv(outbuf_t *b, const hermes_tvg_t *tvg, int i){
+    ob_int(b, i + 1);
+    ob_lit(b, ",");
+    ob_int(b, tvg->delta_us[i]);
+    ob_lit(b, ",");
+    ob_int(b, tvg->t_us[i]);
+    ob_lit(b, ",");
+    ob_dist(b, tvg->t_us[i], tvg->dist_cm[i]);
+    ob_lit(b, ",");
+    ob_gain_pct(b, tvg->gain_raw[i], tvg->gain_pct[i]);
+    ob_lit(b, ",");
+    ob_int(b, tvg->gain_raw[i]);
+    ob_lit(b, ",");
+    ob_int(b, HERMES_TVG_GAIN_MAX);
+    ob_lit(b, "\n");
+}
+
+/* {"stage": %d, "delta_us": %d, "t_us": %d, "dist_cm": %.4f, "value_pct": %.2f, "value_raw": %d} */
+static void ob_th_point_json(outbuf_t *b, const hermes_th_t *th, int i){
+    ob_lit(b, "{\"stage\": ");
+    ob_int(b, i + 1);
+    ob_lit(b, ", \"delta_us\": ");
+    ob_int(b, th->delta_us[i]);
+    ob_lit(b, ", \"t_us\": ");
+    ob_int(b, th->t_us[i]);
+    ob_lit(b, ", \"dist_cm\": ");
+    ob_dist(b, th->t_us[i], th->dist_cm[i]);
+    ob_lit(b, ", \"value_pct\": ");
+    ob_th_pct(b, i + 1, th->level[i], th->pct[i]);
+    ob_lit(b, ", \"value_raw\": ");
+    ob_int(b, th->level[i]);
+    ob_lit(b, "}");
+}
+
+/* {"stage": ..., "gain_raw": %d[, "gain_raw_max": %d]} */
+static void ob_tvg_point_json(outbuf_t *b, const hermes_tvg_t *tvg, int i, int with_max){
+    ob_lit(b, "{\"stage\": ");
+    ob_int(b, i + 1);
+    ob_lit(b, ", \"delta_us\": ");
+    ob_int(b, tvg->delta_us[i]);
+    ob_lit(b, ", \"t_us\": ");
+    ob_int(b, tvg->t_us[i]);
+    ob_lit(b, ", \"dist_cm\": ");
+    ob_dist(b, tvg->t_us[i], tvg->dist_cm[i]);
+    ob_lit(b, ", \"gain_pct\": ");
+    ob_gain_pct(b, tvg->gain_raw[i], tvg->gain_pct[i]);
+    ob_lit(b, ", \"gain_raw\": ");
+    ob_int(b, tvg->gain_raw[i]);
+    if (with_max){
+        ob_lit(b, ", \"gain_raw_max\": ");
+        ob_int(b, HERMES_TVG_GAIN_MAX);
+    }
+    ob_lit(b, "}");
+}
+
+/* {"reserved": %d, "freq_shift": %d} */
+static void ob_tvg_flags(outbuf_t *b, const hermes_tvg_t *tvg){
+    ob_lit(b, "{\"reserved\": ");
+    ob_int(b, tvg->reserved);
+    ob_lit(b, ", \"freq_shift\": ");
+    ob_int(b, tvg->freq_shift);
+    ob_lit(b, "}");
+}
+
+size_t format_th_profile_csv(char *buf, size_t cap, const hermes_config_t *cfg, int is_p2){
+    const hermes_th_t *th = &cfg->th[is_p2 ? 1 : 0];
+    outbuf_t b = { buf, cap, 0 };
+
+    ob_lit(&b, "stage,delta_us,t_us,dist_cm,value_pct,value_raw\n");
+
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        ob_th_row_csv(&b, th, i);
+    }
+
+    return ob_done(&b);
+}
+
+size_t format_tvg_csv(char *buf, size_t cap, const hermes_config_t *cfg){
+    const hermes_tvg_t *tvg = &cfg->tvg;
+    outbuf_t b = { buf, cap, 0 };
+
+    ob_lit(&b, "stage,delta_us,t_us,dist_cm_tvg,gain_pct,gain_raw,gain_raw_max\n");
+
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        ob_tvg_row_csv(&b, tvg, i);
+    }
+
+    return ob_done(&b);
+}
+
+size_t format_th_profile_json(char *buf, size_t cap, const hermes_config_t *cfg, int is_p2){
+    const hermes_th_t *th = &cfg->th[is_p2 ? 1 : 0];
+    outbuf_t b = { buf, cap, 0 };
+
+    ob_lit(&b, "{\n");
+    if (is_p2) ob_lit(&b, "  \"profile\": \"P2\",\n");
+    else       ob_lit(&b, "  \"profile\": \"P1\",\n");
+    ob_lit(&b, "  \"units\": {\"x\": \"cm\", \"time\": \"us\", \"y\": \"percent\"},\n");
+    ob_lit(&b, "  \"points\": [\n");
+
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        ob_lit(&b, "    ");
+        ob_th_point_json(&b, th, i);
+        if (i == HERMES_TH_STAGES - 1) ob_lit(&b, "\n");
+        else                           ob_lit(&b, ",\n");
+    }
+
+    ob_lit(&b, "  ]\n");
+    ob_lit(&b, "}\n");
+
+    return ob_done(&b);
+}
+
+size_t format_tvg_json(char *buf, size_t cap, const hermes_config_t *cfg){
+    const hermes_tvg_t *tvg = &cfg->tvg;
+    outbuf_t b = { buf, cap, 0 };
+
+    ob_lit(&b, "{\n");
+    ob_lit(&b, "  \"profile\": \"TVG\",\n");
+    ob_lit(&b, "  \"units\": {\"x\": \"cm\", \"time\": \"us\", \"y\": \"percent\"},\n");
+    ob_lit(&b, "  \"flags\": ");
+    ob_tvg_flags(&b, tvg);
+    ob_lit(&b, ",\n");
+    ob_lit(&b, "  \"points\": [\n");
+
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        ob_lit(&b, "    ");
+        ob_tvg_point_json(&b, tvg, i, 1);
+        if (i == HERMES_TVG_STAGES - 1) ob_lit(&b, "\n");
+        else                            ob_lit(&b, ",\n");
+    }
+
+    ob_lit(&b, "  ]\n");
+    ob_lit(&b, "}\n");
+
+    return ob_done(&b);
+}
+
+int fprint_th_profile_csv(FILE *f, const hermes_config_t *cfg, int is_p2){
+    char buf[EXPORT_MAX_BYTES];
+    return emit(f, buf, format_th_profile_csv(buf, sizeof(buf), cfg, is_p2), sizeof(buf));
+}
+
+int fprint_tvg_csv(FILE *f, const hermes_config_t *cfg){
+    char buf[EXPORT_MAX_BYTES];
+    return emit(f, buf, format_tvg_csv(buf, sizeof(buf), cfg), sizeof(buf));
+}
+
+int fprint_th_profile_json(FILE *f, const hermes_config_t *cfg, int is_p2){
+    char buf[EXPORT_MAX_BYTES];
+    return emit(f, buf, format_th_profile_json(buf, sizeof(buf), cfg, is_p2), sizeof(buf));
+}
+
+int fprint_tvg_json(FILE *f, const hermes_config_t *cfg){
+    char buf[EXPORT_MAX_BYTES];
+    return emit(f, buf, format_tvg_json(buf, sizeof(buf), cfg), sizeof(buf));
+}
+
+static int fprint_tvg_csv_p(FILE *f, const hermes_config_t *cfg, int unused){
+    (void)unused;
+    return fprint_tvg_csv(f, cfg);
+}
+
+static int fprint_tvg_json_p(FILE *f, const hermes_config_t *cfg, int unused){
+    (void)unused;
+    return fprint_tvg_json(f, cfg);
+}
+
+int write_th_profile_csv(const char *path, const hermes_config_t *cfg, int is_p2){
+    return write_path(path, fprint_th_profile_csv, cfg, is_p2);
+}
+
+int write_tvg_csv(const char *path, const hermes_config_t *cfg){
+    return write_path(path, fprint_tvg_csv_p, cfg, 0);
+}
+
+int write_th_profile_json(const char *path, const hermes_config_t *cfg, int is_p2){
+    return write_path(path, fprint_th_profile_json, cfg, is_p2);
+}
+
+int write_tvg_json(const char *path, const hermes_config_t *cfg){
+    return write_path(path, fprint_tvg_json_p, cfg, 0);
+}
+
+/* ------------------ Batch (una fila/linea por trama) ------------------ */
+#define KEY_CSV_COLS "frame_id,offset,device,prefix,"
+
+int fprint_th_rows_csv_header(FILE *f){
+    fputs(KEY_CSV_COLS "stage,delta_us,t_us,dist_cm,value_pct,value_raw\n", f);
+    return ferror(f) ? -1 : 0;
+}
+
+/* "%llu,%llu,%u,0x%04X," */
+static void ob_key_csv(outbuf_t *b, const export_key_t *k){
+    ob_u64(b, k->frame_id);
+    ob_lit(b, ",");
+    ob_u64(b, k->offset);
+    ob_lit(b, ",");
+    ob_int(b, k->device);
+    ob_lit(b, ",");
+    ob_prefix(b, k->prefix);
+    ob_lit(b, ",");
+}
+
+int fprint_th_rows_csv(FILE *f, const export_key_t *k, const hermes_config_t *cfg, int is_p2){
+    const hermes_th_t *th = &cfg->th[is_p2 ? 1 : 0];
+    char buf[EXPORT_MAX_BYTES];
+    outbuf_t b = { buf, sizeof(buf), 0 };
+
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        ob_key_csv(&b, k);
+        ob_th_row_csv(&b, th, i);
+    }
+
+    return emit(f, buf, b.len, sizeof(buf));
+}
+
+int fprint_tvg_rows_csv_header(FILE *f){
+    fputs(KEY_CSV_COLS "stage,delta_us,t_us,dist_cm_tvg,gain_pct,gain_raw,gain_raw_max\n", f);
+    return ferror(f) ? -1 : 0;
+}
+
+int fprint_tvg_rows_csv(FILE *f, const export_key_t *k, const hermes_config_t *cfg){
+    const hermes_tvg_t *tvg = &cfg->tvg;
+    char buf[EXPORT_MAX_BYTES];
+    outbuf_t b = { buf, sizeof(buf), 0 };
+
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        ob_key_csv(&b, k);
+        ob_tvg_row_csv(&b, tvg, i);
+    }
+
+    return emit(f, buf, b.len, sizeof(buf));
+}
+
+/* {"frame_id": %llu, "offset": %llu, "device": %u, "prefix": "0x%04X", */
+static void ob_key_json(outbuf_t *b, const export_key_t *k){
+    ob_lit(b, "{\"frame_id\": ");
+    ob_u64(b, k->frame_id);
+    ob_lit(b, ", \"offset\": ");
+    ob_u64(b, k->offset);
+    ob_lit(b, ", \"device\": ");
+    ob_int(b, k->device);
+    ob_lit(b, ", \"prefix\": \"");
+    ob_prefix(b, k->prefix);
+    ob_lit(b, "\", ");
+}
+
+int fprint_th_ndjson(FILE *f, const export_key_t *k, const hermes_config_t *cfg, int is_p2){
+    const hermes_th_t *th = &cfg->th[is_p2 ? 1 : 0];
+    char buf[EXPORT_MAX_BYTES];
+    outbuf_t b = { buf, sizeof(buf), 0 };
+
+    ob_key_json(&b, k);
+    if (is_p2) ob_lit(&b, "\"profile\": \"P2\", ");
+    else       ob_lit(&b, "\"profile\": \"P1\", ");
+    ob_lit(&b, "\"units\": {\"x\": \"cm\", \"time\": \"us\", \"y\": \"percent\"}, \"points\": [");
+
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        if (i) ob_lit(&b, ", ");
+        ob_th_point_json(&b, th, i);
+    }
+    ob_lit(&b, "]}\n");
+
+    return emit(f, buf, b.len, sizeof(buf));
+}
+
+int fprint_tvg_ndjson(FILE *f, const export_key_t *k, const hermes_config_t *cfg){
+    const hermes_tvg_t *tvg = &cfg->tvg;
+    char buf[EXPORT_MAX_BYTES];
+    outbuf_t b = { buf, sizeof(buf), 0 };
+
+    ob_key_json(&b, k);
+    ob_lit(&b, "\"profile\": \"TVG\", \"units\": {\"x\": \"cm\", \"time\": \"us\", \"y\": \"percent\"}, ");
+    ob_lit(&b, "\"flags\": ");
+    ob_tvg_flags(&b, tvg);
+    ob_lit(&b, ", \"points\": [");
+
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        if (i) ob_lit(&b, ", ");
+        ob_tvg_point_json(&b, tvg, i, 1);
+    }
+    ob_lit(&b, "]}\n");
+
+    return emit(f, buf, b.len, sizeof(buf));
+}
+
+/* Trama completa en una linea JSON (respuestas de --serve) */
+size_t format_frame_json(char *buf, size_t cap, const export_key_t *k, const hermes_config_t *cfg){
+    outbuf_t b = { buf, cap, 0 };
+
+    ob_key_json(&b, k);
+    static const char HEX[] = "0123456789ABCDEF";
+    char reg[2 * HERMES_NUM_REGS];
+    for (int i = 0; i < HERMES_NUM_REGS; i++){
+        reg[2 * i]     = HEX[cfg->reg[i] >> 4];
+        reg[2 * i + 1] = HEX[cfg->reg[i] & 0x0F];
+    }
+    ob_lit(&b, "\"reserved_bad\": ");
+    ob_int(&b, regmap_check_reserved(cfg->reg));
+    ob_lit(&b, ", \"reg\": \"");
+    ob_mem(&b, reg, sizeof(reg));
+    ob_lit(&b, "\"");
+
+    for (int p = 0; p < 2; p++){
+        const hermes_th_t *th = &cfg->th[p];
+        if (p) ob_lit(&b, ", \"p2\": [");
+        else   ob_lit(&b, ", \"p1\": [");
+        for (int i = 0; i < HERMES_TH_STAGES; i++){
+            if (i) ob_lit(&b, ", ");
+            ob_th_point_json(&b, th, i);
+        }
+        ob_lit(&b, "]");
+    }
+
+    const hermes_tvg_t *tvg = &cfg->tvg;
+    ob_lit(&b, ", \"tvg\": {\"flags\": ");
+    ob_tvg_flags(&b, tvg);
+    ob_lit(&b, ", \"points\": [");
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        if (i) ob_lit(&b, ", ");
+        ob_tvg_point_json(&b, tvg, i, 0);
+    }
+    ob_lit(&b, "]}}\n");
+
+    return ob_done(&b);
+}
@@ -0,0 +1,147 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "hermes.h"
+#include "frame.h"
+#include "regmap.h"
+#include "decoder.h"
+#include "hexparse.h"
+#include "export.h"
+#include "curve.h"
+
+/* Lineas mas largas que esto se rechazan (una trama son 57 bytes) */
+#define HERMES_HEX_MAX_BYTES 512
+
+#if EXPORT_MAX_BYTES > HERMES_SERIALIZE_MAX
+#error "HERMES_SERIALIZE_MAX debe cubrir EXPORT_MAX_BYTES"
+#endif
+
+int hermes_version(void){
+    return HERMES_API_VERSION;
+}
+
+const char *hermes_strerror(int rc){
+    switch (rc){
+    case HERMES_OK:           return "ok";
+    case HERMES_ERR_HEX:      return "hex invalido o trama demasiado larga";
+    case HERMES_ERR_SHORT:    return "trama incompleta (se esperan 57 bytes)";
+    case HERMES_ERR_ARG:      return "argumento invalido";
+    case HERMES_ERR_NOSPACE:  return "buffer insuficiente";
+    case HERMES_ERR_NOTFOUND: return "registro o campo desconocido";
+    default:                  return "error desconocido";
+    }
+}
+
+int hermes_decode_bytes(const uint8_t *frame, size_t n, hermes_decoded_t *out){
+    if (!frame || !out) return HERMES_ERR_ARG;
+    if (n < HERMES_FRAME_BYTES) return HERMES_ERR_SHORT;
+
+    const uint8_t *reg = frame + HERMES_PREFIX_BYTES;
+    out->prefix = (uint16_t)((frame[0] << 8) | frame[1]);
+    out->nbytes = n > INT32_MAX ? INT32_MAX : (int)n;
+    out->reserved_bad = regmap_check_reserved(reg);
+    decode_config(reg, &out->cfg);
+    return HERMES_OK;
+}
+
+int hermes_decode_hex(const char *hex, size_t len, hermes_decoded_t *out){
+    if (!hex || !out) return HERMES_ERR_ARG;
+
+    uint8_t buf[HERMES_HEX_MAX_BYTES];
+    int n = parse_hex_bytes_n(hex, len, buf, (int)sizeof(buf));
+    if (n < 0) return HERMES_ERR_HEX;
+    return hermes_decode_bytes(buf, (size_t)n, out);
+}
+
+int hermes_decode_regs(const uint8_t reg[55], hermes_config_t *cfg){
+    if (!reg || !cfg) return HERMES_ERR_ARG;
+    decode_config(reg, cfg);
+    return HERMES_OK;
+}
+
+int hermes_field_get(const hermes_config_t *cfg, const char *spec, unsigned *value){
+    if (!cfg || !spec || !value) return HERMES_ERR_ARG;
+
+    int idx, f;
+    if (regmap_find_field(spec, &idx, &f) != 0) return HERMES_ERR_NOTFOUND;
+    *value = regmap_field_value(cfg->reg, regmap_desc(idx), f);
+    return HERMES_OK;
+}
+
+int hermes_reg_get(const hermes_config_t *cfg, const char *name, uint8_t *value){
+    if (!cfg || !name || !value) return HERMES_ERR_ARG;
+
+    int idx = regmap_find_reg(name);
+    if (idx < 0) return HERMES_ERR_NOTFOUND;
+    *value = cfg->reg[idx - 1];
+    return HERMES_OK;
+}
+
+int hermes_th_curve(const hermes_config_t *cfg, int preset, hermes_point_t *pts, size_t cap){
+    if (!cfg || !pts || (preset != 0 && preset != 1)) return HERMES_ERR_ARG;
+    if (cap < HERMES_TH_POINTS) return HERMES_ERR_NOSPACE;
+
+    const hermes_th_t *th = &cfg->th[preset];
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        pts[i].t_us      = th->t_us[i];
+        pts[i].dist_cm   = th->dist_cm[i];
+        pts[i].value_pct = th->pct[i];
+    }
+    return HERMES_TH_POINTS;
+}
+
+/* Como plot_tvg()/render: escalon desde x=0 con la ganancia del primer tramo */
+int hermes_tvg_curve(const hermes_config_t *cfg, hermes_point_t *pts, size_t cap){
+    if (!cfg || !pts) return HERMES_ERR_ARG;
+    if (cap < HERMES_TVG_POINTS) return HERMES_ERR_NOSPACE;
+
+    const hermes_tvg_t *tvg = &cfg->tvg;
+    pts[0].t_us      = 0;
+    pts[0].dist_cm   = 0.0;
+    pts[0].value_pct = tvg->gain_pct[0];
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        pts[i + 1].t_us      = tvg->t_us[i];
+        pts[i + 1].dist_cm   = tvg->dist_cm[i];
+        pts[i + 1].value_pct = tvg->gain_pct[i];
+    }
+    return HERMES_TVG_POINTS;
+}
+
+int hermes_curve_grid(const hermes_config_t *cfgs, size_t ncfg, hermes_profile_t profile,
+                      hermes_interp_t interp, const float *grid_cm, size_t ngrid,
+                      float *out, size_t cap){
+    if ((ncfg && !cfgs) || (ngrid && !grid_cm) || (!out && cap)) return HERMES_ERR_ARG;
+    if (profile != HERMES_PROFILE_P1 && profile != HERMES_PROFILE_P2 && profile != HERMES_PROFILE_TVG) return HERMES_ERR_ARG;
+    if (interp != HERMES_CURVE_STEP && interp != HERMES_CURVE_LINEAR) return HERMES_ERR_ARG;
+    if (ngrid && ncfg > cap / ngrid) return HERMES_ERR_NOSPACE;
+
+    curve_kind_t kind = profile == HERMES_PROFILE_P1 ? CURVE_P1 : profile == HERMES_PROFILE_P2 ? CURVE_P2 : CURVE_TVG;
+    curve_eval_batch(cfgs, ncfg, kind, interp == HERMES_CURVE_LINEAR ? CURVE_LINEAR : CURVE_STEP,
+                     grid_cm, ngrid, out);
+    return HERMES_OK;
+}
+
+int hermes_serialize(const hermes_config_t *cfg, hermes_profile_t profile,
+                     hermes_format_t fmt, char *buf, size_t cap){
+    if (!cfg || (!buf && cap)) return HERMES_ERR_ARG;
+    if (fmt != HERMES_FMT_CSV && fmt != HERMES_FMT_JSON) return HERMES_ERR_ARG;
+
+    size_t n;
+    switch (profile){
+    case HERMES_PROFILE_P1:
+    case HERMES_PROFILE_P2:
+        n = (fmt == HERMES_FMT_CSV)
+            ? format_th_profile_csv(buf, cap, cfg, profile == HERMES_PROFILE_P2)
+            : format_th_profile_json(buf, cap, cfg, profile == HERMES_PROFILE_P2);
+        break;
+    case HERMES_PROFILE_TVG:
+        n = (fmt == HERMES_FMT_CSV) ? format_tvg_csv(buf, cap, cfg) : format_tvg_json(buf, cap, cfg);
+        break;
+    default:
+        return HERMES_ERR_ARG;
+    }
+
+    if (n >= cap) return HERMES_ERR_NOSPACE;
+    return (int)n;
+}
@@ -0,0 +1,252 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "hexparse.h"
+
+/*
+ * Bloques de 64 caracteres:
+ *   1) SIMD: valor de nibble de cada caracter + mascaras de 64 bits
+ *      hex (0-9a-fA-F) y sep (isspace, ':', '-', ',').
+ *   2) Si hay algun caracter que no es hex ni separador -> escalar.
+ *   3) Bloque todo hex y alineado a par -> empaquetado SIMD (32 bytes).
+ *      Si no, se recorren los bits de la mascara hex emparejando nibbles;
+ *      un par separado ("A A") se delega en el escalar.
+ */
+
+#define HP_BLOCK 64
+
+typedef void (*hp_classify_fn)(const uint8_t *p, uint8_t vals[HP_BLOCK], uint64_t *hex, uint64_t *sep);
+typedef void (*hp_pack_fn)(const uint8_t vals[HP_BLOCK], uint8_t *out);
+
+/* ------------------ scalar kernels ------------------ */
+static void classify_scalar(const uint8_t *p, uint8_t vals[HP_BLOCK], uint64_t *hex, uint64_t *sep){
+    uint64_t h = 0, s = 0;
+    for (int i = 0; i < HP_BLOCK; i++){
+        uint8_t c = p[i];
+        int v = hexval((char)c);
+        vals[i] = (uint8_t)(v & 0x0F);
+        h |= (uint64_t)(v >= 0) << i;
+        s |= (uint64_t)(c == ' ' || (c >= '\t' && c <= '\r') || c == ':' || c == '-' || c == ',') << i;
+    }
+    *hex = h;
+    *sep = s;
+}
+
+static void pack_scalar(const uint8_t vals[HP_BLOCK], uint8_t *out){
+    for (int i = 0; i < HP_BLOCK / 2; i++){
+        out[i] = (uint8_t)((vals[2*i] << 4) | vals[2*i + 1]);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* ------------------ SSE2 kernels ------------------ */
+static inline __m128i sse2_le_u8(__m128i x, int k){
+    return _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8((char)k)), x); // x <= k (unsigned)
+}
+
+static void classify_sse2(const uint8_t *p, uint8_t vals[HP_BLOCK], uint64_t *hex, uint64_t *sep){
+    uint64_t h = 0, s = 0;
+    for (int k = 0; k < HP_BLOCK; k += 16){
+        __m128i c = _mm_loadu_si128((const __m128i *)(p + k));
+
+        __m128i d   = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+        __m128i l   = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        __m128i isd = sse2_le_u8(d, 9);
+        __m128i isl = sse2_le_u8(l, 5);
+        __m128i v   = _mm_or_si128(_mm_and_si128(isd, d),
+                                   _mm_andnot_si128(isd, _mm_add_epi8(l, _mm_set1_epi8(10))));
+        _mm_storeu_si128((__m128i *)(vals + k), _mm_and_si128(v, _mm_set1_epi8(0x0F)));
+
+        __m128i iss = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+                         sse2_le_u8(_mm_sub_epi8(c, _mm_set1_epi8('\t')), '\r' - '\t')),
+            _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(':')),
+                         _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')),
+                                      _mm_cmpeq_epi8(c, _mm_set1_epi8(',')))));
+
+        h |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(isd, isl)) << k;
+        s |= (uint64_t)(uint16_t)_mm_movemask_epi8(iss) << k;
+    }
+    *hex = h;
+    *sep = s;
+}
+
+static void pack_sse2(const uint8_t vals[HP_BLOCK], uint8_t *out){
+    for (int k = 0; k < HP_BLOCK; k += 32){
+        __m128i a = _mm_loadu_si128((const __m128i *)(vals + k));
+        __m128i b = _mm_loadu_si128((const __m128i *)(vals + k + 16));
+        // cada lane de 16 bits = [hi nibble | lo nibble << 8] -> (hi << 4) | lo
+        __m128i pa = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, _mm_set1_epi16(0x00FF)), 4),
+                                  _mm_srli_epi16(a, 8));
+        __m128i pb = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, _mm_set1_epi16(0x00FF)), 4),
+                                  _mm_srli_epi16(b, 8));
+        _mm_storeu_si128((__m128i *)(out + k / 2), _mm_packus_epi16(pa, pb));
+    }
+}
+
+/* ------------------ AVX2 kernels ------------------ */
+__attribute__((target("avx2")))
+static inline __m256i avx2_le_u8(__m256i x, int k){
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8((char)k)), x);
+}
+
+__attribute__((target("avx2")))
+static void classify_avx2(const uint8_t *p, uint8_t vals[HP_BLOCK], uint64_t *hex, uint64_t *sep){
+    uint64_t h = 0, s = 0;
+    for (int k = 0; k < HP_BLOCK; k += 32){
+        __m256i c = _mm256_loadu_si256((const __m256i *)(p + k));
+
+        __m256i d   = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+        __m256i l   = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        __m256i isd = avx2_le_u8(d, 9);
+        __m256i isl = avx2_le_u8(l, 5);
+        __m256i v   = _mm256_blendv_epi8(_mm256_add_epi8(l, _mm256_set1_epi8(10)), d, isd);
+        _mm256_storeu_si256((__m256i *)(vals + k), _mm256_and_si256(v, _mm256_set1_epi8(0x0F)));
+
+        __m256i iss = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+                            avx2_le_u8(_mm256_sub_epi8(c, _mm256_set1_epi8('\t')), '\r' - '\t')),
+            _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(':')),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')),
+                                            _mm256_cmpeq_epi8(c, _mm256_set1_epi8(',')))));
+
+        h |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(isd, isl)) << k;
+        s |= (uint64_t)(uint32_t)_mm256_movemask_epi8(iss) << k;
+    }
+    *hex = h;
+    *sep = s;
+}
+
+__attribute__((target("avx2")))
+static void pack_avx2(const uint8_t vals[HP_BLOCK], uint8_t *out){
+    __m256i a = _mm256_loadu_si256((const __m256i *)vals);
+    __m256i b = _mm256_loadu_si256((const __m256i *)(vals + 32));
+    __m256i lo = _mm256_set1_epi16(0x00FF);
+    __m256i pa = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(a, lo), 4), _mm256_srli_epi16(a, 8));
+    __m256i pb = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(b, lo), 4), _mm256_srli_epi16(b, 8));
+    // packus intercala por lanes de 128 bits: reordenar 64-bit qwords 0,2,1,3
+    __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(pa, pb), 0xD8);
+    _mm256_storeu_si256((__m256i *)out, r);
+}
+#endif
+
+/* ------------------ dispatch ------------------ */
+static hp_classify_fn hp_classify;
+static hp_pack_fn     hp_pack;
+static const char    *hp_name;
+
+static pthread_once_t hp_once = PTHREAD_ONCE_INIT;
+
+static void hp_select(void){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")){
+        hp_classify = classify_avx2;
+        hp_pack     = pack_avx2;
+        hp_name     = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")){
+        hp_classify = classify_sse2;
+        hp_pack     = pack_sse2;
+        hp_name     = "sse2";
+        return;
+    }
+#endif
+    hp_classify = classify_scalar;
+    hp_pack     = pack_scalar;
+    hp_name     = "scalar";
+}
+
+/* Eleccion unica y thread-safe (el parser se usa desde varios hilos) */
+static inline void hp_init(void){
+    pthread_once(&hp_once, hp_select);
+}
+
+const char *hexparse_impl(void){
+    hp_init();
+    return hp_name;
+}
+
+/* Fallback escalar con la misma semantica que parse_hex_bytes(), pero
+ * acotado por len: no se lee s[len] (la linea puede acabar justo al final
+ * de un mmap) y no hace falta copiar la cadena para terminarla en '\0'. */
+static int parse_scalar_n(const char *s, size_t len, uint8_t *out, int max_out){
+    const char *end = s + len;
+#define AT(p) ((p) < end ? *(p) : '\0')
+    int n = 0;
+    while (AT(s)){
+        while (AT(s) && (isspace((unsigned char)AT(s)) || AT(s)==':' || AT(s)=='-' || AT(s)==',')) s++;
+        if (!AT(s)) break;
+
+        int hi = hexval(AT(s)); s++;
+        while (AT(s) && isspace((unsigned char)AT(s))) s++; // "A A"
+        int lo = hexval(AT(s)); s++;
+        if (hi < 0 || lo < 0) return -1;
+        if (n >= max_out) return -1;
+
+        out[n++] = (uint8_t)((hi<<4) | lo);
+    }
+#undef AT
+    return n;
+}
+
+int parse_hex_bytes_n(const char *s, size_t len, uint8_t *out, int max_out){
+    hp_init();
+
+    uint8_t vals[HP_BLOCK];
+    uint8_t tail[HP_BLOCK];
+    int n = 0;
+    int pending = -1;       // posicion absoluta del nibble alto pendiente
+    uint8_t pending_val = 0;
+
+    for (size_t pos = 0; pos < len; pos += HP_BLOCK){
+        const uint8_t *p = (const uint8_t *)s + pos;
+        size_t avail = len - pos;
+
+        if (avail < HP_BLOCK){
+            // Relleno con espacios (separador neutro) para el ultimo bloque
+            memcpy(tail, p, avail);
+            memset(tail + avail, ' ', HP_BLOCK - avail);
+            p = tail;
+        }
+
+        uint64_t hex, sep;
+        hp_classify(p, vals, &hex, &sep);
+        if (~(hex | sep)) return parse_scalar_n(s, len, out, max_out);
+
+        if (hex == ~(uint64_t)0 && pending < 0){
+            if (n + HP_BLOCK / 2 > max_out) return parse_scalar_n(s, len, out, max_out);
+            hp_pack(vals, out + n);
+            n += HP_BLOCK / 2;
+            continue;
+        }
+
+        for (uint64_t m = hex; m; m &= m - 1){
+            int bit = __builtin_ctzll(m);
+            if (pending < 0){
+                pending = (int)(pos + (size_t)bit);
+                pending_val = vals[bit];
+                continue;
+            }
+            // Nibble bajo no contiguo: "A A" u otro caso raro -> escalar
+            if ((size_t)pending + 1 != pos + (size_t)bit) return parse_scalar_n(s, len, out, max_out);
+            if (n >= max_out) return -1;
+            out[n++] = (uint8_t)((pending_val << 4) | vals[bit]);
+            pending = -1;
+        }
+    }
+
+    if (pending >= 0) return -1; // numero impar de nibbles
+    return n;
+}
+
+int parse_hex_bytes_fast(const char *s, uint8_t *out, int max_out){
+    return parse_hex_bytes_n(s, strlen(s), out, max_out);
+}
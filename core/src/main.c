@@ -1,223 +1,1266 @@
-/*
- * HermesDecoder - PGA460 config frame decoder (C) + CSV export
- *
- * Frame format (your protocol):
- *   [0..1]  : prefix/mode (e.g., 0x5E02) -> ignored for register mapping
- *   [2..56] : 55 bytes -> REG1..REG55 in fixed order
- *
- * Default: prints "raw decode" (registers + bitfields)
- * --csv   : generates threshold profile CSVs (P1 and P2)
- *
- * CSV columns:
- *   stage,delta_us,t_us,dist_cm,value_pct,value_raw
- *
- * Extra raw decode feature:
- *   - After Px_THR_10 (REG34 for P1, REG50 for P2) it prints decoded L1..L8
- *     (5-bit packed values) both raw and percentage.
- *
- * Build:
- *   gcc -O2 -Wall -Wextra hermes_decoder.c -o HermesDecoder
- *
- * Run:
- *   echo "<HEX>" | ./HermesDecoder
- *   echo "<HEX>" | ./HermesDecoder --csv
- *   echo "<HEX>" | ./HermesDecoder --csv prefix
- */
-
- //gcc -O2 -Wall -Wextra -Icore/inc core/src/*.c -o hermesdecoder
-
-#include <stdio.h>
-#include <stdint.h>
-#include <ctype.h>
-#include <string.h>
-
-#include "plot.h"
-#include "export.h"
-#include "utils.h"
-#include "decoder.h"
-#include "usage.h"
-
-int main(int argc, char **argv){
-    int want_plot_th = 0;
-    int want_plot_tvg = 0;
-    int want_export_csv = 0;
-    int want_export_json = 0;
-    const char *csv_prefix = NULL;
-
-    for (int i = 1; i < argc; i++){
-        if (strcmp(argv[i], "--export-csv") == 0){
-            want_export_csv = 1;
-            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
-                csv_prefix = argv[++i];
-            }
-
-        } else if (strcmp(argv[i], "--export-json") == 0){
-            want_export_json = 1;
-            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
-                csv_prefix = argv[++i];
-            }
-
-        } else if (strcmp(argv[i], "--plot") == 0){
-            want_plot_th = 1;
-            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
-                csv_prefix = argv[++i];
-            }
-
-        } else if (strcmp(argv[i], "--plot-tvg") == 0){
-            want_plot_tvg = 1;
-            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
-                csv_prefix = argv[++i];
-            }
-
-        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0){
-            usage(argv[0]);
-            return 0;
-
-        } else {
-            fprintf(stderr, "Argumento no reconocido: %s\n\n", argv[i]);
-            usage(argv[0]);
-            return 1;
-        }
-    }
-
-
-
-    uint8_t buf[512];
-    char line[4096];
-
-    if (!fgets(line, sizeof(line), stdin)){
-        fprintf(stderr, "No se recibió entrada por stdin.\n");
-        return 1;
-    }
-
-    int n = parse_hex_bytes(line, buf, (int)sizeof(buf));
-    if (n < 0){
-        fprintf(stderr, "Error parseando hex.\n");
-        return 1;
-    }
-
-    if (n < 2 + 55){
-        fprintf(stderr, "Trama demasiado corta: %d bytes. Se esperan al menos 57 (2 + 55).\n", n);
-        return 1;
-    }
-
-    uint16_t prefix = (uint16_t)((buf[0] << 8) | buf[1]);
-
-    uint8_t reg[55];
-    for (int i = 0; i < 55; i++){
-        reg[i] = buf[2 + i];
-    }
-
-    printf("HermesDecoder\n");
-    printf("Prefix/mode: 0x%04X (ignorado para el mapeo de registros)\n", prefix);
-    printf("Bytes totales: %d\n", n);
-    if (n != 57){
-        printf("AVISO: longitud esperada = 57 bytes (2 + 55). Recibida = %d bytes.\n", n);
-        printf("      Se decodificarán los primeros 55 bytes de registros igualmente.\n");
-    }
-    printf("\n");
-
-    for (int i = 0; i < 55; i++){
-        int idx = i + 1;
-        printf("[%02d]", idx);
-        decode_reg(reg, idx, reg[i]);
-    }
-
-     // --- Export/plot section ---
-    if (want_export_csv || want_plot_th || want_plot_tvg){
-
-        // Rutas CSV "export" (solo si want_export_csv)
-        char p1_export[256], p2_export[256], tvg_export[256];
-        char p1_json[256], p2_json[256], tvg_json[256];
-
-        if (csv_prefix && csv_prefix[0]){
-            snprintf(p1_export, sizeof(p1_export), "%s_p1_profile.csv", csv_prefix);
-            snprintf(p2_export, sizeof(p2_export), "%s_p2_profile.csv", csv_prefix);
-            snprintf(tvg_export, sizeof(tvg_export), "%s_tvg_profile.csv", csv_prefix);
-        } else {
-            snprintf(p1_export, sizeof(p1_export), "p1_profile.csv");
-            snprintf(p2_export, sizeof(p2_export), "p2_profile.csv");
-            snprintf(tvg_export, sizeof(tvg_export), "tvg_profile.csv");
-        }
-
-        if (csv_prefix && csv_prefix[0]){
-            snprintf(p1_json, sizeof(p1_json), "%s_p1_profile.json", csv_prefix);
-            snprintf(p2_json, sizeof(p2_json), "%s_p2_profile.json", csv_prefix);
-            snprintf(tvg_json, sizeof(tvg_json), "%s_tvg_profile.json", csv_prefix);
-        } else {
-            snprintf(p1_json, sizeof(p1_json), "p1_profile.json");
-            snprintf(p2_json, sizeof(p2_json), "p2_profile.json");
-            snprintf(tvg_json, sizeof(tvg_json), "tvg_profile.json");
-        }
-
-        // Rutas CSV temporales para plot (no exporta)
-        const char *p1_tmp  = "/tmp/hermes_p1_profile.csv";
-        const char *p2_tmp  = "/tmp/hermes_p2_profile.csv";
-        const char *tvg_tmp = "/tmp/hermes_tvg_profile.csv";
-
-        int ok_p1_plot = 0, ok_p2_plot = 0, ok_tvg_plot = 0;
-        int ok_p1_exp  = 0, ok_p2_exp  = 0, ok_tvg_exp  = 0;
-
-        // --- Generar CSVs para PLOT (temporales) ---
-        if (want_plot_th){
-            ok_p1_plot = write_th_profile_csv(p1_tmp, reg, 0);
-            ok_p2_plot = write_th_profile_csv(p2_tmp, reg, 1);
-        }
-        if (want_plot_tvg){
-            ok_tvg_plot = write_tvg_csv(tvg_tmp, reg);
-        }
-
-        // --- Plot (usa SIEMPRE los temporales) ---
-        if (want_plot_th){
-            if (ok_p1_plot==0 && ok_p2_plot==0){
-                printf("\nMostrando gráfica TH (P1 vs P2)...\n");
-                plot_profiles(p1_tmp, p2_tmp);
-            } else {
-                printf("\nNo se puede plotear TH: error generando CSV temporal.\n");
-            }
-        }
-
-        if (want_plot_tvg){
-            if (ok_tvg_plot==0){
-                printf("\nMostrando gráfica TVG...\n");
-                plot_tvg(tvg_tmp);
-            } else {
-                printf("\nNo se puede plotear TVG: error generando CSV temporal.\n");
-            }
-        }
-
-        // Borrar temporales al finalizar
-        if (want_plot_th){
-            remove(p1_tmp);
-            remove(p2_tmp);
-        }
-        if (want_plot_tvg){
-            remove(tvg_tmp);
-        }
-
-        // --- Generar CSVs para EXPORT (persistentes) ---
-        if (want_export_csv){
-            // Política: exportar siempre todo (TH + TVG)
-            ok_p1_exp = write_th_profile_csv(p1_export, reg, 0);
-            ok_p2_exp = write_th_profile_csv(p2_export, reg, 1);
-            ok_tvg_exp = write_tvg_csv(tvg_export, reg);
-
-            printf("\nCSV exportados:\n");
-            printf("  %s %s\n", (ok_p1_exp==0) ? "OK " : "ERR", p1_export);
-            printf("  %s %s\n", (ok_p2_exp==0) ? "OK " : "ERR", p2_export);
-            printf("  %s %s\n", (ok_tvg_exp==0) ? "OK " : "ERR", tvg_export);
-        }
-
-        if (want_export_json){
-            int ok_j1 = write_th_profile_json(p1_json, reg, 0);
-            int ok_j2 = write_th_profile_json(p2_json, reg, 1);
-            int ok_j3 = write_tvg_json(tvg_json, reg);
-
-            printf("\nJSON exportados:\n");
-            printf("  %s %s\n", (ok_j1==0) ? "OK " : "ERR", p1_json);
-            printf("  %s %s\n", (ok_j2==0) ? "OK " : "ERR", p2_json);
-            printf("  %s %s\n", (ok_j3==0) ? "OK " : "ERR", tvg_json);
-        }
-    }
-    return 0;
-}
\ No newline at end of file
+/*
+ * HermesDecoder - PGA460 config frame decoder (C) + CSV export
+ *
+ * Frame format (your protocol):
+ *   [0..1]  : prefix/mode (e.g., 0x5E02) -> ignored for register mapping
+ *   [2..56] : 55 bytes -> REG1..REG55 in fixed order
+ *
+ * Default: prints "raw decode" (registers + bitfields)
+ * --csv   : generates threshold profile CSVs (P1 and P2)
+ *
+ * CSV columns:
+ *   stage,delta_us,t_us,dist_cm,value_pct,value_raw
+ *
+ * Extra raw decode feature:
+ *   - After Px_THR_10 (REG34 for P1, REG50 for P2) it prints decoded L1..L8
+ *     (5-bit packed values) both raw and percentage.
+ *
+ * Build:
+ *   gcc -O2 -Wall -Wextra hermes_decoder.c -o HermesDecoder
+ *
+ * Run:
+ *   echo "<HEX>" | ./HermesDecoder
+ *   echo "<HEX>" | ./HermesDecoder --csv
+ *   echo "<HEX>" | ./HermesDecoder --csv prefix
+ *   cat frames.log | ./HermesDecoder --stream
+ *   ./HermesDecoder --input frames.log --export-csv run
+ *
+ * Stream mode (--stream / --input):
+ *   one frame per line, any line length; each frame is tagged with its
+ *   sequence number and source byte offset. Bad lines are counted and
+ *   skipped instead of aborting the run.
+ */
+
+ //gcc -O2 -Wall -Wextra -Icore/inc core/src/*.c -o hermesdecoder
+
+#include <stdio.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "plot.h"
+#include "export.h"
+#include "utils.h"
+#include "hexparse.h"
+#include "decoder.h"
+#include "usage.h"
+#include "frame.h"
+#include "stream.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include "dcache.h"
+#include "diff.h"
+#include "batch.h"
+#include "render.h"
+#include "serve.h"
+#include "encoder.h"
+#include "record.h"
+#include "archive.h"
+#include "query.h"
+#include "curve.h"
+#include "curveio.h"
+#include "echo.h"
+#include "tty.h"
+#include "binstream.h"
+#include "stats.h"
+#include "zstream.h"
+#include "aggregate.h"
+#include "regmap.h"
+#include "config.h"
+
+typedef struct {
+    int want_plot_th;
+    int want_plot_tvg;
+    int want_export_csv;
+    int want_export_json;
+    const char *csv_prefix;
+
+    int stream;              // --stream / --input: una trama por linea
+    const char *input_path;  // NULL -> stdin
+    input_format_t input_format; // --input-format hex|bin|binlen
+    int threads;             // --threads N: mmap (--input) o pipeline (stdin)
+    int pipeline_stats;      // --pipeline-stats
+    size_t cache_bytes;      // --cache <MB>: 0 = sin cache (total, se reparte entre hilos)
+    int diff;                // --diff [uart|prefix]: solo cambios por dispositivo
+    diff_key_t diff_key;
+    diff_state_t *diff_state;
+    int batch_export;        // --batch-export: un fichero por tipo de perfil
+    batch_export_t *batch;
+    const char *render_dir;  // --render <dir>: graficas SVG/PNG sin gnuplot
+    int render_fmt;          // RENDER_SVG | RENDER_PNG
+    const char *serve_path;  // --serve: socket Unix
+    int encode;              // --encode: perfiles/campos -> tramas hex
+    const char *encode_path; // NULL o "-" = stdin
+    const char *encode_base; // --encode-base: trama de partida en hex
+    record_format_t format;  // --format text|ndjson|binary
+    const char *archive_path;      // --archive: tramas -> archivo columnar
+    archive_writer_t *archive;
+    const char *archive_cat_path;  // --archive-cat: archivo -> tramas hex
+    const char *archive_info_path; // --archive-info: esquema y tamanos
+    const char *curves_grid;       // --curves: rejilla para evaluar TH/TVG
+    curve_out_t curves;
+    int echo;                      // --echo: volcados de eco contra la curva TH
+    int echo_p2;
+    echo_state_t *echo_state;
+    const char *tty_path;          // --tty: captura cruda del UART
+    int baud;                      // --baud
+    int tty_prefix;                // --tty-prefix, -1 = TTY_DEFAULT_PREFIX
+    int stats;                     // --stats: tiempos por etapa al terminar
+    stats_format_t stats_format;
+    int aggregate;                 // --aggregate: histogramas de la flota, sin salida por trama
+} hermes_opts_t;
+
+/* Trama decodificada + (opcional) su entrada en la cache de decodificacion */
+typedef struct {
+    const hermes_config_t *cfg;
+    dcache_t       *cache;
+    dcache_entry_t *entry;   // NULL sin cache
+} frame_view_t;
+
+/* Construye "<prefix>[_fNNNNNN]_<kind>_profile.<ext>" */
+static void build_path(char *out, size_t cap, const hermes_opts_t *o, const hermes_frame_t *fr,
+                       const char *kind, const char *ext){
+    const char *prefix = (o->csv_prefix && o->csv_prefix[0]) ? o->csv_prefix : NULL;
+
+    if (o->stream){
+        snprintf(out, cap, "%s%sf%06llu_%s_profile.%s",
+                 prefix ? prefix : "", prefix ? "_" : "",
+                 (unsigned long long)fr->seq, kind, ext);
+    } else if (prefix){
+        snprintf(out, cap, "%s_%s_profile.%s", prefix, kind, ext);
+    } else {
+        snprintf(out, cap, "%s_profile.%s", kind, ext);
+    }
+}
+
+static void warn_tvg_reserved(FILE *out, const hermes_config_t *cfg){
+    // Flags TVGAIN6
+    if (cfg->tvg.reserved != 0){
+        fprintf(out, "WARNING: TVGAIN6 RESERVED bit != 0 (%d)\n", cfg->tvg.reserved);
+    }
+}
+
+static void print_frame_header(FILE *out, const hermes_opts_t *o, const hermes_frame_t *fr){
+    int n = fr->nbytes;
+
+    if (o->stream){
+        fprintf(out, "=== Trama #%llu (offset %llu) ===\n",
+               (unsigned long long)fr->seq, (unsigned long long)fr->offset);
+    } else {
+        fprintf(out, "HermesDecoder\n");
+    }
+    fprintf(out, "Prefix/mode: 0x%04X (ignorado para el mapeo de registros)\n", fr->prefix);
+    fprintf(out, "Bytes totales: %d\n", n);
+    if (n != HERMES_FRAME_BYTES){
+        fprintf(out, "AVISO: longitud esperada = 57 bytes (2 + 55). Recibida = %d bytes.\n", n);
+        fprintf(out, "      Se decodificarán los primeros 55 bytes de registros igualmente.\n");
+    }
+    fprintf(out, "\n");
+}
+
+static void print_frame(FILE *out, const hermes_opts_t *o, const hermes_frame_t *fr, const frame_view_t *v){
+    print_frame_header(out, o, fr);
+
+    size_t len;
+    const char *txt = v->entry ? dcache_fragment(v->cache, v->entry, DC_TEXT, &len) : NULL;
+    if (txt){
+        fwrite(txt, 1, len, out);
+    } else {
+        decode_print_all(out, v->cfg);
+    }
+}
+
+static int write_bytes(const char *path, const char *buf, size_t len){
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    int rc = (fwrite(buf, 1, len, f) == len) ? 0 : -1;
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+/* Fichero de export persistente: copia del fragmento en cache o writer normal */
+static int export_file(const char *path, const frame_view_t *v, dcache_frag_t kind){
+    size_t len;
+    const char *txt = v->entry ? dcache_fragment(v->cache, v->entry, kind, &len) : NULL;
+    if (txt) return write_bytes(path, txt, len);
+
+    switch (kind){
+        case DC_P1_CSV:   return write_th_profile_csv(path, v->cfg, 0);
+        case DC_P2_CSV:   return write_th_profile_csv(path, v->cfg, 1);
+        case DC_TVG_CSV:  return write_tvg_csv(path, v->cfg);
+        case DC_P1_JSON:  return write_th_profile_json(path, v->cfg, 0);
+        case DC_P2_JSON:  return write_th_profile_json(path, v->cfg, 1);
+        case DC_TVG_JSON: return write_tvg_json(path, v->cfg);
+        default:          return -1;
+    }
+}
+
+/* Fichero temporal unico para gnuplot ("" si no se pudo crear) */
+static int make_tmp(char *path, size_t cap, const char *kind){
+    snprintf(path, cap, "/tmp/hermes_%s_XXXXXX", kind);
+    int fd = mkstemp(path);
+    if (fd < 0){
+        path[0] = '\0';
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+/* Graficas nativas en o->render_dir. Devuelve el numero de ficheros que fallaron. */
+static int render_frame(FILE *out, const hermes_opts_t *o, const hermes_frame_t *fr, const hermes_config_t *cfg){
+    static const struct { render_fmt_t fmt; const char *ext; } FMTS[] = {
+        { RENDER_SVG, "svg" }, { RENDER_PNG, "png" },
+    };
+    int failed = 0;
+
+    fprintf(out, "\nGráficas generadas:\n");
+    for (size_t i = 0; i < sizeof(FMTS) / sizeof(FMTS[0]); i++){
+        if (!(o->render_fmt & FMTS[i].fmt)) continue;
+
+        char name[256], th_path[512], tvg_path[512];
+        build_path(name, sizeof(name), o, fr, "th", FMTS[i].ext);
+        snprintf(th_path, sizeof(th_path), "%s/%s", o->render_dir, name);
+        build_path(name, sizeof(name), o, fr, "tvg", FMTS[i].ext);
+        snprintf(tvg_path, sizeof(tvg_path), "%s/%s", o->render_dir, name);
+
+        int ok_th = write_th_plot(th_path, cfg, FMTS[i].fmt);
+        int ok_tvg = write_tvg_plot(tvg_path, cfg, FMTS[i].fmt);
+
+        fprintf(out, "  %s %s\n", (ok_th==0) ? "OK " : "ERR", th_path);
+        fprintf(out, "  %s %s\n", (ok_tvg==0) ? "OK " : "ERR", tvg_path);
+        failed += (ok_th != 0) + (ok_tvg != 0);
+    }
+    return failed;
+}
+
+/* Plot + export de una trama. Devuelve el numero de ficheros que fallaron. */
+static int export_frame(FILE *out, const hermes_opts_t *o, const hermes_frame_t *fr, const frame_view_t *v){
+    const hermes_config_t *cfg = v->cfg;
+    int failed = 0;
+
+    if (o->render_dir){
+        uint64_t t = stats_begin();
+        failed += render_frame(out, o, fr, cfg);
+        stats_end(STAGE_RENDER, t);
+    }
+
+    if (!(o->want_export_csv || o->want_export_json || o->want_plot_th || o->want_plot_tvg)){
+        return failed;
+    }
+
+    if (o->batch){
+        if (o->want_export_csv) warn_tvg_reserved(out, cfg);
+        uint64_t t = stats_begin();
+        failed += (batch_export_frame(o->batch, fr, cfg) != 0);
+        stats_end(STAGE_EXPORT_BATCH, t);
+        return failed;
+    }
+
+    // Rutas CSV "export" (solo si want_export_csv)
+    char p1_export[256], p2_export[256], tvg_export[256];
+    char p1_json[256], p2_json[256], tvg_json[256];
+
+    build_path(p1_export, sizeof(p1_export), o, fr, "p1", "csv");
+    build_path(p2_export, sizeof(p2_export), o, fr, "p2", "csv");
+    build_path(tvg_export, sizeof(tvg_export), o, fr, "tvg", "csv");
+
+    build_path(p1_json, sizeof(p1_json), o, fr, "p1", "json");
+    build_path(p2_json, sizeof(p2_json), o, fr, "p2", "json");
+    build_path(tvg_json, sizeof(tvg_json), o, fr, "tvg", "json");
+
+    // Rutas CSV temporales para plot (no exporta); unicas por proceso
+    char p1_tmp[64] = "", p2_tmp[64] = "", tvg_tmp[64] = "";
+
+    int ok_p1_plot = 0, ok_p2_plot = 0, ok_tvg_plot = 0;
+    int ok_p1_exp  = 0, ok_p2_exp  = 0, ok_tvg_exp  = 0;
+
+    // --- Generar CSVs para PLOT (temporales) ---
+    uint64_t t = stats_begin();
+    if (o->want_plot_th){
+        ok_p1_plot = make_tmp(p1_tmp, sizeof(p1_tmp), "p1");
+        if (ok_p1_plot == 0) ok_p1_plot = write_th_profile_csv(p1_tmp, cfg, 0);
+        ok_p2_plot = make_tmp(p2_tmp, sizeof(p2_tmp), "p2");
+        if (ok_p2_plot == 0) ok_p2_plot = write_th_profile_csv(p2_tmp, cfg, 1);
+    }
+    if (o->want_plot_tvg){
+        warn_tvg_reserved(out, cfg);
+        ok_tvg_plot = make_tmp(tvg_tmp, sizeof(tvg_tmp), "tvg");
+        if (ok_tvg_plot == 0) ok_tvg_plot = write_tvg_csv(tvg_tmp, cfg);
+    }
+
+    // --- Plot (usa SIEMPRE los temporales) ---
+    if (o->want_plot_th){
+        if (ok_p1_plot==0 && ok_p2_plot==0){
+            fprintf(out, "\nMostrando gráfica TH (P1 vs P2)...\n");
+            plot_profiles(p1_tmp, p2_tmp);
+        } else {
+            fprintf(out, "\nNo se puede plotear TH: error generando CSV temporal.\n");
+        }
+    }
+
+    if (o->want_plot_tvg){
+        if (ok_tvg_plot==0){
+            fprintf(out, "\nMostrando gráfica TVG...\n");
+            plot_tvg(tvg_tmp);
+        } else {
+            fprintf(out, "\nNo se puede plotear TVG: error generando CSV temporal.\n");
+        }
+    }
+
+    // Borrar temporales al finalizar
+    if (p1_tmp[0])  remove(p1_tmp);
+    if (p2_tmp[0])  remove(p2_tmp);
+    if (tvg_tmp[0]) remove(tvg_tmp);
+    if (o->want_plot_th || o->want_plot_tvg) stats_end(STAGE_PLOT, t);
+
+    // --- Generar CSVs para EXPORT (persistentes) ---
+    if (o->want_export_csv){
+        // Política: exportar siempre todo (TH + TVG)
+        t = stats_begin();
+        ok_p1_exp = export_file(p1_export, v, DC_P1_CSV);
+        ok_p2_exp = export_file(p2_export, v, DC_P2_CSV);
+        warn_tvg_reserved(out, cfg);
+        ok_tvg_exp = export_file(tvg_export, v, DC_TVG_CSV);
+
+        fprintf(out, "\nCSV exportados:\n");
+        fprintf(out, "  %s %s\n", (ok_p1_exp==0) ? "OK " : "ERR", p1_export);
+        fprintf(out, "  %s %s\n", (ok_p2_exp==0) ? "OK " : "ERR", p2_export);
+        fprintf(out, "  %s %s\n", (ok_tvg_exp==0) ? "OK " : "ERR", tvg_export);
+        failed += (ok_p1_exp != 0) + (ok_p2_exp != 0) + (ok_tvg_exp != 0);
+        stats_end(STAGE_EXPORT_CSV, t);
+    }
+
+    if (o->want_export_json){
+        t = stats_begin();
+        int ok_j1 = export_file(p1_json, v, DC_P1_JSON);
+        int ok_j2 = export_file(p2_json, v, DC_P2_JSON);
+        int ok_j3 = export_file(tvg_json, v, DC_TVG_JSON);
+
+        fprintf(out, "\nJSON exportados:\n");
+        fprintf(out, "  %s %s\n", (ok_j1==0) ? "OK " : "ERR", p1_json);
+        fprintf(out, "  %s %s\n", (ok_j2==0) ? "OK " : "ERR", p2_json);
+        fprintf(out, "  %s %s\n", (ok_j3==0) ? "OK " : "ERR", tvg_json);
+        failed += (ok_j1 != 0) + (ok_j2 != 0) + (ok_j3 != 0);
+        stats_end(STAGE_EXPORT_JSON, t);
+    }
+    return failed;
+}
+
+/* Callback de stream_run/parallel_run: decodifica, imprime y exporta una trama */
+static int stream_frame_cb(FILE *out, const hermes_frame_t *fr, void *user){
+    const hermes_opts_t *o = (const hermes_opts_t *)user;
+    hermes_config_t cfg;
+    frame_view_t v = { &cfg, NULL, NULL };
+
+    // Los volcados de --echo no son tramas de registros
+    if (stats_enabled && !(o->echo_state && fr->nbytes >= ECHO_FRAME_BYTES) && regmap_check_reserved(fr->reg)){
+        stats_add(STAT_RESERVED, 1);
+    }
+
+    uint64_t t = stats_begin();
+    if (o->diff_state){
+        print_frame_header(out, o, fr);
+        v.cfg = diff_frame(o->diff_state, out, fr);
+        stats_end(STAGE_OUTPUT, t);
+        if (!v.cfg) return -1;
+
+        int failed = export_frame(out, o, fr, &v);
+        fprintf(out, "\n");
+        return failed ? -1 : 0;
+    }
+
+    if (o->archive){
+        int rc = archive_add(o->archive, fr);
+        stats_end(STAGE_OUTPUT, t);
+        return rc;
+    }
+
+    if (o->echo_state){
+        int rc = echo_frame(o->echo_state, out, fr);
+        stats_end(STAGE_OUTPUT, t);
+        return rc;
+    }
+
+    if (o->cache_bytes){
+        int nthreads = (o->threads > 1) ? o->threads : 1;
+        v.cache = dcache_thread(o->cache_bytes / (size_t)nthreads);
+        v.cfg = v.cache ? dcache_lookup(v.cache, fr->reg, &v.entry) : NULL;
+        if (!v.cfg){
+            v.cfg = &cfg;
+            v.entry = NULL;
+        }
+    }
+    if (!v.entry) decode_config(fr->reg, &cfg);
+    stats_end(STAGE_DECODE, t);
+
+    t = stats_begin();
+    if (o->curves_grid){
+        export_key_t k = { fr->seq, fr->offset, fr->prefix, v.cfg->uart_addr };
+        int rc = curve_write_rows(out, &o->curves, &k, v.cfg);
+        stats_end(STAGE_OUTPUT, t);
+        return rc;
+    }
+
+    if (o->format != RECORD_TEXT){
+        export_key_t k = { fr->seq, fr->offset, fr->prefix, v.cfg->uart_addr };
+        int rc = record_write(out, o->format, &k, v.cfg);
+        stats_end(STAGE_OUTPUT, t);
+        return rc;
+    }
+
+    print_frame(out, o, fr, &v);
+    stats_end(STAGE_OUTPUT, t);
+    int failed = export_frame(out, o, fr, &v);
+    fprintf(out, "\n");
+    return failed ? -1 : 0;
+}
+
+/* Callback de --aggregate: solo acumula en el histograma del hilo */
+static int aggregate_frame_cb(FILE *out, const hermes_frame_t *fr, void *user){
+    (void)out;
+    (void)user;
+    hermes_agg_t *a = aggregate_thread();
+    if (!a) return -1;
+    uint64_t t = stats_begin();
+    aggregate_frame(a, fr);
+    stats_end(STAGE_DECODE, t);
+    return 0;
+}
+
+/* Solo un fichero regular se puede mapear: un FIFO o <(...) da st_size == 0 */
+static int is_regular(FILE *f){
+    struct stat sb;
+    return fstat(fileno(f), &sb) == 0 && S_ISREG(sb.st_mode);
+}
+
+static int run_stream(hermes_opts_t *o){
+    if (o->stats) stats_start(1);
+
+    /* Cualquier fallo salta a out, que libera lo que este creado */
+    stream_stats_t st;
+    memset(&st, 0, sizeof(st));
+    zstream_t *zs = NULL;
+    int ran = 0;             // se llego a leer: hay resumenes que escribir
+    int rc = -1;
+
+    FILE *in = stdin;
+    if (!o->tty_path && o->input_format == INPUT_HEX && o->input_path && strcmp(o->input_path, "-") != 0){
+        in = fopen(o->input_path, "r");
+        if (!in){
+            fprintf(stderr, "No se pudo abrir %s.\n", o->input_path);
+            in = stdin;
+            goto out;
+        }
+    }
+
+    if (o->diff){
+        o->diff_state = diff_new(o->diff_key);
+        if (!o->diff_state){
+            fprintf(stderr, "Sin memoria para --diff.\n");
+            goto out;
+        }
+    }
+
+    if (o->batch_export){
+        o->batch = batch_export_open(o->csv_prefix, o->want_export_csv, o->want_export_json, o->threads > 1);
+        if (!o->batch) goto out;
+    }
+
+    if (o->echo){
+        o->echo_state = echo_new(o->echo_p2, o->curves.interp, o->format);
+        if (!o->echo_state){
+            fprintf(stderr, "Sin memoria para --echo.\n");
+            goto out;
+        }
+    }
+
+    if (o->archive_path){
+        o->archive = archive_create(o->archive_path);
+        if (!o->archive) goto out;
+    }
+
+    if (o->curves_grid){
+        if (curve_write_header(stdout, &o->curves) != 0) goto out;
+    } else if (o->format == RECORD_TEXT && !o->archive && !o->echo && !o->aggregate){
+        printf("HermesDecoder (stream)\n\n");
+    }
+
+    /* .gz/.zst: se descomprime en otro hilo y se lee como texto */
+    FILE *src = in;
+    if (!o->tty_path && o->input_format == INPUT_HEX){
+        zstream_codec_t codec = zstream_detect(in);
+        if (codec != ZSTREAM_NONE){
+            zs = zstream_open(in, codec, o->threads, in == stdin ? "stdin" : o->input_path);
+            if (!zs) goto out;
+            src = zstream_file(zs);
+        }
+    }
+
+    frame_cb cb = o->aggregate ? aggregate_frame_cb : stream_frame_cb;
+    if (o->tty_path){
+        tty_stats_t ts;
+        uint16_t prefix = (uint16_t)(o->tty_prefix >= 0 ? o->tty_prefix : TTY_DEFAULT_PREFIX);
+        rc = tty_run(o->tty_path, o->baud, prefix, cb, (void *)o, &st, &ts);
+        if (rc == 0 || ts.bytes) fprintf(stderr, "TTY: %llu bytes, %llu tramas, %llu bytes descartados (%llu resincronizaciones), "
+                        "%llu truncadas, %llu corruptas [%s].\n",
+                (unsigned long long)ts.bytes, (unsigned long long)st.frames,
+                (unsigned long long)ts.skipped, (unsigned long long)ts.resyncs,
+                (unsigned long long)ts.truncated, (unsigned long long)ts.corrupt, tty_scan_impl());
+    } else if (o->input_format != INPUT_HEX){
+        rc = bin_run(o->input_path, o->input_format, o->threads, cb, (void *)o, &st);
+    } else if (o->threads > 1 && in != stdin && !zs && is_regular(in)){
+        fclose(in);
+        in = stdin;
+        rc = parallel_run(o->input_path, o->threads, cb, (void *)o, &st);
+    } else if (o->threads > 1){
+        pipeline_stats_t ps;
+        rc = pipeline_run(src, o->threads, cb, (void *)o, &st, &ps);
+        if (o->pipeline_stats) pipeline_print_stats(stderr, &ps);
+    } else {
+        rc = stream_run(src, cb, (void *)o, &st);
+    }
+    ran = 1;
+
+out:
+    if (zs){
+        zstream_stats_t zst;
+        if (zstream_close(zs, &zst) != 0) rc = -1;
+        fprintf(stderr, "Descompresión: %s, %.1f MB -> %.1f MB (x%.1f)",
+                zstream_codec_name(zst.codec), (double)zst.in_bytes / 1e6, (double)zst.out_bytes / 1e6,
+                zst.in_bytes ? (double)zst.out_bytes / (double)zst.in_bytes : 0.0);
+        if (zst.frames) fprintf(stderr, ", %llu tramas zstd en %d hilos", (unsigned long long)zst.frames, zst.workers);
+        fprintf(stderr, ".\n");
+    }
+    if (in != stdin) fclose(in);
+
+    if (ran && o->cache_bytes){
+        dcache_stats_t cs;
+        dcache_thread_stats(&cs);
+        uint64_t lookups = cs.hits + cs.misses;
+        fprintf(stderr, "Cache: %llu aciertos / %llu fallos (%.1f%%), %llu expulsiones, "
+                        "%llu fragmentos reutilizados / %llu renderizados, %zu entradas, %.1f MB\n",
+                (unsigned long long)cs.hits, (unsigned long long)cs.misses,
+                lookups ? 100.0 * (double)cs.hits / (double)lookups : 0.0,
+                (unsigned long long)cs.evictions,
+                (unsigned long long)cs.frag_hits, (unsigned long long)cs.frag_renders,
+                cs.entries, (double)cs.bytes / (1024.0 * 1024.0));
+    }
+    dcache_thread_free_all();
+    diff_free(o->diff_state);
+
+    if (o->echo_state){
+        if (ran){
+            echo_stats_t es;
+            echo_get_stats(o->echo_state, &es);
+            fprintf(stderr, "Echo: %llu volcados (%llu con cruce), %llu sin configuración, %llu configuraciones [%s].\n",
+                    (unsigned long long)es.dumps, (unsigned long long)es.detected,
+                    (unsigned long long)es.unpaired, (unsigned long long)es.configs, echo_impl());
+        }
+        echo_free(o->echo_state);
+    }
+
+    if (o->archive){
+        archive_stats_t as;
+        if (archive_finish(o->archive, &as) != 0){
+            fprintf(stderr, "Error escribiendo %s.\n", o->archive_path);
+            rc = -1;
+        }
+        if (ran){
+            fprintf(stderr, "Archive: %llu tramas, %llu bloques, %llu bytes (%.2f bytes/trama",
+                    (unsigned long long)as.rows, (unsigned long long)as.groups, (unsigned long long)as.bytes,
+                    as.rows ? (double)as.bytes / (double)as.rows : 0.0);
+            struct stat sb;
+            if (o->input_path && stat(o->input_path, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0){
+                fprintf(stderr, ", %.1f%% de la entrada", 100.0 * (double)as.bytes / (double)sb.st_size);
+            }
+            fprintf(stderr, ")\n");
+        }
+    }
+
+    if (ran && o->aggregate){
+        hermes_agg_t *total = aggregate_new();
+        if (total){
+            aggregate_thread_merge(total);
+            if (aggregate_report(stdout, total, o->format) != 0) rc = -1;
+            aggregate_free(total);
+        } else {
+            fprintf(stderr, "Sin memoria para --aggregate.\n");
+            rc = -1;
+        }
+    }
+    if (o->aggregate) aggregate_thread_free_all();
+
+    if (o->batch && batch_export_close(o->batch, ran ? stdout : NULL) != 0){
+        fprintf(stderr, "Error escribiendo el export por lotes.\n");
+        rc = -1;
+    }
+
+    if (!ran){
+        // fallo antes de leer: el motivo ya esta en stderr
+    } else if (o->input_format != INPUT_HEX){
+        fprintf(stderr, "Stream: %llu registros, %llu tramas, %llu errores.\n",
+                (unsigned long long)st.lines, (unsigned long long)st.frames, (unsigned long long)st.errors);
+    } else if (!o->tty_path){
+        fprintf(stderr, "Stream: %llu líneas, %llu tramas, %llu errores, %llu vacías.\n",
+                (unsigned long long)st.lines, (unsigned long long)st.frames,
+                (unsigned long long)st.errors, (unsigned long long)st.blank);
+    }
+
+    if (o->stats){
+        if (ran) stats_report(stderr, o->stats_format, &st);
+        stats_free();
+    }
+
+    if (rc != 0) return 1;
+    return (st.errors > 0) ? 2 : 0;
+}
+
+static int run_encode(const hermes_opts_t *o){
+    /* Base por defecto: prefijo 0x5E02 y registros a cero */
+    uint8_t base[HERMES_FRAME_BYTES] = { 0x5E, 0x02 };
+
+    if (o->encode_base){
+        uint8_t buf[HERMES_FRAME_BYTES + 1];
+        int n = parse_hex_bytes_fast(o->encode_base, buf, (int)sizeof(buf));
+        if (n == HERMES_FRAME_BYTES){
+            memcpy(base, buf, HERMES_FRAME_BYTES);
+        } else if (n == HERMES_NUM_REGS){
+            memcpy(base + HERMES_PREFIX_BYTES, buf, HERMES_NUM_REGS);
+        } else {
+            fprintf(stderr, "--encode-base espera 57 bytes (trama) o 55 (REG1..REG55) en hex.\n");
+            return 1;
+        }
+    }
+
+    FILE *in = stdin;
+    if (o->encode_path && strcmp(o->encode_path, "-") != 0){
+        in = fopen(o->encode_path, "r");
+        if (!in){
+            fprintf(stderr, "No se pudo abrir %s.\n", o->encode_path);
+            return 1;
+        }
+    }
+
+    encode_stats_t st;
+    int rc = encode_run(in, stdout, base, &st);
+    if (in != stdin) fclose(in);
+    if (fflush(stdout) != 0) rc = -1;
+
+    fprintf(stderr, "Encode: %llu registros, %llu tramas, %llu errores.\n",
+            (unsigned long long)st.records, (unsigned long long)st.frames,
+            (unsigned long long)st.errors);
+
+    if (rc != 0) return 1;
+    return (st.errors > 0) ? 2 : 0;
+}
+
+static int run_archive_read(const hermes_opts_t *o){
+    const char *path = o->archive_cat_path ? o->archive_cat_path : o->archive_info_path;
+    archive_t *a = archive_open(path);
+    if (!a) return 1;
+
+    int rc = 0;
+    if (o->archive_info_path) archive_print_info(stdout, a);
+    if (o->archive_cat_path) rc = archive_write_hex(stdout, a);
+    archive_close(a);
+    return rc == 0 ? 0 : 1;
+}
+
+/* hermesdecoder query <fichero> ["<expresion>"] [--index f] [--reindex] [--count | --ids] */
+static int run_query(int argc, char **argv, const char *prog){
+    query_opts_t qo = {0};
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--index") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "--index requiere un fichero.\n\n");
+                usage(prog);
+                return 1;
+            }
+            qo.index_path = argv[++i];
+        } else if (strcmp(argv[i], "--reindex") == 0){
+            qo.reindex = 1;
+        } else if (strcmp(argv[i], "--count") == 0){
+            qo.out = QUERY_OUT_COUNT;
+        } else if (strcmp(argv[i], "--ids") == 0){
+            qo.out = QUERY_OUT_IDS;
+        } else if (strncmp(argv[i], "--", 2) == 0){
+            fprintf(stderr, "Argumento no reconocido en query: %s\n\n", argv[i]);
+            usage(prog);
+            return 1;
+        } else if (!path){
+            path = argv[i];
+        } else if (!qo.expr){
+            qo.expr = argv[i];
+        } else {
+            fprintf(stderr, "query admite un fichero y una expresion (entre comillas).\n\n");
+            usage(prog);
+            return 1;
+        }
+    }
+    if (!path){
+        fprintf(stderr, "query requiere un fichero (log hex o archivo).\n\n");
+        usage(prog);
+        return 1;
+    }
+
+    query_stats_t st;
+    int rc = query_run(path, &qo, stdout, &st);
+    if (rc == 0){
+        fprintf(stderr, "Query: %llu tramas", (unsigned long long)st.frames);
+        if (qo.expr) fprintf(stderr, ", %llu coinciden", (unsigned long long)st.matches);
+        if (st.groups){
+            fprintf(stderr, ", %llu/%llu bloques leidos", (unsigned long long)st.groups_read,
+                    (unsigned long long)st.groups);
+        } else {
+            fprintf(stderr, ", %llu configuraciones (%llu trama a trama), %llu líneas nuevas indexadas",
+                    (unsigned long long)st.configs, (unsigned long long)st.configs_maybe,
+                    (unsigned long long)st.new_lines);
+        }
+        fprintf(stderr, ".\n");
+    }
+    return rc == 0 ? 0 : 1;
+}
+
+static int run_single(const hermes_opts_t *o){
+    line_reader_t lr;
+    line_reader_init(&lr, stdin);
+    if (o->stats) stats_start(1);
+
+    uint64_t t = stats_begin();
+    ssize_t len = line_reader_next(&lr);
+    stats_end(STAGE_READ, t);
+    if (len < 0){
+        fprintf(stderr, "No se recibió entrada por stdin.\n");
+        line_reader_free(&lr);
+        return 1;
+    }
+
+    size_t cap = strlen(lr.line) / 2 + 1;
+    uint8_t *buf = malloc(cap);
+    if (!buf){
+        line_reader_free(&lr);
+        return 1;
+    }
+
+    stats_count(STAT_BYTES, (uint64_t)len);
+    t = stats_begin();
+    int n = parse_hex_bytes_fast(lr.line, buf, (int)cap);
+    stats_end(STAGE_PARSE, t);
+    line_reader_free(&lr);
+    if (n < 0){
+        fprintf(stderr, "Error parseando hex.\n");
+        free(buf);
+        return 1;
+    }
+
+    hermes_frame_t fr = {0};
+    if (frame_from_bytes(&fr, buf, n) != 0){
+        fprintf(stderr, "Trama demasiado corta: %d bytes. Se esperan al menos 57 (2 + 55).\n", n);
+        free(buf);
+        return 1;
+    }
+    fr.seq = 1;
+
+    hermes_config_t cfg;
+    frame_view_t v = { &cfg, NULL, NULL };
+    t = stats_begin();
+    decode_config(fr.reg, &cfg);
+    stats_end(STAGE_DECODE, t);
+    if (o->stats && regmap_check_reserved(fr.reg)) stats_add(STAT_RESERVED, 1);
+
+    int rc = 0;
+    t = stats_begin();
+    if (o->format != RECORD_TEXT){
+        export_key_t k = { fr.seq, fr.offset, fr.prefix, cfg.uart_addr };
+        rc = record_write(stdout, o->format, &k, &cfg);
+        stats_end(STAGE_OUTPUT, t);
+    } else {
+        print_frame(stdout, o, &fr, &v);
+        stats_end(STAGE_OUTPUT, t);
+        export_frame(stdout, o, &fr, &v);
+    }
+
+    if (o->stats){
+        stream_stats_t st = { 1, 1, rc ? 1 : 0, 0 };
+        fflush(stdout);
+        stats_report(stderr, o->stats_format, &st);
+        stats_free();
+    }
+    free(buf);
+    return rc ? 1 : 0;
+}
+
+#define CACHE_MAX_MB 65536u   // --cache: tope (64 GB)
+
+/* "<MB>" entero y completo ("64MB", "abc" o "-1" no valen) -> bytes. 0 o -1 */
+static int parse_cache_mb(const char *s, size_t *bytes){
+    if (!isdigit((unsigned char)*s)) return -1;     // strtoul aceptaria "-1" y espacios
+    char *end;
+    errno = 0;
+    unsigned long mb = strtoul(s, &end, 10);
+    if (errno != 0 || *end != '\0' || mb > CACHE_MAX_MB || mb > (SIZE_MAX >> 20)) return -1;
+    *bytes = (size_t)mb << 20;
+    return 0;
+}
+
+#define THREADS_MAX 1024   // --threads: tope
+
+/* "<N>" entero y completo de 1 a THREADS_MAX. 0 o -1 */
+static int parse_threads(const char *s, int *threads){
+    if (!isdigit((unsigned char)*s)) return -1;     // strtol aceptaria signo y espacios
+    char *end;
+    errno = 0;
+    long n = strtol(s, &end, 10);
+    if (errno != 0 || *end != '\0' || n < 1 || n > THREADS_MAX) return -1;
+    *threads = (int)n;
+    return 0;
+}
+
+/* "<baudios>" entero, completo y soportado por tty (tty_baud_ok). 0 o -1 */
+static int parse_baud(const char *s, int *baud){
+    if (!isdigit((unsigned char)*s)) return -1;
+    char *end;
+    errno = 0;
+    unsigned long b = strtoul(s, &end, 10);
+    if (errno != 0 || *end != '\0' || b > INT_MAX || tty_baud_ok((int)b) != 0) return -1;
+    *baud = (int)b;
+    return 0;
+}
+
+int main(int argc, char **argv){
+    hermes_opts_t o = {0};
+    o.baud = TTY_DEFAULT_BAUD;
+    o.tty_prefix = -1;
+
+    if (argc > 1 && strcmp(argv[1], "query") == 0) return run_query(argc - 1, argv + 1, argv[0]);
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--export-csv") == 0){
+            o.want_export_csv = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                o.csv_prefix = argv[++i];
+            }
+
+        } else if (strcmp(argv[i], "--export-json") == 0){
+            o.want_export_json = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                o.csv_prefix = argv[++i];
+            }
+
+        } else if (strcmp(argv[i], "--plot") == 0){
+            o.want_plot_th = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                o.csv_prefix = argv[++i];
+            }
+
+        } else if (strcmp(argv[i], "--plot-tvg") == 0){
+            o.want_plot_tvg = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                o.csv_prefix = argv[++i];
+            }
+
+        } else if (strcmp(argv[i], "--stream") == 0){
+            o.stream = 1;
+
+        } else if (strcmp(argv[i], "--input") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "--input requiere un fichero.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.input_path = argv[++i];
+            o.stream = 1;
+
+        } else if (strcmp(argv[i], "--input-format") == 0){
+            int f = (i + 1 < argc) ? input_format_parse(argv[++i]) : -1;
+            if (f < 0){
+                fprintf(stderr, "--input-format admite hex, bin o binlen.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.input_format = (input_format_t)f;
+
+        } else if (strcmp(argv[i], "--threads") == 0){
+            if (i + 1 >= argc || parse_threads(argv[i + 1], &o.threads) != 0){
+                fprintf(stderr, "--threads requiere un número entero de 1 a %d.\n\n", THREADS_MAX);
+                usage(argv[0]);
+                return 1;
+            }
+            i++;
+
+        } else if (strcmp(argv[i], "--cache") == 0){
+            if (i + 1 >= argc || parse_cache_mb(argv[i + 1], &o.cache_bytes) != 0){
+                fprintf(stderr, "--cache requiere un tamaño en MB (entero de 0 a %u).\n\n", CACHE_MAX_MB);
+                usage(argv[0]);
+                return 1;
+            }
+            i++;
+
+        } else if (strcmp(argv[i], "--diff") == 0){
+            o.diff = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                const char *key = argv[++i];
+                if (strcmp(key, "uart") == 0){
+                    o.diff_key = DIFF_KEY_UART;
+                } else if (strcmp(key, "prefix") == 0){
+                    o.diff_key = DIFF_KEY_PREFIX;
+                } else {
+                    fprintf(stderr, "--diff admite 'uart' o 'prefix' (recibido: %s).\n\n", key);
+                    usage(argv[0]);
+                    return 1;
+                }
+            }
+
+        } else if (strcmp(argv[i], "--render") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "--render requiere un directorio.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.render_dir = argv[++i];
+
+        } else if (strcmp(argv[i], "--render-format") == 0){
+            const char *fmt = (i + 1 < argc) ? argv[++i] : "";
+            if (strcmp(fmt, "svg") == 0){
+                o.render_fmt = RENDER_SVG;
+            } else if (strcmp(fmt, "png") == 0){
+                o.render_fmt = RENDER_PNG;
+            } else if (strcmp(fmt, "both") == 0){
+                o.render_fmt = RENDER_SVG | RENDER_PNG;
+            } else {
+                fprintf(stderr, "--render-format admite svg, png o both.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+
+        } else if (strcmp(argv[i], "--batch-export") == 0){
+            o.batch_export = 1;
+
+        } else if (strcmp(argv[i], "--serve") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "--serve requiere la ruta del socket.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.serve_path = argv[++i];
+
+        } else if (strcmp(argv[i], "--encode") == 0){
+            o.encode = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                o.encode_path = argv[++i];
+            }
+
+        } else if (strcmp(argv[i], "--encode-base") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "--encode-base requiere una trama en hex.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.encode_base = argv[++i];
+
+        } else if (strcmp(argv[i], "--format") == 0){
+            int fmt = (i + 1 < argc) ? record_format_parse(argv[++i]) : -1;
+            if (fmt < 0){
+                fprintf(stderr, "--format admite text, ndjson o binary.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.format = (record_format_t)fmt;
+
+        } else if (strcmp(argv[i], "--archive") == 0 || strcmp(argv[i], "--archive-cat") == 0 ||
+                   strcmp(argv[i], "--archive-info") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "%s requiere un fichero de archivo.\n\n", argv[i]);
+                usage(argv[0]);
+                return 1;
+            }
+            if (strcmp(argv[i], "--archive") == 0){
+                o.archive_path = argv[++i];
+                o.stream = 1;
+            } else if (strcmp(argv[i], "--archive-cat") == 0){
+                o.archive_cat_path = argv[++i];
+            } else {
+                o.archive_info_path = argv[++i];
+            }
+
+        } else if (strcmp(argv[i], "--curves") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "--curves requiere una rejilla (desde:paso:hasta[cm|us] o fichero).\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.curves_grid = argv[++i];
+            o.stream = 1;
+
+        } else if (strcmp(argv[i], "--curves-profiles") == 0){
+            char list[64];
+            snprintf(list, sizeof(list), "%s", (i + 1 < argc) ? argv[++i] : "");
+            o.curves.kinds = 0;
+            for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")){
+                int k = curve_kind_parse(tok);
+                if (k < 0){
+                    o.curves.kinds = 0;
+                    break;
+                }
+                o.curves.kinds |= 1u << k;
+            }
+            if (!o.curves.kinds){
+                fprintf(stderr, "--curves-profiles admite una lista de p1, p2 y tvg separada por comas.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+
+        } else if (strcmp(argv[i], "--curves-interp") == 0){
+            int interp = (i + 1 < argc) ? curve_interp_parse(argv[++i]) : -1;
+            if (interp < 0){
+                fprintf(stderr, "--curves-interp admite step o linear.\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.curves.interp = (curve_interp_t)interp;
+
+        } else if (strcmp(argv[i], "--echo") == 0){
+            o.echo = 1;
+            o.stream = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                const char *preset = argv[++i];
+                if (strcmp(preset, "p1") == 0 || strcmp(preset, "p2") == 0){
+                    o.echo_p2 = (preset[1] == '2');
+                } else {
+                    fprintf(stderr, "--echo admite 'p1' o 'p2' (recibido: %s).\n\n", preset);
+                    usage(argv[0]);
+                    return 1;
+                }
+            }
+
+        } else if (strcmp(argv[i], "--tty") == 0){
+            if (i + 1 >= argc){
+                fprintf(stderr, "--tty requiere un dispositivo (p.ej. /dev/ttyUSB0).\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            o.tty_path = argv[++i];
+            o.stream = 1;
+
+        } else if (strcmp(argv[i], "--baud") == 0){
+            if (i + 1 >= argc || parse_baud(argv[i + 1], &o.baud) != 0){
+                fprintf(stderr, "--baud requiere una velocidad estándar (9600, 115200, ...).\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            i++;
+
+        } else if (strcmp(argv[i], "--tty-prefix") == 0){
+            uint8_t pb[3];
+            if (i + 1 >= argc || parse_hex_bytes_fast(argv[i + 1], pb, (int)sizeof(pb)) != 2){
+                fprintf(stderr, "--tty-prefix requiere 2 bytes en hex (p.ej. 5E02).\n\n");
+                usage(argv[0]);
+                return 1;
+            }
+            i++;
+            o.tty_prefix = (pb[0] << 8) | pb[1];
+
+        } else if (strcmp(argv[i], "--stats") == 0){
+            o.stats = 1;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0){
+                const char *f = argv[++i];
+                if (strcmp(f, "text") == 0 || strcmp(f, "json") == 0){
+                    o.stats_format = (f[0] == 'j') ? STATS_JSON : STATS_TEXT;
+                } else {
+                    fprintf(stderr, "--stats admite 'text' o 'json' (recibido: %s).\n\n", f);
+                    usage(argv[0]);
+                    return 1;
+                }
+            }
+
+        } else if (strcmp(argv[i], "--aggregate") == 0){
+            o.aggregate = 1;
+            o.stream = 1;
+
+        } else if (strcmp(argv[i], "--pipeline-stats") == 0){
+            o.pipeline_stats = 1;
+
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0){
+            usage(argv[0]);
+            return 0;
+
+        } else {
+            fprintf(stderr, "Argumento no reconocido: %s\n\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (o.stats && (o.encode || o.serve_path || o.archive_cat_path || o.archive_info_path)){
+        fprintf(stderr, "--stats mide la decodificación: no se combina con --encode, --serve ni --archive-cat/--archive-info.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.encode_base && !o.encode){
+        fprintf(stderr, "--encode-base solo tiene sentido con --encode.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.encode){
+        if (o.serve_path || o.stream || o.input_path || o.threads > 1 || o.diff || o.batch_export ||
+            o.cache_bytes || o.render_dir || o.want_plot_th || o.want_plot_tvg ||
+            o.want_export_csv || o.want_export_json || o.format != RECORD_TEXT ||
+            o.archive_cat_path || o.archive_info_path){
+            fprintf(stderr, "--encode no se combina con las opciones de decodificación.\n\n");
+            usage(argv[0]);
+            return 1;
+        }
+        return run_encode(&o);
+    }
+
+    if (o.archive_cat_path || o.archive_info_path){
+        if (o.serve_path || o.stream || o.threads > 1 || o.diff || o.batch_export || o.cache_bytes ||
+            o.render_dir || o.want_plot_th || o.want_plot_tvg || o.want_export_csv || o.want_export_json ||
+            o.format != RECORD_TEXT || (o.archive_cat_path && o.archive_info_path &&
+                                        strcmp(o.archive_cat_path, o.archive_info_path) != 0)){
+            fprintf(stderr, "--archive-cat/--archive-info no se combinan con otras opciones.\n\n");
+            usage(argv[0]);
+            return 1;
+        }
+        return run_archive_read(&o);
+    }
+
+    if (o.serve_path){
+        if (o.stream || o.input_path || o.diff || o.batch_export || o.cache_bytes || o.render_dir ||
+            o.want_plot_th || o.want_plot_tvg || o.want_export_csv || o.want_export_json ||
+            o.format != RECORD_TEXT){
+            fprintf(stderr, "--serve solo admite --threads.\n\n");
+            usage(argv[0]);
+            return 1;
+        }
+        return serve_run(o.serve_path, o.threads) == 0 ? 0 : 1;
+    }
+
+    if (o.threads > 1 || o.diff || o.batch_export) o.stream = 1;
+
+    if ((o.baud != TTY_DEFAULT_BAUD || o.tty_prefix >= 0) && !o.tty_path){
+        fprintf(stderr, "--baud y --tty-prefix solo tienen sentido con --tty.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.input_format != INPUT_HEX && (!o.input_path || strcmp(o.input_path, "-") == 0 || o.pipeline_stats)){
+        fprintf(stderr, "--input-format bin/binlen mapea el fichero: requiere --input <fichero>.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+    if (o.input_format != INPUT_HEX){
+        struct stat sb;
+        if (stat(o.input_path, &sb) == 0 && !S_ISREG(sb.st_mode)){
+            fprintf(stderr, "--input-format bin/binlen requiere un fichero regular: %s no lo es.\n", o.input_path);
+            return 1;
+        }
+    }
+
+    if (o.tty_path && (o.input_path || o.threads > 1 || o.echo)){
+        fprintf(stderr, "--tty lee el UART en un solo hilo: no se combina con --input, --threads ni --echo.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.format != RECORD_TEXT && (o.diff || o.batch_export || o.render_dir || o.want_plot_th ||
+                                    o.want_plot_tvg || o.want_export_csv || o.want_export_json)){
+        fprintf(stderr, "--format ndjson/binary solo admite --stream, --input, --threads y --cache.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.archive_path && (o.diff || o.batch_export || o.cache_bytes || o.render_dir || o.want_plot_th ||
+                           o.want_plot_tvg || o.want_export_csv || o.want_export_json ||
+                           o.format != RECORD_TEXT)){
+        fprintf(stderr, "--archive solo admite --input y --threads.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if ((o.curves.kinds && !o.curves_grid) || (o.curves.interp != CURVE_STEP && !o.curves_grid && !o.echo)){
+        fprintf(stderr, "--curves-profiles solo tiene sentido con --curves y --curves-interp con --curves o --echo.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.aggregate && (o.curves_grid || o.archive_path || o.echo || o.cache_bytes || o.diff || o.batch_export ||
+                        o.render_dir || o.want_plot_th || o.want_plot_tvg || o.want_export_csv ||
+                        o.want_export_json || o.format == RECORD_BINARY)){
+        fprintf(stderr, "--aggregate no escribe nada por trama: solo admite --input, --input-format, --threads, "
+                        "--tty, --stats y --format ndjson.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.echo && (o.curves_grid || o.archive_path || o.threads > 1 || o.cache_bytes || o.diff ||
+                   o.batch_export || o.render_dir || o.want_plot_th || o.want_plot_tvg ||
+                   o.want_export_csv || o.want_export_json || o.format == RECORD_BINARY)){
+        fprintf(stderr, "--echo empareja cada volcado con la configuración anterior: solo admite --input, "
+                        "--curves-interp y --format ndjson.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.curves_grid){
+        if (o.archive_path || o.diff || o.batch_export || o.render_dir || o.want_plot_th || o.want_plot_tvg ||
+            o.want_export_csv || o.want_export_json || o.format == RECORD_NDJSON){
+            fprintf(stderr, "--curves solo admite --input, --threads, --cache y --format binary.\n\n");
+            usage(argv[0]);
+            return 1;
+        }
+        float *grid;
+        char err[256];
+        if (curve_grid_parse(o.curves_grid, &grid, &o.curves.ngrid, err, sizeof(err)) != 0){
+            fprintf(stderr, "--curves: %s.\n", err);
+            return 1;
+        }
+        o.curves.grid   = grid;
+        o.curves.binary = (o.format == RECORD_BINARY);
+        if (!o.curves.kinds) o.curves.kinds = (1u << CURVE_NUM_KINDS) - 1;
+
+        int rc = run_stream(&o);
+        curve_rows_free_all();
+        free(grid);
+        return rc;
+    }
+
+    if (o.batch_export && !(o.want_export_csv || o.want_export_json)){
+        fprintf(stderr, "--batch-export requiere --export-csv y/o --export-json.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.diff && (o.threads > 1 || o.cache_bytes)){
+        fprintf(stderr, "--diff compara cada trama con la anterior: no se puede usar con --threads ni --cache.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.stream && (o.want_plot_th || o.want_plot_tvg)){
+        fprintf(stderr, "--plot/--plot-tvg no se pueden usar en modo stream.\n\n");
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (o.render_dir){
+        if (!o.render_fmt) o.render_fmt = RENDER_SVG;
+        if (mkdir(o.render_dir, 0777) != 0 && errno != EEXIST){
+            fprintf(stderr, "No se pudo crear el directorio %s.\n", o.render_dir);
+            return 1;
+        }
+    }
+
+    return o.stream ? run_stream(&o) : run_single(&o);
+}
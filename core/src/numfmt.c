@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "numfmt.h"
+#include "config.h"
+#include "utils.h"
+
+/* Cadena preformateada de longitud fija: se copia entera y se devuelve len */
+typedef struct {
+    char    s[15];
+    uint8_t len;
+} numstr_t;
+
+#define NF_DIST_MAX_STEPS  (HERMES_TH_STAGES * 8000 / 100)   // 12 x max(TIME_US), en pasos de 100us
+
+static numstr_t nf_pct5[32];
+static numstr_t nf_pct8[256];
+static numstr_t nf_gain[HERMES_TVG_GAIN_MAX + 1];
+static numstr_t nf_dist[NF_DIST_MAX_STEPS + 1];
+static int      nf_step_us;    // mcd de TIME_US (100)
+static int      nf_max_us;     // t_us cubiertos: 0..nf_max_us
+
+static pthread_once_t nf_once = PTHREAD_ONCE_INIT;
+
+static void nf_set(numstr_t *e, const char *fmt, double v){
+    char tmp[NUMFMT_MAX];
+    int n = snprintf(tmp, sizeof(tmp), fmt, v);
+    if (n <= 0 || (size_t)n > sizeof(e->s)) n = 0;   // no pasa con estos dominios
+    memcpy(e->s, tmp, (size_t)n);
+    e->len = (uint8_t)n;
+}
+
+static int gcd(int a, int b){
+    while (b){
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Las mismas expresiones que decoder.c, para que el double sea el mismo */
+static void nf_build(void){
+    for (int r = 0; r < 32; r++)  nf_set(&nf_pct5[r], "%.2f", value_to_pct(1, r));
+    for (int r = 0; r < 256; r++) nf_set(&nf_pct8[r], "%.2f", value_to_pct(9, r));
+    for (int g = 0; g <= HERMES_TVG_GAIN_MAX; g++){
+        nf_set(&nf_gain[g], "%.2f", (g / (double)HERMES_TVG_GAIN_MAX) * 100.0);
+    }
+
+    int step = 0, max = 0;
+    for (int n = 0; n < 16; n++){
+        int us = nibble_to_us((uint8_t)n);
+        step = gcd(step, us);
+        if (us > max) max = us;
+    }
+    max *= HERMES_TH_STAGES;
+    if (step <= 0 || max / step > NF_DIST_MAX_STEPS) max = NF_DIST_MAX_STEPS * step;
+
+    for (int i = 0; i * step <= max; i++) nf_set(&nf_dist[i], "%.4f", tof_us_to_cm(i * step));
+    nf_step_us = step;
+    nf_max_us = max;
+}
+
+static inline size_t nf_copy(char *out, const numstr_t *e){
+    memcpy(out, e->s, sizeof(e->s));
+    return e->len;
+}
+
+static size_t nf_slow(char *out, const char *fmt, double v){
+    char tmp[64];
+    int n = snprintf(tmp, sizeof(tmp), fmt, v);
+    if (n < 0) n = 0;
+    if (n > NUMFMT_MAX) n = NUMFMT_MAX;   // solo con valores absurdos
+    memcpy(out, tmp, (size_t)n);
+    return (size_t)n;
+}
+
+/* ------------------ enteros ------------------ */
+size_t numfmt_u64(char *out, uint64_t v){
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[sizeof(tmp) - 1 - n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    memcpy(out, tmp + sizeof(tmp) - n, (size_t)n);
+    return (size_t)n;
+}
+
+size_t numfmt_i64(char *out, int64_t v){
+    if (v >= 0) return numfmt_u64(out, (uint64_t)v);
+    out[0] = '-';
+    return 1 + numfmt_u64(out + 1, (uint64_t)0 - (uint64_t)v);
+}
+
+/* ------------------ tablas ------------------ */
+size_t numfmt_dist_cm(char *out, int32_t t_us, double dist_cm){
+    pthread_once(&nf_once, nf_build);
+    if (t_us >= 0 && t_us <= nf_max_us && t_us % nf_step_us == 0 && dist_cm == tof_us_to_cm(t_us)){
+        return nf_copy(out, &nf_dist[t_us / nf_step_us]);
+    }
+    return nf_slow(out, "%.4f", dist_cm);
+}
+
+size_t numfmt_th_pct(char *out, int stage, int raw, double pct){
+    pthread_once(&nf_once, nf_build);
+    if (stage <= 8){
+        if (raw >= 0 && raw < 32 && pct == value_to_pct(stage, raw)) return nf_copy(out, &nf_pct5[raw]);
+    } else if (raw >= 0 && raw < 256 && pct == value_to_pct(stage, raw)){
+        return nf_copy(out, &nf_pct8[raw]);
+    }
+    return nf_slow(out, "%.2f", pct);
+}
+
+size_t numfmt_gain_pct(char *out, int raw, double pct){
+    pthread_once(&nf_once, nf_build);
+    if (raw >= 0 && raw <= HERMES_TVG_GAIN_MAX && pct == (raw / (double)HERMES_TVG_GAIN_MAX) * 100.0){
+        return nf_copy(out, &nf_gain[raw]);
+    }
+    return nf_slow(out, "%.2f", pct);
+}
@@ -0,0 +1,329 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "frame.h"
+#include "stream.h"
+#include "hexparse.h"
+#include "parallel.h"
+#include "stats.h"
+
+/*
+ * Pool de chunks sobre un fichero mapeado. Cada chunk pasa por dos fases:
+ *   A) scan: cuenta sus lineas y tramas (se lo salta si split ya las sabe).
+ *   B) cuando se conoce la base (lineas/tramas de los chunks anteriores),
+ *      render con la numeracion global en sus propios buffers.
+ * La fase A es barata, asi que la espera por la base es corta. El hilo
+ * llamante vuelca los buffers en orden.
+ */
+
+typedef struct {
+    const char *map;
+    size_t      size;
+    parallel_chunk_t *chunks;
+    size_t      nchunks;
+    size_t      window;
+
+    const parallel_ops_t *ops;
+    void       *arg;
+
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+    size_t      next;        // siguiente chunk a reclamar
+    size_t      written;     // chunks ya volcados por el hilo principal
+    size_t      based_upto;  // chunks con base conocida
+    int         failed;
+} pool_t;
+
+/* Propaga las bases en orden (llamar con mu tomado) */
+static void propagate_bases(pool_t *p){
+    while (p->based_upto < p->nchunks){
+        size_t i = p->based_upto;
+        parallel_chunk_t *c = &p->chunks[i];
+        if (i == 0){
+            c->base_line = 0;
+            c->base_frame = 0;
+        } else {
+            parallel_chunk_t *prev = &p->chunks[i - 1];
+            if (!prev->counted) break;
+            c->base_line  = prev->base_line + prev->nlines;
+            c->base_frame = prev->base_frame + prev->nframes;
+        }
+        c->based = 1;
+        p->based_upto++;
+    }
+}
+
+/* Fase B en buffers propios del chunk */
+static int chunk_output(pool_t *p, parallel_chunk_t *c, void *scratch){
+    FILE *out = open_memstream(&c->out, &c->out_len);
+    FILE *err = open_memstream(&c->err, &c->err_len);
+    int rc = -1;
+    if (out && err) rc = p->ops->render(p->map, p->size, c, out, err, scratch, p->arg);
+    if (out) fclose(out);
+    if (err) fclose(err);
+    return rc;
+}
+
+static void *worker(void *arg){
+    pool_t *p = (pool_t *)arg;
+    void *scratch = p->ops->scratch_bytes ? calloc(1, p->ops->scratch_bytes) : NULL;
+    int no_scratch = p->ops->scratch_bytes && !scratch;
+
+    for (;;){
+        pthread_mutex_lock(&p->mu);
+        if (no_scratch) p->failed = 1;
+        while (p->next < p->nchunks && p->next >= p->written + p->window && !p->failed){
+            pthread_cond_wait(&p->cv, &p->mu);
+        }
+        if (p->next >= p->nchunks || p->failed){
+            pthread_cond_broadcast(&p->cv);
+            pthread_mutex_unlock(&p->mu);
+            break;
+        }
+        size_t i = p->next++;
+        parallel_chunk_t *c = &p->chunks[i];
+        int counted = c->counted;
+        pthread_mutex_unlock(&p->mu);
+
+        int rc = counted ? 0 : p->ops->scan(p->map, p->size, c, scratch, p->arg);
+
+        pthread_mutex_lock(&p->mu);
+        c->counted = 1;
+        propagate_bases(p);
+        pthread_cond_broadcast(&p->cv);
+        while (!c->based && !p->failed) pthread_cond_wait(&p->cv, &p->mu);
+        pthread_mutex_unlock(&p->mu);
+
+        if (rc == 0) rc = chunk_output(p, c, scratch);
+
+        pthread_mutex_lock(&p->mu);
+        if (rc != 0) p->failed = 1;
+        c->done = 1;
+        pthread_cond_broadcast(&p->cv);
+        pthread_mutex_unlock(&p->mu);
+    }
+
+    if (scratch && p->ops->scratch_free) p->ops->scratch_free(scratch);
+    free(scratch);
+    return NULL;
+}
+
+int parallel_pool_run(const char *map, size_t size, int nthreads,
+                      const parallel_ops_t *ops, void *arg, stream_stats_t *st){
+    size_t max_chunks = size / PARALLEL_CHUNK_BYTES + 1;
+    parallel_chunk_t *chunks = calloc(max_chunks, sizeof(parallel_chunk_t));
+    pthread_t *th = calloc((size_t)nthreads, sizeof(pthread_t));
+    if (!chunks || !th){
+        free(chunks);
+        free(th);
+        return -1;
+    }
+
+    pool_t p;
+    memset(&p, 0, sizeof(p));
+    p.map     = map;
+    p.size    = size;
+    p.chunks  = chunks;
+    p.nchunks = ops->split(map, size, chunks, max_chunks, arg);
+    p.window  = (size_t)nthreads * 2;
+    p.ops     = ops;
+    p.arg     = arg;
+    pthread_mutex_init(&p.mu, NULL);
+    pthread_cond_init(&p.cv, NULL);
+    propagate_bases(&p);   // los chunks que split ya conto
+
+    int started = 0;
+    for (; started < nthreads; started++){
+        if (pthread_create(&th[started], NULL, worker, &p) != 0) break;
+    }
+    if (started == 0) p.failed = 1;
+
+    /* Volcado en orden */
+    for (size_t i = 0; i < p.nchunks; i++){
+        parallel_chunk_t *c = &chunks[i];
+
+        pthread_mutex_lock(&p.mu);
+        while (!c->done && !p.failed) pthread_cond_wait(&p.cv, &p.mu);
+        int ok = c->done && !p.failed;
+        pthread_mutex_unlock(&p.mu);
+        if (!ok) break;
+
+        if (c->out_len) fwrite(c->out, 1, c->out_len, stdout);
+        if (c->err_len) fwrite(c->err, 1, c->err_len, stderr);
+        free(c->out);
+        free(c->err);
+        c->out = c->err = NULL;
+
+        st->lines  += c->nlines;
+        st->frames += c->nframes;
+        st->blank  += c->nblank;
+        st->errors += c->errors;
+
+        pthread_mutex_lock(&p.mu);
+        p.written++;
+        pthread_cond_broadcast(&p.cv);
+        pthread_mutex_unlock(&p.mu);
+    }
+
+    pthread_mutex_lock(&p.mu);
+    if (p.written < p.nchunks) p.failed = 1;
+    pthread_cond_broadcast(&p.cv);
+    pthread_mutex_unlock(&p.mu);
+
+    for (int t = 0; t < started; t++) pthread_join(th[t], NULL);
+
+    int rc = p.failed ? -1 : 0;
+    for (size_t i = 0; i < p.nchunks; i++){
+        free(chunks[i].out);
+        free(chunks[i].err);
+    }
+    pthread_mutex_destroy(&p.mu);
+    pthread_cond_destroy(&p.cv);
+    free(chunks);
+    free(th);
+    return rc;
+}
+
+/* ------------------ lineas hex ------------------ */
+typedef struct {
+    frame_cb cb;
+    void    *user;
+} hex_arg_t;
+
+/* Registros del chunk entre scan y render (uno por hilo) */
+typedef struct {
+    frame_recs_t recs;
+    uint8_t *buf;
+    size_t   buf_cap;
+} hex_scratch_t;
+
+static void hex_scratch_free(void *scratch){
+    hex_scratch_t *h = (hex_scratch_t *)scratch;
+    frame_recs_free(&h->recs);
+    free(h->buf);
+}
+
+/* Limites de chunk: cada uno empieza justo tras un '\n' */
+static size_t split_chunks(const char *map, size_t size, parallel_chunk_t *chunks, size_t max_chunks, void *arg){
+    (void)arg;
+    size_t n = 0, start = 0;
+    while (start < size && n < max_chunks){
+        size_t end = start + PARALLEL_CHUNK_BYTES;
+        if (end >= size){
+            end = size;
+        } else {
+            const char *nl = memchr(map + end, '\n', size - end);
+            end = nl ? (size_t)(nl - map) + 1 : size;
+        }
+        chunks[n].start = start;
+        chunks[n].end = end;
+        n++;
+        start = end;
+    }
+    return n;
+}
+
+/* Fase A: lineas del chunk -> registros */
+static int chunk_scan(const char *map, size_t size, parallel_chunk_t *c, void *scratch, void *arg){
+    (void)size;
+    (void)arg;
+    hex_scratch_t *h = (hex_scratch_t *)scratch;
+    const char *s = map + c->start;
+    const char *end = map + c->end;
+    uint32_t line = 0;
+
+    h->recs.n = 0;
+    while (s < end){
+        const char *nl = memchr(s, '\n', (size_t)(end - s));
+        const char *le = nl ? nl + 1 : end;
+
+        hermes_frame_t fr = {0};
+        uint64_t t = stats_begin();
+        int status = stream_parse_line(s, (size_t)(le - s), &h->buf, &h->buf_cap, &fr);
+        stats_end(STAGE_PARSE, t);
+
+        if (status == LINE_BLANK){
+            c->nblank++;
+        } else {
+            frame_rec_t r;
+            r.offset = (uint64_t)(s - map);
+            r.line   = line;
+            r.status = status;
+            r.nbytes = fr.nbytes;
+            if (status == LINE_OK){
+                memcpy(r.bytes, h->buf, HERMES_FRAME_BYTES);
+                c->nframes++;
+            }
+            if (frame_recs_push(&h->recs, &r) != 0) return -1;
+        }
+
+        line++;
+        s = le;
+    }
+    c->nlines = line;
+    stats_count(STAT_BYTES, c->end - c->start);
+    return 0;
+}
+
+/* Fase B: registros -> texto, con numeracion global */
+static int chunk_render(const char *map, size_t size, parallel_chunk_t *c, FILE *out, FILE *err,
+                        void *scratch, void *arg){
+    (void)map;
+    (void)size;
+    const hex_arg_t *a = (const hex_arg_t *)arg;
+    const hex_scratch_t *h = (const hex_scratch_t *)scratch;
+    stream_render_recs(out, err, &h->recs, c->base_line, c->base_frame, a->cb, a->user, &c->errors);
+    return 0;
+}
+
+static const parallel_ops_t HEX_OPS = {
+    split_chunks, chunk_scan, chunk_render, sizeof(hex_scratch_t), hex_scratch_free
+};
+
+int parallel_run(const char *path, int nthreads, frame_cb cb, void *user, stream_stats_t *st){
+    memset(st, 0, sizeof(*st));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        fprintf(stderr, "No se pudo abrir %s.\n", path);
+        return -1;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0){
+        close(fd);
+        return -1;
+    }
+    if (!S_ISREG(sb.st_mode)){
+        fprintf(stderr, "%s no es un fichero regular: no se puede mapear.\n", path);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)sb.st_size;
+    if (size == 0){
+        close(fd);
+        return 0;
+    }
+
+    const char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        fprintf(stderr, "No se pudo mapear %s.\n", path);
+        return -1;
+    }
+    madvise((void *)map, size, MADV_SEQUENTIAL);
+
+    hexparse_impl(); // elegir kernel SIMD antes de lanzar hilos
+    hex_arg_t a = { cb, user };
+    int rc = parallel_pool_run(map, size, nthreads, &HEX_OPS, &a, st);
+    munmap((void *)map, size);
+    return rc;
+}
@@ -0,0 +1,495 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <poll.h>
+
+#include "stream.h"
+#include "ring.h"
+#include "hexparse.h"
+#include "pipeline.h"
+#include "stats.h"
+
+typedef struct {
+    uint64_t seq;            // numero de lote (0..)
+    uint64_t base_line;      // lineas anteriores a este lote
+
+    /* entrada: lineas concatenadas */
+    char     *text;
+    size_t    len, cap;
+    size_t   *start;         // inicio de cada linea en text
+    uint64_t *offset;        // offset de cada linea en la entrada
+    size_t    nlines, lines_cap;
+
+    /* salida */
+    frame_recs_t recs;
+    char     *out;  size_t out_len;
+    char     *err;  size_t err_len;
+    uint64_t  nframes, nblank, errors;
+    int       failed;
+} batch_t;
+
+/* Fin acumulado de tramas del lote seq (tag = seq + 1 cuando es valido) */
+typedef struct {
+    _Atomic uint64_t tag;
+    uint64_t end_frame;
+} prefix_t;
+
+/* Hueco de salida ordenada (ready = seq + 1 cuando el lote seq esta listo) */
+typedef struct {
+    _Atomic uint64_t ready;
+    batch_t *b;
+} slot_t;
+
+typedef struct {
+    FILE       *in;
+    frame_cb    cb;
+    void       *user;
+
+    ring_t      free_q, work_q;
+    ring_event_t ev_free;    // writer -> reader: lote devuelto a free_q
+    ring_event_t ev_work;    // reader -> workers: lote en work_q o eof
+    ring_event_t ev_order;   // worker -> workers: fin acumulado publicado
+    ring_event_t ev_done;    // workers -> writer: lote listo (y eof del reader)
+    slot_t     *slots;
+    prefix_t   *prefix;
+    size_t      mask;        // slots/prefix: potencia de 2 >= pool
+
+    _Atomic int      eof;
+    _Atomic uint64_t total;  // lotes emitidos (valido con eof)
+    uint64_t    lines;       // solo reader
+    int         read_failed;
+
+    pipeline_stats_t *ps;
+    pthread_mutex_t   stats_mu;
+} pipe_t;
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void queue_stats_add(pipe_queue_stats_t *dst, const pipe_queue_stats_t *src){
+    dst->items         += src->items;
+    dst->depth_sum     += src->depth_sum;
+    if (src->depth_max > dst->depth_max) dst->depth_max = src->depth_max;
+    dst->push_stalls   += src->push_stalls;
+    dst->pop_stalls    += src->pop_stalls;
+    dst->push_stall_ns += src->push_stall_ns;
+    dst->pop_stall_ns  += src->pop_stall_ns;
+}
+
+static void note_depth(pipe_queue_stats_t *qs, size_t depth){
+    qs->items++;
+    qs->depth_sum += depth;
+    if (depth > qs->depth_max) qs->depth_max = depth;
+}
+
+/* ------------------ batches ------------------ */
+static void batch_reset(batch_t *b){
+    b->len = 0;
+    b->nlines = 0;
+    b->recs.n = 0;
+    b->nframes = b->nblank = b->errors = 0;
+    b->failed = 0;
+}
+
+static void batch_free(batch_t *b){
+    free(b->text);
+    free(b->start);
+    free(b->offset);
+    frame_recs_free(&b->recs);
+    free(b->out);
+    free(b->err);
+}
+
+static int batch_add_line(batch_t *b, const char *line, size_t len, uint64_t offset){
+    if (b->len + len > b->cap){
+        size_t ncap = b->cap ? b->cap : PIPELINE_BATCH_BYTES;
+        while (ncap < b->len + len) ncap *= 2;
+        char *nt = realloc(b->text, ncap);
+        if (!nt) return -1;
+        b->text = nt;
+        b->cap = ncap;
+    }
+    if (b->nlines == b->lines_cap){
+        size_t ncap = b->lines_cap ? b->lines_cap * 2 : PIPELINE_BATCH_LINES;
+        size_t *ns = realloc(b->start, ncap * sizeof(size_t));
+        if (!ns) return -1;
+        b->start = ns;
+        uint64_t *no = realloc(b->offset, ncap * sizeof(uint64_t));
+        if (!no) return -1;
+        b->offset = no;
+        b->lines_cap = ncap;
+    }
+    memcpy(b->text + b->len, line, len);
+    b->start[b->nlines]  = b->len;
+    b->offset[b->nlines] = offset;
+    b->nlines++;
+    b->len += len;
+    return 0;
+}
+
+/* ------------------ reader ------------------ */
+/* 1 si stdio ya tiene otra linea completa: la siguiente lectura no bloquea */
+static int stdio_has_line(FILE *in){
+#if defined(__GLIBC__)
+    const char *s = in->_IO_read_ptr;
+    return s < in->_IO_read_end && memchr(s, '\n', (size_t)(in->_IO_read_end - s)) != NULL;
+#else
+    (void)in;
+    return 0;   // sin acceso al buffer: se pregunta al descriptor
+#endif
+}
+
+/*
+ * 1 si la entrada esta en pausa (pipe/tty sin datos). Mientras stdio tenga
+ * lineas completas no hace falta preguntar, asi que poll() se llama como
+ * mucho una vez por read() y no una por linea.
+ */
+static int input_idle(FILE *in){
+    if (stdio_has_line(in)) return 0;
+    struct pollfd pfd = { fileno(in), POLLIN, 0 };
+    if (pfd.fd < 0) return 0;   // sin descriptor (.gz/.zst descomprimido en memoria)
+    return poll(&pfd, 1, 0) == 0;
+}
+
+static batch_t *reader_get_free(pipe_t *p, pipe_queue_stats_t *qs){
+    void *item;
+    if (ring_pop(&p->free_q, &item) != 0){
+        unsigned spins = 0;
+        uint64_t t0 = now_ns();
+        qs->pop_stalls++;
+        for (;;){
+            unsigned gen = ring_event_gen(&p->ev_free);
+            if (ring_pop(&p->free_q, &item) == 0) break;
+            ring_wait(&p->ev_free, gen, &spins);
+        }
+        qs->pop_stall_ns += now_ns() - t0;
+    }
+    return (batch_t *)item;
+}
+
+static void reader_submit(pipe_t *p, batch_t *b, uint64_t seq, pipe_queue_stats_t *qs){
+    b->seq = seq;
+    note_depth(qs, ring_depth(&p->work_q));
+    ring_push(&p->work_q, b); // siempre cabe: work_q tiene hueco para el pool entero
+    ring_notify(&p->ev_work);
+}
+
+static void *reader_main(void *arg){
+    pipe_t *p = (pipe_t *)arg;
+    pipe_queue_stats_t free_qs = {0}, work_qs = {0};
+    line_reader_t lr;
+    uint64_t seq = 0;
+
+    line_reader_init(&lr, p->in);
+    batch_t *b = reader_get_free(p, &free_qs);
+    batch_reset(b);
+    b->base_line = 0;
+
+    ssize_t len;
+    for (;;){
+        uint64_t t = stats_begin();
+        len = line_reader_next(&lr);
+        stats_end(STAGE_READ, t);
+        if (len < 0) break;
+        stats_count(STAT_BYTES, (uint64_t)len);
+        if (batch_add_line(b, lr.line, (size_t)len, lr.offset) != 0){
+            p->read_failed = 1;
+            break;
+        }
+        p->lines++;
+
+        // Lote lleno, o entrada en pausa: no retener tramas ya recibidas
+        if (b->nlines >= PIPELINE_BATCH_LINES || b->len >= PIPELINE_BATCH_BYTES || input_idle(p->in)){
+            reader_submit(p, b, seq++, &work_qs);
+            b = reader_get_free(p, &free_qs);
+            batch_reset(b);
+            b->base_line = p->lines;
+        }
+    }
+
+    if (b->nlines > 0){
+        reader_submit(p, b, seq++, &work_qs);
+    } else {
+        ring_push(&p->free_q, b); // siempre cabe: el pool entero cabe en la cola
+    }
+    line_reader_free(&lr);
+
+    pthread_mutex_lock(&p->stats_mu);
+    queue_stats_add(&p->ps->free_q, &free_qs);
+    queue_stats_add(&p->ps->work_q, &work_qs);
+    pthread_mutex_unlock(&p->stats_mu);
+
+    atomic_store_explicit(&p->total, seq, memory_order_relaxed);
+    atomic_store_explicit(&p->eof, 1, memory_order_release);
+    ring_notify(&p->ev_work);
+    ring_notify(&p->ev_done);
+    return NULL;
+}
+
+/* ------------------ workers ------------------ */
+static void worker_process(pipe_t *p, batch_t *b, uint8_t **buf, size_t *buf_cap,
+                           uint64_t *order_stalls, uint64_t *order_ns){
+    /* Fase A: parseo */
+    for (size_t j = 0; j < b->nlines; j++){
+        size_t end = (j + 1 < b->nlines) ? b->start[j + 1] : b->len;
+        hermes_frame_t fr = {0};
+        uint64_t t = stats_begin();
+        int status = stream_parse_line(b->text + b->start[j], end - b->start[j], buf, buf_cap, &fr);
+        stats_end(STAGE_PARSE, t);
+
+        if (status == LINE_BLANK){
+            b->nblank++;
+            continue;
+        }
+        frame_rec_t r;
+        r.offset = b->offset[j];
+        r.line   = (uint32_t)j;
+        r.status = status;
+        r.nbytes = fr.nbytes;
+        if (status == LINE_OK){
+            memcpy(r.bytes, *buf, HERMES_FRAME_BYTES);
+            b->nframes++;
+        }
+        if (frame_recs_push(&b->recs, &r) != 0){
+            b->failed = 1;
+            break;
+        }
+    }
+
+    /* Numeracion: espera al fin acumulado del lote anterior */
+    uint64_t base_frame = 0;
+    if (b->seq > 0){
+        prefix_t *prev = &p->prefix[(b->seq - 1) & p->mask];
+        if (atomic_load_explicit(&prev->tag, memory_order_acquire) != b->seq){
+            unsigned spins = 0;
+            uint64_t t0 = now_ns();
+            (*order_stalls)++;
+            for (;;){
+                unsigned gen = ring_event_gen(&p->ev_order);
+                if (atomic_load_explicit(&prev->tag, memory_order_acquire) == b->seq) break;
+                ring_wait(&p->ev_order, gen, &spins);
+            }
+            *order_ns += now_ns() - t0;
+        }
+        base_frame = prev->end_frame;
+    }
+    prefix_t *mine = &p->prefix[b->seq & p->mask];
+    mine->end_frame = base_frame + b->nframes;
+    atomic_store_explicit(&mine->tag, b->seq + 1, memory_order_release);
+    ring_notify(&p->ev_order);
+
+    /* Fase B: render */
+    FILE *out = open_memstream(&b->out, &b->out_len);
+    FILE *err = open_memstream(&b->err, &b->err_len);
+    if (!out || !err){
+        b->failed = 1;
+    } else {
+        stream_render_recs(out, err, &b->recs, b->base_line, base_frame, p->cb, p->user, &b->errors);
+    }
+    if (out) fclose(out);
+    if (err) fclose(err);
+}
+
+static void *worker_main(void *arg){
+    pipe_t *p = (pipe_t *)arg;
+    pipe_queue_stats_t work_qs = {0};
+    uint64_t order_stalls = 0, order_ns = 0;
+    uint8_t *buf = NULL;
+    size_t buf_cap = 0;
+
+    for (;;){
+        void *item;
+        if (ring_pop(&p->work_q, &item) != 0){
+            unsigned spins = 0;
+            uint64_t t0 = now_ns();
+            int got = 0;
+            work_qs.pop_stalls++;
+            for (;;){
+                unsigned gen = ring_event_gen(&p->ev_work);
+                if (ring_pop(&p->work_q, &item) == 0){ got = 1; break; }
+                if (atomic_load_explicit(&p->eof, memory_order_acquire)){
+                    got = (ring_pop(&p->work_q, &item) == 0);
+                    break;
+                }
+                ring_wait(&p->ev_work, gen, &spins);
+            }
+            work_qs.pop_stall_ns += now_ns() - t0;
+            if (!got) break;
+        }
+
+        batch_t *b = (batch_t *)item;
+        worker_process(p, b, &buf, &buf_cap, &order_stalls, &order_ns);
+
+        slot_t *s = &p->slots[b->seq & p->mask];
+        s->b = b;
+        atomic_store_explicit(&s->ready, b->seq + 1, memory_order_release);
+        ring_notify(&p->ev_done);
+    }
+
+    free(buf);
+    pthread_mutex_lock(&p->stats_mu);
+    queue_stats_add(&p->ps->work_q, &work_qs);
+    p->ps->order_stalls   += order_stalls;
+    p->ps->order_stall_ns += order_ns;
+    pthread_mutex_unlock(&p->stats_mu);
+    return NULL;
+}
+
+/* ------------------ writer (hilo llamante) ------------------ */
+int pipeline_run(FILE *in, int nworkers, frame_cb cb, void *user,
+                 stream_stats_t *st, pipeline_stats_t *ps){
+    memset(st, 0, sizeof(*st));
+    memset(ps, 0, sizeof(*ps));
+    if (nworkers < 1) nworkers = 1;
+
+    size_t pool = (size_t)nworkers * 4;
+    pipe_t p;
+    memset(&p, 0, sizeof(p));
+    p.in = in;
+    p.cb = cb;
+    p.user = user;
+    p.ps = ps;
+    ps->workers = nworkers;
+    ps->pool = (int)pool;
+
+    size_t nslots = 2;
+    while (nslots < pool) nslots <<= 1;
+    p.mask = nslots - 1;
+
+    batch_t *batches = calloc(pool, sizeof(batch_t));
+    p.slots  = calloc(nslots, sizeof(slot_t));
+    p.prefix = calloc(nslots, sizeof(prefix_t));
+    pthread_t *th = calloc((size_t)nworkers, sizeof(pthread_t));
+    if (!batches || !p.slots || !p.prefix || !th ||
+        ring_init(&p.free_q, pool) != 0 || ring_init(&p.work_q, pool) != 0){
+        free(batches); free(p.slots); free(p.prefix); free(th);
+        ring_free(&p.free_q); ring_free(&p.work_q);
+        return -1;
+    }
+    for (size_t i = 0; i < pool; i++) ring_push(&p.free_q, &batches[i]);
+    pthread_mutex_init(&p.stats_mu, NULL);
+    ring_event_init(&p.ev_free);
+    ring_event_init(&p.ev_work);
+    ring_event_init(&p.ev_order);
+    ring_event_init(&p.ev_done);
+    hexparse_impl(); // elegir kernel SIMD antes de lanzar hilos
+
+    int started = 0;
+    for (; started < nworkers; started++){
+        if (pthread_create(&th[started], NULL, worker_main, &p) != 0) break;
+    }
+    pthread_t reader;
+    int have_reader = (started > 0) && pthread_create(&reader, NULL, reader_main, &p) == 0;
+    if (!have_reader){
+        // sin reader no llegara nada: liberar a los workers
+        atomic_store_explicit(&p.eof, 1, memory_order_release);
+        ring_notify(&p.ev_work);
+    }
+
+    pipe_queue_stats_t done_qs = {0}, free_qs = {0};
+    int rc = have_reader ? 0 : -1;
+
+    /* Un lote fallido no corta el bucle: hay que seguir reciclando lotes o
+     * el reader se quedaria esperando en free_q. */
+    for (uint64_t next = 0; have_reader; next++){
+        slot_t *s = &p.slots[next & p.mask];
+
+        if (atomic_load_explicit(&s->ready, memory_order_acquire) != next + 1){
+            unsigned spins = 0;
+            uint64_t t0 = now_ns();
+            int got = 0;
+            done_qs.pop_stalls++;
+            for (;;){
+                unsigned gen = ring_event_gen(&p.ev_done);
+                if (atomic_load_explicit(&s->ready, memory_order_acquire) == next + 1){ got = 1; break; }
+                if (atomic_load_explicit(&p.eof, memory_order_acquire) &&
+                    next >= atomic_load_explicit(&p.total, memory_order_relaxed)) break;
+                ring_wait(&p.ev_done, gen, &spins);
+            }
+            done_qs.pop_stall_ns += now_ns() - t0;
+            if (!got) break;
+        }
+
+        batch_t *b = s->b;
+        // profundidad: lotes decodificados esperando detras de este
+        size_t depth = 0;
+        for (size_t k = 1; k < pool; k++){
+            if (atomic_load_explicit(&p.slots[(next + k) & p.mask].ready, memory_order_relaxed) != next + k + 1) break;
+            depth++;
+        }
+        note_depth(&done_qs, depth);
+
+        if (b->out_len) fwrite(b->out, 1, b->out_len, stdout);
+        if (b->err_len) fwrite(b->err, 1, b->err_len, stderr);
+        fflush(stdout); // un lote puede ser una sola trama en tiempo real
+        free(b->out);
+        free(b->err);
+        b->out = b->err = NULL;
+        b->out_len = b->err_len = 0;
+
+        st->frames += b->nframes;
+        st->blank  += b->nblank;
+        st->errors += b->errors;
+        if (b->failed) rc = -1;
+
+        note_depth(&free_qs, ring_depth(&p.free_q));
+        ring_push(&p.free_q, b); // siempre cabe
+        ring_notify(&p.ev_free);
+        ps->batches++;
+    }
+
+    if (have_reader) pthread_join(reader, NULL);
+    for (int t = 0; t < started; t++) pthread_join(th[t], NULL);
+
+    st->lines = p.lines;
+    if (p.read_failed) rc = -1;
+    // free_q: el reader registra las esperas (pop), el writer los items (push)
+    ps->free_q.items     += free_qs.items;
+    ps->free_q.depth_sum += free_qs.depth_sum;
+    if (free_qs.depth_max > ps->free_q.depth_max) ps->free_q.depth_max = free_qs.depth_max;
+    queue_stats_add(&ps->done_q, &done_qs);
+
+    for (size_t i = 0; i < pool; i++) batch_free(&batches[i]);
+    pthread_mutex_destroy(&p.stats_mu);
+    ring_event_destroy(&p.ev_free);
+    ring_event_destroy(&p.ev_work);
+    ring_event_destroy(&p.ev_order);
+    ring_event_destroy(&p.ev_done);
+    ring_free(&p.free_q);
+    ring_free(&p.work_q);
+    free(batches);
+    free(p.slots);
+    free(p.prefix);
+    free(th);
+    return rc;
+}
+
+static void print_queue(FILE *out, const char *name, const pipe_queue_stats_t *q){
+    double avg = q->items ? (double)q->depth_sum / (double)q->items : 0.0;
+    fprintf(out, "  %-8s items=%llu depth_avg=%.2f depth_max=%llu "
+                 "push_stalls=%llu (%.3f ms) pop_stalls=%llu (%.3f ms)\n",
+            name, (unsigned long long)q->items, avg, (unsigned long long)q->depth_max,
+            (unsigned long long)q->push_stalls, q->push_stall_ns / 1e6,
+            (unsigned long long)q->pop_stalls, q->pop_stall_ns / 1e6);
+}
+
+void pipeline_print_stats(FILE *out, const pipeline_stats_t *ps){
+    fprintf(out, "Pipeline: %d workers, %d lotes en circulación, %llu lotes\n",
+            ps->workers, ps->pool, (unsigned long long)ps->batches);
+    print_queue(out, "free", &ps->free_q);
+    print_queue(out, "work", &ps->work_q);
+    print_queue(out, "done", &ps->done_q);
+    fprintf(out, "  order    stalls=%llu (%.3f ms)\n",
+            (unsigned long long)ps->order_stalls, ps->order_stall_ns / 1e6);
+    fprintf(out, "  (work.pop_stalls altos: la entrada frena; free.pop_stalls con work.depth_avg\n"
+                 "   alto: el decode frena; con done.depth_avg alto: la salida frena)\n");
+}
@@ -0,0 +1,905 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "query.h"
+#include "archive.h"
+#include "regmap.h"
+#include "stream.h"
+#include "frame.h"
+
+#define QUERY_MAX_TERMS  16
+#define QUERY_MAX_NODES  64
+#define QUERY_NAME_MAX   40
+
+/* ------------------ expresion ------------------ */
+enum {
+    QT_BITS = 0,        // reg_idx/lsb/width
+    QT_PREFIX,
+    QT_FRAME_ID,
+    QT_OFFSET,
+    QT_TIMESTAMP,
+    QT_HASH,
+    QT_RESERVED,
+};
+
+enum { QN_CMP = 0, QN_AND, QN_OR, QN_NOT };
+enum { QO_EQ = 0, QO_NE, QO_LT, QO_LE, QO_GT, QO_GE };
+
+/* Logica de tres valores: con rangos en vez de valores exactos puede quedar en "quizas" */
+enum { Q_FALSE = 0, Q_TRUE = 1, Q_MAYBE = 2 };
+
+typedef struct {
+    char    name[QUERY_NAME_MAX];
+    uint8_t kind;
+    uint8_t reg_idx, lsb, width;
+} qterm_t;
+
+typedef struct {
+    uint8_t  kind;
+    uint8_t  op;
+    int16_t  a, b;           // hijos (and/or/not)
+    int16_t  term;           // QN_CMP
+    uint64_t val;
+} qnode_t;
+
+struct query {
+    qterm_t terms[QUERY_MAX_TERMS];
+    int     nterms;
+    qnode_t nodes[QUERY_MAX_NODES];
+    int     nnodes;
+    int     root;
+};
+
+typedef struct {
+    const char *s, *p;
+    query_t *q;
+    char *err;
+    size_t errcap;
+    int failed;
+} qparser_t;
+
+static void qp_error(qparser_t *ps, const char *msg){
+    if (ps->failed) return;
+    ps->failed = 1;
+    snprintf(ps->err, ps->errcap, "%s (posicion %d)", msg, (int)(ps->p - ps->s) + 1);
+}
+
+static void qp_skip(qparser_t *ps){
+    while (*ps->p == ' ' || *ps->p == '\t') ps->p++;
+}
+
+static int is_ident(char c){
+    return isalnum((unsigned char)c) || c == '_' || c == '.';
+}
+
+/* Palabra clave (and/or/not, sin distinguir mayusculas) seguida de algo que no es identificador */
+static int qp_keyword(qparser_t *ps, const char *kw){
+    qp_skip(ps);
+    size_t n = strlen(kw);
+    for (size_t i = 0; i < n; i++){
+        if (tolower((unsigned char)ps->p[i]) != kw[i]) return 0;
+    }
+    if (is_ident(ps->p[n])) return 0;
+    ps->p += n;
+    return 1;
+}
+
+static int qp_sym(qparser_t *ps, const char *sym){
+    qp_skip(ps);
+    size_t n = strlen(sym);
+    if (strncmp(ps->p, sym, n) != 0) return 0;
+    ps->p += n;
+    return 1;
+}
+
+static int term_resolve(const char *name, qterm_t *t){
+    static const struct { const char *name; uint8_t kind; } META[] = {
+        { "frame_id", QT_FRAME_ID }, { "offset", QT_OFFSET }, { "timestamp_us", QT_TIMESTAMP },
+        { "prefix", QT_PREFIX }, { "hash", QT_HASH }, { "reserved", QT_RESERVED },
+    };
+    memset(t, 0, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name);
+
+    for (size_t i = 0; i < sizeof(META) / sizeof(META[0]); i++){
+        if (strcmp(name, META[i].name) == 0){
+            t->kind = META[i].kind;
+            return 0;
+        }
+    }
+
+    char up[QUERY_NAME_MAX];
+    size_t n = strlen(name);
+    if (n >= sizeof(up)) return -1;
+    for (size_t i = 0; i <= n; i++) up[i] = (char)toupper((unsigned char)name[i]);
+    if (strcmp(name, "device") == 0) snprintf(up, sizeof(up), "PULSE_P2.UART_ADDR");
+
+    int idx, f;
+    t->kind = QT_BITS;
+    if (regmap_find_field(up, &idx, &f) == 0){
+        const reg_desc_t *d = regmap_desc(idx);
+        t->reg_idx = (uint8_t)idx;
+        t->lsb = d->fields[f].lsb;
+        t->width = d->fields[f].width;
+        return 0;
+    }
+    if ((idx = regmap_find_reg(up)) > 0){
+        t->reg_idx = (uint8_t)idx;
+        t->width = 8;
+        return 0;
+    }
+    return -1;
+}
+
+static int qp_node(qparser_t *ps, qnode_t nd){
+    if (ps->q->nnodes == QUERY_MAX_NODES){
+        qp_error(ps, "expresion demasiado larga");
+        return -1;
+    }
+    ps->q->nodes[ps->q->nnodes] = nd;
+    return ps->q->nnodes++;
+}
+
+static int qp_term(qparser_t *ps, const char *name){
+    query_t *q = ps->q;
+    for (int i = 0; i < q->nterms; i++){
+        if (strcmp(q->terms[i].name, name) == 0) return i;
+    }
+    qterm_t t;
+    if (term_resolve(name, &t) != 0){
+        char msg[96];
+        snprintf(msg, sizeof(msg), "campo desconocido o ambiguo '%s'", name);
+        qp_error(ps, msg);
+        return -1;
+    }
+    if (q->nterms == QUERY_MAX_TERMS){
+        qp_error(ps, "demasiados campos distintos");
+        return -1;
+    }
+    q->terms[q->nterms] = t;
+    return q->nterms++;
+}
+
+static int qp_or(qparser_t *ps);
+
+static int qp_cmp(qparser_t *ps){
+    qp_skip(ps);
+    const char *start = ps->p;
+    while (is_ident(*ps->p)) ps->p++;
+    size_t len = (size_t)(ps->p - start);
+    if (len == 0 || isdigit((unsigned char)start[0])){
+        ps->p = start;
+        qp_error(ps, "se esperaba un campo");
+        return -1;
+    }
+    char name[QUERY_NAME_MAX];
+    if (len >= sizeof(name)){
+        qp_error(ps, "nombre de campo demasiado largo");
+        return -1;
+    }
+    memcpy(name, start, len);
+    name[len] = '\0';
+
+    int term = qp_term(ps, name);
+    if (term < 0) return -1;
+
+    static const struct { const char *sym; uint8_t op; } OPS[] = {
+        { "==", QO_EQ }, { "!=", QO_NE }, { "<=", QO_LE }, { ">=", QO_GE },
+        { "<", QO_LT }, { ">", QO_GT }, { "=", QO_EQ },
+    };
+    int op = -1;
+    for (size_t i = 0; i < sizeof(OPS) / sizeof(OPS[0]) && op < 0; i++){
+        if (qp_sym(ps, OPS[i].sym)) op = OPS[i].op;
+    }
+    if (op < 0){
+        /* Campo suelto: distinto de cero */
+        return qp_node(ps, (qnode_t){ QN_CMP, QO_NE, -1, -1, (int16_t)term, 0 });
+    }
+
+    qp_skip(ps);
+    char *end;
+    if (!isdigit((unsigned char)*ps->p)){
+        qp_error(ps, "se esperaba un numero");
+        return -1;
+    }
+    unsigned long long v = strtoull(ps->p, &end, 0);
+    if (is_ident(*end)){
+        qp_error(ps, "numero no valido");
+        return -1;
+    }
+    ps->p = end;
+    return qp_node(ps, (qnode_t){ QN_CMP, (uint8_t)op, -1, -1, (int16_t)term, v });
+}
+
+static int qp_unary(qparser_t *ps){
+    if (qp_keyword(ps, "not") || qp_sym(ps, "!")){
+        int a = qp_unary(ps);
+        if (a < 0) return -1;
+        return qp_node(ps, (qnode_t){ QN_NOT, 0, (int16_t)a, -1, -1, 0 });
+    }
+    if (qp_sym(ps, "(")){
+        int a = qp_or(ps);
+        if (a < 0) return -1;
+        if (!qp_sym(ps, ")")){
+            qp_error(ps, "falta ')'");
+            return -1;
+        }
+        return a;
+    }
+    return qp_cmp(ps);
+}
+
+static int qp_and(qparser_t *ps){
+    int a = qp_unary(ps);
+    while (a >= 0 && (qp_keyword(ps, "and") || qp_sym(ps, "&&"))){
+        int b = qp_unary(ps);
+        if (b < 0) return -1;
+        a = qp_node(ps, (qnode_t){ QN_AND, 0, (int16_t)a, (int16_t)b, -1, 0 });
+    }
+    return a;
+}
+
+static int qp_or(qparser_t *ps){
+    int a = qp_and(ps);
+    while (a >= 0 && (qp_keyword(ps, "or") || qp_sym(ps, "||"))){
+        int b = qp_and(ps);
+        if (b < 0) return -1;
+        a = qp_node(ps, (qnode_t){ QN_OR, 0, (int16_t)a, (int16_t)b, -1, 0 });
+    }
+    return a;
+}
+
+query_t *query_compile(const char *expr, char *err, size_t errcap){
+    query_t *q = calloc(1, sizeof(*q));
+    if (!q){
+        snprintf(err, errcap, "sin memoria");
+        return NULL;
+    }
+    qparser_t ps = { expr, expr, q, err, errcap, 0 };
+    q->root = qp_or(&ps);
+    qp_skip(&ps);
+    if (q->root >= 0 && *ps.p != '\0') qp_error(&ps, "sobra texto al final");
+    if (q->root < 0 || ps.failed){
+        if (!ps.failed) qp_error(&ps, "expresion no valida");
+        free(q);
+        return NULL;
+    }
+    return q;
+}
+
+void query_free(query_t *q){
+    free(q);
+}
+
+static int cmp_range(int op, uint64_t lo, uint64_t hi, uint64_t v){
+    switch (op){
+    case QO_EQ: return (lo == v && hi == v) ? Q_TRUE : (v < lo || v > hi) ? Q_FALSE : Q_MAYBE;
+    case QO_NE: return (lo == v && hi == v) ? Q_FALSE : (v < lo || v > hi) ? Q_TRUE : Q_MAYBE;
+    case QO_LT: return hi < v ? Q_TRUE : lo >= v ? Q_FALSE : Q_MAYBE;
+    case QO_LE: return hi <= v ? Q_TRUE : lo > v ? Q_FALSE : Q_MAYBE;
+    case QO_GT: return lo > v ? Q_TRUE : hi <= v ? Q_FALSE : Q_MAYBE;
+    case QO_GE: return lo >= v ? Q_TRUE : hi < v ? Q_FALSE : Q_MAYBE;
+    }
+    return Q_MAYBE;
+}
+
+/* lo/hi: rango de cada termino (lo == hi con valores exactos) */
+static int q_eval(const query_t *q, int n, const uint64_t *lo, const uint64_t *hi){
+    const qnode_t *nd = &q->nodes[n];
+    int r, s;
+    switch (nd->kind){
+    case QN_NOT:
+        r = q_eval(q, nd->a, lo, hi);
+        return r == Q_MAYBE ? Q_MAYBE : !r;
+    case QN_AND:
+        if ((r = q_eval(q, nd->a, lo, hi)) == Q_FALSE) return Q_FALSE;
+        if ((s = q_eval(q, nd->b, lo, hi)) == Q_FALSE) return Q_FALSE;
+        return (r == Q_TRUE && s == Q_TRUE) ? Q_TRUE : Q_MAYBE;
+    case QN_OR:
+        if ((r = q_eval(q, nd->a, lo, hi)) == Q_TRUE) return Q_TRUE;
+        if ((s = q_eval(q, nd->b, lo, hi)) == Q_TRUE) return Q_TRUE;
+        return (r == Q_FALSE && s == Q_FALSE) ? Q_FALSE : Q_MAYBE;
+    default:
+        return cmp_range(nd->op, lo[nd->term], hi[nd->term], nd->val);
+    }
+}
+
+static uint64_t config_hash(const uint8_t *f){
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int i = 0; i < HERMES_FRAME_BYTES; i++){
+        h ^= f[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/* Valor de un termino que solo depende de la trama (57 bytes) */
+static int term_from_frame(const qterm_t *t, const uint8_t *f, uint64_t *v){
+    switch (t->kind){
+    case QT_BITS:     *v = (f[HERMES_PREFIX_BYTES + t->reg_idx - 1] >> t->lsb) & ((1u << t->width) - 1u); return 0;
+    case QT_PREFIX:   *v = ((uint64_t)f[0] << 8) | f[1]; return 0;
+    case QT_HASH:     *v = config_hash(f); return 0;
+    case QT_RESERVED: *v = (uint64_t)regmap_check_reserved(f + HERMES_PREFIX_BYTES); return 0;
+    }
+    return -1;   // por trama: frame_id/offset/timestamp_us
+}
+
+/* Rango de valores posible de un termino sin mirar datos */
+static void term_full_range(const qterm_t *t, uint64_t *lo, uint64_t *hi){
+    *lo = 0;
+    *hi = (t->kind == QT_BITS) ? (1u << t->width) - 1u : (t->kind == QT_PREFIX) ? 0xFFFF :
+          (t->kind == QT_RESERVED) ? REGMAP_NUM_REGS : UINT64_MAX;
+}
+
+/* ------------------ indice de logs ------------------
+ * Fichero (little-endian):
+ *   cabecera (64 bytes): "HRMSIDX1", u32 version, u32 0, u64 log_bytes,
+ *     u64 lines, u64 frames, u64 head_hash, u64 index_end, u64 0
+ *   segmentos hasta index_end, uno por actualizacion:
+ *     u32 ncfg, u32 npost, ncfg x trama de 57 bytes,
+ *     npost x { u64 frame_id, u64 offset, u32 cfg }   (cfg: indice global)
+ * head_hash es el FNV-1a de los primeros min(log_bytes, 4096) bytes del log
+ * y detecta que el fichero se ha rotado aunque no haya encogido.
+ */
+#define IDX_MAGIC      "HRMSIDX1"
+#define IDX_VERSION    1
+#define IDX_HDR_BYTES  64
+#define IDX_POST_BYTES 20
+#define IDX_HEAD_BYTES 4096
+
+typedef struct {
+    uint64_t frame_id, offset;
+    uint32_t cfg;
+} qpost_t;
+
+typedef struct {
+    uint8_t  (*cfg)[HERMES_FRAME_BYTES];
+    uint32_t ncfg, cap_cfg;
+    uint32_t *slot;          // tabla hash: indice + 1 (0 = libre)
+    uint32_t nslot;
+    qpost_t  *post;
+    size_t   npost, cap_post;
+
+    uint64_t log_bytes, lines, frames, head_hash, index_end;
+} qindex_t;
+
+static void put_u32(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_u64(uint8_t *p, uint64_t v){
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint32_t get_u32(const uint8_t *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t *p){
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static uint64_t fnv_bytes(const uint8_t *p, size_t n){
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < n; i++){
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static void index_reset(qindex_t *ix){
+    ix->ncfg = 0;
+    ix->npost = 0;
+    if (ix->slot) memset(ix->slot, 0, ix->nslot * sizeof(*ix->slot));
+    ix->log_bytes = ix->lines = ix->frames = ix->head_hash = ix->index_end = 0;
+}
+
+static void index_free(qindex_t *ix){
+    free(ix->cfg);
+    free(ix->slot);
+    free(ix->post);
+    memset(ix, 0, sizeof(*ix));
+}
+
+static int index_rehash(qindex_t *ix, uint32_t nslot){
+    uint32_t *slot = calloc(nslot, sizeof(*slot));
+    if (!slot) return -1;
+    for (uint32_t c = 0; c < ix->ncfg; c++){
+        uint32_t h = (uint32_t)config_hash(ix->cfg[c]) & (nslot - 1);
+        while (slot[h]) h = (h + 1) & (nslot - 1);
+        slot[h] = c + 1;
+    }
+    free(ix->slot);
+    ix->slot = slot;
+    ix->nslot = nslot;
+    return 0;
+}
+
+/* Indice de la configuracion de f; la anade si es nueva. -1 sin memoria. */
+static int64_t index_config(qindex_t *ix, const uint8_t *f){
+    if ((ix->ncfg + 1) * 2 > ix->nslot && index_rehash(ix, ix->nslot ? ix->nslot * 2 : 1024) != 0) return -1;
+
+    uint32_t h = (uint32_t)config_hash(f) & (ix->nslot - 1);
+    while (ix->slot[h]){
+        uint32_t c = ix->slot[h] - 1;
+        if (memcmp(ix->cfg[c], f, HERMES_FRAME_BYTES) == 0) return c;
+        h = (h + 1) & (ix->nslot - 1);
+    }
+    if (ix->ncfg == ix->cap_cfg){
+        uint32_t cap = ix->cap_cfg ? ix->cap_cfg * 2 : 256;
+        void *nc = realloc(ix->cfg, (size_t)cap * sizeof(*ix->cfg));
+        if (!nc) return -1;
+        ix->cfg = nc;
+        ix->cap_cfg = cap;
+    }
+    memcpy(ix->cfg[ix->ncfg], f, HERMES_FRAME_BYTES);
+    ix->slot[h] = ix->ncfg + 1;
+    return ix->ncfg++;
+}
+
+static int index_post(qindex_t *ix, uint64_t frame_id, uint64_t offset, uint32_t cfg){
+    if (ix->npost == ix->cap_post){
+        size_t cap = ix->cap_post ? ix->cap_post * 2 : 4096;
+        qpost_t *np = realloc(ix->post, cap * sizeof(*np));
+        if (!np) return -1;
+        ix->post = np;
+        ix->cap_post = cap;
+    }
+    ix->post[ix->npost++] = (qpost_t){ frame_id, offset, cfg };
+    return 0;
+}
+
+/* Carga un indice existente. 0, 1 si no existe o no es valido (se reconstruye) o -1 sin memoria. */
+static int index_load(qindex_t *ix, const char *path){
+    FILE *f = fopen(path, "rb");
+    if (!f) return 1;
+
+    uint8_t h[IDX_HDR_BYTES];
+    if (fread(h, 1, sizeof(h), f) != sizeof(h) || memcmp(h, IDX_MAGIC, 8) != 0 || get_u32(h + 8) != IDX_VERSION){
+        fclose(f);
+        return 1;
+    }
+    ix->log_bytes = get_u64(h + 16);
+    ix->lines = get_u64(h + 24);
+    ix->frames = get_u64(h + 32);
+    ix->head_hash = get_u64(h + 40);
+    ix->index_end = get_u64(h + 48);
+
+    int rc = 0;
+    uint64_t pos = IDX_HDR_BYTES;
+    while (rc == 0 && pos < ix->index_end){
+        uint8_t sh[8];
+        if (fread(sh, 1, sizeof(sh), f) != sizeof(sh)){
+            rc = 1;
+            break;
+        }
+        uint32_t ncfg = get_u32(sh), npost = get_u32(sh + 4);
+        pos += sizeof(sh) + (uint64_t)ncfg * HERMES_FRAME_BYTES + (uint64_t)npost * IDX_POST_BYTES;
+        if (pos > ix->index_end){
+            rc = 1;
+            break;
+        }
+        uint32_t base = ix->ncfg;
+        for (uint32_t c = 0; c < ncfg && rc == 0; c++){
+            uint8_t fr[HERMES_FRAME_BYTES];
+            if (fread(fr, 1, sizeof(fr), f) != sizeof(fr)) rc = 1;
+            else if (index_config(ix, fr) != (int64_t)(base + c)) rc = (ix->ncfg == base + c) ? -1 : 1;
+        }
+        for (uint32_t p = 0; p < npost && rc == 0; p++){
+            uint8_t e[IDX_POST_BYTES];
+            if (fread(e, 1, sizeof(e), f) != sizeof(e) || get_u32(e + 16) >= ix->ncfg) rc = 1;
+            else if (index_post(ix, get_u64(e), get_u64(e + 8), get_u32(e + 16)) != 0) rc = -1;
+        }
+    }
+    fclose(f);
+    if (rc != 0) index_reset(ix);
+    return rc;
+}
+
+static void index_header(const qindex_t *ix, uint8_t h[IDX_HDR_BYTES]){
+    memset(h, 0, IDX_HDR_BYTES);
+    memcpy(h, IDX_MAGIC, 8);
+    put_u32(h + 8, IDX_VERSION);
+    put_u64(h + 16, ix->log_bytes);
+    put_u64(h + 24, ix->lines);
+    put_u64(h + 32, ix->frames);
+    put_u64(h + 40, ix->head_hash);
+    put_u64(h + 48, ix->index_end);
+}
+
+/*
+ * Escribe las configuraciones y entradas desde cfg0/post0 como un segmento
+ * nuevo (o el indice entero si fresh) y actualiza la cabecera al final.
+ */
+static int index_save(qindex_t *ix, const char *path, int fresh, uint32_t cfg0, size_t post0){
+    FILE *f = fopen(path, fresh ? "wb" : "r+b");
+    if (!f){
+        fprintf(stderr, "No se pudo escribir el indice %s.\n", path);
+        return -1;
+    }
+    int bad = 0;
+    uint8_t h[IDX_HDR_BYTES];
+    if (fresh){
+        ix->index_end = IDX_HDR_BYTES;
+        index_header(ix, h);
+        bad |= fwrite(h, 1, sizeof(h), f) != sizeof(h);
+    }
+
+    uint32_t ncfg = ix->ncfg - cfg0;
+    size_t npost = ix->npost - post0;
+    if (ncfg || npost){
+        bad |= fseeko(f, (off_t)ix->index_end, SEEK_SET) != 0;
+        uint8_t sh[8];
+        put_u32(sh, ncfg);
+        put_u32(sh + 4, (uint32_t)npost);
+        bad |= fwrite(sh, 1, sizeof(sh), f) != sizeof(sh);
+        bad |= fwrite(ix->cfg[cfg0], HERMES_FRAME_BYTES, ncfg, f) != ncfg;
+        for (size_t p = post0; p < ix->npost && !bad; p++){
+            uint8_t e[IDX_POST_BYTES];
+            put_u64(e, ix->post[p].frame_id);
+            put_u64(e + 8, ix->post[p].offset);
+            put_u32(e + 16, ix->post[p].cfg);
+            bad |= fwrite(e, 1, sizeof(e), f) != sizeof(e);
+        }
+        ix->index_end += sizeof(sh) + (uint64_t)ncfg * HERMES_FRAME_BYTES + (uint64_t)npost * IDX_POST_BYTES;
+    }
+
+    /* La cabecera va la ultima: si algo falla antes, el indice viejo sigue valido */
+    bad |= fflush(f) != 0;
+    index_header(ix, h);
+    bad |= fseeko(f, 0, SEEK_SET) != 0;
+    bad |= fwrite(h, 1, sizeof(h), f) != sizeof(h);
+    if (fclose(f) != 0) bad = 1;
+    if (bad) fprintf(stderr, "Error escribiendo el indice %s.\n", path);
+    return bad ? -1 : 0;
+}
+
+/* Indexa las lineas completas de log[ix->log_bytes..len) */
+static int index_scan(qindex_t *ix, const uint8_t *log, size_t len, query_stats_t *st){
+    uint8_t *buf = NULL;
+    size_t cap = 0;
+    int rc = 0;
+
+    size_t pos = (size_t)ix->log_bytes;
+    while (pos < len){
+        const uint8_t *nl = memchr(log + pos, '\n', len - pos);
+        if (!nl) break;   // linea a medio escribir: en la siguiente consulta
+        size_t end = (size_t)(nl - log) + 1;
+
+        hermes_frame_t fr = {0};
+        int status = stream_parse_line((const char *)log + pos, end - pos, &buf, &cap, &fr);
+        ix->lines++;
+        st->new_lines++;
+        if (status == LINE_NOMEM){
+            rc = -1;
+            break;
+        }
+        if (status == LINE_OK){
+            int64_t c = index_config(ix, buf);
+            if (c < 0 || index_post(ix, ++ix->frames, pos, (uint32_t)c) != 0){
+                rc = -1;
+                break;
+            }
+        }
+        pos = end;
+    }
+    ix->log_bytes = pos;
+    free(buf);
+    return rc;
+}
+
+static int index_sync(qindex_t *ix, const char *idx_path, int reindex, const uint8_t *log, size_t len,
+                      query_stats_t *st){
+    int fresh = 1;
+    if (!reindex){
+        int lr = index_load(ix, idx_path);
+        if (lr < 0) return -1;
+        if (lr == 0){
+            size_t head = ix->log_bytes < IDX_HEAD_BYTES ? (size_t)ix->log_bytes : IDX_HEAD_BYTES;
+            if (ix->log_bytes <= len && fnv_bytes(log, head) == ix->head_hash){
+                fresh = 0;
+            } else {
+                fprintf(stderr, "El log ha cambiado desde el ultimo indice: se reconstruye.\n");
+                index_reset(ix);
+            }
+        }
+    }
+
+    uint32_t cfg0 = ix->ncfg;
+    size_t post0 = ix->npost;
+    uint64_t lines0 = ix->lines, bytes0 = ix->log_bytes;
+    if (index_scan(ix, log, len, st) != 0){
+        fprintf(stderr, "Sin memoria indexando el log.\n");
+        return -1;
+    }
+    ix->head_hash = fnv_bytes(log, ix->log_bytes < IDX_HEAD_BYTES ? (size_t)ix->log_bytes : IDX_HEAD_BYTES);
+
+    if (fresh || ix->lines != lines0 || ix->log_bytes != bytes0){
+        return index_save(ix, idx_path, fresh, fresh ? 0 : cfg0, fresh ? 0 : post0);
+    }
+    return 0;
+}
+
+/* ------------------ salida ------------------ */
+static void emit_ids(FILE *out, uint64_t frame_id, uint64_t offset){
+    fprintf(out, "%llu %llu\n", (unsigned long long)frame_id, (unsigned long long)offset);
+}
+
+static void emit_hex(FILE *out, const uint8_t *f){
+    static const char HEX[] = "0123456789ABCDEF";
+    char s[3 * HERMES_FRAME_BYTES];
+    for (int b = 0; b < HERMES_FRAME_BYTES; b++){
+        s[3 * b]     = HEX[f[b] >> 4];
+        s[3 * b + 1] = HEX[f[b] & 0x0F];
+        s[3 * b + 2] = ' ';
+    }
+    s[3 * HERMES_FRAME_BYTES - 1] = '\n';
+    fwrite(s, 1, sizeof(s), out);
+}
+
+/* ------------------ consulta sobre log ------------------ */
+static int query_log(const char *path, const uint8_t *log, size_t len, const query_t *q,
+                     const query_opts_t *o, FILE *out, query_stats_t *st){
+    char idx_path[4096];
+    if (o->index_path) snprintf(idx_path, sizeof(idx_path), "%s", o->index_path);
+    else snprintf(idx_path, sizeof(idx_path), "%s.hidx", path);
+
+    for (int t = 0; q && t < q->nterms; t++){
+        if (q->terms[t].kind == QT_TIMESTAMP){
+            fprintf(stderr, "timestamp_us solo existe en archivos (--archive).\n");
+            return -1;
+        }
+    }
+
+    qindex_t ix = {0};
+    if (index_sync(&ix, idx_path, o->reindex, log, len, st) != 0){
+        index_free(&ix);
+        return -1;
+    }
+    st->frames = ix.frames;
+    st->configs = ix.ncfg;
+    if (!q){
+        index_free(&ix);
+        return 0;
+    }
+
+    /* Una evaluacion por configuracion; frame_id/offset quedan abiertos */
+    uint8_t *state = malloc(ix.ncfg ? ix.ncfg : 1);
+    if (!state){
+        index_free(&ix);
+        return -1;
+    }
+    uint64_t lo[QUERY_MAX_TERMS], hi[QUERY_MAX_TERMS];
+    for (uint32_t c = 0; c < ix.ncfg; c++){
+        for (int t = 0; t < q->nterms; t++){
+            if (term_from_frame(&q->terms[t], ix.cfg[c], &lo[t]) == 0) hi[t] = lo[t];
+            else term_full_range(&q->terms[t], &lo[t], &hi[t]);
+        }
+        state[c] = (uint8_t)q_eval(q, q->root, lo, hi);
+        st->configs_maybe += state[c] == Q_MAYBE;
+    }
+
+    for (size_t i = 0; i < ix.npost; i++){
+        const qpost_t *p = &ix.post[i];
+        int r = state[p->cfg];
+        if (r == Q_MAYBE){
+            for (int t = 0; t < q->nterms; t++){
+                const qterm_t *term = &q->terms[t];
+                if (term->kind == QT_FRAME_ID) lo[t] = p->frame_id;
+                else if (term->kind == QT_OFFSET) lo[t] = p->offset;
+                else term_from_frame(term, ix.cfg[p->cfg], &lo[t]);
+                hi[t] = lo[t];
+            }
+            r = q_eval(q, q->root, lo, hi);
+        }
+        if (r != Q_TRUE) continue;
+
+        st->matches++;
+        if (o->out == QUERY_OUT_IDS){
+            emit_ids(out, p->frame_id, p->offset);
+        } else if (o->out == QUERY_OUT_HEX){
+            /* La linea original tal cual */
+            const uint8_t *nl = memchr(log + p->offset, '\n', len - p->offset);
+            size_t n = nl ? (size_t)(nl - (log + p->offset)) + 1 : len - p->offset;
+            fwrite(log + p->offset, 1, n, out);
+        }
+    }
+
+    free(state);
+    index_free(&ix);
+    return 0;
+}
+
+/* ------------------ consulta sobre archivo ------------------ */
+static const uint64_t *sort_ids;   // clave de qsort (un solo hilo)
+
+static int cmp_match(const void *a, const void *b){
+    uint64_t x = sort_ids[*(const uint32_t *)a], y = sort_ids[*(const uint32_t *)b];
+    return (x > y) - (x < y);
+}
+
+/* Columna del archivo para el termino t o -1 si hace falta la trama entera */
+static int term_column(const archive_t *a, const qterm_t *t){
+    switch (t->kind){
+    case QT_FRAME_ID:  return ARCHIVE_COL_FRAME_ID;
+    case QT_OFFSET:    return ARCHIVE_COL_OFFSET;
+    case QT_TIMESTAMP: return ARCHIVE_COL_TIMESTAMP;
+    case QT_PREFIX:    return ARCHIVE_COL_PREFIX;
+    case QT_BITS:
+        for (int c = ARCHIVE_NUM_META; c < archive_num_cols(a); c++){
+            const archive_col_t *col = archive_col(a, c);
+            if (col->reg_idx == t->reg_idx && col->lsb == t->lsb && col->width == t->width) return c;
+        }
+        return -1;
+    }
+    return -1;
+}
+
+static int query_archive(const char *path, const query_t *q, const query_opts_t *o, FILE *out,
+                         query_stats_t *st){
+    archive_t *a = archive_open(path);
+    if (!a) return -1;
+    st->frames = archive_rows(a);
+    st->groups = (uint64_t)archive_num_groups(a);
+    if (!q){
+        archive_close(a);
+        return 0;
+    }
+
+    int col[QUERY_MAX_TERMS], need_frames = 0;
+    for (int t = 0; t < q->nterms; t++){
+        col[t] = term_column(a, &q->terms[t]);
+        need_frames |= col[t] < 0;
+    }
+
+    uint64_t *vals = malloc((size_t)(q->nterms + 3) * ARCHIVE_GROUP_ROWS * sizeof(uint64_t));
+    uint8_t (*frames)[HERMES_FRAME_BYTES] = malloc(ARCHIVE_GROUP_ROWS * sizeof(*frames));
+    uint32_t *match = malloc(ARCHIVE_GROUP_ROWS * sizeof(*match));
+    int rc = (vals && frames && match) ? 0 : -1;
+    uint64_t *ids = vals + (size_t)q->nterms * ARCHIVE_GROUP_ROWS;
+    uint64_t *offs = ids + ARCHIVE_GROUP_ROWS, *ts = offs + ARCHIVE_GROUP_ROWS;
+
+    for (int g = 0; g < archive_num_groups(a) && rc == 0; g++){
+        uint32_t n = archive_group_rows(a, g);
+        if (n > ARCHIVE_GROUP_ROWS){
+            rc = -1;
+            break;
+        }
+
+        /* min/max de cada trozo: descarta el bloque o lo da por bueno entero */
+        uint64_t lo[QUERY_MAX_TERMS], hi[QUERY_MAX_TERMS];
+        for (int t = 0; t < q->nterms; t++){
+            archive_chunk_t ch;
+            if (col[t] < 0){
+                term_full_range(&q->terms[t], &lo[t], &hi[t]);
+                continue;
+            }
+            archive_chunk(a, g, col[t], &ch);
+            lo[t] = ch.min;
+            hi[t] = ch.max;
+        }
+        int r = q_eval(q, q->root, lo, hi);
+        if (r == Q_FALSE) continue;
+        st->groups_read++;
+
+        int have_frames = 0, have_ids = 0;
+        uint32_t nm = 0;
+        if (r == Q_TRUE){
+            for (uint32_t i = 0; i < n; i++) match[nm++] = i;
+        } else {
+            if (need_frames){
+                if (archive_read_frames(a, g, frames, ids, offs, ts) != 0) rc = -1;
+                have_frames = have_ids = 1;
+            } else {
+                for (int t = 0; t < q->nterms && rc == 0; t++){
+                    rc = archive_read_col(a, g, col[t], vals + (size_t)t * ARCHIVE_GROUP_ROWS);
+                }
+            }
+            for (uint32_t i = 0; i < n && rc == 0; i++){
+                for (int t = 0; t < q->nterms; t++){
+                    const qterm_t *term = &q->terms[t];
+                    if (!need_frames) lo[t] = vals[(size_t)t * ARCHIVE_GROUP_ROWS + i];
+                    else if (term->kind == QT_FRAME_ID) lo[t] = ids[i];
+                    else if (term->kind == QT_OFFSET) lo[t] = offs[i];
+                    else if (term->kind == QT_TIMESTAMP) lo[t] = ts[i];
+                    else term_from_frame(term, frames[i], &lo[t]);
+                    hi[t] = lo[t];
+                }
+                if (q_eval(q, q->root, lo, hi) == Q_TRUE) match[nm++] = i;
+            }
+        }
+        if (rc != 0){
+            fprintf(stderr, "%s: bloque %d corrupto.\n", path, g);
+            break;
+        }
+
+        st->matches += nm;
+        if (nm == 0 || o->out == QUERY_OUT_COUNT) continue;
+
+        /* Las filas van por dispositivo en disco: salida por frame_id */
+        if (o->out == QUERY_OUT_HEX && !have_frames){
+            rc = archive_read_frames(a, g, frames, ids, offs, ts);
+        } else if (!have_ids){
+            rc = archive_read_col(a, g, ARCHIVE_COL_FRAME_ID, ids);
+            if (rc == 0) rc = archive_read_col(a, g, ARCHIVE_COL_OFFSET, offs);
+        }
+        if (rc != 0){
+            fprintf(stderr, "%s: bloque %d corrupto.\n", path, g);
+            break;
+        }
+        sort_ids = ids;
+        qsort(match, nm, sizeof(*match), cmp_match);
+        for (uint32_t k = 0; k < nm; k++){
+            if (o->out == QUERY_OUT_IDS) emit_ids(out, ids[match[k]], offs[match[k]]);
+            else emit_hex(out, frames[match[k]]);
+        }
+    }
+
+    free(vals);
+    free(frames);
+    free(match);
+    archive_close(a);
+    return rc;
+}
+
+/* ------------------ entrada ------------------ */
+int query_run(const char *path, const query_opts_t *o, FILE *out, query_stats_t *st){
+    memset(st, 0, sizeof(*st));
+
+    query_t *q = NULL;
+    if (o->expr){
+        char err[160];
+        q = query_compile(o->expr, err, sizeof(err));
+        if (!q){
+            fprintf(stderr, "Expresion: %s.\n", err);
+            return -1;
+        }
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0){
+        fprintf(stderr, "No se pudo abrir %s.\n", path);
+        if (fd >= 0) close(fd);
+        query_free(q);
+        return -1;
+    }
+    size_t len = (size_t)sb.st_size;
+    const uint8_t *map = NULL;
+    if (len > 0){
+        void *m = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED){
+            fprintf(stderr, "No se pudo mapear %s.\n", path);
+            close(fd);
+            query_free(q);
+            return -1;
+        }
+        map = m;
+    }
+    close(fd);
+
+    int rc;
+    if (len >= 8 && memcmp(map, ARCHIVE_MAGIC, 8) == 0){
+        rc = query_archive(path, q, o, out, st);
+    } else {
+        rc = query_log(path, map ? map : (const uint8_t *)"", len, q, o, out, st);
+    }
+    if (o->out == QUERY_OUT_COUNT && q && rc == 0) fprintf(out, "%llu\n", (unsigned long long)st->matches);
+
+    if (map) munmap((void *)map, len);
+    query_free(q);
+    return rc;
+}
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "record.h"
+#include "regmap.h"
+#include "numfmt.h"
+#include "outbuf.h"
+
+/* ------------------ buffer de salida ------------------
+ * Todo se escribe a mano en memoria del llamador (outbuf.h): nada de printf
+ * por campo.
+ */
+static void ob_u64(outbuf_t *b, uint64_t v){ OB_NUM(b, numfmt_u64(out, v)); }
+
+static void ob_i64(outbuf_t *b, int64_t v){ OB_NUM(b, numfmt_i64(out, v)); }
+
+static void ob_key(outbuf_t *b, const char *k){
+    ob_lit(b, "\"");
+    ob_str(b, k);
+    ob_lit(b, "\":");
+}
+
+/* ------------------ NDJSON ------------------ */
+int record_format_parse(const char *s){
+    if (strcmp(s, "text") == 0)   return RECORD_TEXT;
+    if (strcmp(s, "ndjson") == 0) return RECORD_NDJSON;
+    if (strcmp(s, "binary") == 0) return RECORD_BINARY;
+    return -1;
+}
+
+static void ndjson_regs(outbuf_t *b, const hermes_config_t *cfg){
+    ob_lit(b, ",\"regs\":{");
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        if (idx > 1) ob_lit(b, ",");
+        ob_key(b, d->name);
+        ob_lit(b, "{\"idx\":");
+        ob_u64(b, (uint64_t)idx);
+        ob_lit(b, ",\"raw\":");
+        ob_u64(b, cfg->reg[idx - 1]);
+        ob_lit(b, ",\"fields\":{");
+        for (int f = 0; f < d->nfields; f++){
+            if (f) ob_lit(b, ",");
+            ob_key(b, d->fields[f].name);
+            ob_u64(b, regmap_field_value(cfg->reg, d, f));
+        }
+        ob_lit(b, "}}");
+    }
+    ob_lit(b, "}");
+}
+
+static void ndjson_warnings(outbuf_t *b, const hermes_config_t *cfg){
+    ob_lit(b, ",\"warnings\":[");
+    int n = 0;
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        if (!(cfg->reg[idx - 1] & d->rsv_mask)) continue;
+        for (int f = 0; f < d->nfields; f++){
+            if (!(d->fields[f].flags & REG_FF_RESERVED) || regmap_field_value(cfg->reg, d, f) == 0) continue;
+            if (n++) ob_lit(b, ",");
+            ob_lit(b, "\"");
+            ob_str(b, d->name);
+            ob_lit(b, ".");
+            ob_str(b, d->fields[f].name);
+            ob_lit(b, "\"");
+        }
+    }
+    ob_lit(b, "]");
+}
+
+static void ndjson_th(outbuf_t *b, const hermes_th_t *th, int is_p2){
+    ob_str(b, is_p2 ? ",\"p2\":{\"points\":[" : ",\"p1\":{\"points\":[");
+    for (int i = 0; i < HERMES_TH_STAGES; i++){
+        if (i) ob_lit(b, ",");
+        ob_lit(b, "{\"stage\":");
+        ob_u64(b, (uint64_t)i + 1);
+        ob_lit(b, ",\"delta_us\":");
+        ob_i64(b, th->delta_us[i]);
+        ob_lit(b, ",\"t_us\":");
+        ob_i64(b, th->t_us[i]);
+        ob_lit(b, ",\"dist_cm\":");
+        OB_NUM(b, numfmt_dist_cm(out, th->t_us[i], th->dist_cm[i]));
+        ob_lit(b, ",\"value_pct\":");
+        OB_NUM(b, numfmt_th_pct(out, i + 1, th->level[i], th->pct[i]));
+        ob_lit(b, ",\"value_raw\":");
+        ob_u64(b, th->level[i]);
+        ob_lit(b, "}");
+    }
+    ob_lit(b, "]}");
+}
+
+static void ndjson_tvg(outbuf_t *b, const hermes_tvg_t *tvg){
+    ob_lit(b, ",\"tvg\":{\"g\":[");
+    for (int i = 0; i < HERMES_TVG_GAINS; i++){
+        if (i) ob_lit(b, ",");
+        ob_u64(b, tvg->g[i]);
+    }
+    ob_lit(b, "],\"points\":[");
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        if (i) ob_lit(b, ",");
+        ob_lit(b, "{\"stage\":");
+        ob_u64(b, (uint64_t)i + 1);
+        ob_lit(b, ",\"delta_us\":");
+        ob_i64(b, tvg->delta_us[i]);
+        ob_lit(b, ",\"t_us\":");
+        ob_i64(b, tvg->t_us[i]);
+        ob_lit(b, ",\"dist_cm\":");
+        OB_NUM(b, numfmt_dist_cm(out, tvg->t_us[i], tvg->dist_cm[i]));
+        ob_lit(b, ",\"gain_pct\":");
+        OB_NUM(b, numfmt_gain_pct(out, tvg->gain_raw[i], tvg->gain_pct[i]));
+        ob_lit(b, ",\"gain_raw\":");
+        ob_u64(b, tvg->gain_raw[i]);
+        ob_lit(b, "}");
+    }
+    ob_lit(b, "]}");
+}
+
+size_t record_format_ndjson(char *buf, size_t cap, const export_key_t *k, const hermes_config_t *cfg){
+    static const char HEX[] = "0123456789ABCDEF";
+    outbuf_t b = { buf, cap, 0 };
+
+    ob_lit(&b, "{\"frame_id\":");
+    ob_u64(&b, k->frame_id);
+    ob_lit(&b, ",\"offset\":");
+    ob_u64(&b, k->offset);
+    ob_lit(&b, ",\"device\":");
+    ob_u64(&b, k->device);
+
+    char prefix[] = ",\"prefix\":\"0x0000\"";
+    for (int i = 0; i < 4; i++) prefix[13 + i] = HEX[(k->prefix >> (12 - 4 * i)) & 0x0F];
+    ob_lit(&b, prefix);
+
+    ob_lit(&b, ",\"reserved_bad\":");
+    ob_u64(&b, (uint64_t)regmap_check_reserved(cfg->reg));
+    ndjson_warnings(&b, cfg);
+    ndjson_regs(&b, cfg);
+    ndjson_th(&b, &cfg->th[0], 0);
+    ndjson_th(&b, &cfg->th[1], 1);
+    ndjson_tvg(&b, &cfg->tvg);
+    ob_lit(&b, "}\n");
+
+    return ob_done(&b);
+}
+
+/* ------------------ binario ------------------ */
+static uint8_t *put_point(uint8_t *p, int32_t delta_us, int32_t t_us, double dist_cm, double pct){
+    p = put_u32le(p, (uint32_t)delta_us);
+    p = put_u32le(p, (uint32_t)t_us);
+    p = put_f32le(p, dist_cm);
+    return put_f32le(p, pct);
+}
+
+size_t record_format_binary(uint8_t *buf, size_t cap, const export_key_t *k, const hermes_config_t *cfg){
+    if (cap < RECORD_BIN_BYTES) return RECORD_BIN_BYTES;
+
+    uint8_t *p = buf;
+    p = put_u64le(p, k->frame_id);
+    p = put_u64le(p, k->offset);
+    p = put_u16le(p, k->prefix);
+    *p++ = k->device;
+    *p++ = (uint8_t)regmap_check_reserved(cfg->reg);
+    memcpy(p, cfg->reg, 55);
+    p += 55;
+
+    for (int idx = 1; idx <= REGMAP_NUM_REGS; idx++){
+        const reg_desc_t *d = regmap_desc(idx);
+        for (int f = 0; f < d->nfields; f++) *p++ = (uint8_t)regmap_field_value(cfg->reg, d, f);
+    }
+
+    memcpy(p, cfg->tvg.g, HERMES_TVG_GAINS);
+    p += HERMES_TVG_GAINS;
+    for (int n = 0; n < 2; n++){
+        memcpy(p, cfg->th[n].level, HERMES_TH_STAGES);
+        p += HERMES_TH_STAGES;
+    }
+
+    for (int n = 0; n < 2; n++){
+        const hermes_th_t *th = &cfg->th[n];
+        for (int i = 0; i < HERMES_TH_STAGES; i++){
+            p = put_point(p, th->delta_us[i], th->t_us[i], th->dist_cm[i], th->pct[i]);
+        }
+    }
+    const hermes_tvg_t *tvg = &cfg->tvg;
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        p = put_point(p, tvg->delta_us[i], tvg->t_us[i], tvg->dist_cm[i], tvg->gain_pct[i]);
+    }
+
+    return (size_t)(p - buf);
+}
+
+int record_write(FILE *f, record_format_t fmt, const export_key_t *k, const hermes_config_t *cfg){
+    char buf[RECORD_NDJSON_MAX_BYTES];
+    size_t n;
+
+    if (fmt == RECORD_BINARY){
+        n = record_format_binary((uint8_t *)buf, sizeof(buf), k, cfg);
+    } else {
+        n = record_format_ndjson(buf, sizeof(buf), k, cfg);
+        if (n >= sizeof(buf)) return -1;
+    }
+    if (fwrite(buf, 1, n, f) != n) return -1;
+    return ferror(f) ? -1 : 0;
+}
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "utils.h"
+#include "regmap.h"
+
+/* ------------------ descriptor table (from regmap.def) ------------------ */
+#define CFG(member) ((uint16_t)offsetof(hermes_config_t, member))
+#define NOCFG       ((uint16_t)REGMAP_NO_CFG)
+
+#define F(name, lsb, width, xform, flags, dst) { name, lsb, width, xform, flags, dst },
+
+#define REG(idx, name, note, rsv, post, preset, ...)                          \
+    [(idx) - 1] = {                                                           \
+        name, note, idx, rsv, post, preset,                                   \
+        (uint8_t)(sizeof((reg_field_t[]){ __VA_ARGS__ { 0 } }) / sizeof(reg_field_t) - 1), \
+        { __VA_ARGS__ }                                                       \
+    },
+
+static const reg_desc_t REGMAP[REGMAP_NUM_REGS] = {
+#include "regmap.def"
+};
+
+#undef REG
+#undef F
+
+/* REGMAP_NUM_FIELDS fija el layout del registro binario (record.h) */
+#define F(...) + 1
+#define REG(idx, name, note, rsv, post, preset, ...) __VA_ARGS__
+_Static_assert(0
+#include "regmap.def"
+    == REGMAP_NUM_FIELDS, "REGMAP_NUM_FIELDS no coincide con regmap.def");
+
+#undef REG
+#undef F
+#undef NOCFG
+#undef CFG
+
+const reg_desc_t *regmap_desc(int idx){
+    if (idx < 1 || idx > REGMAP_NUM_REGS) return NULL;
+    return &REGMAP[idx - 1];
+}
+
+int regmap_find_reg(const char *name){
+    for (int i = 0; i < REGMAP_NUM_REGS; i++){
+        if (strcmp(REGMAP[i].name, name) == 0) return i + 1;
+    }
+    return -1;
+}
+
+int regmap_find_field(const char *spec, int *reg_idx, int *field){
+    const char *dot = strchr(spec, '.');
+    const char *fname = dot ? dot + 1 : spec;
+    int found = 0;
+
+    for (int i = 0; i < REGMAP_NUM_REGS; i++){
+        const reg_desc_t *d = &REGMAP[i];
+        if (dot && (strncmp(d->name, spec, (size_t)(dot - spec)) != 0 || d->name[dot - spec] != '\0')){
+            continue;
+        }
+        for (int f = 0; f < d->nfields; f++){
+            if (strcmp(d->fields[f].name, fname) != 0) continue;
+            if (found++) return -1; // ambiguo sin "REG."
+            *reg_idx = d->idx;
+            *field = f;
+        }
+    }
+    return found == 1 ? 0 : -1;
+}
+
+/* ------------------ decode / validation ------------------ */
+int regmap_check_reserved(const uint8_t reg[55]){
+    int bad = 0;
+    for (int i = 0; i < REGMAP_NUM_REGS; i++){
+        bad += (reg[i] & REGMAP[i].rsv_mask) != 0;
+    }
+    return bad;
+}
+
+void regmap_decode(const uint8_t reg[55], const int *idx, int n, hermes_config_t *cfg){
+    uint8_t *base = (uint8_t *)cfg;
+
+    for (int k = 0; k < n; k++){
+        const reg_desc_t *d = regmap_desc(idx ? idx[k] : k + 1);
+        if (!d) continue;
+
+        cfg->reg[d->idx - 1] = reg[d->idx - 1];
+        for (int f = 0; f < d->nfields; f++){
+            uint16_t off = d->fields[f].cfg_off;
+            if (off != REGMAP_NO_CFG) base[off] = (uint8_t)regmap_field_value(reg, d, f);
+        }
+    }
+}
+
+void regmap_encode(const hermes_config_t *cfg, uint8_t reg[55]){
+    const uint8_t *base = (const uint8_t *)cfg;
+
+    for (int i = 0; i < REGMAP_NUM_REGS; i++){
+        const reg_desc_t *d = &REGMAP[i];
+        for (int f = 0; f < d->nfields; f++){
+            uint16_t off = d->fields[f].cfg_off;
+            if (off == REGMAP_NO_CFG) continue;
+            unsigned mask = (1u << d->fields[f].width) - 1u;
+            reg[i] = (uint8_t)((reg[i] & ~(mask << d->fields[f].lsb)) | ((base[off] & mask) << d->fields[f].lsb));
+        }
+    }
+}
+
+/* ------------------ printing ------------------ */
+static void print_L1_L8_decoded(FILE *out, const hermes_th_t *th, int is_p2){
+    fprintf(out, "    Decoded %s L1..L8 (5-bit):\n", is_p2 ? "P2" : "P1");
+    for (int i = 0; i < 8; i++){
+        fprintf(out, "      L%d = %2d  (%.2f%%)\n", i + 1, th->level[i], th->pct[i]);
+    }
+}
+
+static void print_field_value(FILE *out, const reg_field_t *fd, unsigned v){
+    if (fd->xform == REG_XF_TIME_US) fprintf(out, "%dus", nibble_to_us((uint8_t)v));
+    else                             fprintf(out, "%u", v);
+}
+
+void regmap_print(FILE *out, const hermes_config_t *cfg, int idx){
+    const reg_desc_t *d = regmap_desc(idx);
+    if (!d) return;
+
+    uint8_t b = cfg->reg[idx - 1];
+    char name[24];
+    snprintf(name, sizeof(name), "%s:", d->name);
+
+    fprintf(out, "  %-15s0x%02X | %s", name, b, d->note);
+
+    int warn = 0;
+    const char *sep = "";
+    for (int f = 0; f < d->nfields; f++){
+        const reg_field_t *fd = &d->fields[f];
+        if (fd->flags & REG_FF_HIDDEN) continue;
+
+        unsigned v = regmap_field_value(cfg->reg, d, f);
+        fprintf(out, "%s%s=", sep, fd->name);
+        print_field_value(out, fd, v);
+        sep = " ";
+        warn |= (fd->flags & REG_FF_RESERVED) && v != 0;
+    }
+    fputc('\n', out);
+
+    if (warn) fprintf(out, "    WARNING: RESERVED bit is not 0\n");
+    if (d->post == REG_POST_TH_L1_L8) print_L1_L8_decoded(out, &cfg->th[d->preset], d->preset);
+}
+
+void regmap_print_diff(FILE *out, const uint8_t old_reg[55], const hermes_config_t *cfg, int idx){
+    const reg_desc_t *d = regmap_desc(idx);
+    if (!d) return;
+
+    uint8_t a = old_reg[idx - 1], b = cfg->reg[idx - 1];
+    char name[24];
+    snprintf(name, sizeof(name), "%s:", d->name);
+
+    fprintf(out, "  %-15s0x%02X -> 0x%02X | %s", name, a, b, d->note);
+
+    int warn = 0;
+    const char *sep = "";
+    for (int f = 0; f < d->nfields; f++){
+        const reg_field_t *fd = &d->fields[f];
+        if (fd->flags & REG_FF_HIDDEN) continue;
+
+        unsigned va = regmap_field_value(old_reg, d, f);
+        unsigned vb = regmap_field_value(cfg->reg, d, f);
+        warn |= (fd->flags & REG_FF_RESERVED) && vb != 0;
+        if (va == vb) continue;
+
+        fprintf(out, "%s%s=", sep, fd->name);
+        print_field_value(out, fd, va);
+        fputs("->", out);
+        print_field_value(out, fd, vb);
+        sep = " ";
+    }
+    fputc('\n', out);
+
+    if (warn) fprintf(out, "    WARNING: RESERVED bit is not 0\n");
+}
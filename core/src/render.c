@@ -0,0 +1,602 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "render.h"
+
+/* ------------------ chart model (comun a SVG y PNG) ------------------ */
+#define R_W   800
+#define R_H   480
+#define R_X0  70            // area de dibujo
+#define R_X1  (R_W - 130)   // a la derecha va la leyenda
+#define R_Y0  50
+#define R_Y1  (R_H - 50)
+
+#define R_MAX_PTS 16
+
+/* Paleta (indices del PNG y colores del SVG) */
+enum { C_WHITE = 0, C_BLACK, C_GRID, C_P1, C_P2, C_TVG, C_NUM };
+static const uint32_t PALETTE[C_NUM] = {
+    0xFFFFFF, 0x000000, 0xDDDDDD, 0x1F77B4, 0xD62728, 0x9400D3
+};
+
+enum { MK_CIRCLE = 0, MK_SQUARE };
+
+typedef struct {
+    const char *name;
+    uint8_t line_c, mark_c, marker;
+    uint8_t step;             // escalones (TVG) en vez de segmentos
+    int n;
+    int first_mark;           // primer punto con marcador
+    double x[R_MAX_PTS], y[R_MAX_PTS];
+} series_t;
+
+typedef struct {
+    const char *title, *xlabel, *ylabel;
+    double xmax, ymax, xstep, ystep;
+    int nseries;
+    series_t s[2];
+} chart_t;
+
+/* Paso "bonito" (1/2/5 x 10^k) para ~target divisiones */
+static double nice_step(double range, int target){
+    double raw = range / target, p = 1.0;
+    while (p * 10.0 <= raw) p *= 10.0;
+    while (p > raw) p /= 10.0;
+
+    double m = raw / p;
+    return (m < 1.5 ? 1.0 : m < 3.0 ? 2.0 : m < 7.0 ? 5.0 : 10.0) * p;
+}
+
+static void chart_axes(chart_t *c){
+    double xmax = 0.0;
+    for (int k = 0; k < c->nseries; k++){
+        for (int i = 0; i < c->s[k].n; i++){
+            if (c->s[k].x[i] > xmax) xmax = c->s[k].x[i];
+        }
+    }
+    if (xmax <= 0.0) xmax = 1.0;
+
+    c->xstep = nice_step(xmax * 1.05, 8);
+    c->xmax = c->xstep * (double)(long)(xmax * 1.05 / c->xstep + 0.999);
+    c->ymax = 100.0;
+    c->ystep = nice_step(c->ymax, 5);
+}
+
+static void chart_th(chart_t *c, const hermes_config_t *cfg){
+    memset(c, 0, sizeof(*c));
+    c->title  = "Perfil de sensibilidad P1 vs P2";
+    c->xlabel = "Distancia (cm)";
+    c->ylabel = "Sensibilidad (%)";
+    c->nseries = 2;
+
+    for (int k = 0; k < 2; k++){
+        series_t *s = &c->s[k];
+        s->name = k ? "P2" : "P1";
+        s->line_c = s->mark_c = k ? C_P2 : C_P1;
+        s->marker = k ? MK_SQUARE : MK_CIRCLE;
+        s->n = HERMES_TH_STAGES;
+        for (int i = 0; i < HERMES_TH_STAGES; i++){
+            s->x[i] = cfg->th[k].dist_cm[i];
+            s->y[i] = cfg->th[k].pct[i];
+        }
+    }
+    chart_axes(c);
+}
+
+static void chart_tvg(chart_t *c, const hermes_config_t *cfg){
+    memset(c, 0, sizeof(*c));
+    c->title  = "TVG: Ganancia vs Distancia";
+    c->xlabel = "Distancia (cm)";
+    c->ylabel = "Ganancia (%)";
+    c->nseries = 1;
+
+    /* Como plot_tvg(): escalon desde x=0 con la ganancia del primer tramo */
+    series_t *s = &c->s[0];
+    s->name = "TVG";
+    s->line_c = C_TVG;
+    s->mark_c = C_BLACK;
+    s->marker = MK_CIRCLE;
+    s->step = 1;
+    s->first_mark = 1;
+    s->n = HERMES_TVG_STAGES + 1;
+    s->x[0] = 0.0;
+    s->y[0] = cfg->tvg.gain_pct[0];
+    for (int i = 0; i < HERMES_TVG_STAGES; i++){
+        s->x[i + 1] = cfg->tvg.dist_cm[i];
+        s->y[i + 1] = cfg->tvg.gain_pct[i];
+    }
+    chart_axes(c);
+}
+
+static double sx(const chart_t *c, double x){ return R_X0 + x / c->xmax * (R_X1 - R_X0); }
+static double sy(const chart_t *c, double y){ return R_Y1 - y / c->ymax * (R_Y1 - R_Y0); }
+
+/* Polilinea en pixeles (los escalones se expanden). Devuelve n puntos. */
+static int series_path(const chart_t *c, const series_t *s, double px[], double py[]){
+    int n = 0;
+    for (int i = 0; i < s->n; i++){
+        if (s->step && i > 0){
+            px[n] = sx(c, s->x[i]);
+            py[n] = sy(c, s->y[i - 1]);
+            n++;
+        }
+        px[n] = sx(c, s->x[i]);
+        py[n] = sy(c, s->y[i]);
+        n++;
+    }
+    return n;
+}
+
+static void fmt_tick(char *buf, size_t cap, double v){
+    snprintf(buf, cap, "%g", v);
+}
+
+/* ------------------ SVG ------------------ */
+static int svg_chart(FILE *f, const chart_t *c){
+    char t[32];
+    double px[2 * R_MAX_PTS], py[2 * R_MAX_PTS];
+
+    fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" "
+               "viewBox=\"0 0 %d %d\" font-family=\"sans-serif\" font-size=\"12\">\n",
+            R_W, R_H, R_W, R_H);
+    fprintf(f, "<rect width=\"%d\" height=\"%d\" fill=\"#%06X\"/>\n", R_W, R_H, PALETTE[C_WHITE]);
+
+    /* Rejilla + etiquetas de los ejes */
+    fprintf(f, "<g stroke=\"#%06X\">\n", PALETTE[C_GRID]);
+    for (double x = c->xstep; x <= c->xmax + 1e-9; x += c->xstep){
+        fprintf(f, "<line x1=\"%.1f\" y1=\"%d\" x2=\"%.1f\" y2=\"%d\"/>\n", sx(c, x), R_Y0, sx(c, x), R_Y1);
+    }
+    for (double y = c->ystep; y <= c->ymax + 1e-9; y += c->ystep){
+        fprintf(f, "<line x1=\"%d\" y1=\"%.1f\" x2=\"%d\" y2=\"%.1f\"/>\n", R_X0, sy(c, y), R_X1, sy(c, y));
+    }
+    fprintf(f, "</g>\n");
+    fprintf(f, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"none\" stroke=\"#%06X\"/>\n",
+            R_X0, R_Y0, R_X1 - R_X0, R_Y1 - R_Y0, PALETTE[C_BLACK]);
+
+    fprintf(f, "<g text-anchor=\"middle\">\n");
+    for (double x = 0.0; x <= c->xmax + 1e-9; x += c->xstep){
+        fmt_tick(t, sizeof(t), x);
+        fprintf(f, "<text x=\"%.1f\" y=\"%d\">%s</text>\n", sx(c, x), R_Y1 + 18, t);
+    }
+    fprintf(f, "</g>\n<g text-anchor=\"end\">\n");
+    for (double y = 0.0; y <= c->ymax + 1e-9; y += c->ystep){
+        fmt_tick(t, sizeof(t), y);
+        fprintf(f, "<text x=\"%d\" y=\"%.1f\">%s</text>\n", R_X0 - 6, sy(c, y) + 4, t);
+    }
+    fprintf(f, "</g>\n");
+
+    fprintf(f, "<text x=\"%d\" y=\"28\" text-anchor=\"middle\" font-size=\"16\">%s</text>\n",
+            (R_X0 + R_X1) / 2, c->title);
+    fprintf(f, "<text x=\"%d\" y=\"%d\" text-anchor=\"middle\">%s</text>\n",
+            (R_X0 + R_X1) / 2, R_H - 12, c->xlabel);
+    fprintf(f, "<text transform=\"translate(18 %d) rotate(-90)\" text-anchor=\"middle\">%s</text>\n",
+            (R_Y0 + R_Y1) / 2, c->ylabel);
+
+    /* Curvas, marcadores y leyenda */
+    for (int k = 0; k < c->nseries; k++){
+        const series_t *s = &c->s[k];
+        int n = series_path(c, s, px, py);
+
+        fprintf(f, "<polyline fill=\"none\" stroke=\"#%06X\" stroke-width=\"2\" points=\"", PALETTE[s->line_c]);
+        for (int i = 0; i < n; i++) fprintf(f, "%s%.1f,%.1f", i ? " " : "", px[i], py[i]);
+        fprintf(f, "\"/>\n");
+
+        fprintf(f, "<g fill=\"#%06X\">\n", PALETTE[s->mark_c]);
+        for (int i = s->first_mark; i < s->n; i++){
+            double x = sx(c, s->x[i]), y = sy(c, s->y[i]);
+            if (s->marker == MK_SQUARE){
+                fprintf(f, "<rect x=\"%.1f\" y=\"%.1f\" width=\"8\" height=\"8\"/>\n", x - 4, y - 4);
+            } else {
+                fprintf(f, "<circle cx=\"%.1f\" cy=\"%.1f\" r=\"4\"/>\n", x, y);
+            }
+        }
+        fprintf(f, "</g>\n");
+
+        int ly = R_Y0 + 10 + 22 * k;
+        fprintf(f, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"#%06X\" stroke-width=\"2\"/>\n",
+                R_X1 + 15, ly, R_X1 + 45, ly, PALETTE[s->line_c]);
+        fprintf(f, "<text x=\"%d\" y=\"%d\">%s</text>\n", R_X1 + 52, ly + 4, s->name);
+    }
+
+    fprintf(f, "</svg>\n");
+    return ferror(f) ? -1 : 0;
+}
+
+/* ------------------ PNG: raster ------------------ */
+/* Fuente 5x7 (columnas, bit 0 arriba) para ' '..'_'; minusculas -> mayusculas */
+static const uint8_t FONT5X7[64][5] = {
+    {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+    {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x56,0x20,0x50}, {0x00,0x05,0x03,0x00,0x00},
+    {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x2A,0x1C,0x7F,0x1C,0x2A}, {0x08,0x08,0x3E,0x08,0x08},
+    {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+    {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+    {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+    {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+    {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+    {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+    {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A},
+    {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+    {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+    {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+    {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+    {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+    {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+};
+
+typedef struct {
+    uint8_t px[R_W * R_H];    // indice de paleta
+} canvas_t;
+
+static inline void cv_dot(canvas_t *cv, int x, int y, uint8_t c){
+    if ((unsigned)x < R_W && (unsigned)y < R_H) cv->px[y * R_W + x] = c;
+}
+
+static void cv_rect(canvas_t *cv, int x0, int y0, int x1, int y1, uint8_t c){
+    for (int y = y0; y <= y1; y++){
+        for (int x = x0; x <= x1; x++) cv_dot(cv, x, y, c);
+    }
+}
+
+/* Bresenham con pincel cuadrado de lado w */
+static void cv_line(canvas_t *cv, double fx0, double fy0, double fx1, double fy1, uint8_t c, int w){
+    int x0 = (int)(fx0 + 0.5), y0 = (int)(fy0 + 0.5);
+    int x1 = (int)(fx1 + 0.5), y1 = (int)(fy1 + 0.5);
+    int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+    int stx = x0 < x1 ? 1 : -1, sty = y0 < y1 ? 1 : -1;
+    int err = dx + dy, lo = -(w - 1) / 2, hi = w / 2;
+
+    for (;;){
+        cv_rect(cv, x0 + lo, y0 + lo, x0 + hi, y0 + hi, c);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy){ err += dy; x0 += stx; }
+        if (e2 <= dx){ err += dx; y0 += sty; }
+    }
+}
+
+static void cv_disk(canvas_t *cv, double fx, double fy, int r, uint8_t c){
+    int cx = (int)(fx + 0.5), cy = (int)(fy + 0.5);
+    for (int y = -r; y <= r; y++){
+        for (int x = -r; x <= r; x++){
+            if (x * x + y * y <= r * r) cv_dot(cv, cx + x, cy + y, c);
+        }
+    }
+}
+
+static const uint8_t *glyph(char ch){
+    if (ch >= 'a' && ch <= 'z') ch = (char)(ch - 'a' + 'A');
+    if (ch < ' ' || ch > '_') ch = ' ';
+    return FONT5X7[ch - ' '];
+}
+
+static int text_width(const char *s, int scale){
+    int n = (int)strlen(s);
+    return n ? (n * 6 - 1) * scale : 0;
+}
+
+/* anchor: 0 = izquierda, 1 = centro, 2 = derecha; y = linea superior */
+static void cv_text(canvas_t *cv, int x, int y, const char *s, uint8_t c, int scale, int anchor){
+    x -= anchor * text_width(s, scale) / 2;
+    for (; *s; s++, x += 6 * scale){
+        const uint8_t *g = glyph(*s);
+        for (int col = 0; col < 5; col++){
+            for (int row = 0; row < 7; row++){
+                if (!(g[col] >> row & 1)) continue;
+                cv_rect(cv, x + col * scale, y + row * scale,
+                        x + col * scale + scale - 1, y + row * scale + scale - 1, c);
+            }
+        }
+    }
+}
+
+/* Texto girado -90 grados (de abajo a arriba), centrado en (x, y) */
+static void cv_text_up(canvas_t *cv, int x, int y, const char *s, uint8_t c){
+    y += text_width(s, 1) / 2;
+    for (; *s; s++, y -= 6){
+        const uint8_t *g = glyph(*s);
+        for (int col = 0; col < 5; col++){
+            for (int row = 0; row < 7; row++){
+                if (g[col] >> row & 1) cv_dot(cv, x + row, y - col, c);
+            }
+        }
+    }
+}
+
+static void cv_chart(canvas_t *cv, const chart_t *c){
+    char t[32];
+    double px[2 * R_MAX_PTS], py[2 * R_MAX_PTS];
+
+    memset(cv->px, C_WHITE, sizeof(cv->px));
+
+    for (double x = c->xstep; x <= c->xmax + 1e-9; x += c->xstep){
+        cv_line(cv, sx(c, x), R_Y0, sx(c, x), R_Y1, C_GRID, 1);
+    }
+    for (double y = c->ystep; y <= c->ymax + 1e-9; y += c->ystep){
+        cv_line(cv, R_X0, sy(c, y), R_X1, sy(c, y), C_GRID, 1);
+    }
+    cv_line(cv, R_X0, R_Y0, R_X1, R_Y0, C_BLACK, 1);
+    cv_line(cv, R_X0, R_Y1, R_X1, R_Y1, C_BLACK, 1);
+    cv_line(cv, R_X0, R_Y0, R_X0, R_Y1, C_BLACK, 1);
+    cv_line(cv, R_X1, R_Y0, R_X1, R_Y1, C_BLACK, 1);
+
+    for (double x = 0.0; x <= c->xmax + 1e-9; x += c->xstep){
+        fmt_tick(t, sizeof(t), x);
+        cv_text(cv, (int)(sx(c, x) + 0.5), R_Y1 + 8, t, C_BLACK, 1, 1);
+    }
+    for (double y = 0.0; y <= c->ymax + 1e-9; y += c->ystep){
+        fmt_tick(t, sizeof(t), y);
+        cv_text(cv, R_X0 - 6, (int)(sy(c, y) + 0.5) - 3, t, C_BLACK, 1, 2);
+    }
+
+    cv_text(cv, (R_X0 + R_X1) / 2, 14, c->title, C_BLACK, 2, 1);
+    cv_text(cv, (R_X0 + R_X1) / 2, R_H - 20, c->xlabel, C_BLACK, 1, 1);
+    cv_text_up(cv, 12, (R_Y0 + R_Y1) / 2, c->ylabel, C_BLACK);
+
+    for (int k = 0; k < c->nseries; k++){
+        const series_t *s = &c->s[k];
+        int n = series_path(c, s, px, py);
+
+        for (int i = 1; i < n; i++) cv_line(cv, px[i - 1], py[i - 1], px[i], py[i], s->line_c, 2);
+        for (int i = s->first_mark; i < s->n; i++){
+            double x = sx(c, s->x[i]), y = sy(c, s->y[i]);
+            if (s->marker == MK_SQUARE) cv_rect(cv, (int)x - 4, (int)y - 4, (int)x + 4, (int)y + 4, s->mark_c);
+            else                        cv_disk(cv, x, y, 4, s->mark_c);
+        }
+
+        int ly = R_Y0 + 10 + 22 * k;
+        cv_line(cv, R_X1 + 15, ly, R_X1 + 45, ly, s->line_c, 2);
+        cv_text(cv, R_X1 + 52, ly - 3, s->name, C_BLACK, 1, 0);
+    }
+}
+
+/* ------------------ PNG: codificacion ------------------
+ * Paleta de 8 bits, filtro Up en todas las filas y deflate con Huffman fijo
+ * usando solo coincidencias de distancia 1: el fondo y las filas repetidas
+ * (que el filtro Up deja a cero) se quedan en unos pocos KB.
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t len, cap;
+    uint32_t acc;
+    int nbits;
+    int err;
+} bitw_t;
+
+static void bw_byte(bitw_t *w, uint8_t b){
+    if (w->len == w->cap){
+        size_t ncap = w->cap ? w->cap * 2 : 16384;
+        uint8_t *p = realloc(w->buf, ncap);
+        if (!p){
+            w->err = 1;
+            return;
+        }
+        w->buf = p;
+        w->cap = ncap;
+    }
+    w->buf[w->len++] = b;
+}
+
+/* n bits de v, LSB primero (orden de deflate) */
+static void bw_put(bitw_t *w, uint32_t v, int n){
+    w->acc |= v << w->nbits;
+    w->nbits += n;
+    while (w->nbits >= 8){
+        bw_byte(w, (uint8_t)w->acc);
+        w->acc >>= 8;
+        w->nbits -= 8;
+    }
+}
+
+/* Codigo Huffman: se emite MSB primero */
+static void bw_huff(bitw_t *w, uint32_t code, int n){
+    uint32_t rev = 0;
+    for (int i = 0; i < n; i++) rev |= ((code >> i) & 1u) << (n - 1 - i);
+    bw_put(w, rev, n);
+}
+
+static void bw_flush(bitw_t *w){
+    if (w->nbits > 0) bw_byte(w, (uint8_t)w->acc);
+    w->acc = 0;
+    w->nbits = 0;
+}
+
+static void put_sym(bitw_t *w, int sym){
+    if (sym < 144)      bw_huff(w, 0x30u + sym, 8);
+    else if (sym < 256) bw_huff(w, 0x190u + (sym - 144), 9);
+    else if (sym < 280) bw_huff(w, (uint32_t)(sym - 256), 7);
+    else                bw_huff(w, 0xC0u + (sym - 280), 8);
+}
+
+static const uint16_t LEN_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LEN_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/* Coincidencia de longitud len (3..258) a distancia 1 */
+static void put_run(bitw_t *w, int len){
+    int i = 28;
+    while (LEN_BASE[i] > len) i--;
+    put_sym(w, 257 + i);
+    bw_put(w, (uint32_t)(len - LEN_BASE[i]), LEN_EXTRA[i]);
+    bw_huff(w, 0, 5);   // codigo de distancia 0 = distancia 1
+}
+
+static void zlib_compress(bitw_t *w, const uint8_t *d, size_t n){
+    uint64_t a = 1, b = 0;    // Adler-32, actualizado por rachas
+
+    bw_byte(w, 0x78);
+    bw_byte(w, 0x01);
+    bw_put(w, 1, 1);    // BFINAL
+    bw_put(w, 1, 2);    // BTYPE = 01 (Huffman fijo)
+
+    for (size_t i = 0; i < n; ){
+        uint8_t v = d[i];
+        uint64_t pat = 0x0101010101010101ull * v;
+        size_t j = i + 1;
+        for (uint64_t x; j + 8 <= n; j += 8){
+            memcpy(&x, d + j, 8);
+            if (x != pat) break;
+        }
+        while (j < n && d[j] == v) j++;
+
+        uint64_t run = j - i;
+        b = (b + run * a + v * run * (run + 1) / 2) % 65521u;
+        a = (a + v * run) % 65521u;
+        i = j;
+
+        put_sym(w, v);
+        size_t rem = run - 1;
+        while (rem >= 3){
+            int len = rem > 258 ? 258 : (int)rem;
+            put_run(w, len);
+            rem -= (size_t)len;
+        }
+        while (rem--) put_sym(w, v);
+    }
+    put_sym(w, 256);
+    bw_flush(w);
+
+    uint32_t adler = (uint32_t)((b << 16) | a);
+    for (int s = 24; s >= 0; s -= 8) bw_byte(w, (uint8_t)(adler >> s));
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n){
+    static const uint32_t T[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    for (size_t i = 0; i < n; i++){
+        crc ^= p[i];
+        crc = (crc >> 4) ^ T[crc & 15];
+        crc = (crc >> 4) ^ T[crc & 15];
+    }
+    return crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, size_t n){
+    uint8_t hdr[8];
+    put_be32(hdr, (uint32_t)n);
+    memcpy(hdr + 4, type, 4);
+
+    uint32_t crc = crc32_update(0xFFFFFFFFu, hdr + 4, 4);
+    crc = crc32_update(crc, data, n) ^ 0xFFFFFFFFu;
+
+    uint8_t tail[4];
+    put_be32(tail, crc);
+    fwrite(hdr, 1, 8, f);
+    if (n) fwrite(data, 1, n, f);
+    fwrite(tail, 1, 4, f);
+}
+
+static int png_write(FILE *f, const canvas_t *cv){
+    static const uint8_t SIG[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    const size_t stride = R_W + 1;
+
+    uint8_t *raw = malloc(stride * R_H);
+    if (!raw) return -1;
+
+    /* Filtro Up (2): la fila 0 se compara con una fila previa de ceros */
+    for (int y = 0; y < R_H; y++){
+        uint8_t *row = raw + (size_t)y * stride;
+        const uint8_t *cur = cv->px + (size_t)y * R_W;
+        row[0] = 2;
+        if (y == 0){
+            memcpy(row + 1, cur, R_W);
+        } else if (memcmp(cur, cur - R_W, R_W) == 0){
+            memset(row + 1, 0, R_W);
+        } else {
+            const uint8_t *prev = cur - R_W;
+            for (int x = 0; x < R_W; x++) row[1 + x] = (uint8_t)(cur[x] - prev[x]);
+        }
+    }
+
+    bitw_t w = {0};
+    zlib_compress(&w, raw, stride * R_H);
+    free(raw);
+    if (w.err){
+        free(w.buf);
+        return -1;
+    }
+
+    uint8_t ihdr[13];
+    put_be32(ihdr, R_W);
+    put_be32(ihdr + 4, R_H);
+    ihdr[8] = 8;        // bits por indice
+    ihdr[9] = 3;        // paleta
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+
+    uint8_t plte[3 * C_NUM];
+    for (int i = 0; i < C_NUM; i++){
+        plte[3 * i]     = (uint8_t)(PALETTE[i] >> 16);
+        plte[3 * i + 1] = (uint8_t)(PALETTE[i] >> 8);
+        plte[3 * i + 2] = (uint8_t)PALETTE[i];
+    }
+
+    fwrite(SIG, 1, sizeof(SIG), f);
+    png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    png_chunk(f, "PLTE", plte, sizeof(plte));
+    png_chunk(f, "IDAT", w.buf, w.len);
+    png_chunk(f, "IEND", NULL, 0);
+    free(w.buf);
+
+    return ferror(f) ? -1 : 0;
+}
+
+static int png_chart(FILE *f, const chart_t *c){
+    canvas_t *cv = malloc(sizeof(*cv));
+    if (!cv) return -1;
+
+    cv_chart(cv, c);
+    int rc = png_write(f, cv);
+    free(cv);
+    return rc;
+}
+
+/* ------------------ API ------------------ */
+static int render_chart(FILE *f, const chart_t *c, render_fmt_t fmt){
+    switch (fmt){
+        case RENDER_SVG: return svg_chart(f, c);
+        case RENDER_PNG: return png_chart(f, c);
+        default:         return -1;
+    }
+}
+
+int render_th(FILE *f, const hermes_config_t *cfg, render_fmt_t fmt){
+    chart_t c;
+    chart_th(&c, cfg);
+    return render_chart(f, &c, fmt);
+}
+
+int render_tvg(FILE *f, const hermes_config_t *cfg, render_fmt_t fmt){
+    chart_t c;
+    chart_tvg(&c, cfg);
+    return render_chart(f, &c, fmt);
+}
+
+int write_th_plot(const char *path, const hermes_config_t *cfg, render_fmt_t fmt){
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    int rc = render_th(f, cfg, fmt);
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+int write_tvg_plot(const char *path, const hermes_config_t *cfg, render_fmt_t fmt){
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    int rc = render_tvg(f, cfg, fmt);
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "ring.h"
+
+int ring_init(ring_t *r, size_t capacity){
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+
+    r->cells = malloc(cap * sizeof(ring_cell_t));
+    if (!r->cells) return -1;
+    for (size_t i = 0; i < cap; i++){
+        atomic_init(&r->cells[i].seq, i);
+        r->cells[i].data = NULL;
+    }
+    r->mask = cap - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    return 0;
+}
+
+void ring_free(ring_t *r){
+    free(r->cells);
+    r->cells = NULL;
+}
+
+int ring_push(ring_t *r, void *item){
+    size_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    for (;;){
+        ring_cell_t *c = &r->cells[pos & r->mask];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if (dif == 0){
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)){
+                c->data = item;
+                atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+                return 0;
+            }
+        } else if (dif < 0){
+            return -1; // llena
+        } else {
+            pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        }
+    }
+}
+
+int ring_pop(ring_t *r, void **item){
+    size_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    for (;;){
+        ring_cell_t *c = &r->cells[pos & r->mask];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (dif == 0){
+            if (atomic_compare_exchange_weak_explicit(&r->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)){
+                *item = c->data;
+                atomic_store_explicit(&c->seq, pos + r->mask + 1, memory_order_release);
+                return 0;
+            }
+        } else if (dif < 0){
+            return -1; // vacia
+        } else {
+            pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        }
+    }
+}
+
+size_t ring_depth(ring_t *r){
+    size_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    return (h > t) ? h - t : 0;
+}
+
+/* ------------------ espera ------------------ */
+void ring_event_init(ring_event_t *ev){
+    atomic_init(&ev->gen, 0);
+    atomic_init(&ev->sleepers, 0);
+    pthread_mutex_init(&ev->mu, NULL);
+    pthread_cond_init(&ev->cv, NULL);
+}
+
+void ring_event_destroy(ring_event_t *ev){
+    pthread_mutex_destroy(&ev->mu);
+    pthread_cond_destroy(&ev->cv);
+}
+
+unsigned ring_event_gen(ring_event_t *ev){
+    return atomic_load_explicit(&ev->gen, memory_order_acquire);
+}
+
+void ring_wait(ring_event_t *ev, unsigned gen, unsigned *spins){
+    unsigned n = (*spins)++;
+    if (n < 64){
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+        return;
+    }
+    if (n < 128){
+        sched_yield();
+        return;
+    }
+
+    /* Con sleepers visible antes de releer gen, un notify posterior a la
+     * comprobacion del llamante ve que hay alguien y despierta (Dekker). */
+    atomic_fetch_add(&ev->sleepers, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ev->gen, memory_order_relaxed) == gen){
+        pthread_mutex_lock(&ev->mu);
+        while (atomic_load_explicit(&ev->gen, memory_order_relaxed) == gen) pthread_cond_wait(&ev->cv, &ev->mu);
+        pthread_mutex_unlock(&ev->mu);
+    }
+    atomic_fetch_sub(&ev->sleepers, 1);
+}
+
+void ring_notify(ring_event_t *ev){
+    atomic_fetch_add_explicit(&ev->gen, 1, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ev->sleepers, memory_order_relaxed) == 0) return;
+    pthread_mutex_lock(&ev->mu);
+    pthread_cond_broadcast(&ev->cv);
+    pthread_mutex_unlock(&ev->mu);
+}
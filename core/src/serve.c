@@ -0,0 +1,461 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "serve.h"
+#include "hermes.h"
+#include "export.h"
+#include "outbuf.h"
+
+#define SERVE_EVENTS     64
+#define SERVE_READ_CHUNK (64u << 10)
+#define SERVE_MAX_IN     (1u << 20)   // lectura maxima por evento (reparto entre clientes)
+#define SERVE_MAX_OUT    (4u << 20)   // pendiente de enviar: se deja de leer hasta vaciar
+#define SERVE_ERR_BYTES  256
+
+typedef struct conn {
+    int fd;
+    uint64_t seq;         // peticiones respondidas (frame_id)
+    uint64_t consumed;    // bytes de entrada ya procesados (offset)
+    char  *in;
+    size_t in_len, in_cap;
+    char  *out;
+    size_t out_len, out_off, out_cap;
+    uint32_t events;      // mascara registrada en epoll
+    int eof;              // el cliente cerro su extremo de escritura
+    int closing;          // error de protocolo: cerrar tras vaciar out
+    struct conn *prev, *next;
+} conn_t;
+
+typedef struct {
+    unsigned long long conns, requests, errors;
+} serve_stats_t;
+
+typedef struct {
+    int listen_fd;
+    int stop_fd;
+    int ep;
+    conn_t *conns;        // lista de conexiones abiertas de este hilo
+    serve_stats_t st;
+} worker_t;
+
+/* Marcas de epoll para los descriptores que no son conexiones */
+static char TAG_LISTEN, TAG_STOP;
+
+static int g_stop_fd = -1;
+
+static void on_signal(int sig){
+    (void)sig;
+    uint64_t one = 1;
+    ssize_t r = write(g_stop_fd, &one, sizeof(one));
+    (void)r;
+}
+
+/* ------------------ buffers ------------------ */
+static int reserve(char **buf, size_t *cap, size_t len, size_t extra){
+    if (len + extra <= *cap) return 0;
+    size_t ncap = *cap ? *cap : SERVE_READ_CHUNK;
+    while (ncap < len + extra) ncap *= 2;
+    char *p = realloc(*buf, ncap);
+    if (!p) return -1;
+    *buf = p;
+    *cap = ncap;
+    return 0;
+}
+
+static size_t put_points(uint8_t *p, const hermes_point_t *pts, int n){
+    for (int i = 0; i < n; i++){
+        put_u32le(p + 12 * i, (uint32_t)pts[i].t_us);
+        put_f32le(p + 12 * i + 4, pts[i].dist_cm);
+        put_f32le(p + 12 * i + 8, pts[i].value_pct);
+    }
+    return (size_t)n * 12;
+}
+
+/* Resultado binario descrito en serve.h */
+static size_t bin_result(uint8_t *p, const hermes_decoded_t *d){
+    hermes_point_t pts[HERMES_TVG_POINTS > HERMES_TH_POINTS ? HERMES_TVG_POINTS : HERMES_TH_POINTS];
+    size_t n = 0;
+
+    p[n++] = (uint8_t)d->prefix;
+    p[n++] = (uint8_t)(d->prefix >> 8);
+    p[n++] = (uint8_t)(d->reserved_bad > 255 ? 255 : d->reserved_bad);
+    memcpy(p + n, d->cfg.reg, sizeof(d->cfg.reg));
+    n += sizeof(d->cfg.reg);
+
+    for (int k = 0; k < 2; k++){
+        hermes_th_curve(&d->cfg, k, pts, HERMES_TH_POINTS);
+        n += put_points(p + n, pts, HERMES_TH_POINTS);
+    }
+    hermes_tvg_curve(&d->cfg, pts, HERMES_TVG_POINTS);
+    n += put_points(p + n, pts, HERMES_TVG_POINTS);
+    return n;
+}
+
+static size_t json_result(char *p, size_t cap, const conn_t *c, uint64_t offset, const hermes_decoded_t *d){
+    export_key_t k = {
+        .frame_id = c->seq,
+        .offset   = offset,
+        .prefix   = d->prefix,
+        .device   = d->cfg.uart_addr,
+    };
+    return format_frame_json(p, cap, &k, &d->cfg);
+}
+
+/* ------------------ peticiones ------------------ */
+static int handle_line(worker_t *w, conn_t *c, const char *line, size_t len, uint64_t offset){
+    while (len && (line[len - 1] == '\r' || line[len - 1] == ' ' || line[len - 1] == '\t')) len--;
+    size_t skip = 0;
+    while (skip < len && (line[skip] == ' ' || line[skip] == '\t')) skip++;
+    if (skip == len) return 0;
+
+    if (reserve(&c->out, &c->out_cap, c->out_len, EXPORT_FRAME_MAX_BYTES) != 0) return -1;
+
+    hermes_decoded_t d;
+    int rc = hermes_decode_hex(line, len, &d);
+    char *p = c->out + c->out_len;
+    size_t cap = c->out_cap - c->out_len;
+
+    c->seq++;
+    w->st.requests++;
+    if (rc == HERMES_OK){
+        c->out_len += json_result(p, cap, c, offset, &d);
+    } else {
+        w->st.errors++;
+        c->out_len += (size_t)snprintf(p, cap, "{\"frame_id\": %llu, \"offset\": %llu, \"error\": \"%s\"}\n",
+                                       (unsigned long long)c->seq, (unsigned long long)offset,
+                                       hermes_strerror(rc));
+    }
+    return 0;
+}
+
+static int handle_bin(worker_t *w, conn_t *c, uint8_t flags, const uint8_t *payload, size_t len, uint64_t offset){
+    if (reserve(&c->out, &c->out_cap, c->out_len, 4 + EXPORT_FRAME_MAX_BYTES) != 0) return -1;
+
+    hermes_decoded_t d;
+    int rc;
+    if (flags & ~(SERVE_REQ_HEX | SERVE_REQ_JSON)){
+        rc = HERMES_ERR_ARG;
+    } else if (flags & SERVE_REQ_HEX){
+        rc = hermes_decode_hex((const char *)payload, len, &d);
+    } else {
+        rc = hermes_decode_bytes(payload, len, &d);
+    }
+
+    uint8_t *h = (uint8_t *)c->out + c->out_len;
+    char *body = (char *)h + 4;
+    size_t cap = c->out_cap - c->out_len - 4;
+    size_t n;
+
+    c->seq++;
+    w->st.requests++;
+    if (rc == HERMES_OK){
+        n = (flags & SERVE_REQ_JSON) ? json_result(body, cap, c, offset, &d)
+                                     : bin_result((uint8_t *)body, &d);
+    } else {
+        w->st.errors++;
+        n = (size_t)snprintf(body, cap, "%s", hermes_strerror(rc));
+    }
+
+    h[0] = 0x00;
+    h[1] = (uint8_t)(-rc);
+    h[2] = (uint8_t)(n >> 8);
+    h[3] = (uint8_t)n;
+    c->out_len += 4 + n;
+    return 0;
+}
+
+/* Atiende todas las peticiones completas de c->in; deja el resto */
+static int conn_process(worker_t *w, conn_t *c){
+    const uint8_t *in = (const uint8_t *)c->in;
+    size_t pos = 0;
+
+    while (pos < c->in_len && !c->closing){
+        size_t avail = c->in_len - pos;
+        uint64_t offset = c->consumed + pos;
+
+        if (in[pos] == 0x00){
+            if (avail < 4) break;
+            size_t len = ((size_t)in[pos + 2] << 8) | in[pos + 3];
+            if (avail < 4 + len) break;
+            if (handle_bin(w, c, in[pos + 1], in + pos + 4, len, offset) != 0) return -1;
+            pos += 4 + len;
+        } else {
+            const uint8_t *nl = memchr(in + pos, '\n', avail);
+            size_t len = nl ? (size_t)(nl - (in + pos)) : avail;
+            if (!nl && !c->eof){
+                if (avail > SERVE_MAX_LINE){
+                    if (reserve(&c->out, &c->out_cap, c->out_len, SERVE_ERR_BYTES) != 0) return -1;
+                    c->out_len += (size_t)snprintf(c->out + c->out_len, SERVE_ERR_BYTES,
+                                                   "{\"offset\": %llu, \"error\": \"linea demasiado larga\"}\n",
+                                                   (unsigned long long)offset);
+                    w->st.errors++;
+                    c->closing = 1;
+                    pos = c->in_len;
+                }
+                break;
+            }
+            if (handle_line(w, c, (const char *)in + pos, len, offset) != 0) return -1;
+            pos += nl ? len + 1 : len;
+        }
+    }
+
+    if (pos){
+        memmove(c->in, c->in + pos, c->in_len - pos);
+        c->in_len -= pos;
+        c->consumed += pos;
+    }
+    return 0;
+}
+
+/* ------------------ conexiones ------------------ */
+static int conn_set_events(worker_t *w, conn_t *c, uint32_t events){
+    if (events == c->events) return 0;
+    struct epoll_event ev = { .events = events, .data.ptr = c };
+    if (epoll_ctl(w->ep, EPOLL_CTL_MOD, c->fd, &ev) != 0) return -1;
+    c->events = events;
+    return 0;
+}
+
+static void conn_close(worker_t *w, conn_t *c){
+    epoll_ctl(w->ep, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    if (c->prev) c->prev->next = c->next;
+    else w->conns = c->next;
+    if (c->next) c->next->prev = c->prev;
+    free(c->in);
+    free(c->out);
+    free(c);
+}
+
+static void accept_all(worker_t *w){
+    for (;;){
+        int fd = accept4(w->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;  // EAGAIN: otro hilo se la llevo o no quedan
+
+        conn_t *c = calloc(1, sizeof(*c));
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+        if (!c || epoll_ctl(w->ep, EPOLL_CTL_ADD, fd, &ev) != 0){
+            free(c);
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->events = ev.events;
+        c->next = w->conns;
+        if (w->conns) w->conns->prev = c;
+        w->conns = c;
+        w->st.conns++;
+    }
+}
+
+/* Envia lo pendiente. 1 = vaciado, 0 = queda (EAGAIN), -1 = error */
+static int conn_flush(conn_t *c){
+    while (c->out_off < c->out_len){
+        ssize_t r = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+        if (r < 0){
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        c->out_off += (size_t)r;
+    }
+    c->out_off = c->out_len = 0;
+    return 1;
+}
+
+static int conn_read(worker_t *w, conn_t *c){
+    size_t got = 0;
+    while (got < SERVE_MAX_IN){
+        if (reserve(&c->in, &c->in_cap, c->in_len, SERVE_READ_CHUNK) != 0) return -1;
+        ssize_t r = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, 0);
+        if (r < 0){
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        if (r == 0){
+            c->eof = 1;
+            break;
+        }
+        c->in_len += (size_t)r;
+        got += (size_t)r;
+    }
+    return conn_process(w, c);
+}
+
+static void conn_event(worker_t *w, conn_t *c, uint32_t events){
+    if (events & EPOLLERR){
+        conn_close(w, c);
+        return;
+    }
+    if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !c->eof && !c->closing){
+        if (conn_read(w, c) != 0){
+            conn_close(w, c);
+            return;
+        }
+    }
+
+    int fl = conn_flush(c);
+    if (fl < 0 || (fl == 1 && (c->eof || c->closing))){
+        conn_close(w, c);
+        return;
+    }
+
+    /* Con mucha salida pendiente se deja de leer (contrapresion) */
+    uint32_t want = 0;
+    if (fl == 0) want |= EPOLLOUT;
+    if (!c->eof && !c->closing && c->out_len - c->out_off < SERVE_MAX_OUT) want |= EPOLLIN | EPOLLRDHUP;
+    if (conn_set_events(w, c, want) != 0) conn_close(w, c);
+}
+
+/* ------------------ bucle ------------------ */
+static void *worker_main(void *arg){
+    worker_t *w = arg;
+    struct epoll_event evs[SERVE_EVENTS];
+
+    for (;;){
+        int n = epoll_wait(w->ep, evs, SERVE_EVENTS, -1);
+        if (n < 0){
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++){
+            void *tag = evs[i].data.ptr;
+            if (tag == &TAG_STOP){
+                while (w->conns) conn_close(w, w->conns);
+                return NULL;
+            }
+            if (tag == &TAG_LISTEN) accept_all(w);
+            else conn_event(w, tag, evs[i].events);
+        }
+    }
+
+    while (w->conns) conn_close(w, w->conns);
+    return NULL;
+}
+
+static int worker_init(worker_t *w, int listen_fd, int stop_fd){
+    memset(w, 0, sizeof(*w));
+    w->listen_fd = listen_fd;
+    w->stop_fd = stop_fd;
+    w->ep = epoll_create1(EPOLL_CLOEXEC);
+    if (w->ep < 0) return -1;
+
+    /* EPOLLEXCLUSIVE: una conexion nueva despierta a un solo hilo */
+    struct epoll_event lev = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = &TAG_LISTEN };
+    struct epoll_event sev = { .events = EPOLLIN, .data.ptr = &TAG_STOP };
+    if (epoll_ctl(w->ep, EPOLL_CTL_ADD, listen_fd, &lev) != 0 ||
+        epoll_ctl(w->ep, EPOLL_CTL_ADD, stop_fd, &sev) != 0){
+        close(w->ep);
+        return -1;
+    }
+    return 0;
+}
+
+static int listen_unix(const char *path){
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)){
+        fprintf(stderr, "Ruta de socket demasiado larga: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    struct stat sb;
+    if (lstat(path, &sb) == 0){
+        if (!S_ISSOCK(sb.st_mode)){
+            fprintf(stderr, "%s existe y no es un socket.\n", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0){
+        fprintf(stderr, "No se pudo escuchar en %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int serve_run(const char *path, int nthreads){
+    if (nthreads < 1) nthreads = 1;
+
+    int lfd = listen_unix(path);
+    if (lfd < 0) return -1;
+
+    g_stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    worker_t *w = calloc((size_t)nthreads, sizeof(*w));
+    pthread_t *tid = calloc((size_t)nthreads, sizeof(*tid));
+    int rc = 0, ninit = 0, nstarted = 1;
+
+    if (g_stop_fd < 0 || !w || !tid){
+        fprintf(stderr, "Sin recursos para --serve.\n");
+        rc = -1;
+        goto out;
+    }
+    for (; ninit < nthreads; ninit++){
+        if (worker_init(&w[ninit], lfd, g_stop_fd) != 0){
+            fprintf(stderr, "No se pudo crear el bucle epoll.\n");
+            rc = -1;
+            goto out;
+        }
+    }
+
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    for (; nstarted < nthreads; nstarted++){
+        if (pthread_create(&tid[nstarted], NULL, worker_main, &w[nstarted]) != 0){
+            fprintf(stderr, "No se pudo crear el hilo %d.\n", nstarted);
+            rc = -1;
+            on_signal(0);   // detiene los hilos que ya arrancaron
+            break;
+        }
+    }
+
+    if (rc == 0){
+        fprintf(stderr, "Escuchando en %s (%d hilo%s). Ctrl+C para terminar.\n",
+                path, nthreads, nthreads == 1 ? "" : "s");
+        worker_main(&w[0]);
+    }
+    for (int i = 1; i < nstarted; i++) pthread_join(tid[i], NULL);
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    if (rc == 0){
+        serve_stats_t tot = {0};
+        for (int i = 0; i < nthreads; i++){
+            tot.conns += w[i].st.conns;
+            tot.requests += w[i].st.requests;
+            tot.errors += w[i].st.errors;
+        }
+        fprintf(stderr, "Serve: %llu conexiones, %llu peticiones, %llu errores.\n",
+                tot.conns, tot.requests, tot.errors);
+    }
+
+out:
+    for (int i = 0; i < ninit; i++) close(w[i].ep);
+    free(tid);
+    free(w);
+    if (g_stop_fd >= 0) close(g_stop_fd);
+    g_stop_fd = -1;
+    close(lfd);
+    unlink(path);
+    return rc;
+}
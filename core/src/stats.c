@@ -0,0 +1,258 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "stats.h"
+
+int stats_enabled;
+
+static const char *const STAGE_NAMES[STAGE_NUM] = {
+    "read", "decompress", "parse", "decode", "output", "export_csv", "export_json", "export_batch", "render", "plot",
+};
+
+/* ------------------ histograma log-lineal ------------------ */
+/* 0..15 exactos; despues 8 sub-cubos por potencia de 2 hasta 2^64 */
+#define HIST_BUCKETS (16 + (64 - 4) * 8)
+
+static int hist_bucket(uint64_t v){
+    if (v < 16) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    return 16 + (e - 4) * 8 + (int)((v >> (e - 3)) & 7);
+}
+
+static uint64_t hist_lower(int b){
+    if (b < 16) return (uint64_t)b;
+    int e = (b - 16) / 8 + 4;
+    return (uint64_t)(8 + (b - 16) % 8) << (e - 3);
+}
+
+/* ------------------ acumuladores por hilo ------------------ */
+typedef struct stats_tls {
+    uint64_t count[STAGE_NUM];
+    uint64_t sum[STAGE_NUM];
+    uint64_t max[STAGE_NUM];
+    uint64_t hist[STAGE_NUM][HIST_BUCKETS];
+    uint64_t counters[STAT_NUM];
+    struct stats_tls *next;
+} stats_tls_t;
+
+static __thread stats_tls_t *t_stats;
+static stats_tls_t *g_threads;
+static pthread_mutex_t g_mu = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t g_start_ns;
+
+static stats_tls_t *tls_get(void){
+    if (t_stats) return t_stats;
+    stats_tls_t *t = calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    pthread_mutex_lock(&g_mu);
+    t->next = g_threads;
+    g_threads = t;
+    pthread_mutex_unlock(&g_mu);
+    t_stats = t;
+    return t;
+}
+
+uint64_t stats_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void stats_record(stats_stage_t s, uint64_t ns){
+    stats_tls_t *t = tls_get();
+    if (!t) return;
+    t->count[s]++;
+    t->sum[s] += ns;
+    if (ns > t->max[s]) t->max[s] = ns;
+    t->hist[s][hist_bucket(ns)]++;
+}
+
+void stats_add(stats_counter_t c, uint64_t n){
+    stats_tls_t *t = tls_get();
+    if (t) t->counters[c] += n;
+}
+
+/* ------------------ contadores hardware ------------------ */
+enum { HW_CYCLES, HW_INSTRUCTIONS, HW_CACHE_MISSES, HW_NUM };
+
+static int hw_fd[HW_NUM] = { -1, -1, -1 };
+static int hw_errno;
+
+static void hw_open(void){
+#ifdef __linux__
+    static const uint64_t CONFIG[HW_NUM] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+    };
+    for (int i = 0; i < HW_NUM; i++){
+        struct perf_event_attr a;
+        memset(&a, 0, sizeof(a));
+        a.type = PERF_TYPE_HARDWARE;
+        a.size = sizeof(a);
+        a.config = CONFIG[i];
+        a.inherit = 1;           // hilos creados despues (se suman al terminar)
+        a.exclude_kernel = 1;    // funciona con perf_event_paranoid = 2
+        a.exclude_hv = 1;
+        long fd = syscall(SYS_perf_event_open, &a, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fd < 0){
+            hw_errno = errno;
+            for (int j = 0; j < i; j++){
+                close(hw_fd[j]);
+                hw_fd[j] = -1;
+            }
+            return;
+        }
+        hw_fd[i] = (int)fd;
+    }
+#else
+    hw_errno = ENOSYS;
+#endif
+}
+
+static int hw_read(uint64_t v[HW_NUM]){
+    for (int i = 0; i < HW_NUM; i++){
+        if (hw_fd[i] < 0 || read(hw_fd[i], &v[i], sizeof(v[i])) != (ssize_t)sizeof(v[i])) return -1;
+    }
+    return 0;
+}
+
+void stats_start(int hw){
+    if (hw) hw_open();
+    g_start_ns = stats_now_ns();
+    stats_enabled = 1;
+}
+
+/* ------------------ informe ------------------ */
+typedef struct {
+    uint64_t count, sum, max;
+    uint64_t hist[HIST_BUCKETS];
+} stage_total_t;
+
+/* Valor del percentil p: punto medio de su cubo, sin pasar del maximo */
+static uint64_t percentile(const stage_total_t *s, double p){
+    if (!s->count) return 0;
+    uint64_t rank = (uint64_t)(p * (double)s->count);
+    if (rank >= s->count) rank = s->count - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++){
+        seen += s->hist[b];
+        if (seen > rank){
+            uint64_t lo = hist_lower(b);
+            uint64_t hi = (b + 1 < HIST_BUCKETS) ? hist_lower(b + 1) - 1 : UINT64_MAX;
+            uint64_t mid = lo + (hi - lo) / 2;
+            return mid < s->max ? mid : s->max;
+        }
+    }
+    return s->max;
+}
+
+void stats_report(FILE *out, stats_format_t fmt, const stream_stats_t *st){
+    double wall = (double)(stats_now_ns() - g_start_ns) * 1e-9;
+    stats_enabled = 0;
+
+    static stage_total_t tot[STAGE_NUM];
+    uint64_t counters[STAT_NUM] = { 0 };
+    int nthreads = 0;
+
+    memset(tot, 0, sizeof(tot));
+    pthread_mutex_lock(&g_mu);
+    for (const stats_tls_t *t = g_threads; t; t = t->next){
+        nthreads++;
+        for (int s = 0; s < STAGE_NUM; s++){
+            tot[s].count += t->count[s];
+            tot[s].sum += t->sum[s];
+            if (t->max[s] > tot[s].max) tot[s].max = t->max[s];
+            for (int b = 0; b < HIST_BUCKETS; b++) tot[s].hist[b] += t->hist[s][b];
+        }
+        for (int c = 0; c < STAT_NUM; c++) counters[c] += t->counters[c];
+    }
+    pthread_mutex_unlock(&g_mu);
+
+    uint64_t hw[HW_NUM];
+    int have_hw = (hw_read(hw) == 0);
+    uint64_t frames = st ? st->frames : 0, errors = st ? st->errors : 0;
+    double fdiv = frames ? (double)frames : 1.0;
+
+    if (fmt == STATS_JSON){
+        fprintf(out, "{\"wall_s\":%.6f,\"threads\":%d,\"frames\":%llu,\"bytes\":%llu,\"errors\":%llu,"
+                     "\"reserved_frames\":%llu,\"hw\":",
+                wall, nthreads, (unsigned long long)frames, (unsigned long long)counters[STAT_BYTES],
+                (unsigned long long)errors, (unsigned long long)counters[STAT_RESERVED]);
+        if (have_hw){
+            fprintf(out, "{\"cycles\":%llu,\"instructions\":%llu,\"cache_misses\":%llu}",
+                    (unsigned long long)hw[HW_CYCLES], (unsigned long long)hw[HW_INSTRUCTIONS],
+                    (unsigned long long)hw[HW_CACHE_MISSES]);
+        } else {
+            fprintf(out, "null");
+        }
+        fprintf(out, ",\"stages\":{");
+        int first = 1;
+        for (int s = 0; s < STAGE_NUM; s++){
+            const stage_total_t *x = &tot[s];
+            if (!x->count) continue;
+            fprintf(out, "%s\"%s\":{\"count\":%llu,\"total_ns\":%llu,\"mean_ns\":%llu,\"p50_ns\":%llu,"
+                         "\"p99_ns\":%llu,\"max_ns\":%llu}",
+                    first ? "" : ",", STAGE_NAMES[s], (unsigned long long)x->count,
+                    (unsigned long long)x->sum, (unsigned long long)(x->sum / x->count),
+                    (unsigned long long)percentile(x, 0.50), (unsigned long long)percentile(x, 0.99),
+                    (unsigned long long)x->max);
+            first = 0;
+        }
+        fprintf(out, "}}\n");
+        return;
+    }
+
+    fprintf(out, "Stats: %.3f s, %llu tramas (%.0f tramas/s), %.1f MB de entrada (%.1f MB/s), %llu errores, "
+                 "%llu con RESERVED, %d hilos\n",
+            wall, (unsigned long long)frames, wall > 0 ? (double)frames / wall : 0.0,
+            (double)counters[STAT_BYTES] / 1e6, wall > 0 ? (double)counters[STAT_BYTES] / 1e6 / wall : 0.0,
+            (unsigned long long)errors, (unsigned long long)counters[STAT_RESERVED], nthreads);
+    if (have_hw){
+        fprintf(out, "  hw: %.0f ciclos/trama, %.0f instrucciones/trama (IPC %.2f), %.1f fallos de cache/trama\n",
+                (double)hw[HW_CYCLES] / fdiv, (double)hw[HW_INSTRUCTIONS] / fdiv,
+                hw[HW_CYCLES] ? (double)hw[HW_INSTRUCTIONS] / (double)hw[HW_CYCLES] : 0.0,
+                (double)hw[HW_CACHE_MISSES] / fdiv);
+    } else if (hw_errno){
+        fprintf(out, "  hw: no disponible (perf_event_open: %s)\n", strerror(hw_errno));
+    }
+    fprintf(out, "  %-13s %10s %11s %9s %9s %9s %11s\n",
+            "etapa", "llamadas", "total ms", "media ns", "p50 ns", "p99 ns", "max ns");
+    for (int s = 0; s < STAGE_NUM; s++){
+        const stage_total_t *x = &tot[s];
+        if (!x->count) continue;
+        fprintf(out, "  %-13s %10llu %11.1f %9llu %9llu %9llu %11llu\n",
+                STAGE_NAMES[s], (unsigned long long)x->count, (double)x->sum * 1e-6,
+                (unsigned long long)(x->sum / x->count),
+                (unsigned long long)percentile(x, 0.50), (unsigned long long)percentile(x, 0.99),
+                (unsigned long long)x->max);
+    }
+}
+
+void stats_free(void){
+    pthread_mutex_lock(&g_mu);
+    stats_tls_t *t = g_threads;
+    g_threads = NULL;
+    pthread_mutex_unlock(&g_mu);
+    while (t){
+        stats_tls_t *next = t->next;
+        free(t);
+        t = next;
+    }
+    t_stats = NULL;
+    for (int i = 0; i < HW_NUM; i++){
+        if (hw_fd[i] >= 0) close(hw_fd[i]);
+        hw_fd[i] = -1;
+    }
+}
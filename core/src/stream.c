@@ -0,0 +1,180 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "stream.h"
+#include "utils.h"
+#include "hexparse.h"
+#include "stats.h"
+
+int frame_from_bytes(hermes_frame_t *fr, const uint8_t *buf, int n){
+    if (n < HERMES_FRAME_BYTES) return -1;
+    fr->prefix = (uint16_t)((buf[0] << 8) | buf[1]);
+    fr->nbytes = n;
+    fr->reg    = buf + HERMES_PREFIX_BYTES;
+    return 0;
+}
+
+/* ------------------ line reader ------------------ */
+void line_reader_init(line_reader_t *lr, FILE *fp){
+    memset(lr, 0, sizeof(*lr));
+    lr->fp = fp;
+}
+
+ssize_t line_reader_next(line_reader_t *lr){
+    ssize_t len = getline(&lr->line, &lr->cap, lr->fp);
+    if (len < 0) return -1;
+
+    lr->offset = lr->next_offset;
+    lr->next_offset += (uint64_t)len;
+    lr->lineno++;
+    return len;
+}
+
+void line_reader_free(line_reader_t *lr){
+    free(lr->line);
+    lr->line = NULL;
+    lr->cap = 0;
+}
+
+static int is_blank(const char *s, size_t len){
+    for (size_t i = 0; i < len; i++){
+        char c = s[i];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') return 0;
+    }
+    return 1;
+}
+
+int stream_parse_line(const char *line, size_t len, uint8_t **buf, size_t *cap, hermes_frame_t *fr){
+    if (is_blank(line, len)) return LINE_BLANK;
+
+    // Cada byte ocupa al menos 2 caracteres: len/2 + 1 siempre basta
+    size_t need = len / 2 + 1;
+    if (need > *cap){
+        uint8_t *nb = realloc(*buf, need);
+        if (!nb) return LINE_NOMEM;
+        *buf = nb;
+        *cap = need;
+    }
+
+    int n = parse_hex_bytes_n(line, len, *buf, (int)*cap);
+    if (n < 0) return LINE_BAD_HEX;
+
+    if (frame_from_bytes(fr, *buf, n) != 0){
+        fr->nbytes = n;
+        return LINE_SHORT;
+    }
+    return LINE_OK;
+}
+
+void stream_report_error(FILE *err, int status, uint64_t lineno, uint64_t offset, int nbytes){
+    switch (status){
+        case LINE_BAD_HEX:
+            fprintf(err, "Linea %llu (offset %llu): error parseando hex.\n",
+                    (unsigned long long)lineno, (unsigned long long)offset);
+            break;
+        case LINE_SHORT:
+            fprintf(err, "Linea %llu (offset %llu): trama demasiado corta (%d bytes).\n",
+                    (unsigned long long)lineno, (unsigned long long)offset, nbytes);
+            break;
+        case LINE_NOMEM:
+            fprintf(err, "Linea %llu (offset %llu): sin memoria.\n",
+                    (unsigned long long)lineno, (unsigned long long)offset);
+            break;
+        default:
+            break;
+    }
+}
+
+/* ------------------ stream loop ------------------ */
+int stream_run(FILE *fp, frame_cb cb, void *user, stream_stats_t *st){
+    line_reader_t lr;
+    uint8_t *buf = NULL;
+    size_t buf_cap = 0;
+    int rc = 0;
+
+    memset(st, 0, sizeof(*st));
+    line_reader_init(&lr, fp);
+
+    ssize_t len;
+    for (;;){
+        uint64_t t = stats_begin();
+        len = line_reader_next(&lr);
+        stats_end(STAGE_READ, t);
+        if (len < 0) break;
+        st->lines++;
+        stats_count(STAT_BYTES, (uint64_t)len);
+
+        hermes_frame_t fr = {0};
+        t = stats_begin();
+        int status = stream_parse_line(lr.line, (size_t)len, &buf, &buf_cap, &fr);
+        stats_end(STAGE_PARSE, t);
+        if (status == LINE_BLANK){
+            st->blank++;
+            continue;
+        }
+        if (status != LINE_OK){
+            stream_report_error(stderr, status, lr.lineno, lr.offset, fr.nbytes);
+            st->errors++;
+            if (status == LINE_NOMEM){
+                rc = -1;
+                break;
+            }
+            continue;
+        }
+
+        fr.seq = st->frames + 1;
+        fr.offset = lr.offset;
+
+        if (cb(stdout, &fr, user) != 0) st->errors++;
+        st->frames++;
+    }
+
+    free(buf);
+    line_reader_free(&lr);
+    return rc;
+}
+
+/* ------------------ records (multihilo) ------------------ */
+int frame_recs_push(frame_recs_t *r, const frame_rec_t *rec){
+    if (r->n == r->cap){
+        size_t ncap = r->cap ? r->cap * 2 : 1024;
+        frame_rec_t *nv = realloc(r->v, ncap * sizeof(frame_rec_t));
+        if (!nv) return -1;
+        r->v = nv;
+        r->cap = ncap;
+    }
+    r->v[r->n++] = *rec;
+    return 0;
+}
+
+void frame_recs_free(frame_recs_t *r){
+    free(r->v);
+    r->v = NULL;
+    r->n = r->cap = 0;
+}
+
+void stream_render_recs(FILE *out, FILE *err, const frame_recs_t *recs,
+                        uint64_t base_line, uint64_t base_frame,
+                        frame_cb cb, void *user, uint64_t *errors){
+    uint64_t seq = base_frame;
+
+    for (size_t i = 0; i < recs->n; i++){
+        const frame_rec_t *r = &recs->v[i];
+        if (r->status != LINE_OK){
+            stream_report_error(err, r->status, base_line + r->line + 1, r->offset, r->nbytes);
+            (*errors)++;
+            continue;
+        }
+
+        hermes_frame_t fr;
+        frame_from_bytes(&fr, r->bytes, HERMES_FRAME_BYTES);
+        fr.nbytes = r->nbytes;
+        fr.seq    = ++seq;
+        fr.offset = r->offset;
+        if (cb(out, &fr, user) != 0) (*errors)++;
+    }
+}
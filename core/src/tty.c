@@ -0,0 +1,344 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <termios.h>
+#include <pthread.h>
+
+#include "tty.h"
+#include "stats.h"
+
+#define TTY_BUF_BYTES  65536
+
+/* ------------------ busqueda del prefijo ------------------ */
+typedef size_t (*tty_find_fn)(const uint8_t *p, size_t n, uint8_t hi, uint8_t lo);
+
+static size_t find_scalar(const uint8_t *p, size_t n, uint8_t hi, uint8_t lo){
+    for (size_t i = 0; i + 1 < n; i++){
+        if (p[i] == hi && p[i + 1] == lo) return i;
+    }
+    return n;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* p[i] == hi y p[i + 1] == lo para 16 posiciones a la vez (dos cargas solapadas) */
+static size_t find_sse2(const uint8_t *p, size_t n, uint8_t hi, uint8_t lo){
+    const __m128i vh = _mm_set1_epi8((char)hi), vl = _mm_set1_epi8((char)lo);
+    size_t i = 0;
+    for (; i + 17 <= n; i += 16){
+        __m128i a = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + i + 1));
+        int m = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, vh), _mm_cmpeq_epi8(b, vl)));
+        if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+    }
+    size_t r = find_scalar(p + i, n - i, hi, lo);
+    return i + r;
+}
+
+__attribute__((target("avx2")))
+static size_t find_avx2(const uint8_t *p, size_t n, uint8_t hi, uint8_t lo){
+    const __m256i vh = _mm256_set1_epi8((char)hi), vl = _mm256_set1_epi8((char)lo);
+    size_t i = 0;
+    for (; i + 33 <= n; i += 32){
+        __m256i a = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(p + i + 1));
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, vh),
+                                                                     _mm256_cmpeq_epi8(b, vl)));
+        if (m) return i + (size_t)__builtin_ctz(m);
+    }
+    size_t r = find_scalar(p + i, n - i, hi, lo);
+    return i + r;
+}
+#endif
+
+static tty_find_fn tf_find;
+static const char *tf_name;
+
+static pthread_once_t tf_once = PTHREAD_ONCE_INIT;
+
+static void tf_select(void){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")){
+        tf_find = find_avx2;
+        tf_name = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")){
+        tf_find = find_sse2;
+        tf_name = "sse2";
+        return;
+    }
+#endif
+    tf_find = find_scalar;
+    tf_name = "scalar";
+}
+
+const char *tty_scan_impl(void){
+    pthread_once(&tf_once, tf_select);
+    return tf_name;
+}
+
+size_t tty_find_prefix(const uint8_t *p, size_t n, uint16_t prefix){
+    pthread_once(&tf_once, tf_select);
+    return tf_find(p, n, (uint8_t)(prefix >> 8), (uint8_t)prefix);
+}
+
+/* ------------------ terminal ------------------ */
+static const struct { int baud; speed_t code; } BAUDS[] = {
+    { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 },
+    { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 },
+    { 230400, B230400 },
+#ifdef B460800
+    { 460800, B460800 }, { 921600, B921600 },
+#endif
+#ifdef B1000000
+    { 1000000, B1000000 }, { 2000000, B2000000 }, { 3000000, B3000000 },
+#endif
+};
+
+static int baud_index(int baud){
+    for (size_t i = 0; i < sizeof(BAUDS) / sizeof(BAUDS[0]); i++){
+        if (BAUDS[i].baud == baud) return (int)i;
+    }
+    return -1;
+}
+
+int tty_baud_ok(int baud){
+    return baud_index(baud) >= 0 ? 0 : -1;
+}
+
+/* Modo crudo 8N1: cada byte llega en cuanto esta disponible (VMIN=1, VTIME=0) */
+static int tty_setup(int fd, const char *path, int baud){
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0){
+        fprintf(stderr, "No se pudo leer la configuracion de %s: %s.\n", path, strerror(errno));
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(tcflag_t)(CSTOPB | PARENB);
+    tio.c_cc[VMIN]  = 1;
+    tio.c_cc[VTIME] = 0;
+    speed_t sp = BAUDS[baud_index(baud)].code;
+    cfsetispeed(&tio, sp);
+    cfsetospeed(&tio, sp);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0){
+        fprintf(stderr, "No se pudo configurar %s a %d baudios: %s.\n", path, baud, strerror(errno));
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+    return 0;
+}
+
+static volatile sig_atomic_t g_tty_stop;
+
+static void on_signal(int sig){
+    (void)sig;
+    g_tty_stop = 1;
+}
+
+/* ------------------ escaner ------------------ */
+typedef struct {
+    uint8_t  *buf;
+    size_t    len;          // bytes validos en buf
+    size_t    start;        // primer byte sin consumir
+    uint64_t  base;         // offset en la captura de buf[0]
+    int       check;        // trama emitida pendiente de ver que sigue
+    size_t    check_pos;
+    uint64_t  check_seq;    // numero de la trama en check_pos
+    int       synced;       // hubo al menos una trama
+    uint16_t  prefix;
+    frame_cb  cb;
+    void     *user;
+    int       flush;
+    stream_stats_t *st;
+    tty_stats_t    *ts;
+} scan_t;
+
+static int is_prefix(const scan_t *s, size_t i){
+    return s->buf[i] == (uint8_t)(s->prefix >> 8) && s->buf[i + 1] == (uint8_t)s->prefix;
+}
+
+static void emit(scan_t *s, size_t pos){
+    hermes_frame_t fr;
+    frame_from_bytes(&fr, s->buf + pos, HERMES_FRAME_BYTES);
+    fr.seq = s->st->frames + 1;
+    fr.offset = s->base + pos;
+    if (s->cb(stdout, &fr, s->user) != 0) s->st->errors++;
+    s->st->frames++;
+    if (s->flush) fflush(stdout);
+}
+
+/* Consume todo lo que se pueda decidir con los bytes que hay */
+static void scan(scan_t *s){
+    for (;;){
+        if (s->check){
+            size_t next = s->check_pos + HERMES_FRAME_BYTES;
+            if (s->len < next + 2) return;          // falta ver el inicio de la siguiente
+            s->check = 0;
+            if (!is_prefix(s, next)){
+                size_t in = tty_find_prefix(s->buf + s->check_pos + 1, HERMES_FRAME_BYTES, s->prefix);
+                if (in < HERMES_FRAME_BYTES - 1){
+                    fprintf(stderr, "Trama %llu (offset %llu): corrupta, resincronizando.\n",
+                            (unsigned long long)s->check_seq,
+                            (unsigned long long)(s->base + s->check_pos));
+                    s->ts->corrupt++;
+                    s->st->errors++;
+                    s->start = s->check_pos + 1 + in;
+                }
+            }
+        }
+
+        size_t avail = s->len - s->start;
+        size_t p = tty_find_prefix(s->buf + s->start, avail, s->prefix);
+        if (p == avail){
+            // sin prefijo: se guarda el ultimo byte por si es su primera mitad
+            size_t keep = (avail && s->buf[s->len - 1] == (uint8_t)(s->prefix >> 8)) ? 1 : 0;
+            if (avail - keep){
+                s->ts->skipped += avail - keep;
+                if (s->synced) s->ts->resyncs++;
+                s->synced = 0;
+            }
+            s->start = s->len - keep;
+            return;
+        }
+        if (p){
+            s->ts->skipped += p;
+            if (s->synced) s->ts->resyncs++;
+            s->start += p;
+        }
+        if (s->len - s->start < HERMES_FRAME_BYTES) return;
+
+        emit(s, s->start);
+        s->synced = 1;
+        s->check = 1;
+        s->check_pos = s->start;
+        s->check_seq = s->st->frames;
+        s->start += HERMES_FRAME_BYTES;
+    }
+}
+
+/* Silencio o EOF: la trama a medias se descarta y la emitida se da por buena */
+static void scan_idle(scan_t *s){
+    s->check = 0;
+    if (s->len - s->start >= 2 && is_prefix(s, s->start)) s->ts->truncated++;
+    else if (s->len > s->start) s->ts->skipped += s->len - s->start;
+    s->start = s->len;
+}
+
+static void scan_compact(scan_t *s){
+    size_t keep = s->check ? s->check_pos : s->start;
+    if (keep == 0) return;
+    memmove(s->buf, s->buf + keep, s->len - keep);
+    s->len -= keep;
+    s->start -= keep;
+    if (s->check) s->check_pos -= keep;
+    s->base += keep;
+}
+
+int tty_run(const char *path, int baud, uint16_t prefix, frame_cb cb, void *user,
+            stream_stats_t *st, tty_stats_t *ts){
+    memset(st, 0, sizeof(*st));
+    memset(ts, 0, sizeof(*ts));
+    if (baud_index(baud) < 0){
+        fprintf(stderr, "Velocidad no soportada: %d baudios.\n", baud);
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0){
+        fprintf(stderr, "No se pudo abrir %s: %s.\n", path, strerror(errno));
+        return -1;
+    }
+    int is_tty = isatty(fd);
+    if (is_tty && tty_setup(fd, path, baud) != 0){
+        close(fd);
+        return -1;
+    }
+
+    scan_t s = { 0 };
+    s.buf = malloc(TTY_BUF_BYTES);
+    if (!s.buf){
+        fprintf(stderr, "Sin memoria para --tty.\n");
+        close(fd);
+        return -1;
+    }
+    s.prefix = prefix;
+    s.cb = cb;
+    s.user = user;
+    s.flush = is_tty;
+    s.st = st;
+    s.ts = ts;
+
+    /* Silencio que cierra una trama: ~20 bytes de 10 bits, minimo 2 ms */
+    int gap_ms = 2 + 200000 / baud;
+
+    struct sigaction sa = { .sa_handler = on_signal }, old_int, old_term;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+    g_tty_stop = 0;
+    tty_scan_impl();
+
+    if (is_tty) fprintf(stderr, "Capturando %s a %d baudios (prefijo %04X). Ctrl+C para terminar.\n",
+                        path, baud, prefix);
+
+    int rc = 0;
+    while (!g_tty_stop){
+        int pending = s.check || s.len > s.start;
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int pr = poll(&pfd, 1, pending ? gap_ms : -1);
+        if (pr < 0){
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error esperando datos de %s: %s.\n", path, strerror(errno));
+            rc = -1;
+            break;
+        }
+        if (pr == 0){
+            scan_idle(&s);
+            scan_compact(&s);
+            continue;
+        }
+
+        if (s.len == TTY_BUF_BYTES){      // no pasa: scan deja < 2 tramas sin consumir
+            scan_idle(&s);
+            scan_compact(&s);
+        }
+        uint64_t t = stats_begin();
+        ssize_t n = read(fd, s.buf + s.len, TTY_BUF_BYTES - s.len);
+        stats_end(STAGE_READ, t);
+        if (n < 0){
+            if (errno == EINTR || errno == EAGAIN) continue;
+            if (errno != EIO){            // EIO: se cerro el otro extremo del pty
+                fprintf(stderr, "Error leyendo %s: %s.\n", path, strerror(errno));
+                rc = -1;
+            }
+            break;
+        }
+        if (n == 0) break;                // EOF (fichero, FIFO, pty cerrado)
+
+        s.len += (size_t)n;
+        ts->bytes += (uint64_t)n;
+        stats_count(STAT_BYTES, (uint64_t)n);
+        scan(&s);
+        scan_compact(&s);
+    }
+    scan_idle(&s);
+    fflush(stdout);
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    free(s.buf);
+    close(fd);
+    return rc;
+}
@@ -1,47 +1,210 @@
-#include <stdio.h>
-#include <stdint.h>
-
-/* ------------------ CLI ------------------ */
-void usage(const char *prog){
-    fprintf(stderr,
-        "Uso:\n"
-        "  %s [opciones]\n\n"
-
-        "Descripción:\n"
-        "  Lee una trama HEX por stdin y decodifica la configuración del PGA460.\n"
-        "  Puede mostrar gráficas interactivas y/o exportar perfiles a disco.\n\n"
-
-        "Opciones:\n"
-        "  --plot [prefix]        Muestra gráfica TH (P1 vs P2).\n"
-        "                         No exporta CSV ni JSON.\n\n"
-
-        "  --plot-tvg [prefix]    Muestra gráfica TVG (ganancia vs distancia).\n"
-        "                         No exporta CSV ni JSON.\n\n"
-
-        "  --export-csv [prefix]  Exporta perfiles TH (P1/P2) y TVG en CSV.\n"
-        "                         No muestra gráficas.\n\n"
-
-        "  --export-json [prefix] Exporta perfiles TH (P1/P2) y TVG en JSON.\n"
-        "                         No muestra gráficas.\n\n"
-
-        "  --help, -h             Muestra esta ayuda.\n\n"
-
-        "Notas:\n"
-        "  - Las opciones --plot y --plot-tvg pueden combinarse.\n"
-        "  - Las opciones --export-csv y --export-json pueden combinarse\n"
-        "    entre sí y con --plot / --plot-tvg.\n"
-        "  - El prefijo es opcional y se usa para nombrar los ficheros exportados.\n\n"
-
-        "Ejemplos:\n"
-        "  %s --plot\n"
-        "  %s --plot-tvg\n"
-        "  %s --plot --plot-tvg\n"
-        "  %s --export-csv test\n"
-        "  %s --export-json test\n"
-        "  %s --plot --export-csv test\n"
-        "  %s --plot --plot-tvg --export-json test\n",
-        prog, prog, prog, prog, prog, prog, prog, prog
-    );
-}
-
-
+#include <stdio.h>
+#include <stdint.h>
+
+/* ------------------ CLI ------------------ */
+void usage(const char *prog){
+    fprintf(stderr,
+        "Uso:\n"
+        "  %s [opciones]\n"
+        "  %s query <fichero> [\"<expresion>\"] [opciones de query]\n\n"
+
+        "Descripción:\n"
+        "  Lee una trama HEX por stdin y decodifica la configuración del PGA460.\n"
+        "  Puede mostrar gráficas interactivas y/o exportar perfiles a disco.\n\n"
+
+        "Opciones:\n"
+        "  --plot [prefix]        Muestra gráfica TH (P1 vs P2).\n"
+        "                         No exporta CSV ni JSON.\n\n"
+
+        "  --plot-tvg [prefix]    Muestra gráfica TVG (ganancia vs distancia).\n"
+        "                         No exporta CSV ni JSON.\n\n"
+
+        "  --export-csv [prefix]  Exporta perfiles TH (P1/P2) y TVG en CSV.\n"
+        "                         No muestra gráficas.\n\n"
+
+        "  --export-json [prefix] Exporta perfiles TH (P1/P2) y TVG en JSON.\n"
+        "                         No muestra gráficas.\n\n"
+
+        "  --render <dir>         Dibuja las gráficas TH y TVG sin gnuplot y las\n"
+        "                         guarda en <dir> (una pareja por trama en stream).\n\n"
+
+        "  --render-format <f>    Formato de --render: svg (defecto), png o both.\n\n"
+
+        "  --stream               Lee una trama por línea de stdin hasta EOF.\n"
+        "                         Las líneas erróneas se cuentan y se saltan.\n\n"
+
+        "  --input <fichero>      Como --stream, pero leyendo de <fichero>.\n"
+        "                         Logs .gz/.zst (también por stdin) se detectan\n"
+        "                         por contenido y se descomprimen en otro hilo.\n\n"
+
+        "  --input-format <f>     Formato de --input: hex (defecto, una trama por\n"
+        "                         línea), bin (registros fijos de 57 bytes) o\n"
+        "                         binlen (longitud u16 big-endian + trama). Los\n"
+        "                         binarios se mapean y decodifican sin copia.\n\n"
+
+        "  --threads <N>          Con --input: mmap del fichero y decodificación\n"
+        "                         en N hilos. Con stdin: pipeline lector -> N workers\n"
+        "                         -> escritor con colas acotadas. La salida mantiene\n"
+        "                         el orden original.\n\n"
+
+        "  --pipeline-stats       Con --threads sobre stdin: profundidad de colas y\n"
+        "                         esperas por etapa al terminar (stderr).\n\n"
+
+        "  --stats [text|json]    Al terminar (stderr): tiempo por etapa (lectura,\n"
+        "                         parseo, decodificación, salida, exports) con\n"
+        "                         media/p50/p99/máximo, tramas/s, MB/s, errores,\n"
+        "                         tramas con RESERVED y contadores hardware si\n"
+        "                         perf_event_open está disponible.\n\n"
+
+        "  --cache <MB>           En modo stream: reutiliza la decodificación y el\n"
+        "                         texto/CSV/JSON de tramas repetidas (LRU acotada\n"
+        "                         a <MB>, entero de 0 a 65536, repartida entre\n"
+        "                         hilos). Aciertos/fallos al terminar (stderr).\n\n"
+
+        "  --diff [uart|prefix]   Modo stream que guarda la última trama de cada\n"
+        "                         dispositivo (UART_ADDR o prefijo; por defecto uart)\n"
+        "                         e imprime solo los registros/campos que cambian y\n"
+        "                         las etapas TH/TVG afectadas.\n\n"
+
+        "  --batch-export         Modo stream con --export-csv/--export-json: un solo\n"
+        "                         fichero por perfil (<prefix>_p1_profile.csv,\n"
+        "                         .ndjson, ...) con frame_id/offset/device por fila.\n\n"
+
+        "  --serve <socket>       Servidor persistente en un socket Unix: recibe\n"
+        "                         tramas hex por línea (o registros binarios con\n"
+        "                         longitud) y responde JSON o binario. Con\n"
+        "                         --threads N usa N bucles epoll.\n\n"
+
+        "  --format <f>           Salida de la decodificación: text (defecto),\n"
+        "                         ndjson (un objeto por trama con todos los\n"
+        "                         registros, campos, avisos y perfiles) o binary\n"
+        "                         (registro fijo, ver inc/record.h).\n\n"
+
+        "  --encode [fichero]     Inversa del decodificador: lee perfiles/campos en\n"
+        "                         CSV (cabecera con claves) o NDJSON y escribe una\n"
+        "                         trama hex por registro. Tiempos cuantizados a la\n"
+        "                         tabla TIME_US; niveles en crudo o %%.\n\n"
+
+        "  --encode-base <hex>    Trama (57 bytes) o REG1..REG55 de partida para\n"
+        "                         --encode (defecto: prefijo 5E02 y registros a 0).\n\n"
+
+        "  --archive <fichero>    Modo stream que guarda las tramas en un archivo\n"
+        "                         columnar (un campo de registro por columna,\n"
+        "                         bit-packing/RLE/diccionario) en vez de imprimirlas.\n\n"
+
+        "  --archive-cat <fich>   Vuelca las tramas de un archivo en hex.\n\n"
+
+        "  --archive-info <fich>  Esquema, bytes y codificación por columna.\n\n"
+
+        "  --curves <rejilla>     Modo stream que evalúa las curvas TH P1/P2 y TVG\n"
+        "                         en cada distancia de la rejilla: desde:paso:hasta\n"
+        "                         en cm o us (0:1:500, 0:100:30000us) o un fichero\n"
+        "                         con una distancia por línea. Matriz CSV (una fila\n"
+        "                         por trama y curva, en %%) o binaria con --format\n"
+        "                         binary (ver inc/curve.h).\n\n"
+
+        "  --curves-profiles <l>  Curvas de --curves: lista de p1, p2, tvg (defecto\n"
+        "                         las tres).\n\n"
+
+        "  --curves-interp <m>    step (defecto: nivel de la última etapa\n"
+        "                         alcanzada) o linear (rectas entre puntos TH, como\n"
+        "                         las gráficas; TVG siempre en escalón). También\n"
+        "                         para el umbral de --echo.\n\n"
+
+        "  --echo [p1|p2]         Modo stream con volcados de eco (prefijo + 128\n"
+        "                         muestras; dispositivo en el nibble bajo del 2º\n"
+        "                         byte) mezclados con tramas de configuración. Cada\n"
+        "                         volcado se compara con el umbral TH (P1 por\n"
+        "                         defecto) de la última configuración de su\n"
+        "                         dispositivo: cruces, margen y distancia del\n"
+        "                         objeto. Admite --format ndjson.\n\n"
+
+        "  --tty <dispositivo>    Captura en vivo del UART (bytes crudos, sin\n"
+        "                         líneas): delimita las tramas por el prefijo,\n"
+        "                         descarta la basura, resincroniza tras tramas\n"
+        "                         truncadas o corruptas y emite cada trama en\n"
+        "                         cuanto llega. También lee un fichero crudo.\n\n"
+
+        "  --baud <n>             Velocidad de --tty (defecto: 115200).\n\n"
+
+        "  --tty-prefix <hex>     Prefijo de 2 bytes de --tty (defecto: 5E02).\n\n"
+        "  --aggregate            Modo stream sin salida por trama: al terminar\n"
+        "                         imprime, para cada campo de regmap, valores\n"
+        "                         distintos, mín/máx/media y los más frecuentes;\n"
+        "                         tramas con RESERVED por registro y niveles y\n"
+        "                         tiempos de cada etapa TH. Con --format ndjson,\n"
+        "                         un objeto JSON con los histogramas completos.\n\n"
+
+        "  --help, -h             Muestra esta ayuda.\n\n"
+
+        "Query (log hex o archivo de --archive):\n"
+        "  <expresion>            Comparaciones campo op valor (==, !=, <, <=,\n"
+        "                         >, >=) con and/or/not y paréntesis. Campos:\n"
+        "                         REG.CAMPO, CAMPO, REG, device, prefix,\n"
+        "                         frame_id, offset, reserved, hash y, en\n"
+        "                         archivos, timestamp_us. Sin expresión solo\n"
+        "                         crea/actualiza el índice.\n\n"
+
+        "  --index <fichero>      Índice del log (defecto: <fichero>.hidx). Se\n"
+        "                         crea en la primera consulta y solo indexa las\n"
+        "                         líneas nuevas en las siguientes.\n\n"
+
+        "  --reindex              Reconstruye el índice desde cero.\n\n"
+
+        "  --count | --ids        Solo el número de coincidencias, o\n"
+        "                         \"frame_id offset\" por trama (defecto: la\n"
+        "                         trama en hex).\n\n"
+
+        "Notas:\n"
+        "  - Las opciones --plot y --plot-tvg pueden combinarse.\n"
+        "  - Las opciones --export-csv y --export-json pueden combinarse\n"
+        "    entre sí y con --plot / --plot-tvg.\n"
+        "  - El prefijo es opcional y se usa para nombrar los ficheros exportados.\n"
+        "  - En modo stream los ficheros exportados llevan el número de trama\n"
+        "    (<prefix>_f000001_p1_profile.csv) y no se admite --plot.\n"
+        "  - --diff no se combina con --threads ni --cache.\n"
+        "  - --format ndjson/binary no se combina con --plot, --export-*, --render\n"
+        "    ni --diff.\n"
+        "  - --archive solo admite --input y --threads.\n"
+        "  - --curves solo admite --input, --threads, --cache y --format binary.\n"
+        "  - --echo depende del orden de las líneas: no admite --threads ni --cache.\n"
+        "  - --tty no se combina con --input, --threads ni --echo.\n"
+        "  - --input-format bin/binlen requiere --input <fichero> (no stdin) y\n"
+        "    sin comprimir.\n"
+        "  - --aggregate solo admite --input, --input-format, --threads, --tty,\n"
+        "    --stats y --format ndjson.\n\n"
+
+        "Ejemplos:\n"
+        "  %s --plot\n"
+        "  %s --plot-tvg\n"
+        "  %s --plot --plot-tvg\n"
+        "  %s --export-csv test\n"
+        "  %s --export-json test\n"
+        "  %s --plot --export-csv test\n"
+        "  %s --plot --plot-tvg --export-json test\n"
+        "  %s --input frames.log --export-csv run\n"
+        "  %s --input frames.log --threads 8 > decode.txt\n"
+        "  cat 2024-05-*.log.zst | %s --stream --threads 4 --format ndjson > mayo.ndjson\n"
+        "  %s --input captura.bin --input-format bin --threads 8 --format ndjson > decode.ndjson\n"
+        "  adquisicion | %s --threads 4 --pipeline-stats\n"
+        "  %s --input frames.log --threads 8 --stats json > decode.txt 2> stats.json\n"
+        "  %s --input frames.log --cache 64 > decode.txt\n"
+        "  ajuste | %s --diff\n"
+        "  %s --input frames.log --batch-export --export-csv run --export-json\n"
+        "  %s --input frames.log --render informe --render-format png\n"
+        "  %s --serve /run/hermes.sock --threads 4\n"
+        "  %s --encode barrido.csv > tramas.txt\n"
+        "  %s --input frames.log --threads 8 --format ndjson > decode.ndjson\n"
+        "  %s --input frames.log --threads 8 --archive flota.hrc\n"
+        "  %s --archive-cat flota.hrc | %s --stream\n"
+        "  %s --input frames.log --threads 8 --curves 0:1:500 --format binary > curvas.bin\n"
+        "  %s --input captura.log --echo p1 --format ndjson > ecos.ndjson\n"
+        "  %s --tty /dev/ttyUSB0 --baud 115200 --format ndjson | tee vivo.ndjson\n"
+        "  %s --input flota.log.gz --threads 8 --aggregate\n"
+        "  %s query frames.log \"DEADTIME.PULSE_DT > 8\" --ids\n"
+        "  %s query flota.hrc \"TVGAIN6.RESERVED or CURR_LIM_P1.RESERVED\" | %s --stream\n",
+        prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog
+    );
+}
+
+
@@ -0,0 +1,549 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef HERMES_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HERMES_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "zstream.h"
+#include "stats.h"
+
+static const uint8_t GZIP_MAGIC[2] = { 0x1F, 0x8B };
+static const uint8_t ZSTD_MAGIC[4] = { 0x28, 0xB5, 0x2F, 0xFD };  // 0xFD2FB528 LE
+
+/*
+ * Bloques de salida. El bloque k del flujo (un trozo de ZSTREAM_SLOT_BYTES
+ * en modo secuencial, una trama zstd en modo por tramas) va al hueco
+ * k % nslots; se produce solo si k < consumed + nslots, asi que la memoria
+ * queda acotada y cada hueco se reutiliza sin liberar.
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t   cap, len;
+    int      ready;
+} zslot_t;
+
+struct zstream {
+    FILE           *in;
+    zstream_codec_t codec;
+    const char     *name;
+    FILE           *fp;
+
+    zslot_t        *slots;
+    size_t          nslots;
+
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+    uint64_t        next;       // siguiente bloque a producir (modo por tramas)
+    uint64_t        consumed;   // bloque que esta leyendo el consumidor
+    size_t          rpos;       // posicion dentro de ese bloque
+    uint64_t        end;        // numero de bloques (UINT64_MAX hasta saberlo)
+    int             failed;
+    int             stop;       // el consumidor cerro antes del final
+    char            err[128];
+
+    /* modo por tramas: .zst mapeado con varias tramas */
+    const uint8_t  *map;
+    size_t          map_size;
+    size_t         *frame_off;  // nframes + 1 limites
+    size_t          nframes;
+
+    pthread_t      *th;
+    int             nth;
+    uint64_t        in_bytes, out_bytes;
+};
+
+/*
+ * Copia hasta n bytes del principio de in sin consumirlos. ungetc solo
+ * garantiza un byte de vuelta, asi que con glibc se miran los que stdio
+ * ya tiene en su buffer tras el primer read(); en otra libc solo se puede
+ * releer si la entrada admite fseek, y si no se devuelve el primer byte.
+ */
+static size_t peek_head(FILE *in, uint8_t *m, size_t n){
+    int c = getc(in);
+    if (c == EOF) return 0;
+    ungetc(c, in);
+#if defined(__GLIBC__)
+    size_t avail = (size_t)(in->_IO_read_end - in->_IO_read_ptr);
+    if (avail > n) avail = n;
+    memcpy(m, in->_IO_read_ptr, avail);
+    return avail;
+#else
+    long pos = ftell(in);
+    if (pos >= 0){
+        size_t k = fread(m, 1, n, in);
+        if (fseek(in, pos, SEEK_SET) == 0) return k;
+    }
+    m[0] = (uint8_t)c;
+    return 1;
+#endif
+}
+
+zstream_codec_t zstream_detect(FILE *in){
+    uint8_t m[sizeof ZSTD_MAGIC];
+    size_t k = peek_head(in, m, sizeof m);
+    if (k >= sizeof GZIP_MAGIC && !memcmp(m, GZIP_MAGIC, sizeof GZIP_MAGIC))
+        return ZSTREAM_GZIP;
+    if (k >= sizeof ZSTD_MAGIC && !memcmp(m, ZSTD_MAGIC, sizeof ZSTD_MAGIC))
+        return ZSTREAM_ZSTD;
+    return ZSTREAM_NONE;
+}
+
+const char *zstream_codec_name(zstream_codec_t c){
+    switch (c){
+        case ZSTREAM_GZIP: return "gzip";
+        case ZSTREAM_ZSTD: return "zstd";
+        default:           return "ninguno";
+    }
+}
+
+int zstream_available(zstream_codec_t c){
+#ifdef HERMES_HAVE_ZLIB
+    if (c == ZSTREAM_GZIP) return 1;
+#endif
+#ifdef HERMES_HAVE_ZSTD
+    if (c == ZSTREAM_ZSTD) return 1;
+#endif
+    (void)c;
+    return 0;
+}
+
+/* ------------------ huecos (productores) ------------------ */
+/* Marca el final del flujo en el bloque k; con msg, por error */
+static void finish_at(zstream_t *z, uint64_t k, const char *msg){
+    pthread_mutex_lock(&z->mu);
+    if (k < z->end) z->end = k;
+    if (msg && !z->failed){
+        z->failed = 1;
+        snprintf(z->err, sizeof(z->err), "%s", msg);
+    }
+    pthread_cond_broadcast(&z->cv);
+    pthread_mutex_unlock(&z->mu);
+}
+
+#if defined(HERMES_HAVE_ZLIB) || defined(HERMES_HAVE_ZSTD)
+/* Espera a que el hueco del bloque k quede libre; NULL si hay que parar */
+static zslot_t *slot_acquire(zstream_t *z, uint64_t k){
+    pthread_mutex_lock(&z->mu);
+    while (k >= z->consumed + z->nslots && !z->stop && k < z->end) pthread_cond_wait(&z->cv, &z->mu);
+    int ok = !z->stop && k < z->end;
+    pthread_mutex_unlock(&z->mu);
+    if (!ok) return NULL;
+    zslot_t *s = &z->slots[k % z->nslots];
+    s->len = 0;
+    return s;
+}
+
+static void slot_publish(zstream_t *z, zslot_t *s){
+    pthread_mutex_lock(&z->mu);
+    s->ready = 1;
+    z->out_bytes += s->len;
+    pthread_cond_broadcast(&z->cv);
+    pthread_mutex_unlock(&z->mu);
+}
+
+/* ------------------ modo secuencial (un hilo) ------------------ */
+/* Lee mas entrada comprimida; 0 en EOF (con *rerr si fue un error de lectura) */
+static size_t read_in(zstream_t *z, uint8_t *buf, int *eof, int *rerr){
+    size_t n = fread(buf, 1, ZSTREAM_READ_BYTES, z->in);
+    if (n == 0){
+        *eof = 1;
+        *rerr = ferror(z->in);
+    }
+    z->in_bytes += n;
+    return n;
+}
+#endif
+
+#ifdef HERMES_HAVE_ZLIB
+static void gzip_main(zstream_t *z, uint8_t *inbuf){
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, 15 + 32) != Z_OK){      // +32: cabecera gzip o zlib
+        finish_at(z, 0, "sin memoria para zlib");
+        return;
+    }
+
+    uint64_t k = 0;
+    zslot_t *s = slot_acquire(z, k);
+    int eof = 0, rerr = 0, pending = 0;
+    const char *msg = NULL;
+
+    while (s){
+        if (zs.avail_in == 0 && !eof){
+            zs.next_in = inbuf;
+            zs.avail_in = (uInt)read_in(z, inbuf, &eof, &rerr);
+            if (rerr){
+                msg = "error de lectura";
+                break;
+            }
+        }
+        if (s->len == s->cap){
+            slot_publish(z, s);
+            s = slot_acquire(z, ++k);
+            if (!s) break;
+        }
+
+        zs.next_out = s->buf + s->len;
+        zs.avail_out = (uInt)(s->cap - s->len);
+        uint64_t t = stats_begin();
+        int r = inflate(&zs, Z_NO_FLUSH);
+        stats_end(STAGE_DECOMPRESS, t);
+        s->len = s->cap - zs.avail_out;
+
+        if (r == Z_STREAM_END){
+            // fin de un miembro: puede seguir otro (ficheros .gz concatenados)
+            pending = 0;
+            inflateReset(&zs);
+        } else if (r == Z_OK){
+            pending = 1;
+        } else if (r == Z_BUF_ERROR && zs.avail_in == 0){
+            if (!eof) continue;
+            if (pending) msg = "fichero truncado";
+            break;
+        } else {
+            msg = zs.msg ? zs.msg : "datos corruptos";
+            break;
+        }
+    }
+
+    if (s){
+        if (s->len) slot_publish(z, s);
+        finish_at(z, k + (s->len ? 1 : 0), msg);
+    }
+    inflateEnd(&zs);
+}
+#endif
+
+#ifdef HERMES_HAVE_ZSTD
+static void zstd_main(zstream_t *z, uint8_t *inbuf){
+    ZSTD_DStream *ds = ZSTD_createDStream();
+    if (!ds){
+        finish_at(z, 0, "sin memoria para zstd");
+        return;
+    }
+    ZSTD_initDStream(ds);
+
+    uint64_t k = 0;
+    zslot_t *s = slot_acquire(z, k);
+    ZSTD_inBuffer ib = { inbuf, 0, 0 };
+    int eof = 0, rerr = 0, pending = 0;
+    const char *msg = NULL;
+
+    while (s){
+        if (ib.pos == ib.size && !eof){
+            ib.size = read_in(z, inbuf, &eof, &rerr);
+            ib.pos = 0;
+            if (rerr){
+                msg = "error de lectura";
+                break;
+            }
+        }
+        if (s->len == s->cap){
+            slot_publish(z, s);
+            s = slot_acquire(z, ++k);
+            if (!s) break;
+        }
+
+        ZSTD_outBuffer ob = { s->buf, s->cap, s->len };
+        size_t in_pos = ib.pos;
+        uint64_t t = stats_begin();
+        size_t r = ZSTD_decompressStream(ds, &ob, &ib);
+        stats_end(STAGE_DECOMPRESS, t);
+        if (ZSTD_isError(r)){
+            msg = ZSTD_getErrorName(r);
+            break;
+        }
+        // 0: trama terminada y volcada; si no, hay una a medias si hubo avance
+        if (r == 0) pending = 0;
+        else if (ib.pos != in_pos || ob.pos != s->len) pending = 1;
+        s->len = ob.pos;
+
+        // sin entrada y con hueco libre: el decodificador ya no da mas
+        if (eof && ib.pos == ib.size && ob.pos < ob.size){
+            if (pending) msg = "fichero truncado";
+            break;
+        }
+    }
+
+    if (s){
+        if (s->len) slot_publish(z, s);
+        finish_at(z, k + (s->len ? 1 : 0), msg);
+    }
+    ZSTD_freeDStream(ds);
+}
+
+/* ------------------ modo por tramas (N hilos) ------------------ */
+/* Una trama zstd completa en el hueco, que crece hasta su tamaño */
+static const char *zstd_frame(ZSTD_DStream *ds, const uint8_t *src, size_t n, zslot_t *s){
+    unsigned long long want = ZSTD_getFrameContentSize(src, n);
+    if (want != ZSTD_CONTENTSIZE_UNKNOWN && want != ZSTD_CONTENTSIZE_ERROR && want > s->cap &&
+        want <= (256ull << 20)){
+        uint8_t *nb = realloc(s->buf, (size_t)want);
+        if (!nb) return "sin memoria";
+        s->buf = nb;
+        s->cap = (size_t)want;
+    }
+
+    ZSTD_DCtx_reset(ds, ZSTD_reset_session_only);
+    ZSTD_inBuffer ib = { src, n, 0 };
+    for (;;){
+        if (s->len == s->cap){
+            uint8_t *nb = realloc(s->buf, s->cap * 2);
+            if (!nb) return "sin memoria";
+            s->buf = nb;
+            s->cap *= 2;
+        }
+        ZSTD_outBuffer ob = { s->buf, s->cap, s->len };
+        size_t r = ZSTD_decompressStream(ds, &ob, &ib);
+        s->len = ob.pos;
+        if (ZSTD_isError(r)) return ZSTD_getErrorName(r);
+        if (r == 0) return NULL;
+        if (ib.pos == ib.size && ob.pos < ob.size) return "trama truncada";
+    }
+}
+
+static void *frame_worker(void *arg){
+    zstream_t *z = (zstream_t *)arg;
+    ZSTD_DStream *ds = ZSTD_createDStream();
+    if (!ds){
+        finish_at(z, 0, "sin memoria para zstd");
+        return NULL;
+    }
+
+    for (;;){
+        pthread_mutex_lock(&z->mu);
+        while (z->next < z->end && z->next >= z->consumed + z->nslots && !z->stop) pthread_cond_wait(&z->cv, &z->mu);
+        if (z->next >= z->end || z->stop){
+            pthread_mutex_unlock(&z->mu);
+            break;
+        }
+        uint64_t k = z->next++;
+        pthread_mutex_unlock(&z->mu);
+
+        zslot_t *s = &z->slots[k % z->nslots];
+        s->len = 0;
+        uint64_t t = stats_begin();
+        const char *msg = zstd_frame(ds, z->map + z->frame_off[k], z->frame_off[k + 1] - z->frame_off[k], s);
+        stats_end(STAGE_DECOMPRESS, t);
+        if (msg){
+            finish_at(z, k, msg);
+            break;
+        }
+        slot_publish(z, s);
+    }
+
+    ZSTD_freeDStream(ds);
+    return NULL;
+}
+
+/*
+ * Limites de las tramas de un .zst regular mapeado. 0 si hay al menos dos
+ * tramas validas; si no (una sola, o la ultima esta rota) se usa el modo
+ * secuencial, que ademas informa del error en su sitio.
+ */
+static int map_frames(zstream_t *z){
+    int fd = fileno(z->in);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size <= 0) return -1;
+    if (ftello(z->in) != 0) return -1;      // stdin redirigido a mitad de fichero
+
+    size_t size = (size_t)sb.st_size;
+    const uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return -1;
+
+    size_t cap = 64, n = 0, pos = 0;
+    size_t *off = malloc(cap * sizeof(*off));
+    while (off && pos < size){
+        size_t fs = ZSTD_findFrameCompressedSize(map + pos, size - pos);
+        if (ZSTD_isError(fs)) break;
+        if (n + 2 > cap){
+            size_t *no = realloc(off, cap * 2 * sizeof(*off));
+            if (!no) break;
+            off = no;
+            cap *= 2;
+        }
+        off[n++] = pos;
+        pos += fs;
+    }
+    if (!off || pos != size || n < 2){
+        free(off);
+        munmap((void *)map, size);
+        return -1;
+    }
+    off[n] = size;
+
+    madvise((void *)map, size, MADV_SEQUENTIAL);
+    z->map = map;
+    z->map_size = size;
+    z->frame_off = off;
+    z->nframes = n;
+    z->end = n;
+    z->in_bytes = size;
+    return 0;
+}
+#endif
+
+static void *stream_main(void *arg){
+    zstream_t *z = (zstream_t *)arg;
+    uint8_t *inbuf = malloc(ZSTREAM_READ_BYTES);
+    if (!inbuf){
+        finish_at(z, 0, "sin memoria");
+        return NULL;
+    }
+#ifdef HERMES_HAVE_ZLIB
+    if (z->codec == ZSTREAM_GZIP) gzip_main(z, inbuf);
+#endif
+#ifdef HERMES_HAVE_ZSTD
+    if (z->codec == ZSTREAM_ZSTD) zstd_main(z, inbuf);
+#endif
+    free(inbuf);
+    return NULL;
+}
+
+/* ------------------ consumidor (FILE* de solo lectura) ------------------ */
+static ssize_t zs_read(void *cookie, char *buf, size_t size){
+    zstream_t *z = (zstream_t *)cookie;
+    size_t done = 0;
+
+    pthread_mutex_lock(&z->mu);
+    while (done < size){
+        zslot_t *s = &z->slots[z->consumed % z->nslots];
+        while (z->consumed < z->end && !s->ready) pthread_cond_wait(&z->cv, &z->mu);
+        if (!s->ready) break;   // fin del flujo
+        pthread_mutex_unlock(&z->mu);
+
+        size_t n = s->len - z->rpos;
+        if (n > size - done) n = size - done;
+        memcpy(buf + done, s->buf + z->rpos, n);
+        z->rpos += n;
+        done += n;
+
+        pthread_mutex_lock(&z->mu);
+        if (z->rpos == s->len){
+            s->ready = 0;
+            z->rpos = 0;
+            z->consumed++;
+            pthread_cond_broadcast(&z->cv);
+        }
+        if (done) break;        // no esperar al siguiente bloque con datos ya listos
+    }
+    int failed = z->failed && z->consumed >= z->end;
+    pthread_mutex_unlock(&z->mu);
+
+    if (done == 0 && failed) return -1;
+    return (ssize_t)done;
+}
+
+static int zs_close(void *cookie){
+    (void)cookie;
+    return 0;
+}
+
+zstream_t *zstream_open(FILE *in, zstream_codec_t codec, int nthreads, const char *name){
+    if (!zstream_available(codec)){
+        fprintf(stderr, "%s: entrada %s, pero este binario se compiló sin %s (instalar la biblioteca y recompilar).\n",
+                name, zstream_codec_name(codec), codec == ZSTREAM_GZIP ? "zlib" : "libzstd");
+        return NULL;
+    }
+
+    zstream_t *z = calloc(1, sizeof(*z));
+    if (!z){
+        fprintf(stderr, "Sin memoria para descomprimir %s.\n", name);
+        return NULL;
+    }
+    z->in = in;
+    z->codec = codec;
+    z->name = name;
+    z->end = UINT64_MAX;
+    z->nth = 1;
+    pthread_mutex_init(&z->mu, NULL);
+    pthread_cond_init(&z->cv, NULL);
+
+    void *(*fn)(void *) = stream_main;
+    size_t slot_bytes = ZSTREAM_SLOT_BYTES;
+    z->nslots = ZSTREAM_SLOTS;
+#ifdef HERMES_HAVE_ZSTD
+    if (codec == ZSTREAM_ZSTD && nthreads > 1 && map_frames(z) == 0){
+        fn = frame_worker;
+        z->nth = nthreads < (int)z->nframes ? nthreads : (int)z->nframes;
+        if ((size_t)z->nth * 2 > z->nslots) z->nslots = (size_t)z->nth * 2;
+    }
+#else
+    (void)nthreads;
+#endif
+
+    z->slots = calloc(z->nslots, sizeof(zslot_t));
+    z->th = calloc((size_t)z->nth, sizeof(pthread_t));
+    int ok = z->slots && z->th;
+    for (size_t i = 0; ok && i < z->nslots; i++){
+        z->slots[i].buf = malloc(slot_bytes);
+        z->slots[i].cap = slot_bytes;
+        ok = z->slots[i].buf != NULL;
+    }
+
+    cookie_io_functions_t io = { .read = zs_read, .close = zs_close };
+    if (ok) z->fp = fopencookie(z, "r", io);
+    if (z->fp) setvbuf(z->fp, NULL, _IOFBF, 1 << 16);
+
+    int started = 0;
+    if (z->fp){
+        for (; started < z->nth; started++){
+            if (pthread_create(&z->th[started], NULL, fn, z) != 0) break;
+        }
+    }
+    z->nth = started;
+    if (started == 0){
+        fprintf(stderr, "Sin memoria/hilos para descomprimir %s.\n", name);
+        zstream_close(z, NULL);
+        return NULL;
+    }
+    return z;
+}
+
+FILE *zstream_file(zstream_t *z){
+    return z->fp;
+}
+
+int zstream_close(zstream_t *z, zstream_stats_t *st){
+    if (z->fp) fclose(z->fp);
+
+    pthread_mutex_lock(&z->mu);
+    z->stop = 1;
+    pthread_cond_broadcast(&z->cv);
+    pthread_mutex_unlock(&z->mu);
+    for (int t = 0; t < z->nth; t++) pthread_join(z->th[t], NULL);
+
+    int rc = 0;
+    if (z->failed){
+        fprintf(stderr, "Error descomprimiendo %s (%s): %s.\n", z->name, zstream_codec_name(z->codec), z->err);
+        rc = -1;
+    }
+    if (st){
+        st->codec = z->codec;
+        st->in_bytes = z->in_bytes;
+        st->out_bytes = z->out_bytes;
+        st->frames = z->nframes;
+        st->workers = z->nth;
+    }
+
+    for (size_t i = 0; z->slots && i < z->nslots; i++) free(z->slots[i].buf);
+    free(z->slots);
+    free(z->th);
+    free(z->frame_off);
+    if (z->map) munmap((void *)z->map, z->map_size);
+    pthread_mutex_destroy(&z->mu);
+    pthread_cond_destroy(&z->cv);
+    free(z);
+    return rc;
+}
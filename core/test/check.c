@@ -0,0 +1,633 @@
+/*
+ * hermescheck - comprobaciones de correccion de HermesDecoder (make check)
+ *
+ *   make check                       (las tres distribuciones, 2000 tramas)
+ *   ./test/hermescheck --frames 20000 --seed 7
+ *
+ * Cada comprobacion enfrenta una implementacion rapida a su referencia
+ * (SIMD frente a escalar, encoder frente a decoder, ...) sobre las tramas
+ * sinteticas de bench/gen.c. Una linea por comprobacion y distribucion
+ * ("ok", "FALLO" u "omitida" si falta algo del sistema: ptys, zlib,
+ * libzstd). Termina con 1 si alguna falla.
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <pthread.h>
+
+#include "gen.h"
+#include "utils.h"
+#include "hexparse.h"
+#include "config.h"
+#include "decoder.h"
+#include "encoder.h"
+#include "curve.h"
+#include "echo.h"
+#include "tty.h"
+#include "stream.h"
+#include "zstream.h"
+#include "export.h"
+#include "hermes.h"
+#include "record.h"
+
+#ifdef HERMES_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HERMES_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+enum { CHECK_OK = 0, CHECK_FAIL = -1, CHECK_SKIP = 1 };
+
+/* --curves: rejilla de 1 cm (cubre todos los tiempos de TH y TVG) */
+#define CHECK_GRID 1024
+static float check_grid[CHECK_GRID];
+
+typedef struct {
+    gen_kind_t kind;
+    size_t   n;
+    char   **line;          // tramas en hex (terminadas en '\0')
+    size_t  *len;
+    uint8_t (*frame)[HERMES_FRAME_BYTES];
+    hermes_config_t *cfg;
+} dataset_t;
+
+/* ------------------ hexparse ------------------ */
+static int hex_same(const char *s, size_t len, int max_out){
+    uint8_t a[HERMES_FRAME_BYTES * 2], b[HERMES_FRAME_BYTES * 2], c[HERMES_FRAME_BYTES * 2];
+    int na = parse_hex_bytes(s, a, max_out);
+    int nb = parse_hex_bytes_fast(s, b, max_out);
+    int nc = parse_hex_bytes_n(s, len, c, max_out);
+    if (na != nb || na != nc) return 0;
+    return na <= 0 || (memcmp(a, b, (size_t)na) == 0 && memcmp(a, c, (size_t)na) == 0);
+}
+
+static int check_hexparse(const char *line, size_t len, size_t i){
+    static const char SEPS[] = { ' ', ':', '-', ',', '\t' };
+    static const char BAD[] = { 'G', 'x', '\x80', '.' };
+    char t[4 * HERMES_FRAME_BYTES + 8];
+    const int max = HERMES_FRAME_BYTES * 2;
+
+    if (!hex_same(line, len, max)) return 0;
+    if (!hex_same(line, len, HERMES_FRAME_BYTES - 1)) return 0;       // no cabe: -1
+
+    /* solo los digitos, luego cada separador entre bytes (y al principio y al final) */
+    char h[2 * HERMES_FRAME_BYTES + 2];
+    size_t nh = 0;
+    for (size_t j = 0; j < len && nh + 1 < sizeof(h); j++){
+        if (isxdigit((unsigned char)line[j])) h[nh++] = line[j];
+    }
+    for (size_t k = 0; k < sizeof(SEPS); k++){
+        size_t n = 0;
+        t[n++] = SEPS[k];
+        for (size_t j = 0; j + 1 < nh; j += 2){
+            t[n++] = h[j];
+            t[n++] = h[j + 1];
+            t[n++] = SEPS[k];
+        }
+        t[n] = '\0';
+        if (!hex_same(t, n, max)) return 0;
+    }
+
+    if (len > 2){
+        /* longitud impar */
+        memcpy(t, line, len - 1);
+        t[len - 1] = '\0';
+        if (!hex_same(t, len - 1, max)) return 0;
+
+        /* "A A": espacio entre los dos nibbles de un byte */
+        size_t at = (i * 2) % (len - 1) | 1;
+        memcpy(t, line, at);
+        t[at] = ' ';
+        memcpy(t + at + 1, line + at, len - at + 1);
+        if (!hex_same(t, len + 1, max)) return 0;
+
+        /* caracter invalido en una posicion distinta por linea */
+        memcpy(t, line, len + 1);
+        t[i % len] = BAD[i % sizeof(BAD)];
+        if (!hex_same(t, len, max)) return 0;
+    }
+    return 1;
+}
+
+static int check_hex(const dataset_t *ds){
+    for (size_t i = 0; i < ds->n; i++){
+        if (!check_hexparse(ds->line[i], ds->len[i], i)){
+            fprintf(stderr, "parse_hex_bytes_fast (%s) no coincide con parse_hex_bytes en la trama %zu.\n",
+                    hexparse_impl(), i);
+            return CHECK_FAIL;
+        }
+    }
+    return CHECK_OK;
+}
+
+/* ------------------ encoder ------------------ */
+/* Ida y vuelta: el encoder debe reproducir los registros bit a bit */
+static int check_encoder(const dataset_t *ds){
+    for (size_t i = 0; i < ds->n; i++){
+        uint8_t reg[HERMES_NUM_REGS];
+        encode_config(&ds->cfg[i], reg);
+        if (memcmp(reg, ds->frame[i] + HERMES_PREFIX_BYTES, HERMES_NUM_REGS) != 0 ||
+            encode_check(&ds->cfg[i], reg) != 0){
+            fprintf(stderr, "encode_config no reproduce la trama %zu.\n", i);
+            return CHECK_FAIL;
+        }
+    }
+    return CHECK_OK;
+}
+
+/* ------------------ echo / curvas ------------------ */
+/* Muestras derivadas de la trama; SIMD y escalar deben coincidir */
+static int check_echo(const dataset_t *ds){
+    uint8_t echo[ECHO_SAMPLES], thr[ECHO_SAMPLES];
+    for (size_t i = 0; i < ds->n; i++){
+        for (int j = 0; j < ECHO_SAMPLES; j++){
+            echo[j] = (uint8_t)(ds->frame[i][HERMES_PREFIX_BYTES + j % HERMES_NUM_REGS] ^ (j * 37));
+        }
+        echo_threshold(&ds->cfg[i], 0, (curve_interp_t)(i & 1), thr);
+        echo_result_t ea, eb;
+        echo_analyze_scalar(echo, thr, &ea);
+        echo_analyze(echo, thr, &eb);
+        if (memcmp(&ea, &eb, sizeof(ea)) != 0){
+            fprintf(stderr, "echo_analyze (%s) no coincide con el escalar en la trama %zu.\n", echo_impl(), i);
+            return CHECK_FAIL;
+        }
+    }
+    return CHECK_OK;
+}
+
+/* El kernel SIMD debe dar lo mismo que el escalar, bit a bit */
+static int check_curves(const dataset_t *ds){
+    float a[CHECK_GRID], b[CHECK_GRID];
+    for (size_t i = 0; i < ds->n; i++){
+        for (int k = 0; k < CURVE_NUM_KINDS; k++){
+            for (int ip = CURVE_STEP; ip <= CURVE_LINEAR; ip++){
+                curve_table_t t;
+                curve_table(&ds->cfg[i], (curve_kind_t)k, &t);
+                curve_eval_scalar(&t, (curve_interp_t)ip, check_grid, CHECK_GRID, a);
+                curve_eval(&t, (curve_interp_t)ip, check_grid, CHECK_GRID, b);
+                if (memcmp(a, b, sizeof(a)) != 0){
+                    fprintf(stderr, "curve_eval (%s) no coincide con el escalar en la trama %zu.\n", curve_impl(), i);
+                    return CHECK_FAIL;
+                }
+            }
+        }
+    }
+    return CHECK_OK;
+}
+
+/* ------------------ serializacion ------------------ */
+/*
+ * hermes_serialize, format_frame_json y record_format_ndjson en un buffer
+ * sucio: '\0' justo tras el texto (y strlen == longitud) y, truncado, un
+ * prefijo terminado en cap - 1.
+ */
+static int terminated(const char *buf, size_t n, const char *full, size_t cap){
+    if (n < cap) return buf[n] == '\0' && strlen(buf) == n;
+    return cap == 0 || (buf[cap - 1] == '\0' && memcmp(buf, full, cap - 1) == 0);
+}
+
+static int check_serialize(const dataset_t *ds){
+    static char full[RECORD_NDJSON_MAX_BYTES], buf[RECORD_NDJSON_MAX_BYTES];
+    for (size_t i = 0; i < ds->n; i++){
+        for (int p = HERMES_PROFILE_P1; p <= HERMES_PROFILE_TVG; p++){
+            for (int f = HERMES_FMT_CSV; f <= HERMES_FMT_JSON; f++){
+                int n = hermes_serialize(&ds->cfg[i], (hermes_profile_t)p, (hermes_format_t)f, full, sizeof(full));
+                if (n <= 0) return CHECK_FAIL;
+                size_t caps[3] = { HERMES_SERIALIZE_MAX, (size_t)n + 1, (size_t)n / 2 };
+                for (int c = 0; c < 3; c++){
+                    memset(buf, 0xA5, sizeof(buf));
+                    int m = hermes_serialize(&ds->cfg[i], (hermes_profile_t)p, (hermes_format_t)f, buf, caps[c]);
+                    int want = (size_t)n < caps[c] ? n : HERMES_ERR_NOSPACE;
+                    if (m != want || !terminated(buf, (size_t)n, full, caps[c])){
+                        fprintf(stderr, "hermes_serialize (perfil %d, formato %d, cap %zu) sin '\\0' en la trama %zu.\n",
+                                p, f, caps[c], i);
+                        return CHECK_FAIL;
+                    }
+                }
+            }
+        }
+
+        export_key_t k = { i + 1, 0, 0x5E02, ds->cfg[i].uart_addr };
+        for (int w = 0; w < 2; w++){
+            size_t (*fmt)(char *, size_t, const export_key_t *, const hermes_config_t *) =
+                w ? record_format_ndjson : format_frame_json;
+            size_t n = fmt(full, sizeof(full), &k, &ds->cfg[i]);
+            memset(buf, 0xA5, sizeof(buf));
+            size_t m = fmt(buf, n / 2, &k, &ds->cfg[i]);
+            if (n >= sizeof(full) || m != n || !terminated(full, n, full, sizeof(full)) ||
+                !terminated(buf, n, full, n / 2)){
+                fprintf(stderr, "%s sin '\\0' en la trama %zu.\n", w ? "record_format_ndjson" : "format_frame_json", i);
+                return CHECK_FAIL;
+            }
+        }
+    }
+    return CHECK_OK;
+}
+
+/* ------------------ tty ------------------ */
+/* Flujo crudo: cada trama y 0..2 bytes de basura que a veces empiezan como el prefijo */
+static int check_tty_scan(const dataset_t *ds){
+    uint8_t *uart = malloc(ds->n * (HERMES_FRAME_BYTES + 2));
+    if (!uart) return CHECK_FAIL;
+    size_t len = 0;
+    for (size_t i = 0; i < ds->n; i++){
+        memcpy(uart + len, ds->frame[i], HERMES_FRAME_BYTES);
+        len += HERMES_FRAME_BYTES;
+        for (size_t j = 0; j < i % 3; j++) uart[len++] = (j == 0) ? 0x5E : (uint8_t)i;
+    }
+
+    static const uint8_t pre[2] = { 0x5E, 0x02 };
+    size_t want = 0, got = 0, pos = 0;
+    const uint8_t *p = uart, *end = uart + len;
+    while ((p = memmem(p, (size_t)(end - p), pre, 2)) != NULL){
+        want++;
+        p += 2;
+    }
+    while (pos < len){
+        size_t k = tty_find_prefix(uart + pos, len - pos, 0x5E02);
+        if (k == len - pos) break;
+        got++;
+        pos += k + 2;
+    }
+    free(uart);
+    if (got != want){
+        fprintf(stderr, "tty_find_prefix (%s): %zu prefijos, memmem %zu.\n", tty_scan_impl(), got, want);
+        return CHECK_FAIL;
+    }
+    return CHECK_OK;
+}
+
+/* --tty de punta a punta sobre un pty: 2 tramas, 20 bytes de otra, 2 tramas mas */
+#define PTY_FRAMES 5
+
+typedef struct {
+    int      master;
+    const uint8_t *data;
+    size_t   len;
+    volatile int seen;      // tramas entregadas por tty_run
+    uint64_t seq[PTY_FRAMES];
+    uint8_t  reg[PTY_FRAMES][HERMES_NUM_REGS];
+} pty_check_t;
+
+static int pty_cb(FILE *out, const hermes_frame_t *fr, void *user){
+    (void)out;
+    pty_check_t *pc = user;
+    int i = __atomic_load_n(&pc->seen, __ATOMIC_RELAXED);
+    if (i < PTY_FRAMES){
+        pc->seq[i] = fr->seq;
+        memcpy(pc->reg[i], fr->reg, HERMES_NUM_REGS);
+    }
+    __atomic_store_n(&pc->seen, i + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Escribe en cuanto tty_run ha puesto el pty en crudo y cierra al ver todas las tramas */
+static void *pty_writer(void *arg){
+    pty_check_t *pc = arg;
+    struct termios tio;
+    for (int t = 0; t < 2000; t++){
+        if (tcgetattr(pc->master, &tio) == 0 && !(tio.c_lflag & ICANON)) break;
+        usleep(1000);
+    }
+    usleep(20000);          // tras tcsetattr, tty_run descarta lo pendiente (TCIFLUSH)
+    for (size_t pos = 0; pos < pc->len; ){
+        ssize_t n = write(pc->master, pc->data + pos, pc->len - pos);
+        if (n <= 0) break;
+        pos += (size_t)n;
+    }
+    for (int t = 0; t < 2000 && __atomic_load_n(&pc->seen, __ATOMIC_ACQUIRE) < PTY_FRAMES; t++) usleep(1000);
+    close(pc->master);      // tty_run sale con EIO
+    return NULL;
+}
+
+/* Sin el prefijo fuera del byte 0: el unico punto de resincronizacion es el esperado */
+static int pty_clean(const uint8_t *f){
+    if (f[0] != 0x5E || f[1] != 0x02) return 0;
+    return tty_find_prefix(f + 1, HERMES_FRAME_BYTES - 1, 0x5E02) == HERMES_FRAME_BYTES - 1;
+}
+
+static int check_tty_pty(const dataset_t *ds){
+    size_t pick[PTY_FRAMES], k = 0;
+    for (size_t i = 0; i < ds->n && k < PTY_FRAMES; i++){
+        if (pty_clean(ds->frame[i])) pick[k++] = i;
+    }
+    if (k < PTY_FRAMES) return CHECK_SKIP;   // dataset sin tramas utilizables
+
+    uint8_t data[PTY_FRAMES * HERMES_FRAME_BYTES];
+    size_t len = 0;
+    for (size_t j = 0; j < PTY_FRAMES; j++){
+        size_t n = (j == 2) ? 20 : HERMES_FRAME_BYTES;     // la tercera pierde 37 bytes
+        memcpy(data + len, ds->frame[pick[j]], n);
+        len += n;
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0){
+        if (master >= 0) close(master);
+        return CHECK_SKIP;          // sin ptys (contenedor)
+    }
+    char path[128];
+    if (ptsname_r(master, path, sizeof(path)) != 0){
+        close(master);
+        return CHECK_SKIP;
+    }
+
+    pty_check_t pc;
+    memset(&pc, 0, sizeof(pc));
+    pc.master = master;
+    pc.data = data;
+    pc.len = len;
+    pthread_t th;
+    if (pthread_create(&th, NULL, pty_writer, &pc) != 0){
+        close(master);
+        return CHECK_FAIL;
+    }
+    /* "Capturando..." y el aviso de la trama corrupta son lo esperado: fuera de stderr */
+    fflush(stderr);
+    int saved = dup(STDERR_FILENO), null = open("/dev/null", O_WRONLY);
+    if (saved >= 0 && null >= 0) dup2(null, STDERR_FILENO);
+    stream_stats_t st;
+    tty_stats_t ts;
+    int rc = tty_run(path, TTY_DEFAULT_BAUD, 0x5E02, pty_cb, &pc, &st, &ts);
+    pthread_join(th, NULL);
+    fflush(stderr);
+    if (saved >= 0 && null >= 0) dup2(saved, STDERR_FILENO);
+    if (saved >= 0) close(saved);
+    if (null >= 0) close(null);
+
+    /* #3 es la corrupta (20 + 37 bytes); #4 y #5 se recuperan tras resincronizar */
+    static const size_t expect[PTY_FRAMES] = { 0, 1, 2, 3, 4 };
+    int ok = rc == 0 && pc.seen == PTY_FRAMES && st.frames == PTY_FRAMES &&
+             st.errors == 1 && ts.corrupt == 1;
+    for (size_t j = 0; ok && j < PTY_FRAMES; j++){
+        if (pc.seq[j] != j + 1) ok = 0;
+        else if (j != 2 && memcmp(pc.reg[j], ds->frame[pick[expect[j]]] + HERMES_PREFIX_BYTES,
+                                  HERMES_NUM_REGS) != 0) ok = 0;
+    }
+    if (!ok){
+        fprintf(stderr, "tty_run sobre un pty: %llu tramas, %llu errores, %llu corruptas (%s).\n",
+                (unsigned long long)st.frames, (unsigned long long)st.errors,
+                (unsigned long long)ts.corrupt, gen_kind_name(ds->kind));
+        return CHECK_FAIL;
+    }
+    return CHECK_OK;
+}
+
+/* ------------------ zstream ------------------ */
+/*
+ * zstream_detect por una tuberia (sin fseek): la firma completa decide y
+ * ningun byte se pierde, sea cual sea el resultado.
+ */
+static int detect_pipe(const uint8_t *data, size_t len, zstream_codec_t want){
+    int fd[2];
+    if (pipe(fd) != 0) return -1;
+    if (write(fd[1], data, len) != (ssize_t)len){
+        close(fd[0]);
+        close(fd[1]);
+        return -1;
+    }
+    close(fd[1]);
+    FILE *in = fdopen(fd[0], "r");
+    if (!in){
+        close(fd[0]);
+        return -1;
+    }
+    zstream_codec_t got = zstream_detect(in);
+    uint8_t back[64];
+    size_t n = fread(back, 1, sizeof(back), in);
+    fclose(in);
+    return (got == want && n == len && memcmp(back, data, len) == 0) ? 0 : -2;
+}
+
+static int check_zdetect(const dataset_t *ds){
+    static const struct { uint8_t b[8]; size_t len; zstream_codec_t want; } cases[] = {
+        { { 0x1F, 0x8B, 0x08, 0x00 },             4, ZSTREAM_GZIP },
+        { { 0x28, 0xB5, 0x2F, 0xFD, 0x24, 0x00 }, 6, ZSTREAM_ZSTD },
+        { { 0x1F, 'A', 'B', '\n' },               4, ZSTREAM_NONE },
+        { { 0x28, 0xB5, 0x2F, 0x00 },             4, ZSTREAM_NONE },
+        { { 0x28, 0xB5 },                         2, ZSTREAM_NONE },
+        { { 0x1F },                               1, ZSTREAM_NONE },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+        if (detect_pipe(cases[i].b, cases[i].len, cases[i].want) != 0){
+            fprintf(stderr, "zstream_detect falla en el caso %zu.\n", i);
+            return CHECK_FAIL;
+        }
+    }
+    if (ds->n == 0) return CHECK_OK;
+    size_t len = ds->len[0] < 64 ? ds->len[0] : 64;
+    if (detect_pipe((const uint8_t *)ds->line[0], len, ZSTREAM_NONE) != 0){
+        fprintf(stderr, "zstream_detect toma una linea hex por comprimida.\n");
+        return CHECK_FAIL;
+    }
+    return CHECK_OK;
+}
+
+#if defined(HERMES_HAVE_ZLIB) || defined(HERMES_HAVE_ZSTD)
+/* Las lineas hex como un log ("linea\n" por trama) */
+static char *dataset_text(const dataset_t *ds, size_t *len){
+    size_t cap = 0;
+    for (size_t i = 0; i < ds->n; i++) cap += ds->len[i] + 1;
+    char *t = malloc(cap);
+    if (!t) return NULL;
+    size_t pos = 0;
+    for (size_t i = 0; i < ds->n; i++){
+        memcpy(t + pos, ds->line[i], ds->len[i]);
+        pos += ds->len[i];
+        t[pos++] = '\n';
+    }
+    *len = pos;
+    return t;
+}
+
+/* zstream debe devolver exactamente el texto original */
+static int check_zstream(uint8_t *buf, size_t len, zstream_codec_t codec, const char *text, size_t text_len){
+    FILE *in = fmemopen(buf, len, "r");
+    zstream_t *z = in ? zstream_open(in, codec, 1, "check") : NULL;
+    if (!z){
+        if (in) fclose(in);
+        return -1;
+    }
+    char chunk[4096];
+    size_t pos = 0, n;
+    int same = 1;
+    while ((n = fread(chunk, 1, sizeof(chunk), zstream_file(z))) > 0){
+        if (pos + n > text_len || memcmp(chunk, text + pos, n) != 0) same = 0;
+        pos += n;
+    }
+    int rc = zstream_close(z, NULL);
+    fclose(in);
+    return (rc == 0 && same && pos == text_len) ? 0 : -2;
+}
+#endif
+
+static int check_gzip(const dataset_t *ds){
+#ifdef HERMES_HAVE_ZLIB
+    size_t len;
+    char *text = dataset_text(ds, &len);
+    uint8_t *gz = text ? malloc(compressBound((uLong)len) + 64) : NULL;
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (!gz || deflateInit2(&zs, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK){   // +16: gzip
+        free(text);
+        free(gz);
+        return CHECK_FAIL;
+    }
+    zs.next_in = (Bytef *)text;
+    zs.avail_in = (uInt)len;
+    zs.next_out = gz;
+    zs.avail_out = (uInt)(compressBound((uLong)len) + 64);
+    deflate(&zs, Z_FINISH);
+    size_t gz_len = zs.total_out;
+    deflateEnd(&zs);
+    int rc = check_zstream(gz, gz_len, ZSTREAM_GZIP, text, len);
+    if (rc != 0) fprintf(stderr, "zstream no reproduce el log en gzip.\n");
+    free(text);
+    free(gz);
+    return rc == 0 ? CHECK_OK : CHECK_FAIL;
+#else
+    (void)ds;
+    return CHECK_SKIP;
+#endif
+}
+
+static int check_zstd(const dataset_t *ds){
+#ifdef HERMES_HAVE_ZSTD
+    size_t len;
+    char *text = dataset_text(ds, &len);
+    uint8_t *zst = text ? malloc(ZSTD_compressBound(len)) : NULL;
+    if (!zst){
+        free(text);
+        return CHECK_FAIL;
+    }
+    size_t zst_len = ZSTD_compress(zst, ZSTD_compressBound(len), text, len, 3);
+    int rc = ZSTD_isError(zst_len) ? -1 : check_zstream(zst, zst_len, ZSTREAM_ZSTD, text, len);
+    if (rc != 0) fprintf(stderr, "zstream no reproduce el log en zstd.\n");
+    free(text);
+    free(zst);
+    return rc == 0 ? CHECK_OK : CHECK_FAIL;
+#else
+    (void)ds;
+    return CHECK_SKIP;
+#endif
+}
+
+/* ------------------ tabla ------------------ */
+typedef struct {
+    const char *name;
+    int (*run)(const dataset_t *ds);
+} check_t;
+
+static const check_t CHECKS[] = {
+    { "hexparse",      check_hex      },
+    { "encoder",       check_encoder  },
+    { "echo",          check_echo     },
+    { "curves",        check_curves   },
+    { "serialize",     check_serialize },
+    { "tty_scan",      check_tty_scan },
+    { "tty_pty",       check_tty_pty  },
+    { "zstream_detect", check_zdetect },
+    { "zstream_gzip",  check_gzip     },
+    { "zstream_zstd",  check_zstd     },
+};
+
+/* ------------------ dataset ------------------ */
+static int dataset_build(dataset_t *ds, gen_kind_t kind, size_t n, uint64_t seed){
+    memset(ds, 0, sizeof(*ds));
+    ds->kind = kind;
+    ds->n = n;
+    ds->line = calloc(n, sizeof(*ds->line));
+    ds->len = calloc(n, sizeof(*ds->len));
+    ds->frame = calloc(n, sizeof(*ds->frame));
+    ds->cfg = calloc(n, sizeof(*ds->cfg));
+    if (!ds->line || !ds->len || !ds->frame || !ds->cfg) return -1;
+
+    gen_t g;
+    char tmp[3 * HERMES_FRAME_BYTES + 1];
+    gen_init(&g, kind, seed);
+    for (size_t i = 0; i < n; i++){
+        ds->len[i] = gen_line(&g, tmp, sizeof(tmp));
+        ds->line[i] = strdup(tmp);
+        if (!ds->line[i]) return -1;
+        if (parse_hex_bytes(tmp, ds->frame[i], HERMES_FRAME_BYTES) != HERMES_FRAME_BYTES) return -1;
+        decode_config(ds->frame[i] + HERMES_PREFIX_BYTES, &ds->cfg[i]);
+    }
+    return 0;
+}
+
+static void dataset_free(dataset_t *ds){
+    for (size_t i = 0; ds->line && i < ds->n; i++) free(ds->line[i]);
+    free(ds->line);
+    free(ds->len);
+    free(ds->frame);
+    free(ds->cfg);
+}
+
+static void check_usage(const char *prog){
+    fprintf(stderr, "Uso: %s [--frames N] [--seed S] [--filter texto] [--kind random|worst|fleet]\n", prog);
+}
+
+int main(int argc, char **argv){
+    size_t nframes = 2000;
+    unsigned long long seed = 1;
+    const char *filter = NULL;
+    int only_kind = -1;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc){
+            nframes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc){
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--kind") == 0 && i + 1 < argc){
+            only_kind = gen_kind_parse(argv[++i]);
+            if (only_kind < 0){
+                check_usage(argv[0]);
+                return 1;
+            }
+        } else {
+            check_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nframes == 0) nframes = 1;
+    for (int i = 0; i < CHECK_GRID; i++) check_grid[i] = (float)i;
+
+    fprintf(stderr, "hermescheck: %zu tramas por dataset, semilla %llu, hexparse=%s, curve=%s, echo=%s, tty=%s\n",
+            nframes, seed, hexparse_impl(), curve_impl(), echo_impl(), tty_scan_impl());
+
+    int failed = 0, passed = 0, skipped = 0;
+    for (int k = 0; k < GEN_NUM_KINDS; k++){
+        if (only_kind >= 0 && k != only_kind) continue;
+
+        dataset_t ds;
+        if (dataset_build(&ds, (gen_kind_t)k, nframes, seed) != 0){
+            fprintf(stderr, "Sin memoria generando el dataset %s.\n", gen_kind_name((gen_kind_t)k));
+            dataset_free(&ds);
+            return 1;
+        }
+        for (size_t c = 0; c < sizeof(CHECKS) / sizeof(CHECKS[0]); c++){
+            if (filter && !strstr(CHECKS[c].name, filter)) continue;
+            int rc = CHECKS[c].run(&ds);
+            const char *tag = rc == CHECK_OK ? "ok" : rc == CHECK_SKIP ? "omitida" : "FALLO";
+            printf("%-8s %-16s %s\n", tag, CHECKS[c].name, gen_kind_name((gen_kind_t)k));
+            fflush(stdout);
+            if (rc == CHECK_OK) passed++;
+            else if (rc == CHECK_SKIP) skipped++;
+            else failed++;
+        }
+        dataset_free(&ds);
+    }
+
+    printf("%d ok, %d fallos, %d omitidas\n", passed, failed, skipped);
+    return failed ? 1 : 0;
+}